@@ -31,6 +31,9 @@ static UnhandledEventHandler unhandled_handler = nullptr;
 // Send callback
 static EventSendCallback send_callback = nullptr;
 
+// Guards the shared encode buffer (events are sent from BLE, Lua and writer tasks)
+static SemaphoreHandle_t send_mutex = NULL;
+
 // ═══════════════════════════════════════════════════════
 // ENCODER (with byte stuffing)
 // ═══════════════════════════════════════════════════════
@@ -185,6 +188,9 @@ uint16_t event_msg_encode(const char* name, const uint8_t* data, uint16_t data_l
 void event_msg_init(EventSendCallback on_send) {
     LOG_INFO("EVENT", "Initializing event message system");
     send_callback = on_send;
+    if (send_mutex == NULL) {
+        send_mutex = xSemaphoreCreateMutex();
+    }
     decoder_state = STATE_IDLE;
     event_name = "";
     event_data.clear();
@@ -217,12 +223,14 @@ void event_msg_send(const char* name, const uint8_t* data, uint16_t len) {
 
     // Use static buffer to avoid stack overflow (ESP32 has limited stack)
     static uint8_t buffer[4*1024];  // Static allocation - not on stack
+    xSemaphoreTake(send_mutex, portMAX_DELAY);
     uint16_t encoded_len = event_msg_encode(name, data, len, buffer);
 
     LOG_DEBUG("EVENT", "Calling send callback with %d encoded bytes", encoded_len);
 
     // Send via callback
     send_callback(buffer, encoded_len);
+    xSemaphoreGive(send_mutex);
 
     LOG_TRACE("EVENT", "Event '%s' sent successfully", name);
 }
@@ -0,0 +1,358 @@
+#include "file_manifest.h"
+#include "file_transfer.h"
+#include "event_msg.h"
+#include "utils/debug.h"
+#include "../lua_modules/lua_storage/storage_log.h"
+#include <map>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════
+// GLOBAL STATE
+// ═══════════════════════════════════════════════════════
+
+struct ManifestEntry {
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t crc;
+};
+
+// Sorted by path, so pages are stable between requests
+static std::map<String, ManifestEntry> g_entries;
+static uint32_t g_generation = 0;
+static bool g_dirty = false;
+static unsigned long g_lastSave = 0;
+
+static uint8_t g_page[ManifestConfig::PAGE_BYTES];
+
+// ═══════════════════════════════════════════════════════
+// HELPERS
+// ═══════════════════════════════════════════════════════
+
+// Storage logs change on every key write without telling the manifest
+static bool isStorageDir(const String &path) {
+    return path == StorageLogConfig::DIR || path.startsWith(String(StorageLogConfig::DIR) + "/");
+}
+
+// Temp files, storage logs and the manifest itself are not part of the synced tree
+static bool isTracked(const String &path) {
+    return path != ManifestConfig::PATH && !isStorageDir(path) &&
+           !path.endsWith(".part") && !path.endsWith(".part.tmp") && !path.endsWith(".ckpt") &&
+           !path.endsWith(".delta");
+}
+
+static uint32_t fileCrc(File &file) {
+    uint8_t buffer[512];
+    CRC32 crc;
+    size_t bytesRead;
+    file.seek(0);
+    while ((bytesRead = file.read(buffer, sizeof(buffer))) > 0) {
+        crc.update(buffer, bytesRead);
+    }
+    return crc.finalize();
+}
+
+static void markChanged() {
+    g_generation++;
+    g_dirty = true;
+
+    // Saves are rate-limited; init reconciles anything lost to a reset
+    if (millis() - g_lastSave >= ManifestConfig::SAVE_INTERVAL_MS) {
+        file_manifest_save();
+    }
+}
+
+static void writeU32(File &file, uint32_t value, CRC32 &crc) {
+    uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    file.write(bytes, 4);
+    crc.update(bytes, 4);
+}
+
+static bool readU32(File &file, uint32_t &value, CRC32 &crc) {
+    uint8_t bytes[4];
+    if (file.read(bytes, 4) != 4) {
+        return false;
+    }
+    crc.update(bytes, 4);
+    value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════
+// PERSISTENCE
+// ═══════════════════════════════════════════════════════
+
+// Layout: [magic u32][version u32][count u32][generation u32]
+//         count x [size u32][mtime u32][crc u32][path_len u8][path]
+//         [crc32 of everything above]
+static bool loadManifest() {
+    File file = FILESYSTEM.open(ManifestConfig::PATH, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    CRC32 crc;
+    uint32_t magic = 0, version = 0, count = 0, generation = 0;
+    bool ok = readU32(file, magic, crc) && readU32(file, version, crc) && readU32(file, count, crc) &&
+              readU32(file, generation, crc) &&
+              magic == ManifestConfig::MAGIC && version == ManifestConfig::FILE_VERSION &&
+              count <= ManifestConfig::MAX_ENTRIES;
+
+    for (uint32_t i = 0; ok && i < count; i++) {
+        ManifestEntry entry;
+        uint8_t pathLen = 0;
+        char path[256];
+
+        ok = readU32(file, entry.size, crc) && readU32(file, entry.mtime, crc) &&
+             readU32(file, entry.crc, crc) && file.read(&pathLen, 1) == 1 &&
+             file.read((uint8_t*)path, pathLen) == pathLen;
+        if (ok) {
+            crc.update(&pathLen, 1);
+            crc.update((uint8_t*)path, pathLen);
+            path[pathLen] = '\0';
+            g_entries[String(path)] = entry;
+        }
+    }
+
+    uint32_t expected = crc.finalize();
+    uint32_t stored = 0;
+    CRC32 unused;
+    ok = ok && readU32(file, stored, unused) && stored == expected;
+    file.close();
+
+    if (ok) {
+        g_generation = generation;
+    } else {
+        g_entries.clear();
+        LOG_ERROR("MANIFEST", "%s is damaged, rebuilding", ManifestConfig::PATH);
+    }
+    return ok;
+}
+
+void file_manifest_save() {
+    File file = FILESYSTEM.open(ManifestConfig::PATH, FILE_WRITE);
+    if (!file) {
+        LOG_ERROR("MANIFEST", "Failed to write %s", ManifestConfig::PATH);
+        return;
+    }
+
+    CRC32 crc;
+    writeU32(file, ManifestConfig::MAGIC, crc);
+    writeU32(file, ManifestConfig::FILE_VERSION, crc);
+    writeU32(file, g_entries.size(), crc);
+    writeU32(file, g_generation, crc);
+
+    for (std::map<String, ManifestEntry>::const_iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+        uint8_t pathLen = min(it->first.length(), (unsigned int)255);
+        writeU32(file, it->second.size, crc);
+        writeU32(file, it->second.mtime, crc);
+        writeU32(file, it->second.crc, crc);
+        file.write(&pathLen, 1);
+        file.write((const uint8_t*)it->first.c_str(), pathLen);
+        crc.update(&pathLen, 1);
+        crc.update((const uint8_t*)it->first.c_str(), pathLen);
+    }
+
+    CRC32 unused;
+    writeU32(file, crc.finalize(), unused);
+    file.close();
+
+    g_dirty = false;
+    g_lastSave = millis();
+}
+
+// Walk the tree: drop vanished files, re-hash new or changed ones.
+// Only files whose size or mtime differ are read. Any change starts a
+// new generation, since it happened behind the host's back.
+static void reconcile() {
+    std::map<String, bool> seen;
+    std::vector<String> dirs;
+    dirs.push_back("/");
+    uint32_t hashed = 0;
+    bool changed = false;
+
+    while (!dirs.empty()) {
+        String dirPath = dirs.back();
+        dirs.pop_back();
+
+        File dir = FILESYSTEM.open(dirPath);
+        if (!dir || !dir.isDirectory()) {
+            continue;
+        }
+
+        File file = dir.openNextFile();
+        while (file) {
+            String path = String(file.path());
+            if (file.isDirectory()) {
+                if (!isStorageDir(path)) {
+                    dirs.push_back(path);
+                }
+            } else if (isTracked(path)) {
+                seen[path] = true;
+                uint32_t size = file.size();
+                uint32_t mtime = (uint32_t)file.getLastWrite();
+
+                std::map<String, ManifestEntry>::iterator it = g_entries.find(path);
+                bool stale = it == g_entries.end() || it->second.size != size || it->second.mtime != mtime;
+                if (stale && (it != g_entries.end() || g_entries.size() < ManifestConfig::MAX_ENTRIES)) {
+                    ManifestEntry entry = { size, mtime, fileCrc(file) };
+                    g_entries[path] = entry;
+                    changed = true;
+                    hashed++;
+                }
+            }
+            file = dir.openNextFile();
+        }
+    }
+
+    for (std::map<String, ManifestEntry>::iterator it = g_entries.begin(); it != g_entries.end();) {
+        if (!seen.count(it->first)) {
+            g_entries.erase(it++);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (changed) {
+        g_generation++;
+        g_dirty = true;
+    }
+
+    LOG_INFO("MANIFEST", "%u files tracked, %u re-hashed", g_entries.size(), hashed);
+}
+
+// ═══════════════════════════════════════════════════════
+// UPDATES
+// ═══════════════════════════════════════════════════════
+
+void file_manifest_update(const String &path, uint32_t size, uint32_t crc) {
+    if (!isTracked(path)) {
+        return;
+    }
+    if (!g_entries.count(path) && g_entries.size() >= ManifestConfig::MAX_ENTRIES) {
+        LOG_ERROR("MANIFEST", "Full, not tracking %s", path.c_str());
+        return;
+    }
+
+    File file = FILESYSTEM.open(path, FILE_READ);
+    ManifestEntry entry = { size, file ? (uint32_t)file.getLastWrite() : 0, crc };
+    file.close();
+
+    g_entries[path] = entry;
+    markChanged();
+}
+
+void file_manifest_refresh(const String &path) {
+    File file = FILESYSTEM.open(path, FILE_READ);
+    if (!file) {
+        file_manifest_remove(path);
+        return;
+    }
+
+    uint32_t size = file.size();
+    uint32_t crc = fileCrc(file);
+    file.close();
+
+    file_manifest_update(path, size, crc);
+}
+
+void file_manifest_remove(const String &path) {
+    if (g_entries.erase(path) > 0) {
+        markChanged();
+    }
+}
+
+// ═══════════════════════════════════════════════════════
+// EVENT HANDLER
+// ═══════════════════════════════════════════════════════
+
+// One page per request: {"offset", "limit", "prefix", "since", "rebuild"}
+static void handleFileManifest(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(256);
+    deserializeJson(doc, (const char*)data.data(), data.size());
+
+    uint32_t offset = doc["offset"] | 0;
+    uint32_t limit = doc["limit"] | 0;
+    String prefix = doc["prefix"] | "/";
+
+    if (doc["rebuild"] | false) {
+        g_entries.clear();
+        reconcile();
+        g_generation++;
+        g_dirty = true;
+    }
+
+    // Saved before it is reported, so a generation the host holds is never
+    // handed out again after a reset
+    if (g_dirty) {
+        file_manifest_save();
+    }
+
+    ManifestPageHeader header = {};
+    header.version = ManifestConfig::VERSION;
+    header.first = offset;
+    header.generation = g_generation;
+
+    // Cheap sync check: nothing changed since the host's copy
+    if (!doc["since"].isNull() && (uint32_t)(doc["since"] | 0) == g_generation) {
+        header.flags = MANIFEST_NOT_MODIFIED;
+        header.total = 0;
+        memcpy(g_page, &header, sizeof(header));
+        event_msg_send("file_manifest_data", g_page, sizeof(header));
+        return;
+    }
+
+    size_t pos = sizeof(header);
+    uint32_t index = 0;
+
+    for (std::map<String, ManifestEntry>::const_iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+        if (!it->first.startsWith(prefix)) {
+            continue;
+        }
+
+        if (index >= offset && !(header.flags & MANIFEST_MORE)) {
+            size_t pathLen = min(it->first.length(), (unsigned int)255);
+            bool full = pos + 13 + pathLen > sizeof(g_page) || (limit > 0 && header.count >= limit);
+
+            if (full) {
+                header.flags |= MANIFEST_MORE;
+            } else {
+                const ManifestEntry &e = it->second;
+                uint32_t fields[3] = { e.size, e.mtime, e.crc };
+                memcpy(g_page + pos, fields, sizeof(fields));
+                g_page[pos + 12] = pathLen;
+                memcpy(g_page + pos + 13, it->first.c_str(), pathLen);
+                pos += 13 + pathLen;
+                header.count++;
+            }
+        }
+        index++;
+    }
+
+    header.total = index;
+    memcpy(g_page, &header, sizeof(header));
+    event_msg_send("file_manifest_data", g_page, pos);
+}
+
+// ═══════════════════════════════════════════════════════
+// PUBLIC API IMPLEMENTATION
+// ═══════════════════════════════════════════════════════
+
+void file_manifest_init() {
+    unsigned long start = millis();
+
+    // Without a saved generation, start somewhere no host has seen
+    if (!loadManifest()) {
+        g_generation = esp_random();
+    }
+    reconcile();
+    if (g_dirty) {
+        file_manifest_save();
+    }
+
+    LOG_INFO("MANIFEST", "Ready in %lu ms", millis() - start);
+}
+
+void file_manifest_register_handlers() {
+    event_msg_on("file_manifest", handleFileManifest);
+}
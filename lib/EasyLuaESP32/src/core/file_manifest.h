@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ═══════════════════════════════════════════════════════
+// FILE MANIFEST CONFIGURATION
+// ═══════════════════════════════════════════════════════
+
+namespace ManifestConfig {
+    const char *const PATH = "/.manifest";
+    const uint32_t MAGIC = 0x464E414D;            // "MANF"
+    const uint8_t VERSION = 1;                    // Wire format
+    const uint32_t FILE_VERSION = 2;              // /.manifest layout
+    const size_t MAX_ENTRIES = 512;
+    const size_t PAGE_BYTES = 480;                // Max file_manifest_data payload
+    const unsigned long SAVE_INTERVAL_MS = 5000;  // Min time between background saves
+}
+
+// ═══════════════════════════════════════════════════════
+// WIRE FORMAT
+// ═══════════════════════════════════════════════════════
+
+// Flags in ManifestPageHeader
+enum ManifestPageFlags : uint8_t {
+    MANIFEST_MORE = 0x01,           // Request the next page at first + count
+    MANIFEST_NOT_MODIFIED = 0x02    // Generation matched "since", no records sent
+};
+
+// Payload of "file_manifest_data" (little-endian, packed), followed by
+// `count` records: [size u32][mtime u32][crc u32][path_len u8][path]
+struct __attribute__((packed)) ManifestPageHeader {
+    uint8_t version;        // ManifestConfig::VERSION
+    uint8_t flags;          // ManifestPageFlags
+    uint16_t count;         // Records in this page
+    uint32_t total;         // Entries matching the prefix
+    uint32_t first;         // Index of the first record
+    uint32_t generation;    // Bumped on every manifest change, kept across reboots
+};
+
+// ═══════════════════════════════════════════════════════
+// PUBLIC API
+// ═══════════════════════════════════════════════════════
+
+// Load /.manifest and reconcile it with the filesystem (after file_transfer_init)
+void file_manifest_init();
+
+// Register the file_manifest event handler
+void file_manifest_register_handlers();
+
+// Record a file whose size and CRC32 are already known (mtime is read from the file)
+void file_manifest_update(const String &path, uint32_t size, uint32_t crc);
+
+// Re-read a file to refresh its entry (for writes whose CRC is not known)
+void file_manifest_refresh(const String &path);
+
+// Drop a deleted file
+void file_manifest_remove(const String &path);
+
+// Write pending changes to /.manifest now
+void file_manifest_save();
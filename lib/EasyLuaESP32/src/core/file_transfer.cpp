@@ -1,13 +1,68 @@
 #include "file_transfer.h"
+#include "file_manifest.h"
 #include "event_msg.h"
 #include "utils/debug.h"
+#include "utils/rolling_checksum.h"
+#include <esp_heap_caps.h>
 #include <rom/crc.h>
+#include <rom/miniz.h>
 
 // ═══════════════════════════════════════════════════════
 // GLOBAL STATE
 // ═══════════════════════════════════════════════════════
 
-static FileSession g_fileSession;
+// Session table - uploads and downloads are numbered independently
+static FileSession g_sessions[FileConfig::MAX_SESSIONS];
+static FileStream g_streams[FileConfig::MAX_SESSIONS];
+static uint8_t g_streamBuffer[5 + FileConfig::STREAM_CHUNK_SIZE];
+
+// Control record format (binary unless the host asks for JSON in file_init)
+static volatile bool g_jsonControl = false;
+
+// Cost of building + sending each ack, per format: [0] binary, [1] JSON.
+// heapBytes is how far free heap dropped while the ack was built; allocs
+// counts heap allocations during the ack (needs CONFIG_HEAP_USE_HOOKS)
+struct AckTiming {
+    uint32_t count;
+    uint32_t totalUs;
+    uint32_t maxUs;
+    uint32_t allocs;
+    uint32_t heapBytes;
+    uint32_t maxHeapBytes;
+};
+static AckTiming g_ackTiming[2];
+
+// Delta sync (one rebuild at a time)
+static DeltaSession g_delta;
+
+// Shared buffer pool: every session draws from one global budget
+static size_t g_poolUsed = 0;
+
+// Decompressor + its dictionary; the dictionary doubles as the output ring
+struct FileInflater {
+    tinfl_decompressor decomp;
+    uint8_t dict[FileConfig::INFLATE_DICT_SIZE];
+    size_t dictOffset;
+    uint32_t flags;
+    tinfl_status status;
+    bool inPsram;
+};
+
+// Writer task: drains filled buffers while reception fills the next one
+struct FileWriteJob {
+    FileSession *session;
+    uint8_t index;      // Buffer index, or one of the WRITE_JOB_* markers
+    size_t length;
+    bool sendAck;
+    uint8_t *frame;     // WRITE_JOB_DELTA: copy of a file_delta_ops frame (freed by the writer)
+};
+
+static const uint8_t WRITE_JOB_DRAIN = 0xFF;
+static const uint8_t WRITE_JOB_DELTA = 0xFE;
+static const uint8_t WRITE_JOB_DELTA_DRAIN = 0xFD;
+
+static TaskHandle_t g_writerTask = NULL;
+static QueueHandle_t g_writeQueue = NULL;
 
 // ═══════════════════════════════════════════════════════
 // CRC32 IMPLEMENTATION
@@ -28,14 +83,38 @@ uint32_t CRC32::finalize() const {
     return crc_value;
 }
 
+void CRC32::seed(uint32_t value) {
+    crc_value = value;
+}
+
 // ═══════════════════════════════════════════════════════
 // FILE SESSION IMPLEMENTATION
 // ═══════════════════════════════════════════════════════
 
 FileSession::FileSession()
-    : isOpen(false), buffer(staticBuffer), usingDynamicBuffer(false),
-      bufferPos(0), writtenSize(0), bufferSize(FileConfig::STATIC_BUFFER_SIZE),
-      lastChunkCrc(0), totalFlushTime(0), flushCount(0), timingActive(false) {}
+    : id(0), isOpen(false), writtenSize(0), buffer(nullptr), fillIndex(0),
+      bufferPos(0), bufferSize(0), writeError(false), freeBuffers(NULL), drainDone(NULL),
+      lastChunkCrc(0), resumable(false), checkpointOffset(0), checkpoints(0),
+      compression(COMPRESSION_NONE), inflater(nullptr), compressedTotal(0),
+      compressedSize(0), inflateUs(0), seeked(false),
+      totalFlushTime(0), flushCount(0), timingActive(false),
+      writerBusyUs(0), receiveStallUs(0),
+      windowBuffer(nullptr), chunksSinceAck(0), chunksReceived(0),
+      chunksDuplicate(0), chunksDropped(0), chunkAcks(0) {
+    window.reset(0, FileConfig::DEFAULT_WINDOW_CHUNK, 0);
+    for (size_t i = 0; i < FileConfig::WRITE_BUFFERS; i++) {
+        buffers[i] = nullptr;
+    }
+}
+
+DeltaSession::DeltaSession()
+    : active(false), blockSize(DeltaSync::DEFAULT_BLOCK_SIZE), baseSize(0), copyBuffer(nullptr),
+      freeFrames(NULL), drainDone(NULL), expectedSize(0), expectedCrc(0), written(0), copiedBytes(0), literalBytes(0),
+      ops(0), frames(0), error(false), startTime(0) {}
+
+FileStream::FileStream()
+    : id(0), active(false), offset(0), startOffset(0), size(0),
+      chunkSize(FileConfig::STREAM_CHUNK_SIZE), credits(0), frames(0), startTime(0) {}
 
 // ═══════════════════════════════════════════════════════
 // UTILITIES
@@ -50,405 +129,1758 @@ static String sanitizePath(const String &path) {
     return clean;
 }
 
-static bool allocateBuffer(size_t requestedSize) {
-    // If requesting <= 4KB, use static buffer
-    if (requestedSize <= FileConfig::STATIC_BUFFER_SIZE) {
-        if (g_fileSession.usingDynamicBuffer && g_fileSession.buffer != g_fileSession.staticBuffer) {
-            delete[] g_fileSession.buffer;
-        }
-        g_fileSession.buffer = g_fileSession.staticBuffer;
-        g_fileSession.bufferSize = FileConfig::STATIC_BUFFER_SIZE;
-        g_fileSession.usingDynamicBuffer = false;
+// Move a finished temp file over its target
+static bool replaceFile(const String &from, const String &to) {
+    if (FILESYSTEM.rename(from, to)) {
         return true;
     }
+    // SPIFFS cannot rename over an existing file
+    FILESYSTEM.remove(to);
+    return FILESYSTEM.rename(from, to);
+}
+
+// True while an upload, stream or delta rebuild holds the file;
+// file_create passes ignoreUploads since it takes over stale uploads itself,
+// file_stream passes ignoreStreams since readers can share a file
+static bool isFileBusy(const String &filename, bool ignoreUploads = false, bool ignoreStreams = false) {
+    for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+        if ((!ignoreUploads && g_sessions[i].isOpen && g_sessions[i].filename == filename) ||
+            (!ignoreStreams && g_streams[i].active && g_streams[i].filename == filename)) {
+            return true;
+        }
+    }
+    return g_delta.active && g_delta.filename == filename;
+}
+
+// Resumable uploads write to a temp file next to a checkpoint sidecar
+static String partPath(const String &filename) {
+    return filename + ".part";
+}
+
+static String checkpointPath(const String &filename) {
+    return filename + ".ckpt";
+}
+
+static bool readCheckpoint(const String &filename, FileCheckpoint &ckpt) {
+    File file = FILESYSTEM.open(checkpointPath(filename), FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    size_t bytesRead = file.read((uint8_t*)&ckpt, sizeof(ckpt));
+    file.close();
+
+    // Reject torn or foreign sidecars
+    return bytesRead == sizeof(ckpt) &&
+           ckpt.magic == FileConfig::CHECKPOINT_MAGIC &&
+           ckpt.version == FileConfig::CHECKPOINT_VERSION &&
+           ckpt.check == crc32_le(0, (const uint8_t*)&ckpt, offsetof(FileCheckpoint, check));
+}
+
+// Check that the first ckpt.offset bytes of the .part are the ones the
+// checkpoint covers, and drop anything written past them. There is no
+// truncate on Arduino FS, so a longer .part is rebuilt from its prefix.
+static bool verifyPartPrefix(const String &filename, const FileCheckpoint &ckpt) {
+    String path = partPath(filename);
+    File part = FILESYSTEM.open(path, FILE_READ);
+    if (!part || part.size() < ckpt.offset) {
+        part.close();
+        return false;
+    }
+
+    String trimPath = path + ".tmp";
+    bool trim = part.size() > ckpt.offset;
+    File trimmed;
+    if (trim) {
+        trimmed = FILESYSTEM.open(trimPath, FILE_WRITE);
+        if (!trimmed) {
+            part.close();
+            return false;
+        }
+    }
+
+    uint8_t buffer[512];
+    CRC32 crc;
+    uint32_t remaining = ckpt.offset;
+    bool ok = true;
+    while (ok && remaining > 0) {
+        size_t want = remaining < sizeof(buffer) ? remaining : sizeof(buffer);
+        size_t bytesRead = part.read(buffer, want);
+        ok = bytesRead == want && (!trim || trimmed.write(buffer, bytesRead) == bytesRead);
+        crc.update(buffer, bytesRead);
+        remaining -= bytesRead;
+    }
+    part.close();
+    ok = ok && crc.finalize() == ckpt.crc;
+
+    if (trim) {
+        trimmed.close();
+        if (ok) {
+            ok = replaceFile(trimPath, path);
+        }
+        if (!ok) {
+            FILESYSTEM.remove(trimPath);
+        }
+    }
+    return ok;
+}
+
+// Persist the committed offset (writer task, after the data itself is on flash)
+static void writeCheckpoint(FileSession &s) {
+    s.file.flush();
+
+    FileCheckpoint ckpt = {};
+    ckpt.magic = FileConfig::CHECKPOINT_MAGIC;
+    ckpt.version = FileConfig::CHECKPOINT_VERSION;
+    ckpt.offset = s.writtenSize;
+    ckpt.crc = s.writtenCrc.finalize();
+    ckpt.total = s.totalSize;
+    ckpt.check = crc32_le(0, (const uint8_t*)&ckpt, offsetof(FileCheckpoint, check));
+
+    File file = FILESYSTEM.open(checkpointPath(s.filename), FILE_WRITE);
+    if (!file || file.write((const uint8_t*)&ckpt, sizeof(ckpt)) != sizeof(ckpt)) {
+        LOG_ERROR("FILE", "Checkpoint write failed: %s", s.filename.c_str());
+    } else {
+        s.checkpointOffset = s.writtenSize;
+        s.checkpoints++;
+    }
+    file.close();
+}
+
+// Allocate from the shared pool (PSRAM first), never exceeding the global cap
+static uint8_t *poolAlloc(size_t size) {
+    if (g_poolUsed + size > FileConfig::BUFFER_POOL_CAP) {
+        return nullptr;
+    }
+
+    uint8_t *ptr = nullptr;
+
+    // Try PSRAM first if available
+    if (ESP.getPsramSize() > 0 && ESP.getFreePsram() >= size) {
+        ptr = (uint8_t *)ps_malloc(size);
+    }
+
+    // Fallback to heap
+    if (!ptr) {
+        ptr = (uint8_t *)malloc(size);
+    }
+
+    if (ptr) {
+        g_poolUsed += size;
+    }
+    return ptr;
+}
+
+static void poolFree(uint8_t *ptr, size_t size) {
+    if (ptr) {
+        free(ptr);
+        g_poolUsed -= size;
+    }
+}
+
+static void freeBuffer(FileSession &s) {
+    for (size_t i = 0; i < FileConfig::WRITE_BUFFERS; i++) {
+        poolFree(s.buffers[i], s.bufferSize);
+        s.buffers[i] = nullptr;
+    }
+    s.buffer = nullptr;
+    s.bufferSize = 0;
+}
+
+// Allocate the ping-pong buffers (all the same size)
+// Shrinks the request to what the pool has left so parallel sessions share memory
+static bool allocateBuffer(FileSession &s, size_t requestedSize) {
+    freeBuffer(s);
+
+    size_t available = (FileConfig::BUFFER_POOL_CAP - g_poolUsed) / FileConfig::WRITE_BUFFERS;
+    size_t allocSize = min(min(requestedSize, FileConfig::MAX_DYNAMIC_BUFFER), available);
+    allocSize &= ~(size_t)255;
+
+    if (allocSize < FileConfig::MIN_BUFFER_SIZE) {
+        LOG_ERROR("FILE", "Buffer pool exhausted (%u / %u bytes used)", g_poolUsed, FileConfig::BUFFER_POOL_CAP);
+        return false;
+    }
+
+    for (size_t i = 0; i < FileConfig::WRITE_BUFFERS; i++) {
+        s.buffers[i] = poolAlloc(allocSize);
+
+        if (!s.buffers[i]) {
+            LOG_ERROR("FILE", "Buffer allocation failed (%u bytes)", allocSize);
+            for (size_t j = 0; j < i; j++) {
+                poolFree(s.buffers[j], allocSize);
+                s.buffers[j] = nullptr;
+            }
+            return false;
+        }
+    }
+
+    s.fillIndex = 0;
+    s.buffer = s.buffers[0];
+    s.bufferSize = allocSize;
+
+    LOG_DEBUG("FILE", "Session %u: %u x %u bytes (pool %u / %u)", s.id, FileConfig::WRITE_BUFFERS,
+              allocSize, g_poolUsed, FileConfig::BUFFER_POOL_CAP);
+    return true;
+}
+
+static bool allocateWindow(FileSession &s, size_t slots, size_t chunkSize) {
+    size_t allocSize = slots * chunkSize;
+    uint8_t *window = poolAlloc(allocSize);
+
+    if (!window) {
+        LOG_ERROR("FILE", "Window allocation failed (%u bytes)", allocSize);
+        return false;
+    }
+
+    s.windowBuffer = window;
+    s.window.reset(slots, chunkSize, 0);
+    s.chunksSinceAck = 0;
+    s.chunksReceived = 0;
+    s.chunksDuplicate = 0;
+    s.chunksDropped = 0;
+    s.chunkAcks = 0;
+
+    LOG_DEBUG("FILE", "Window: %u slots x %u bytes", slots, chunkSize);
+    return true;
+}
+
+static void freeWindow(FileSession &s) {
+    if (s.windowBuffer) {
+        poolFree(s.windowBuffer, s.window.slots * s.window.chunkSize);
+        s.windowBuffer = nullptr;
+    }
+    s.window.slots = 0;
+}
+
+// The inflater lives outside the buffer pool (43KB, PSRAM first)
+static bool allocateInflater(FileSession &s, FileCompression compression) {
+    FileInflater *inf = nullptr;
+    bool inPsram = false;
+
+    if (ESP.getPsramSize() > 0 && ESP.getFreePsram() >= sizeof(FileInflater)) {
+        inf = (FileInflater *)ps_malloc(sizeof(FileInflater));
+        inPsram = inf != nullptr;
+    }
+    if (!inf) {
+        inf = (FileInflater *)malloc(sizeof(FileInflater));
+    }
+    if (!inf) {
+        LOG_ERROR("FILE", "Inflater allocation failed (%u bytes)", sizeof(FileInflater));
+        return false;
+    }
+
+    tinfl_init(&inf->decomp);
+    inf->dictOffset = 0;
+    inf->flags = TINFL_FLAG_HAS_MORE_INPUT;
+    if (compression == COMPRESSION_ZLIB) {
+        inf->flags |= TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32;
+    }
+    inf->status = TINFL_STATUS_NEEDS_MORE_INPUT;
+    inf->inPsram = inPsram;
+
+    s.inflater = inf;
+    s.compression = compression;
+    return true;
+}
+
+static void freeInflater(FileSession &s) {
+    free(s.inflater);
+    s.inflater = nullptr;
+    s.compression = COMPRESSION_NONE;
+}
+
+// Inflate one received buffer into the file (runs on the writer task).
+// Returns plain bytes written; a corrupt stream sets inflater->status < 0.
+static size_t inflateBuffer(FileSession &s, const uint8_t *data, size_t length) {
+    FileInflater &inf = *s.inflater;
+    unsigned long start = micros();
+    size_t produced = 0;
+
+    while (inf.status > TINFL_STATUS_DONE) {
+        size_t inBytes = length;
+        size_t outBytes = FileConfig::INFLATE_DICT_SIZE - inf.dictOffset;
+
+        inf.status = tinfl_decompress(&inf.decomp, data, &inBytes, inf.dict,
+                                      inf.dict + inf.dictOffset, &outBytes, inf.flags);
+        data += inBytes;
+        length -= inBytes;
+
+        if (outBytes > 0) {
+            if (s.file.write(inf.dict + inf.dictOffset, outBytes) != outBytes) {
+                inf.status = TINFL_STATUS_FAILED;
+                break;
+            }
+            produced += outBytes;
+            inf.dictOffset = (inf.dictOffset + outBytes) & (FileConfig::INFLATE_DICT_SIZE - 1);
+        }
+
+        // Out of input: wait for the next buffer
+        if (inf.status == TINFL_STATUS_NEEDS_MORE_INPUT && length == 0) {
+            break;
+        }
+    }
+
+    s.inflateUs += micros() - start;
+    return produced;
+}
+
+// ═══════════════════════════════════════════════════════
+// CONTROL RECORDS
+// ═══════════════════════════════════════════════════════
+
+// Allocations made by any task while an ack is in flight (acks are only
+// sent from the writer task, so one counter is enough)
+static volatile bool g_countAllocs = false;
+static volatile uint32_t g_ackAllocs = 0;
+
+#if CONFIG_HEAP_USE_HOOKS
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    if (g_countAllocs) {
+        g_ackAllocs++;
+    }
+}
+#endif
+
+struct AckProbe {
+    unsigned long start;
+    size_t freeBefore;
+    size_t freeLowest;
+};
+
+static void ackProbeStart(AckProbe &probe) {
+    g_ackAllocs = 0;
+    g_countAllocs = true;
+    probe.freeBefore = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    probe.freeLowest = probe.freeBefore;
+    probe.start = micros();
+}
+
+// Called where the ack holds the most memory: built and serialized, not yet sent
+static void ackProbePeak(AckProbe &probe) {
+    probe.freeLowest = min(probe.freeLowest, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+static void recordAck(bool json, const AckProbe &probe) {
+    uint32_t elapsed = micros() - probe.start;
+    g_countAllocs = false;
+    uint32_t heapBytes = probe.freeBefore - probe.freeLowest;
+
+    AckTiming &t = g_ackTiming[json ? 1 : 0];
+    t.count++;
+    t.totalUs += elapsed;
+    t.maxUs = max(t.maxUs, elapsed);
+    t.allocs += g_ackAllocs;
+    t.heapBytes += heapBytes;
+    t.maxHeapBytes = max(t.maxHeapBytes, heapBytes);
+}
+
+// Error reply: FileErrorRecord, or {"status": "error"} in JSON mode
+static void sendError(const char *event, FileStatus status, int sessionId, const char *message) {
+    if (g_jsonControl) {
+        DynamicJsonDocument response(256);
+        response["status"] = "error";
+        response["message"] = message;
+        response["session"] = sessionId;
+        String responseStr;
+        serializeJson(response, responseStr);
+        event_msg_send(event, (const uint8_t*)responseStr.c_str(), responseStr.length());
+        return;
+    }
+
+    uint8_t record[sizeof(FileErrorRecord) + FileConfig::MAX_ERROR_MESSAGE];
+    FileErrorRecord header;
+    header.version = FileConfig::CONTROL_VERSION;
+    header.status = status;
+    header.session = sessionId;
+    header.length = min(strlen(message), FileConfig::MAX_ERROR_MESSAGE);
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), message, header.length);
+    event_msg_send(event, record, sizeof(header) + header.length);
+}
+
+static void sendAppendAck(FileSession &s, FileStatus status, size_t bytes, uint32_t crc) {
+    AckProbe probe;
+    ackProbeStart(probe);
+    bool json = g_jsonControl;
+
+    if (status != FILE_STATUS_OK) {
+        sendError("file_append_ack", status, s.id,
+                  status == FILE_STATUS_DECOMPRESS_ERROR ? "Decompression failed" : "Flush failed");
+    } else if (json) {
+        DynamicJsonDocument ack(256);
+        ack["status"] = "ack";
+        ack["session"] = s.id;
+        ack["bytes"] = bytes;
+        ack["crc"] = crc;
+        ack["total"] = s.writtenSize;
+        ack["timestamp"] = millis();
+        if (s.inflater) {
+            ack["received"] = s.compressedSize;
+        }
+
+        String ackStr;
+        serializeJson(ack, ackStr);
+        ackProbePeak(probe);
+        event_msg_send("file_append_ack", (const uint8_t*)ackStr.c_str(), ackStr.length());
+    } else {
+        FileAppendAck ack;
+        ack.version = FileConfig::CONTROL_VERSION;
+        ack.status = status;
+        ack.session = s.id;
+        ack.reserved = 0;
+        ack.bytes = bytes;
+        ack.crc = crc;
+        ack.total = s.writtenSize;
+        ack.received = s.compressedSize;
+        ack.timestamp = millis();
+        ackProbePeak(probe);
+        event_msg_send("file_append_ack", (const uint8_t*)&ack, sizeof(ack));
+    }
+
+    recordAck(json, probe);
+}
+
+// Write one filled buffer to the file (runs on the writer task)
+static void writeBuffer(const FileWriteJob &job) {
+    FileSession &s = *job.session;
+    const uint8_t *data = s.buffers[job.index];
+
+    unsigned long flushStart = millis();
+    unsigned long busyStart = micros();
+
+    // Calculate CRC for this chunk
+    s.crc.reset();
+    s.crc.update(data, job.length);
+    uint32_t chunkCrc = s.crc.finalize();
+
+    // Write to file (compressed sessions inflate first)
+    size_t written;
+    bool ok;
+    if (s.inflater) {
+        written = inflateBuffer(s, data, job.length);
+        ok = s.inflater->status >= TINFL_STATUS_DONE;
+        s.compressedSize += job.length;
+    } else {
+        written = s.file.write(data, job.length);
+        ok = written == job.length;
+    }
+
+    unsigned long flushEnd = millis();
+    unsigned long flushDuration = flushEnd - flushStart;
+    s.writerBusyUs += micros() - busyStart;
+
+    if (!ok) {
+        LOG_ERROR("FILE", "Buffer flush failed: %u/%u bytes", written, job.length);
+        s.writeError = true;
+
+        if (job.sendAck) {
+            sendAppendAck(s, s.inflater ? FILE_STATUS_DECOMPRESS_ERROR : FILE_STATUS_WRITE_ERROR,
+                          job.length, chunkCrc);
+        }
+        return;
+    }
+
+    s.writtenSize += written;
+    s.lastChunkCrc = chunkCrc;
+    if (s.resumable) {
+        s.writtenCrc.update(data, written);
+        if (s.writtenSize - s.checkpointOffset >= FileConfig::CHECKPOINT_INTERVAL) {
+            writeCheckpoint(s);
+        }
+    }
+    s.totalFlushTime += flushDuration;
+    s.flushCount++;
+    s.lastFlushTime = flushEnd;
+
+    // bytes and crc describe the buffer as the client sent it, which for
+    // compressed sessions is not what reached the file
+    if (job.sendAck) {
+        sendAppendAck(s, FILE_STATUS_OK, job.length, chunkCrc);
+    }
+
+    // Log performance
+    if (flushDuration > 0) {
+        LOG_DEBUG("FILE", "Flush: %u bytes in %lu ms (%u bytes/ms), CRC: 0x%08X",
+                  written, flushDuration, written / flushDuration, chunkCrc);
+    }
+}
+
+static void applyDeltaFrame(const uint8_t *data, size_t size);
+
+static void fileWriterTask(void *parameter) {
+    (void)parameter;
+    FileWriteJob job;
+
+    while (true) {
+        if (xQueueReceive(g_writeQueue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        if (job.index == WRITE_JOB_DRAIN) {
+            // Every job queued before this one is on flash
+            FileSession &s = *job.session;
+            if (s.resumable && !s.writeError && s.writtenSize != s.checkpointOffset) {
+                writeCheckpoint(s);
+            }
+            xSemaphoreGive(job.session->drainDone);
+            continue;
+        }
+        if (job.index == WRITE_JOB_DELTA) {
+            applyDeltaFrame(job.frame, job.length);
+            free(job.frame);
+            xSemaphoreGive(g_delta.freeFrames);
+            continue;
+        }
+        if (job.index == WRITE_JOB_DELTA_DRAIN) {
+            xSemaphoreGive(g_delta.drainDone);
+            continue;
+        }
+
+        writeBuffer(job);
+        xSemaphoreGive(job.session->freeBuffers);
+    }
+}
+
+// Hand the current buffer to the writer task and switch to the next one
+static bool flushBuffer(FileSession &s, bool sendAck) {
+    if (s.writeError) {
+        return false; // Earlier write failed
+    }
+
+    if (s.bufferPos == 0) {
+        return true; // Nothing to flush
+    }
+
+    FileWriteJob job = { &s, s.fillIndex, s.bufferPos, sendAck, nullptr };
+    xQueueSend(g_writeQueue, &job, portMAX_DELAY);
+
+    // Blocks only while the writer still owns the next buffer
+    unsigned long waitStart = micros();
+    xSemaphoreTake(s.freeBuffers, portMAX_DELAY);
+    s.receiveStallUs += micros() - waitStart;
+
+    s.fillIndex = (s.fillIndex + 1) % FileConfig::WRITE_BUFFERS;
+    s.buffer = s.buffers[s.fillIndex];
+    s.bufferPos = 0;
+    return true;
+}
+
+// Wait until the writer task has finished every queued buffer
+static bool drainWriter(FileSession &s) {
+    FileWriteJob job = { &s, WRITE_JOB_DRAIN, 0, false, nullptr };
+    xQueueSend(g_writeQueue, &job, portMAX_DELAY);
+    xSemaphoreTake(s.drainDone, portMAX_DELAY);
+    return !s.writeError;
+}
+
+// Copy bytes into the write buffer, flushing whenever it fills up
+static bool appendToBuffer(FileSession &s, const uint8_t *dataPtr, size_t remaining, bool sendAck) {
+    s.fileCrc.update(dataPtr, remaining);
+
+    while (remaining > 0) {
+        size_t spaceInBuffer = s.bufferSize - s.bufferPos;
+        size_t toWrite = min(remaining, spaceInBuffer);
+
+        // Copy to buffer
+        memcpy(s.buffer + s.bufferPos, dataPtr, toWrite);
+        s.bufferPos += toWrite;
+        dataPtr += toWrite;
+        remaining -= toWrite;
+
+        // Auto-flush if buffer is full
+        if (s.bufferPos >= s.bufferSize) {
+            if (!flushBuffer(s, sendAck)) {
+                return false; // Flush failed
+            }
+        }
+    }
+    return true;
+}
+
+static void sendChunkAck(FileSession &s, FileChunkStatus status) {
+    FileChunkAck ack;
+    ack.version = FileConfig::CHUNK_ACK_VERSION;
+    ack.status = status;
+    ack.window = s.window.slots;
+    ack.session = s.id;
+    ack.base = s.window.base;
+    ack.bitmap = s.window.bitmap;
+    ack.crc = s.fileCrc.finalize();
+
+    event_msg_send("file_chunk_ack", (const uint8_t*)&ack, sizeof(ack));
+
+    s.chunkAcks++;
+    s.chunksSinceAck = 0;
+}
+
+// Move the contiguous run of received chunks at the window base into the file buffer
+static bool commitWindow(FileSession &s) {
+    while (s.window.ready()) {
+        const uint8_t *chunk = s.windowBuffer + s.window.headSlot() * s.window.chunkSize;
+        if (!appendToBuffer(s, chunk, s.window.headLength(), false)) {
+            return false;
+        }
+        s.window.advance();
+    }
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════
+// EVENT HANDLERS
+// ═══════════════════════════════════════════════════════
+
+static void handleFileInit(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(128);
+    if (!deserializeJson(doc, (const char*)data.data(), data.size())) {
+        String format = doc["format"] | "binary";
+        g_jsonControl = format == "json";
+    }
+
+    DynamicJsonDocument response(512);
+    response["status"] = "success";
+    response["format"] = g_jsonControl ? "json" : "binary";
+    response["control_version"] = FileConfig::CONTROL_VERSION;
+    response["filesystem"] = FS_NAME;
+    response["total_bytes"] = FILESYSTEM.totalBytes();
+    response["used_bytes"] = FILESYSTEM.usedBytes();
+    response["free_bytes"] = FILESYSTEM.totalBytes() - FILESYSTEM.usedBytes();
+
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_init_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+}
+
+// Resolve a session ID (requests without one address session 0)
+static FileSession *findSession(int id) {
+    if (id < 0 || id >= (int)FileConfig::MAX_SESSIONS) {
+        return nullptr;
+    }
+    return &g_sessions[id];
+}
+
+static FileSession *findOpenSession(int id) {
+    FileSession *s = findSession(id);
+    return (s && s->isOpen) ? s : nullptr;
+}
+
+static void closeSession(FileSession &s) {
+    if (s.isOpen && s.file) {
+        flushBuffer(s, false);
+        drainWriter(s);
+        s.file.close();
+
+        // fileCrc covers the received bytes, which are the file's bytes
+        // unless they were inflated or written out of order
+        if (s.resumable) {
+            // Tracked once the .part is renamed into place
+        } else if (s.inflater || s.seeked) {
+            file_manifest_refresh(s.filename);
+        } else {
+            file_manifest_update(s.filename, s.writtenSize, s.fileCrc.finalize());
+        }
+    }
+    freeBuffer(s);
+    freeWindow(s);
+    freeInflater(s);
+    s.isOpen = false;
+    s.timingActive = false;
+}
+
+static void handleFileCreate(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
+
+    DynamicJsonDocument response(512);
+
+    if (error) {
+        response["status"] = "error";
+        response["message"] = "Invalid JSON";
+        String responseStr;
+        serializeJson(response, responseStr);
+        event_msg_send("file_create_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+        return;
+    }
+
+    // "session": -1 asks the device to pick a free slot; only a slot the
+    // client names may be taken over while open
+    bool namedSession = doc["session"].is<int>();
+    int sessionId = doc["session"] | 0;
+    if (sessionId < 0) {
+        namedSession = false;
+        for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+            if (!g_sessions[i].isOpen) {
+                sessionId = i;
+                break;
+            }
+        }
+    }
+
+    String filename = doc["filename"].as<String>();
+    size_t expectedSize = doc["size"] | 0;
+    size_t bufferSize = doc["buffer_size"] | FileConfig::DEFAULT_BUFFER_SIZE;
+    size_t windowSlots = doc["window"] | 0;
+    size_t chunkSize = doc["chunk_size"] | FileConfig::DEFAULT_WINDOW_CHUNK;
+    bool resume = doc["resume"] | false;
+    bool resumable = resume || (doc["resumable"] | false);
+    String compressionName = doc["compression"] | "none";
+    FileCompression compression = compressionName == "deflate" ? COMPRESSION_DEFLATE :
+                                  compressionName == "zlib" ? COMPRESSION_ZLIB : COMPRESSION_NONE;
+
+    // Clamp window to bitmap width and reorder buffer budget
+    chunkSize = constrain(chunkSize, (size_t)1, FileConfig::MAX_WINDOW_CHUNK);
+    windowSlots = min(windowSlots, (size_t)FileConfig::MAX_WINDOW_SLOTS);
+    windowSlots = min(windowSlots, FileConfig::MAX_WINDOW_BYTES / chunkSize);
+
+    FileSession *session = findSession(sessionId);
+    if (!filename.isEmpty()) {
+        filename = sanitizePath(filename);
+    }
+
+    if (!session) {
+        response["status"] = "error";
+        response["message"] = "No free session";
+    } else if (session->isOpen && !namedSession && session->filename != filename) {
+        response["status"] = "error";
+        response["message"] = "Session busy";
+    } else if (filename.isEmpty()) {
+        response["status"] = "error";
+        response["message"] = "No filename";
+    } else if (compression == COMPRESSION_NONE && compressionName != "none") {
+        response["status"] = "error";
+        response["message"] = "Unsupported compression";
+    } else if (compression != COMPRESSION_NONE && resumable) {
+        // Decompressor state is not part of the checkpoint
+        response["status"] = "error";
+        response["message"] = "Compressed upload cannot be resumable";
+    } else if (resumable && expectedSize == 0) {
+        // The .part file cannot be truncated, so its final length must be known
+        response["status"] = "error";
+        response["message"] = "Resumable upload needs size";
+    } else if (isFileBusy(filename, true)) {
+        // Streamed out or the base of a delta rebuild
+        response["status"] = "error";
+        response["message"] = "File is open";
+    } else {
+        FileSession &s = *session;
+
+        // Close existing session in this slot, and any other still writing
+        // this file (left open by a dropped connection) - drains its checkpoint
+        closeSession(s);
+        for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+            if (g_sessions[i].isOpen && g_sessions[i].filename == filename) {
+                closeSession(g_sessions[i]);
+            }
+        }
+
+        s.filename = filename;
+        s.totalSize = expectedSize;
+        s.writtenSize = 0;
+        s.bufferPos = 0;
+        s.fileCrc.reset();
+        s.writeError = false;
+        s.writerBusyUs = 0;
+        s.receiveStallUs = 0;
+        s.resumable = resumable;
+        s.writtenCrc.reset();
+        s.checkpointOffset = 0;
+        s.checkpoints = 0;
+        s.compressedTotal = doc["compressed_size"] | 0;
+        s.compressedSize = 0;
+        s.inflateUs = 0;
+        s.seeked = false;
+
+        // Pick up where a previous upload of the same file stopped
+        FileCheckpoint ckpt;
+        uint32_t resumeOffset = 0;
+        if (resume && readCheckpoint(s.filename, ckpt) && ckpt.total == expectedSize) {
+            if (verifyPartPrefix(s.filename, ckpt)) {
+                resumeOffset = ckpt.offset;
+                s.writtenSize = ckpt.offset;
+                s.fileCrc.seed(ckpt.crc);
+                s.writtenCrc.seed(ckpt.crc);
+                s.checkpointOffset = ckpt.offset;
+            } else {
+                LOG_ERROR("FILE", "%s does not match its checkpoint, restarting upload",
+                          partPath(s.filename).c_str());
+            }
+        }
+
+        // Allocate buffers from the shared pool
+        bool allocated = allocateBuffer(s, bufferSize);
+        if (allocated && compression != COMPRESSION_NONE) {
+            allocated = allocateInflater(s, compression);
+        }
+
+        // Allocate reorder window for file_chunk uploads
+        if (allocated && windowSlots > 0 && allocateWindow(s, windowSlots, chunkSize)) {
+            s.window.base = resumeOffset;
+            s.window.end = s.inflater ? s.compressedTotal : s.totalSize;
+        }
+
+        // Open file ("r+" keeps the committed prefix of a resumed .part)
+        if (allocated && resumeOffset > 0) {
+            s.file = FILESYSTEM.open(partPath(s.filename), "r+");
+            if (s.file && !s.file.seek(resumeOffset)) {
+                s.file.close();
+            }
+        } else if (allocated) {
+            s.file = FILESYSTEM.open(resumable ? partPath(s.filename) : s.filename, FILE_WRITE);
+        }
+
+        if (allocated && s.file) {
+            s.isOpen = true;
+            s.startTime = millis();
+            s.timingActive = true;
+            s.totalFlushTime = 0;
+            s.flushCount = 0;
+
+            response["status"] = "success";
+            response["session"] = s.id;
+            response["filename"] = s.filename;
+            response["buffer_size"] = s.bufferSize;
+            response["expected_size"] = s.totalSize;
+            response["window"] = s.window.slots;
+            response["chunk_size"] = s.window.chunkSize;
+            if (s.inflater) {
+                response["compression"] = compressionName;
+                response["inflate_ram"] = sizeof(FileInflater);
+            }
+            if (s.resumable) {
+                response["resumable"] = true;
+                response["offset"] = resumeOffset;
+                response["crc"] = s.fileCrc.finalize();
+            }
+
+            LOG_INFO("FILE", "Created file: %s (%u bytes expected, session %u)",
+                     s.filename.c_str(), s.totalSize, s.id);
+            if (resumeOffset > 0) {
+                LOG_INFO("FILE", "Resuming at %u bytes", resumeOffset);
+            }
+        } else {
+            response["status"] = "error";
+            response["message"] = allocated ? "Failed to create file" : "Out of buffer memory";
+            closeSession(s);
+            LOG_ERROR("FILE", "Failed to create file: %s", s.filename.c_str());
+        }
+    }
+
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_create_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+}
+
+static void sendNoFileOpen(const char *event, int sessionId) {
+    sendError(event, FILE_STATUS_NO_SESSION, sessionId, "No file open");
+}
+
+// Legacy append: raw bytes to session 0
+static void handleFileAppend(const std::vector<uint8_t> &data) {
+    FileSession *s = findOpenSession(0);
+    if (!s || !s->file) {
+        sendNoFileOpen("file_append_ack", 0);
+        return;
+    }
+
+    appendToBuffer(*s, data.data(), data.size(), true);
+}
+
+// Append to any session: [session u8][payload]
+static void handleFileWrite(const std::vector<uint8_t> &data) {
+    if (data.empty()) {
+        return;
+    }
+
+    FileSession *s = findOpenSession(data[0]);
+    if (!s || !s->file) {
+        sendNoFileOpen("file_append_ack", data[0]);
+        return;
+    }
+
+    appendToBuffer(*s, data.data() + 1, data.size() - 1, true);
+}
+
+static void handleFileChunk(const std::vector<uint8_t> &data) {
+    // Chunk layout: [session u8][offset u32 LE][payload]
+    if (data.size() <= 5) {
+        return;
+    }
+
+    FileSession *session = findOpenSession(data[0]);
+    if (!session || !session->file || session->window.slots == 0) {
+        FileChunkAck ack = {};
+        ack.version = FileConfig::CHUNK_ACK_VERSION;
+        ack.status = CHUNK_NO_SESSION;
+        ack.session = data[0];
+        event_msg_send("file_chunk_ack", (const uint8_t*)&ack, sizeof(ack));
+        return;
+    }
+
+    FileSession &s = *session;
+    uint32_t offset = (uint32_t)data[1] | ((uint32_t)data[2] << 8) |
+                      ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 24);
+    size_t len = data.size() - 5;
+    bool ackNow = false;
+
+    s.chunksReceived++;
+    s.chunksSinceAck++;
+
+    size_t slot = 0;
+    ChunkPlacement placement = s.window.place(offset, len, &slot);
+
+    if (placement == CHUNK_COMMITTED) {
+        // Already committed - our ack was probably lost
+        s.chunksDuplicate++;
+        ackNow = true;
+    } else if (placement == CHUNK_REJECTED) {
+        // Misaligned, oversized or beyond the window
+        s.chunksDropped++;
+        ackNow = true;
+    } else {
+        if (placement == CHUNK_DUPLICATE) {
+            s.chunksDuplicate++;
+        } else {
+            memcpy(s.windowBuffer + slot * s.window.chunkSize, data.data() + 5, len);
+        }
+
+        if (!commitWindow(s)) {
+            sendChunkAck(s, CHUNK_WRITE_ERROR);
+            return;
+        }
+
+        // Ack at once when the window is blocked on a missing chunk
+        if (s.window.blocked()) {
+            ackNow = true;
+        }
+    }
+
+    // Ack every half window so the host never drains its credit
+    size_t ackInterval = max((size_t)1, (size_t)s.window.slots / 2);
+    size_t wireTotal = s.inflater ? s.compressedTotal : s.totalSize;
+    bool complete = wireTotal > 0 && s.window.base >= wireTotal;
+
+    if (ackNow || complete || s.chunksSinceAck >= ackInterval) {
+        sendChunkAck(s, CHUNK_OK);
+    }
+}
+
+static void handleFileFlush(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(128);
+    deserializeJson(doc, (const char*)data.data(), data.size());
+
+    int sessionId = doc["session"] | 0;
+    FileSession *session = findOpenSession(sessionId);
+
+    if (!session) {
+        sendNoFileOpen("file_flush_response", sessionId);
+        return;
+    }
+
+    FileSession &s = *session;
+    flushBuffer(s, true);
+
+    if (s.window.slots > 0) {
+        // Ack only once the committed bytes are on flash
+        sendChunkAck(s, drainWriter(s) ? CHUNK_OK : CHUNK_WRITE_ERROR);
+    }
+}
+
+static void handleFileSeek(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(256);
+    DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
+
+    DynamicJsonDocument response(256);
+    int sessionId = error ? 0 : (doc["session"] | 0);
+    FileSession *session = findOpenSession(sessionId);
+    response["session"] = sessionId;
+
+    if (!session) {
+        response["status"] = "error";
+        response["message"] = "No file open";
+    } else if (error) {
+        response["status"] = "error";
+        response["message"] = "Invalid JSON";
+    } else if (session->resumable || session->inflater) {
+        // The checkpoint / deflate stream only describe a contiguous prefix
+        response["status"] = "error";
+        response["message"] = "Seek not supported on this upload";
+    } else {
+        FileSession &s = *session;
+        size_t position = doc["position"] | 0;
+
+        // Flush buffer before seeking
+        flushBuffer(s, false);
+        drainWriter(s);
+
+        if (s.file.seek(position)) {
+            s.seeked = true;
+            response["status"] = "success";
+            response["position"] = position;
+        } else {
+            response["status"] = "error";
+            response["message"] = "Seek failed";
+        }
+    }
+
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_seek_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+}
+
+static void handleFileClose(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(128);
+    deserializeJson(doc, (const char*)data.data(), data.size());
+
+    DynamicJsonDocument response(768);
+    int sessionId = doc["session"] | 0;
+    FileSession *session = findOpenSession(sessionId);
+
+    if (!session) {
+        response["status"] = "error";
+        response["message"] = "No file open";
+        response["session"] = sessionId;
+    } else {
+        FileSession &s = *session;
+
+        // Final flush
+        flushBuffer(s, false);
+        drainWriter(s);
+
+        // Calculate statistics
+        unsigned long totalTime = millis() - s.startTime;
+        // Share of flash write time hidden behind reception
+        float overlap = s.writerBusyUs > 0 ?
+                        100.0f * (1.0f - (float)min(s.receiveStallUs, s.writerBusyUs) /
+                                         s.writerBusyUs) : 0;
+        float avgFlushTime = s.flushCount > 0 ?
+                            (float)s.totalFlushTime / s.flushCount : 0;
+        float writeSpeed = totalTime > 0 ?
+                          (float)s.writtenSize / totalTime * 1000 : 0;
+
+        response["status"] = "success";
+        response["session"] = s.id;
+        response["filename"] = s.filename;
+        response["bytes_written"] = s.writtenSize;
+        response["expected_size"] = s.totalSize;
+
+        int sizeDiff = (int)s.writtenSize - (int)s.totalSize;
+        response["size_difference"] = sizeDiff;
+
+        response["elapsed_ms"] = totalTime;
+        response["flush_count"] = s.flushCount;
+        response["total_flush_ms"] = s.totalFlushTime;
+        response["avg_flush_ms"] = avgFlushTime;
+        response["speed_bps"] = writeSpeed;
+        response["speed_kbps"] = writeSpeed / 1024.0;
+        response["writer_busy_ms"] = s.writerBusyUs / 1000.0;
+        response["receive_stall_ms"] = s.receiveStallUs / 1000.0;
+        response["overlap_pct"] = overlap;
+
+        if (s.window.slots > 0) {
+            response["chunks_received"] = s.chunksReceived;
+            response["chunks_duplicate"] = s.chunksDuplicate;
+            response["chunks_dropped"] = s.chunksDropped;
+            response["chunks_pending"] = s.window.pending();
+            response["chunk_acks"] = s.chunkAcks;
+        }
+
+        // Decompression cost: CPU time, ratio and RAM held by this session
+        float ratio = 0;
+        float inflateSpeed = 0;
+        if (s.inflater) {
+            FileInflater &inf = *s.inflater;
+            ratio = s.compressedSize > 0 ? (float)s.writtenSize / s.compressedSize : 0;
+            inflateSpeed = s.inflateUs > 0 ? (float)s.writtenSize / s.inflateUs * 1000000 : 0;
+
+            response["compression"] = s.compression == COMPRESSION_ZLIB ? "zlib" : "deflate";
+            response["compressed_bytes"] = s.compressedSize;
+            response["ratio"] = ratio;
+            response["inflate_ms"] = s.inflateUs / 1000.0;
+            response["inflate_kbps"] = inflateSpeed / 1024.0;
+            response["inflate_ram"] = sizeof(FileInflater);
+            response["inflate_psram"] = inf.inPsram;
+            response["session_ram"] = sizeof(FileInflater) +
+                                      s.bufferSize * FileConfig::WRITE_BUFFERS +
+                                      s.window.slots * s.window.chunkSize;
+            response["stream_complete"] = inf.status == TINFL_STATUS_DONE;
+            if (inf.status != TINFL_STATUS_DONE) {
+                response["status"] = "error";
+                response["message"] = inf.status < TINFL_STATUS_DONE ?
+                                      "Corrupt compressed stream" : "Compressed stream truncated";
+            }
+        }
+
+        LOG_INFO("FILE", "=== FILE TRANSFER COMPLETE ===");
+        LOG_INFO("FILE", "  File: %s", s.filename.c_str());
+        LOG_INFO("FILE", "  Expected: %u bytes", s.totalSize);
+        LOG_INFO("FILE", "  Written: %u bytes", s.writtenSize);
+        LOG_INFO("FILE", "  Difference: %d bytes", sizeDiff);
+        LOG_INFO("FILE", "  Total Time: %lu ms (%.2f sec)", totalTime, totalTime / 1000.0);
+        LOG_INFO("FILE", "  Flushes: %u times", s.flushCount);
+        LOG_INFO("FILE", "  Speed: %.2f KB/s", writeSpeed / 1024.0);
+        LOG_INFO("FILE", "  Writer: %lu ms busy, %lu ms stalled (%.1f%% overlap)",
+                 (unsigned long)(s.writerBusyUs / 1000),
+                 (unsigned long)(s.receiveStallUs / 1000), overlap);
+        if (s.window.slots > 0) {
+            LOG_INFO("FILE", "  Chunks: %u received, %u duplicate, %u dropped, %u acks",
+                     s.chunksReceived, s.chunksDuplicate,
+                     s.chunksDropped, s.chunkAcks);
+        }
+        if (s.inflater) {
+            LOG_INFO("FILE", "  Inflate: %u -> %u bytes (%.2fx), %lu ms (%.2f KB/s), %u bytes RAM%s",
+                     s.compressedSize, s.writtenSize, ratio,
+                     (unsigned long)(s.inflateUs / 1000), inflateSpeed / 1024.0,
+                     sizeof(FileInflater), s.inflater->inPsram ? " (PSRAM)" : "");
+        }
+
+        // Cleanup
+        closeSession(s);
+
+        // Move a finished resumable upload into place; an unfinished one
+        // keeps its .part and checkpoint for a later "resume"
+        if (s.resumable) {
+            // Only an exact, verified stream replaces the file: the CRC of the
+            // received bytes must match the checkpoint chain on flash and the
+            // client's "crc" when one is given
+            uint32_t crc = s.fileCrc.finalize();
+            bool complete = false;
+            response["resumable"] = true;
+            response["checkpoints"] = s.checkpoints;
+            response["crc"] = crc;
+
+            if (s.writeError || s.writtenSize < s.totalSize) {
+                // Kept for resume
+            } else if (s.writtenSize != s.totalSize) {
+                response["status"] = "error";
+                response["message"] = "Size mismatch";
+            } else if (crc != s.writtenCrc.finalize() ||
+                       (doc.containsKey("crc") && crc != (doc["crc"] | 0u))) {
+                response["status"] = "error";
+                response["message"] = "CRC mismatch";
+            } else if (replaceFile(partPath(s.filename), s.filename)) {
+                complete = true;
+                FILESYSTEM.remove(checkpointPath(s.filename));
+                file_manifest_update(s.filename, s.writtenSize, crc);
+            } else {
+                response["status"] = "error";
+                response["message"] = "Rename failed";
+            }
+            response["complete"] = complete;
+
+            LOG_INFO("FILE", "  Resumable: %u checkpoints, %s", s.checkpoints,
+                     complete ? "renamed into place" : "kept for resume");
+        }
+    }
+
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_close_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+}
+
+static void handleFileResumeQuery(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(256);
+    DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
+
+    DynamicJsonDocument response(256);
+
+    if (error) {
+        response["status"] = "error";
+        response["message"] = "Invalid JSON";
+    } else {
+        String filename = sanitizePath(doc["filename"].as<String>());
+        FileCheckpoint ckpt;
+        response["filename"] = filename;
+
+        // An upload still open for this file has a newer offset than its sidecar
+        FileSession *open = nullptr;
+        for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+            if (g_sessions[i].isOpen && g_sessions[i].resumable &&
+                g_sessions[i].filename == filename) {
+                open = &g_sessions[i];
+            }
+        }
+
+        if (open) {
+            flushBuffer(*open, false);
+            drainWriter(*open);
+        }
+
+        if (readCheckpoint(filename, ckpt)) {
+            response["status"] = "success";
+            response["offset"] = ckpt.offset;
+            response["crc"] = ckpt.crc;
+            response["total"] = ckpt.total;
+            response["open"] = open != nullptr;
+        } else {
+            response["status"] = "none";
+        }
+    }
+
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_resume_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+}
+
+static void handleFileRead(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
+
+    if (error) {
+        sendError("file_read_response", FILE_STATUS_INVALID_REQUEST, 0, "Invalid JSON");
+        return;
+    }
+
+    String filename = sanitizePath(doc["filename"].as<String>());
+    size_t offset = doc["offset"] | 0;
+    size_t size = doc["size"] | FileConfig::MAX_CHUNK_SIZE;
+
+    File file = FILESYSTEM.open(filename, FILE_READ);
+    if (!file) {
+        sendError("file_read_response", FILE_STATUS_NOT_FOUND, 0, "File not found");
+        return;
+    }
+    if (offset > file.size()) {
+        file.close();
+        sendError("file_read_response", FILE_STATUS_INVALID_REQUEST, 0, "Invalid offset");
+        return;
+    }
+
+    file.seek(offset);
+    size_t toRead = min(size, (size_t)(file.size() - offset));
+
+    uint8_t *readBuffer = new uint8_t[toRead];
+    size_t bytesRead = file.read(readBuffer, toRead);
+    file.close();
+
+    // Calculate CRC
+    CRC32 crc;
+    crc.update(readBuffer, bytesRead);
+    uint32_t dataCrc = crc.finalize();
+
+    // Send metadata first
+    if (g_jsonControl) {
+        DynamicJsonDocument metadata(256);
+        metadata["status"] = "success";
+        metadata["bytes"] = bytesRead;
+        metadata["crc"] = dataCrc;
+        metadata["offset"] = offset;
+
+        String metadataStr;
+        serializeJson(metadata, metadataStr);
+        event_msg_send("file_read_metadata", (const uint8_t*)metadataStr.c_str(), metadataStr.length());
+    } else {
+        FileReadMeta metadata;
+        metadata.version = FileConfig::CONTROL_VERSION;
+        metadata.status = FILE_STATUS_OK;
+        metadata.reserved = 0;
+        metadata.offset = offset;
+        metadata.bytes = bytesRead;
+        metadata.crc = dataCrc;
+        event_msg_send("file_read_metadata", (const uint8_t*)&metadata, sizeof(metadata));
+    }
+
+    // Send binary data
+    event_msg_send("file_read_data", readBuffer, bytesRead);
+
+    delete[] readBuffer;
+}
+
+static FileStream *findStream(int id) {
+    if (id < 0 || id >= (int)FileConfig::MAX_SESSIONS) {
+        return nullptr;
+    }
+    return &g_streams[id];
+}
+
+// Close the stream and report totals for the transferred range
+static void endStream(FileStream &st, const char *status) {
+    unsigned long elapsed = millis() - st.startTime;
+    uint32_t bytes = st.offset - st.startOffset;
+    float speed = elapsed > 0 ? (float)bytes / elapsed * 1000 : 0;
+
+    st.file.close();
+    st.active = false;
+
+    DynamicJsonDocument response(256);
+    response["status"] = status;
+    response["session"] = st.id;
+    response["filename"] = st.filename;
+    response["offset"] = st.startOffset;
+    response["bytes"] = bytes;
+    response["crc"] = st.crc.finalize();
+    response["frames"] = st.frames;
+    response["elapsed_ms"] = elapsed;
+    response["speed_kbps"] = speed / 1024.0;
 
-    // Need dynamic allocation
-    size_t allocSize = min(requestedSize, FileConfig::MAX_DYNAMIC_BUFFER);
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_stream_end", (const uint8_t*)responseStr.c_str(), responseStr.length());
 
-    // Free existing dynamic buffer if any
-    if (g_fileSession.usingDynamicBuffer && g_fileSession.buffer != g_fileSession.staticBuffer) {
-        delete[] g_fileSession.buffer;
-    }
+    LOG_INFO("FILE", "Stream %s: %s, %u bytes in %lu ms (%.2f KB/s)", status,
+             st.filename.c_str(), bytes, elapsed, speed / 1024.0);
+}
 
-    // Try PSRAM first if available
-    if (ESP.getPsramSize() > 0 && ESP.getFreePsram() >= allocSize) {
-        g_fileSession.buffer = (uint8_t *)ps_malloc(allocSize);
-        if (g_fileSession.buffer) {
-            LOG_DEBUG("FILE", "Allocated %u bytes in PSRAM", allocSize);
+// Send data frames while the host has credit left
+static void pumpStream(FileStream &st) {
+    while (st.active && st.credits > 0) {
+        if (st.offset >= st.size) {
+            endStream(st, "success");
+            return;
         }
-    }
 
-    // Fallback to heap
-    if (!g_fileSession.buffer || g_fileSession.buffer == g_fileSession.staticBuffer) {
-        g_fileSession.buffer = new uint8_t[allocSize];
-        if (g_fileSession.buffer) {
-            LOG_DEBUG("FILE", "Allocated %u bytes in heap", allocSize);
+        // Frame layout: [session u8][offset u32 LE][payload]
+        uint32_t offset = st.offset;
+        g_streamBuffer[0] = st.id;
+        g_streamBuffer[1] = offset & 0xFF;
+        g_streamBuffer[2] = (offset >> 8) & 0xFF;
+        g_streamBuffer[3] = (offset >> 16) & 0xFF;
+        g_streamBuffer[4] = (offset >> 24) & 0xFF;
+
+        size_t toRead = min(st.chunkSize, st.size - offset);
+        size_t bytesRead = st.file.read(g_streamBuffer + 5, toRead);
+        if (bytesRead == 0) {
+            endStream(st, "error");
+            return;
         }
-    }
-
-    if (g_fileSession.buffer && g_fileSession.buffer != g_fileSession.staticBuffer) {
-        g_fileSession.bufferSize = allocSize;
-        g_fileSession.usingDynamicBuffer = true;
-        return true;
-    }
 
-    // Allocation failed, fallback to static
-    LOG_DEBUG("FILE", "Dynamic allocation failed, using static buffer");
-    g_fileSession.buffer = g_fileSession.staticBuffer;
-    g_fileSession.bufferSize = FileConfig::STATIC_BUFFER_SIZE;
-    g_fileSession.usingDynamicBuffer = false;
-    return false;
-}
+        st.crc.update(g_streamBuffer + 5, bytesRead);
+        event_msg_send("file_stream_data", g_streamBuffer, bytesRead + 5);
 
-static void freeBuffer() {
-    if (g_fileSession.usingDynamicBuffer && g_fileSession.buffer != g_fileSession.staticBuffer) {
-        delete[] g_fileSession.buffer;
-        g_fileSession.buffer = g_fileSession.staticBuffer;
-        g_fileSession.bufferSize = FileConfig::STATIC_BUFFER_SIZE;
-        g_fileSession.usingDynamicBuffer = false;
+        st.offset += bytesRead;
+        st.credits--;
+        st.frames++;
     }
-}
 
-static bool flushBuffer(bool sendAck) {
-    if (g_fileSession.bufferPos == 0) {
-        return true; // Nothing to flush
+    // Nothing left to send - finish without waiting for more credit
+    if (st.active && st.offset >= st.size) {
+        endStream(st, "success");
     }
+}
 
-    unsigned long flushStart = millis();
+static void handleFileStream(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
 
-    // Calculate CRC for this chunk
-    g_fileSession.crc.update(g_fileSession.buffer, g_fileSession.bufferPos);
-    uint32_t chunkCrc = g_fileSession.crc.finalize();
+    DynamicJsonDocument response(256);
+    FileStream *stream = error ? nullptr : findStream(doc["session"] | 0);
+    String filename = error ? String() : sanitizePath(doc["filename"].as<String>());
+    size_t offset = doc["offset"] | 0;
+    File file;
 
-    // Write to file
-    size_t written = g_fileSession.file.write(g_fileSession.buffer, g_fileSession.bufferPos);
+    // A bad request leaves whatever the slot is streaming untouched
+    if (error) {
+        response["status"] = "error";
+        response["message"] = "Invalid JSON";
+    } else if (!stream) {
+        response["status"] = "error";
+        response["message"] = "Invalid session";
+    } else if (isFileBusy(filename, false, true)) {
+        // An upload or delta rebuild is still writing it
+        response["status"] = "error";
+        response["message"] = "File is open";
+    } else if (!(file = FILESYSTEM.open(filename, FILE_READ))) {
+        response["status"] = "error";
+        response["message"] = "File not found";
+    } else if (offset > file.size() || !file.seek(offset)) {
+        file.close();
+        response["status"] = "error";
+        response["message"] = "Invalid offset";
+    } else {
+        FileStream &st = *stream;
+        size_t chunkSize = doc["chunk_size"] | FileConfig::STREAM_CHUNK_SIZE;
+        uint32_t credits = doc["credits"] | 8;
 
-    unsigned long flushEnd = millis();
-    unsigned long flushDuration = flushEnd - flushStart;
+        if (st.active) {
+            endStream(st, "cancelled");
+        }
 
-    if (written != g_fileSession.bufferPos) {
-        LOG_ERROR("FILE", "Buffer flush failed: %u/%u bytes", written, g_fileSession.bufferPos);
+        st.file = file;
+        st.filename = filename;
+        st.size = file.size();
+        st.offset = offset;
+        st.startOffset = offset;
+        st.chunkSize = constrain(chunkSize, (size_t)1, FileConfig::STREAM_CHUNK_SIZE);
+        st.credits = min(credits, FileConfig::MAX_STREAM_CREDITS);
+        st.crc.reset();
+        st.frames = 0;
+        st.startTime = millis();
+        st.active = true;
 
-        if (sendAck) {
-            DynamicJsonDocument response(256);
-            response["status"] = "error";
-            response["message"] = "Flush failed";
-            String responseStr;
-            serializeJson(response, responseStr);
-            event_msg_send("file_append_ack", (const uint8_t*)responseStr.c_str(), responseStr.length());
-        }
-        return false;
+        response["status"] = "success";
+        response["session"] = st.id;
+        response["filename"] = filename;
+        response["size"] = st.size;
+        response["offset"] = offset;
+        response["chunk_size"] = st.chunkSize;
     }
 
-    g_fileSession.writtenSize += written;
-    g_fileSession.lastChunkCrc = chunkCrc;
-    g_fileSession.totalFlushTime += flushDuration;
-    g_fileSession.flushCount++;
-    g_fileSession.lastFlushTime = flushEnd;
-
-    // Send ACK with CRC
-    if (sendAck) {
-        DynamicJsonDocument ack(256);
-        ack["status"] = "ack";
-        ack["bytes"] = written;
-        ack["crc"] = chunkCrc;
-        ack["total"] = g_fileSession.writtenSize;
-        ack["timestamp"] = millis();
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_stream_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
 
-        String ackStr;
-        serializeJson(ack, ackStr);
-        event_msg_send("file_append_ack", (const uint8_t*)ackStr.c_str(), ackStr.length());
+    if (stream) {
+        pumpStream(*stream);
     }
+}
 
-    // Reset buffer
-    g_fileSession.bufferPos = 0;
-    g_fileSession.crc.reset();
+static void handleFileStreamCredit(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(128);
+    DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
 
-    // Log performance
-    if (flushDuration > 0) {
-        LOG_DEBUG("FILE", "Flush: %u bytes in %lu ms (%u bytes/ms), CRC: 0x%08X",
-                  written, flushDuration, written / flushDuration, chunkCrc);
+    FileStream *stream = error ? nullptr : findStream(doc["session"] | 0);
+    if (!stream || !stream->active) {
+        return;
     }
 
-    return true;
+    uint32_t credits = doc["credits"] | 0;
+    stream->credits = min(stream->credits + credits, FileConfig::MAX_STREAM_CREDITS);
+
+    pumpStream(*stream);
+}
+
+static void handleFileStreamCancel(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(128);
+    deserializeJson(doc, (const char*)data.data(), data.size());
+
+    FileStream *stream = findStream(doc["session"] | 0);
+    if (stream && stream->active) {
+        endStream(*stream, "cancelled");
+    }
 }
 
 // ═══════════════════════════════════════════════════════
-// EVENT HANDLERS
+// DELTA SYNC
 // ═══════════════════════════════════════════════════════
 
-static void handleFileInit(const std::vector<uint8_t> &data) {
-    DynamicJsonDocument response(512);
-    response["status"] = "success";
-    response["filesystem"] = FS_NAME;
-    response["total_bytes"] = FILESYSTEM.totalBytes();
-    response["used_bytes"] = FILESYSTEM.usedBytes();
-    response["free_bytes"] = FILESYSTEM.totalBytes() - FILESYSTEM.usedBytes();
+static uint32_t readU32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
 
-    String responseStr;
-    serializeJson(response, responseStr);
-    event_msg_send("file_init_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+static void writeU32(uint8_t *p, uint32_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
 }
 
-static void handleFileCreate(const std::vector<uint8_t> &data) {
-    DynamicJsonDocument doc(512);
+// Per-block signatures of the current file, so the host can send only what changed
+static void handleFileSignature(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(256);
     DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
 
-    DynamicJsonDocument response(512);
+    DynamicJsonDocument response(256);
+    String filename = error ? String() : sanitizePath(doc["filename"].as<String>());
+    size_t blockSize = error ? 0 : (doc["block_size"] | DeltaSync::DEFAULT_BLOCK_SIZE);
+    blockSize = constrain(blockSize, DeltaSync::MIN_BLOCK_SIZE, DeltaSync::MAX_BLOCK_SIZE);
+
+    File file;
+    uint8_t *block = nullptr;
 
     if (error) {
         response["status"] = "error";
         response["message"] = "Invalid JSON";
+    } else if (!(file = FILESYSTEM.open(filename, FILE_READ))) {
+        response["status"] = "error";
+        response["message"] = "File not found";
+    } else if (!(block = (uint8_t *)malloc(blockSize))) {
+        response["status"] = "error";
+        response["message"] = "Out of memory";
+    }
+
+    if (!block) {
+        file.close();
         String responseStr;
         serializeJson(response, responseStr);
-        event_msg_send("file_create_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+        event_msg_send("file_signature_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
         return;
     }
 
-    // Close existing session if any
-    if (g_fileSession.isOpen && g_fileSession.file) {
-        flushBuffer(false);
-        g_fileSession.file.close();
-        freeBuffer();
+    // Frame: [first_block u32][{rolling u32, strong u32} x SIG_ENTRIES_PER_FRAME]
+    uint8_t frame[4 + DeltaSync::SIG_ENTRIES_PER_FRAME * DeltaSync::SIG_ENTRY_SIZE];
+    size_t entries = 0;
+    uint32_t blocks = 0;
+    CRC32 fileCrc;
+    unsigned long start = millis();
+
+    size_t fileSize = file.size();
+    size_t bytesRead;
+    while ((bytesRead = file.read(block, blockSize)) > 0) {
+        RollingChecksum weak;
+        weak.init(block, bytesRead);
+        fileCrc.update(block, bytesRead);
+
+        if (entries == 0) {
+            writeU32(frame, blocks);
+        }
+        uint8_t *entry = frame + 4 + entries * DeltaSync::SIG_ENTRY_SIZE;
+        writeU32(entry, weak.value());
+        writeU32(entry + 4, crc32_le(0, block, bytesRead));
+        entries++;
+        blocks++;
+
+        if (entries == DeltaSync::SIG_ENTRIES_PER_FRAME) {
+            event_msg_send("file_signature_data", frame, sizeof(frame));
+            entries = 0;
+        }
+    }
+    if (entries > 0) {
+        event_msg_send("file_signature_data", frame, 4 + entries * DeltaSync::SIG_ENTRY_SIZE);
     }
 
-    String filename = doc["filename"].as<String>();
-    size_t expectedSize = doc["size"] | 0;
-    size_t bufferSize = doc["buffer_size"] | FileConfig::STATIC_BUFFER_SIZE;
-
-    if (filename.isEmpty()) {
-        response["status"] = "error";
-        response["message"] = "No filename";
-    } else {
-        g_fileSession.filename = sanitizePath(filename);
-        g_fileSession.totalSize = expectedSize;
-        g_fileSession.writtenSize = 0;
-        g_fileSession.bufferPos = 0;
-        g_fileSession.crc.reset();
-
-        // Allocate buffer
-        allocateBuffer(bufferSize);
-
-        // Open file
-        g_fileSession.file = FILESYSTEM.open(g_fileSession.filename, FILE_WRITE);
-
-        if (g_fileSession.file) {
-            g_fileSession.isOpen = true;
-            g_fileSession.startTime = millis();
-            g_fileSession.timingActive = true;
-            g_fileSession.totalFlushTime = 0;
-            g_fileSession.flushCount = 0;
-
-            response["status"] = "success";
-            response["filename"] = g_fileSession.filename;
-            response["buffer_size"] = g_fileSession.bufferSize;
-            response["expected_size"] = g_fileSession.totalSize;
+    file.close();
+    free(block);
 
-            LOG_INFO("FILE", "Created file: %s (%u bytes expected)",
-                     g_fileSession.filename.c_str(), g_fileSession.totalSize);
-        } else {
-            response["status"] = "error";
-            response["message"] = "Failed to create file";
-            freeBuffer();
-            g_fileSession.isOpen = false;
-            LOG_ERROR("FILE", "Failed to create file: %s", g_fileSession.filename.c_str());
-        }
-    }
+    // Sent last so the host knows every data frame has arrived
+    response["status"] = "success";
+    response["filename"] = filename;
+    response["size"] = fileSize;
+    response["block_size"] = blockSize;
+    response["blocks"] = blocks;
+    response["crc"] = fileCrc.finalize();
+    response["elapsed_ms"] = millis() - start;
 
     String responseStr;
     serializeJson(response, responseStr);
-    event_msg_send("file_create_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
-}
-
-static void handleFileAppend(const std::vector<uint8_t> &data) {
-    if (!g_fileSession.isOpen || !g_fileSession.file) {
-        DynamicJsonDocument response(256);
-        response["status"] = "error";
-        response["message"] = "No file open";
-        String responseStr;
-        serializeJson(response, responseStr);
-        event_msg_send("file_append_ack", (const uint8_t*)responseStr.c_str(), responseStr.length());
-        return;
-    }
+    event_msg_send("file_signature_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
 
-    size_t remaining = data.size();
-    const uint8_t *dataPtr = data.data();
+    LOG_INFO("FILE", "Signature: %s, %u blocks of %u bytes", filename.c_str(), blocks, blockSize);
+}
 
-    while (remaining > 0) {
-        size_t spaceInBuffer = g_fileSession.bufferSize - g_fileSession.bufferPos;
-        size_t toWrite = min(remaining, spaceInBuffer);
+// Wait until the writer task has applied every queued ops frame
+static void drainDelta() {
+    FileWriteJob job = { nullptr, WRITE_JOB_DELTA_DRAIN, 0, false, nullptr };
+    xQueueSend(g_writeQueue, &job, portMAX_DELAY);
+    xSemaphoreTake(g_delta.drainDone, portMAX_DELAY);
+}
 
-        // Copy to buffer
-        memcpy(g_fileSession.buffer + g_fileSession.bufferPos, dataPtr, toWrite);
-        g_fileSession.bufferPos += toWrite;
-        dataPtr += toWrite;
-        remaining -= toWrite;
+static void closeDelta(bool keep) {
+    DeltaSession &d = g_delta;
+    drainDelta();
+    d.base.close();
+    d.out.close();
+    free(d.copyBuffer);
+    d.copyBuffer = nullptr;
+    if (!keep) {
+        FILESYSTEM.remove(d.filename + ".delta");
+    }
+    d.active = false;
+}
 
-        // Auto-flush if buffer is full
-        if (g_fileSession.bufferPos >= g_fileSession.bufferSize) {
-            if (!flushBuffer(true)) {
-                return; // Flush failed
-            }
-        }
+static void failDelta(const char *message) {
+    if (!g_delta.error) {
+        g_delta.error = true;
+        g_delta.message = message;
+        LOG_ERROR("FILE", "Delta: %s", message);
     }
 }
 
-static void handleFileFlush(const std::vector<uint8_t> &data) {
-    if (!g_fileSession.isOpen) {
-        DynamicJsonDocument response(256);
-        response["status"] = "error";
-        response["message"] = "No file open";
-        String responseStr;
-        serializeJson(response, responseStr);
-        event_msg_send("file_flush_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+static void deltaWrite(const uint8_t *data, size_t length) {
+    if (g_delta.out.write(data, length) != length) {
+        failDelta("Write failed");
         return;
     }
-
-    flushBuffer(true);
+    g_delta.crc.update(data, length);
+    g_delta.written += length;
 }
 
-static void handleFileSeek(const std::vector<uint8_t> &data) {
+static void handleFileDeltaBegin(const std::vector<uint8_t> &data) {
     DynamicJsonDocument doc(256);
     DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
 
     DynamicJsonDocument response(256);
+    DeltaSession &d = g_delta;
+    String filename = error ? String() : String(doc["filename"] | "");
+    if (!filename.isEmpty()) {
+        filename = sanitizePath(filename);
+    }
 
-    if (!g_fileSession.isOpen) {
-        response["status"] = "error";
-        response["message"] = "No file open";
-    } else if (error) {
+    // A bad request leaves the rebuild in progress untouched; restarting
+    // the same file replaces it
+    if (error) {
         response["status"] = "error";
         response["message"] = "Invalid JSON";
+    } else if (filename.isEmpty()) {
+        response["status"] = "error";
+        response["message"] = "No filename";
+    } else if (isFileBusy(filename) && !(d.active && d.filename == filename)) {
+        response["status"] = "error";
+        response["message"] = "File is open";
     } else {
-        size_t position = doc["position"] | 0;
-
-        // Flush buffer before seeking
-        flushBuffer(false);
+        if (d.active) {
+            closeDelta(false);
+        }
 
-        if (g_fileSession.file.seek(position)) {
-            response["status"] = "success";
-            response["position"] = position;
-        } else {
+        d.filename = filename;
+        d.blockSize = constrain((size_t)(doc["block_size"] | DeltaSync::DEFAULT_BLOCK_SIZE),
+                                DeltaSync::MIN_BLOCK_SIZE, DeltaSync::MAX_BLOCK_SIZE);
+        d.expectedSize = doc["size"] | 0;
+        d.expectedCrc = doc["crc"] | 0;
+        d.crc.reset();
+        d.written = 0;
+        d.copiedBytes = 0;
+        d.literalBytes = 0;
+        d.ops = 0;
+        d.frames = 0;
+        d.error = false;
+        d.message = "";
+        d.startTime = millis();
+
+        d.base = FILESYSTEM.open(filename, FILE_READ);
+        d.baseSize = d.base ? d.base.size() : 0;
+        d.out = FILESYSTEM.open(filename + ".delta", FILE_WRITE);
+        d.copyBuffer = (uint8_t *)malloc(d.blockSize);
+        d.active = true;
+
+        if (!d.base || !d.out || !d.copyBuffer) {
             response["status"] = "error";
-            response["message"] = "Seek failed";
+            response["message"] = !d.base ? "File not found" :
+                                  !d.out ? "Failed to create file" : "Out of memory";
+            closeDelta(false);
+        } else {
+            response["status"] = "success";
+            response["filename"] = filename;
+            response["block_size"] = d.blockSize;
+            response["base_size"] = d.baseSize;
         }
     }
 
     String responseStr;
     serializeJson(response, responseStr);
-    event_msg_send("file_seek_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+    event_msg_send("file_delta_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
 }
 
-static void handleFileClose(const std::vector<uint8_t> &data) {
-    DynamicJsonDocument response(512);
+// Apply one frame of ops (writer task); errors are sticky and reported
+// by file_delta_end
+static void applyDeltaFrame(const uint8_t *data, size_t size) {
+    DeltaSession &d = g_delta;
+    if (d.error) {
+        return;
+    }
 
-    if (!g_fileSession.isOpen) {
-        response["status"] = "error";
-        response["message"] = "No file open";
-    } else {
-        // Final flush
-        flushBuffer(false);
+    d.frames++;
+    size_t pos = 0;
 
-        // Calculate statistics
-        unsigned long totalTime = millis() - g_fileSession.startTime;
-        float avgFlushTime = g_fileSession.flushCount > 0 ?
-                            (float)g_fileSession.totalFlushTime / g_fileSession.flushCount : 0;
-        float writeSpeed = totalTime > 0 ?
-                          (float)g_fileSession.writtenSize / totalTime * 1000 : 0;
+    while (pos < size && !d.error) {
+        uint8_t op = data[pos];
 
-        g_fileSession.file.close();
+        if (op == DeltaSync::OP_COPY && pos + 7 <= size) {
+            uint32_t blockIndex = readU32(data + pos + 1);
+            uint16_t count = data[pos + 5] | (data[pos + 6] << 8);
+            pos += 7;
 
-        response["status"] = "success";
-        response["filename"] = g_fileSession.filename;
-        response["bytes_written"] = g_fileSession.writtenSize;
-        response["expected_size"] = g_fileSession.totalSize;
+            size_t offset = (size_t)blockIndex * d.blockSize;
+            if (offset >= d.baseSize || !d.base.seek(offset)) {
+                failDelta("Copy out of range");
+                break;
+            }
 
-        int sizeDiff = (int)g_fileSession.writtenSize - (int)g_fileSession.totalSize;
-        response["size_difference"] = sizeDiff;
+            // The last block of the old file may be short
+            for (uint16_t i = 0; i < count && !d.error; i++) {
+                size_t bytesRead = d.base.read(d.copyBuffer, d.blockSize);
+                if (bytesRead == 0) {
+                    failDelta("Copy out of range");
+                    break;
+                }
+                deltaWrite(d.copyBuffer, bytesRead);
+                d.copiedBytes += bytesRead;
+            }
+        } else if (op == DeltaSync::OP_LITERAL && pos + 3 <= size) {
+            uint16_t length = data[pos + 1] | (data[pos + 2] << 8);
+            pos += 3;
 
-        response["elapsed_ms"] = totalTime;
-        response["flush_count"] = g_fileSession.flushCount;
-        response["total_flush_ms"] = g_fileSession.totalFlushTime;
-        response["avg_flush_ms"] = avgFlushTime;
-        response["speed_bps"] = writeSpeed;
-        response["speed_kbps"] = writeSpeed / 1024.0;
+            if (pos + length > size) {
+                failDelta("Literal crosses frame");
+                break;
+            }
 
-        LOG_INFO("FILE", "=== FILE TRANSFER COMPLETE ===");
-        LOG_INFO("FILE", "  File: %s", g_fileSession.filename.c_str());
-        LOG_INFO("FILE", "  Expected: %u bytes", g_fileSession.totalSize);
-        LOG_INFO("FILE", "  Written: %u bytes", g_fileSession.writtenSize);
-        LOG_INFO("FILE", "  Difference: %d bytes", sizeDiff);
-        LOG_INFO("FILE", "  Total Time: %lu ms (%.2f sec)", totalTime, totalTime / 1000.0);
-        LOG_INFO("FILE", "  Flushes: %u times", g_fileSession.flushCount);
-        LOG_INFO("FILE", "  Speed: %.2f KB/s", writeSpeed / 1024.0);
+            deltaWrite(data + pos, length);
+            d.literalBytes += length;
+            pos += length;
+        } else {
+            failDelta("Bad op");
+            break;
+        }
 
-        // Cleanup
-        freeBuffer();
-        g_fileSession.isOpen = false;
-        g_fileSession.timingActive = false;
+        d.ops++;
     }
-
-    String responseStr;
-    serializeJson(response, responseStr);
-    event_msg_send("file_close_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
 }
 
-static void handleFileRead(const std::vector<uint8_t> &data) {
-    DynamicJsonDocument doc(512);
-    DeserializationError error = deserializeJson(doc, (const char*)data.data(), data.size());
-
-    if (error) {
-        DynamicJsonDocument response(256);
-        response["status"] = "error";
-        response["message"] = "Invalid JSON";
-        String responseStr;
-        serializeJson(response, responseStr);
-        event_msg_send("file_read_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+// Queue a frame for the writer task: a COPY of many blocks then no longer
+// holds up the other event handlers
+static void handleFileDeltaOps(const std::vector<uint8_t> &data) {
+    DeltaSession &d = g_delta;
+    if (!d.active || d.error || data.empty()) {
         return;
     }
 
-    String filename = sanitizePath(doc["filename"].as<String>());
-    size_t offset = doc["offset"] | 0;
-    size_t size = doc["size"] | FileConfig::MAX_CHUNK_SIZE;
-
-    File file = FILESYSTEM.open(filename, FILE_READ);
-    if (!file) {
-        DynamicJsonDocument response(256);
-        response["status"] = "error";
-        response["message"] = "File not found";
-        String responseStr;
-        serializeJson(response, responseStr);
-        event_msg_send("file_read_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
+    uint8_t *frame = (uint8_t *)malloc(data.size());
+    if (!frame) {
+        drainDelta();
+        failDelta("Out of memory");
         return;
     }
+    memcpy(frame, data.data(), data.size());
 
-    file.seek(offset);
-    size_t toRead = min(size, (size_t)(file.size() - offset));
+    // Blocks only while DELTA_FRAMES_IN_FLIGHT frames are still queued
+    xSemaphoreTake(d.freeFrames, portMAX_DELAY);
+    FileWriteJob job = { nullptr, WRITE_JOB_DELTA, data.size(), false, frame };
+    xQueueSend(g_writeQueue, &job, portMAX_DELAY);
+}
 
-    uint8_t *readBuffer = new uint8_t[toRead];
-    size_t bytesRead = file.read(readBuffer, toRead);
-    file.close();
+static void handleFileDeltaEnd(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(128);
+    deserializeJson(doc, (const char*)data.data(), data.size());
 
-    // Calculate CRC
-    CRC32 crc;
-    crc.update(readBuffer, bytesRead);
-    uint32_t dataCrc = crc.finalize();
+    DynamicJsonDocument response(512);
+    DeltaSession &d = g_delta;
 
-    // Send metadata first
-    DynamicJsonDocument metadata(256);
-    metadata["status"] = "success";
-    metadata["bytes"] = bytesRead;
-    metadata["crc"] = dataCrc;
-    metadata["offset"] = offset;
+    if (!d.active) {
+        response["status"] = "error";
+        response["message"] = "No delta in progress";
+    } else if (doc["abort"] | false) {
+        closeDelta(false);
+        response["status"] = "cancelled";
+        response["filename"] = d.filename;
+    } else {
+        drainDelta();
+        uint32_t crc = d.crc.finalize();
+        unsigned long elapsed = millis() - d.startTime;
+
+        if (!d.error && d.written != d.expectedSize) {
+            failDelta("Size mismatch");
+        } else if (!d.error && crc != d.expectedCrc) {
+            failDelta("CRC mismatch");
+        }
 
-    String metadataStr;
-    serializeJson(metadata, metadataStr);
-    event_msg_send("file_read_metadata", (const uint8_t*)metadataStr.c_str(), metadataStr.length());
+        closeDelta(!d.error);
+        if (!d.error && !replaceFile(d.filename + ".delta", d.filename)) {
+            failDelta("Rename failed");
+            FILESYSTEM.remove(d.filename + ".delta");
+        }
+        if (!d.error) {
+            file_manifest_update(d.filename, d.written, crc);
+        }
 
-    // Send binary data
-    event_msg_send("file_read_data", readBuffer, bytesRead);
+        response["status"] = d.error ? "error" : "success";
+        if (d.error) {
+            response["message"] = d.message;
+        }
+        response["filename"] = d.filename;
+        response["bytes"] = d.written;
+        response["crc"] = crc;
+        response["copied_bytes"] = d.copiedBytes;
+        response["literal_bytes"] = d.literalBytes;
+        response["ops"] = d.ops;
+        response["frames"] = d.frames;
+        response["elapsed_ms"] = elapsed;
+
+        LOG_INFO("FILE", "Delta %s: %s, %u bytes (%u copied, %u literal) in %lu ms",
+                 d.error ? "failed" : "applied", d.filename.c_str(),
+                 d.written, d.copiedBytes, d.literalBytes, elapsed);
+    }
 
-    delete[] readBuffer;
+    String responseStr;
+    serializeJson(response, responseStr);
+    event_msg_send("file_delta_end_response", (const uint8_t*)responseStr.c_str(), responseStr.length());
 }
 
 static void handleFileDelete(const std::vector<uint8_t> &data) {
@@ -463,10 +1895,11 @@ static void handleFileDelete(const std::vector<uint8_t> &data) {
     } else {
         String filename = sanitizePath(doc["filename"].as<String>());
 
-        if (g_fileSession.isOpen && g_fileSession.filename == filename) {
+        if (isFileBusy(filename)) {
             response["status"] = "error";
             response["message"] = "File is open";
         } else if (FILESYSTEM.remove(filename)) {
+            file_manifest_remove(filename);
             response["status"] = "success";
             response["filename"] = filename;
             LOG_INFO("FILE", "Deleted file: %s", filename.c_str());
@@ -511,19 +1944,66 @@ static void handleFileList(const std::vector<uint8_t> &data) {
 }
 
 static void handleFileInfo(const std::vector<uint8_t> &data) {
-    DynamicJsonDocument response(512);
+    DynamicJsonDocument response(1536);
     response["status"] = "success";
     response["filesystem"] = FS_NAME;
     response["total_bytes"] = FILESYSTEM.totalBytes();
     response["used_bytes"] = FILESYSTEM.usedBytes();
     response["free_bytes"] = FILESYSTEM.totalBytes() - FILESYSTEM.usedBytes();
+    response["format"] = g_jsonControl ? "json" : "binary";
+    JsonObject acks = response.createNestedObject("ack_timing");
+    for (int i = 0; i < 2; i++) {
+        const AckTiming &t = g_ackTiming[i];
+        JsonObject timing = acks.createNestedObject(i ? "json" : "binary");
+        timing["count"] = t.count;
+        timing["avg_us"] = t.count > 0 ? (float)t.totalUs / t.count : 0;
+        timing["max_us"] = t.maxUs;
+#if CONFIG_HEAP_USE_HOOKS
+        timing["avg_allocs"] = t.count > 0 ? (float)t.allocs / t.count : 0;
+#endif
+        timing["avg_heap"] = t.count > 0 ? (float)t.heapBytes / t.count : 0;
+        timing["max_heap"] = t.maxHeapBytes;
+    }
+    response["pool_used"] = g_poolUsed;
+    response["pool_size"] = FileConfig::BUFFER_POOL_CAP;
+
+    JsonArray sessions = response.createNestedArray("sessions");
+    for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+        const FileSession &s = g_sessions[i];
+        if (!s.isOpen) {
+            continue;
+        }
+
+        JsonObject session = sessions.createNestedObject();
+        session["session"] = s.id;
+        session["filename"] = s.filename;
+        session["processed"] = s.writtenSize;
+        session["buffered"] = s.bufferPos;
+        session["total"] = s.totalSize;
+        session["buffer_size"] = s.bufferSize;
+        session["resumable"] = s.resumable;
+        if (s.inflater) {
+            session["received"] = s.compressedSize;
+        }
+        if (s.window.slots > 0) {
+            session["window_base"] = s.window.base;
+            session["window_bitmap"] = s.window.bitmap;
+        }
+    }
+
+    JsonArray streams = response.createNestedArray("streams");
+    for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+        const FileStream &st = g_streams[i];
+        if (!st.active) {
+            continue;
+        }
 
-    if (g_fileSession.isOpen) {
-        JsonObject session = response.createNestedObject("active_session");
-        session["filename"] = g_fileSession.filename;
-        session["processed"] = g_fileSession.writtenSize;
-        session["buffered"] = g_fileSession.bufferPos;
-        session["total"] = g_fileSession.totalSize;
+        JsonObject stream = streams.createNestedObject();
+        stream["session"] = st.id;
+        stream["filename"] = st.filename;
+        stream["offset"] = st.offset;
+        stream["size"] = st.size;
+        stream["credits"] = st.credits;
     }
 
     String responseStr;
@@ -543,13 +2023,39 @@ void file_transfer_init() {
         return;
     }
 
-    // Initialize session
-    g_fileSession.isOpen = false;
-    g_fileSession.buffer = g_fileSession.staticBuffer;
-    g_fileSession.usingDynamicBuffer = false;
-    g_fileSession.bufferPos = 0;
-    g_fileSession.writtenSize = 0;
-    g_fileSession.bufferSize = FileConfig::STATIC_BUFFER_SIZE;
+    // Session slots - buffers come from the pool at file_create
+    for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+        g_sessions[i].id = i;
+        g_streams[i].id = i;
+    }
+
+    // Create writer task (only once) - each fill buffer is owned by reception
+    if (g_writerTask == NULL) {
+        for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+            g_sessions[i].freeBuffers = xSemaphoreCreateCounting(FileConfig::WRITE_BUFFERS - 1,
+                                                                 FileConfig::WRITE_BUFFERS - 1);
+            g_sessions[i].drainDone = xSemaphoreCreateBinary();
+        }
+
+        g_delta.freeFrames = xSemaphoreCreateCounting(FileConfig::DELTA_FRAMES_IN_FLIGHT,
+                                                      FileConfig::DELTA_FRAMES_IN_FLIGHT);
+        g_delta.drainDone = xSemaphoreCreateBinary();
+
+        // Room for every session's in-flight buffers plus a drain marker each,
+        // and the delta frames plus their drain marker
+        g_writeQueue = xQueueCreate(FileConfig::MAX_SESSIONS * FileConfig::WRITE_BUFFERS +
+                                    FileConfig::DELTA_FRAMES_IN_FLIGHT + 1,
+                                    sizeof(FileWriteJob));
+
+        xTaskCreatePinnedToCore(
+            fileWriterTask,
+            "FileWriter",
+            4096,
+            NULL,
+            2,
+            &g_writerTask,
+            0);
+    }
 
     LOG_INFO("FILE", "%s ready - %u / %u bytes used", FS_NAME,
              FILESYSTEM.usedBytes(), FILESYSTEM.totalBytes());
@@ -561,15 +2067,29 @@ void file_transfer_register_handlers() {
     event_msg_on("file_init", handleFileInit);
     event_msg_on("file_create", handleFileCreate);
     event_msg_on("file_append", handleFileAppend);
+    event_msg_on("file_write", handleFileWrite);
+    event_msg_on("file_chunk", handleFileChunk);
     event_msg_on("file_flush", handleFileFlush);
     event_msg_on("file_seek", handleFileSeek);
     event_msg_on("file_close", handleFileClose);
+    event_msg_on("file_resume_query", handleFileResumeQuery);
     event_msg_on("file_read", handleFileRead);
+    event_msg_on("file_stream", handleFileStream);
+    event_msg_on("file_stream_credit", handleFileStreamCredit);
+    event_msg_on("file_stream_cancel", handleFileStreamCancel);
+    event_msg_on("file_signature", handleFileSignature);
+    event_msg_on("file_delta_begin", handleFileDeltaBegin);
+    event_msg_on("file_delta_ops", handleFileDeltaOps);
+    event_msg_on("file_delta_end", handleFileDeltaEnd);
     event_msg_on("file_delete", handleFileDelete);
     event_msg_on("file_list", handleFileList);
     event_msg_on("file_info", handleFileInfo);
 
-    LOG_INFO("FILE", "Registered 10 file transfer event handlers");
+    LOG_INFO("FILE", "Registered 20 file transfer event handlers");
+}
+
+String file_sanitize_path(const String &path) {
+    return sanitizePath(path);
 }
 
 void file_transfer_print_status() {
@@ -578,22 +2098,44 @@ void file_transfer_print_status() {
              FILESYSTEM.usedBytes(), FILESYSTEM.totalBytes(),
              (float)(FILESYSTEM.totalBytes() - FILESYSTEM.usedBytes()) / FILESYSTEM.totalBytes() * 100);
 
-    if (g_fileSession.isOpen) {
-        LOG_INFO("FILE", "Open file: %s", g_fileSession.filename.c_str());
-        LOG_INFO("FILE", "Progress: %u / %u bytes", g_fileSession.writtenSize, g_fileSession.totalSize);
-        LOG_INFO("FILE", "Buffer: %u / %u bytes (%s)",
-                 g_fileSession.bufferPos, g_fileSession.bufferSize,
-                 g_fileSession.usingDynamicBuffer ? "Dynamic" : "Static");
-
-        if (g_fileSession.timingActive && g_fileSession.startTime > 0) {
-            unsigned long elapsed = millis() - g_fileSession.startTime;
-            LOG_INFO("FILE", "Time elapsed: %lu ms (%.2f seconds)", elapsed, elapsed / 1000.0);
-            if (elapsed > 0 && g_fileSession.writtenSize > 0) {
-                float currentSpeed = (float)g_fileSession.writtenSize / elapsed * 1000;
-                LOG_INFO("FILE", "Current speed: %.2f KB/sec", currentSpeed / 1024.0);
+    size_t openCount = 0;
+    for (size_t i = 0; i < FileConfig::MAX_SESSIONS; i++) {
+        const FileSession &s = g_sessions[i];
+        if (!s.isOpen) {
+            continue;
+        }
+        openCount++;
+
+        LOG_INFO("FILE", "Session %u: %s", s.id, s.filename.c_str());
+        LOG_INFO("FILE", "  Progress: %u / %u bytes", s.writtenSize, s.totalSize);
+        LOG_INFO("FILE", "  Buffer: %u / %u bytes", s.bufferPos, s.bufferSize);
+
+        if (s.timingActive && s.startTime > 0) {
+            unsigned long elapsed = millis() - s.startTime;
+            LOG_INFO("FILE", "  Time elapsed: %lu ms (%.2f seconds)", elapsed, elapsed / 1000.0);
+            if (elapsed > 0 && s.writtenSize > 0) {
+                float currentSpeed = (float)s.writtenSize / elapsed * 1000;
+                LOG_INFO("FILE", "  Current speed: %.2f KB/sec", currentSpeed / 1024.0);
             }
         }
-    } else {
+    }
+
+    for (int i = 0; i < 2; i++) {
+        const AckTiming &t = g_ackTiming[i];
+        if (t.count > 0) {
+            LOG_INFO("FILE", "Acks (%s): %u sent, avg %.1f us, max %u us", i ? "json" : "binary",
+                     t.count, (float)t.totalUs / t.count, t.maxUs);
+            LOG_INFO("FILE", "  Heap per ack: avg %.1f bytes, max %u bytes",
+                     (float)t.heapBytes / t.count, t.maxHeapBytes);
+#if CONFIG_HEAP_USE_HOOKS
+            LOG_INFO("FILE", "  Allocations per ack: avg %.2f", (float)t.allocs / t.count);
+#endif
+        }
+    }
+
+    if (openCount == 0) {
         LOG_INFO("FILE", "No file open");
+    } else {
+        LOG_INFO("FILE", "Buffer pool: %u / %u bytes", g_poolUsed, FileConfig::BUFFER_POOL_CAP);
     }
 }
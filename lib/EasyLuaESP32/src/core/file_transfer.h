@@ -5,6 +5,7 @@
 #include <FS.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include "utils/chunk_window.h"
 
 // ═══════════════════════════════════════════════════════
 // FILESYSTEM SELECTION - Change here to use SPIFFS
@@ -28,11 +29,52 @@
 // ═══════════════════════════════════════════════════════
 
 namespace FileConfig {
-    const size_t STATIC_BUFFER_SIZE = 4096;      // 4KB static buffer
-    const size_t MAX_DYNAMIC_BUFFER = 32768;     // 32KB max dynamic buffer
+    const size_t DEFAULT_BUFFER_SIZE = 4096;     // 4KB default (per write buffer)
+    const size_t MIN_BUFFER_SIZE = 1024;         // Smallest buffer a session may shrink to
+    const size_t WRITE_BUFFERS = 2;              // Ping-pong buffers for the writer task
+    const size_t MAX_DYNAMIC_BUFFER = 32768;     // 32KB max per write buffer
     const size_t MAX_CHUNK_SIZE = 4096;          // Max read chunk size
+
+    // Sliding-window uploads (file_chunk)
+    const uint8_t MAX_WINDOW_SLOTS = ChunkWindow::MAX_SLOTS; // Chunks in flight (one bitmap bit each)
+    const size_t DEFAULT_WINDOW_CHUNK = 512;     // Default chunk payload size
+    const size_t MAX_WINDOW_CHUNK = 2048;        // Max chunk payload size
+    const size_t MAX_WINDOW_BYTES = 16384;       // Max reorder buffer (slots * chunk)
+    const uint8_t CHUNK_ACK_VERSION = 1;
+
+    // Streamed downloads (file_stream)
+    const size_t STREAM_CHUNK_SIZE = 480;        // Fixed read buffer / max data per frame
+    const uint32_t MAX_STREAM_CREDITS = 64;      // Max frames a host may have outstanding
+
+    // Concurrent sessions (uploads and streams are indexed by session ID)
+    const size_t MAX_SESSIONS = 4;               // Upload slots (and as many stream slots)
+    const size_t BUFFER_POOL_CAP = 65536;        // Write + window buffers shared by all sessions
+
+    // Resumable uploads (file_create "resumable": true)
+    const size_t CHECKPOINT_INTERVAL = 16384;    // Committed bytes between checkpoint writes
+    const uint32_t CHECKPOINT_MAGIC = 0x54504B43; // "CKPT"
+    const uint8_t CHECKPOINT_VERSION = 1;
+
+    // Delta sync (file_delta_ops frames are applied on the writer task)
+    const size_t DELTA_FRAMES_IN_FLIGHT = 4;     // Queued frames before file_delta_ops waits
+
+    // Control records (file_init "format": "binary" | "json")
+    const uint8_t CONTROL_VERSION = 1;           // First byte of every binary record (never '{')
+    const size_t MAX_ERROR_MESSAGE = 60;
+
+    // Compressed uploads (file_create "compression")
+    const size_t INFLATE_DICT_SIZE = 32768;      // Deflate window, also the output buffer
 }
 
+// Stream format declared by file_create
+enum FileCompression : uint8_t {
+    COMPRESSION_NONE = 0,
+    COMPRESSION_DEFLATE = 1,    // Raw deflate (pako.deflateRaw, zlib wbits -15)
+    COMPRESSION_ZLIB = 2        // Deflate with zlib header + Adler-32 (pako.deflate)
+};
+
+struct FileInflater;            // Decompressor state, see file_transfer.cpp
+
 // ═══════════════════════════════════════════════════════
 // CRC32 CALCULATOR
 // ═══════════════════════════════════════════════════════
@@ -43,33 +85,138 @@ public:
     void reset();
     void update(const uint8_t *data, size_t length);
     uint32_t finalize() const;
+    void seed(uint32_t value);      // Continue a running CRC from a saved value
 
 private:
     uint32_t crc_value;
 };
 
+// ═══════════════════════════════════════════════════════
+// WINDOWED UPLOAD ACK
+// ═══════════════════════════════════════════════════════
+
+// Status codes carried in FileChunkAck
+enum FileChunkStatus : uint8_t {
+    CHUNK_OK = 0,
+    CHUNK_WRITE_ERROR = 1,
+    CHUNK_NO_SESSION = 2
+};
+
+// Payload of "file_chunk_ack" (little-endian, packed)
+// Bit i of bitmap = chunk at (base + i * chunk_size) is held by the device.
+// Clear bits below the highest set bit are chunks the host must resend.
+struct __attribute__((packed)) FileChunkAck {
+    uint8_t version;        // FileConfig::CHUNK_ACK_VERSION
+    uint8_t status;         // FileChunkStatus
+    uint8_t window;         // Window size in chunks
+    uint8_t session;        // Session the ack belongs to
+    uint32_t base;          // Every byte below this offset is committed
+    uint32_t bitmap;        // Out-of-order chunks received past base
+    uint32_t crc;           // CRC32 of bytes [0, base)
+};
+
+// ═══════════════════════════════════════════════════════
+// BINARY CONTROL RECORDS
+// ═══════════════════════════════════════════════════════
+
+// Status codes carried in the control records
+enum FileStatus : uint8_t {
+    FILE_STATUS_OK = 0,
+    FILE_STATUS_NO_SESSION = 1,
+    FILE_STATUS_WRITE_ERROR = 2,
+    FILE_STATUS_DECOMPRESS_ERROR = 3,
+    FILE_STATUS_INVALID_REQUEST = 4,
+    FILE_STATUS_NOT_FOUND = 5
+};
+
+// Payload of "file_append_ack" (little-endian, packed)
+struct __attribute__((packed)) FileAppendAck {
+    uint8_t version;        // FileConfig::CONTROL_VERSION
+    uint8_t status;         // FileStatus
+    uint8_t session;
+    uint8_t reserved;
+    uint32_t bytes;         // Bytes in this flush
+    uint32_t crc;           // CRC32 of this flush
+    uint32_t total;         // File bytes written so far
+    uint32_t received;      // Compressed bytes so far (0 if uncompressed)
+    uint32_t timestamp;     // millis()
+};
+
+// Payload of "file_read_metadata" (little-endian, packed)
+struct __attribute__((packed)) FileReadMeta {
+    uint8_t version;
+    uint8_t status;
+    uint16_t reserved;
+    uint32_t offset;
+    uint32_t bytes;         // Bytes in the following file_read_data
+    uint32_t crc;           // CRC32 of those bytes
+};
+
+// Error reply sent in place of a JSON {"status": "error"} document,
+// followed by `length` bytes of message text (not NUL-terminated)
+struct __attribute__((packed)) FileErrorRecord {
+    uint8_t version;
+    uint8_t status;         // FileStatus (never FILE_STATUS_OK)
+    uint8_t session;
+    uint8_t length;
+};
+
+// ═══════════════════════════════════════════════════════
+// UPLOAD CHECKPOINT
+// ═══════════════════════════════════════════════════════
+
+// Contents of "<filename>.ckpt" next to "<filename>.part" (little-endian, packed)
+struct __attribute__((packed)) FileCheckpoint {
+    uint32_t magic;         // FileConfig::CHECKPOINT_MAGIC
+    uint8_t version;        // FileConfig::CHECKPOINT_VERSION
+    uint8_t reserved[3];
+    uint32_t offset;        // Bytes [0, offset) of the .part file are on flash
+    uint32_t crc;           // CRC32 of those bytes
+    uint32_t total;         // Expected final size
+    uint32_t check;         // CRC32 of the fields above
+};
+
 // ═══════════════════════════════════════════════════════
 // FILE SESSION
 // ═══════════════════════════════════════════════════════
 
 struct FileSession {
     // File state
+    uint8_t id;                 // Slot index, fixed at init
     bool isOpen;
     File file;
     String filename;
     size_t totalSize;
     size_t writtenSize;
 
-    // Buffer management
-    uint8_t staticBuffer[FileConfig::STATIC_BUFFER_SIZE];
-    uint8_t *buffer;
-    bool usingDynamicBuffer;
+    // Buffer management (reception fills one buffer while the writer task drains the other)
+    uint8_t *buffers[FileConfig::WRITE_BUFFERS];    // Allocated from the shared pool
+    uint8_t *buffer;            // Buffer currently being filled
+    uint8_t fillIndex;
     size_t bufferPos;
     size_t bufferSize;
+    volatile bool writeError;   // Set by the writer task
+    SemaphoreHandle_t freeBuffers;  // Buffers handed back by the writer
+    SemaphoreHandle_t drainDone;    // Signalled when a drain marker is reached
 
     // CRC tracking
     CRC32 crc;
     uint32_t lastChunkCrc;
+    CRC32 fileCrc;              // Running CRC of all committed bytes
+
+    // Resumable upload (data goes to "<filename>.part" until close)
+    bool resumable;
+    CRC32 writtenCrc;           // CRC of bytes on flash (writer task)
+    uint32_t checkpointOffset;  // Offset recorded in the last checkpoint
+    uint32_t checkpoints;
+
+    // Compressed upload (inflated on the writer task, file gets plain bytes)
+    FileCompression compression;
+    FileInflater *inflater;
+    uint32_t compressedTotal;   // Expected wire bytes (0 = unknown)
+    uint32_t compressedSize;    // Wire bytes inflated so far
+    uint32_t inflateUs;         // Writer time spent in the decompressor
+    bool seeked;                // Written out of order (fileCrc no longer matches the file)
 
     // Performance tracking
     unsigned long startTime;
@@ -77,10 +224,80 @@ struct FileSession {
     unsigned long totalFlushTime;
     uint32_t flushCount;
     bool timingActive;
+    uint32_t writerBusyUs;      // Time the writer spent on CRC + flash writes
+    uint32_t receiveStallUs;    // Time reception waited for a free buffer
+
+    // Sliding window (file_chunk uploads, disabled when window.slots == 0)
+    ChunkWindow window;
+    uint8_t *windowBuffer;      // window.slots x window.chunkSize
+    uint8_t chunksSinceAck;
+    uint32_t chunksReceived;
+    uint32_t chunksDuplicate;
+    uint32_t chunksDropped;
+    uint32_t chunkAcks;
 
     FileSession();
 };
 
+// ═══════════════════════════════════════════════════════
+// STREAMED DOWNLOAD
+// ═══════════════════════════════════════════════════════
+
+struct FileStream {
+    uint8_t id;                 // Slot index, fixed at init
+    bool active;
+    File file;
+    String filename;
+    uint32_t offset;            // Next byte to send
+    uint32_t startOffset;       // Resume point requested by the host
+    size_t size;                // File size
+    size_t chunkSize;
+
+    // Flow control: one credit = one file_stream_data frame
+    uint32_t credits;
+
+    // Stats
+    CRC32 crc;                  // CRC32 of bytes [startOffset, offset)
+    uint32_t frames;
+    unsigned long startTime;
+
+    FileStream();
+};
+
+// ═══════════════════════════════════════════════════════
+// DELTA SYNC
+// ═══════════════════════════════════════════════════════
+
+// Rebuilds a file from copy/literal ops against its current contents
+struct DeltaSession {
+    bool active;
+    File base;                  // Current file (source of COPY ops)
+    File out;                   // "<filename>.delta", renamed over filename on success
+    String filename;
+    size_t blockSize;
+    size_t baseSize;
+    uint8_t *copyBuffer;        // One block (used by the writer task)
+    SemaphoreHandle_t freeFrames;   // Frames the writer task may still take
+    SemaphoreHandle_t drainDone;    // Signalled when a drain marker is reached
+
+    // Expected result (checked before the rename)
+    uint32_t expectedSize;
+    uint32_t expectedCrc;
+
+    // Progress
+    CRC32 crc;
+    uint32_t written;
+    uint32_t copiedBytes;
+    uint32_t literalBytes;
+    uint32_t ops;
+    uint32_t frames;
+    volatile bool error;        // Set by the writer task
+    String message;             // First error
+    unsigned long startTime;
+
+    DeltaSession();
+};
+
 // ═══════════════════════════════════════════════════════
 // PUBLIC API
 // ═══════════════════════════════════════════════════════
@@ -93,3 +310,6 @@ void file_transfer_register_handlers();
 
 // Get current session status
 void file_transfer_print_status();
+
+// Normalize a host-supplied path (leading '/', no "..")
+String file_sanitize_path(const String &path);
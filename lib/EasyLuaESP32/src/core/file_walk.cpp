@@ -0,0 +1,207 @@
+#include "file_walk.h"
+#include "file_transfer.h"
+#include "event_msg.h"
+#include "utils/debug.h"
+#include <vector>
+
+// ═══════════════════════════════════════════════════════
+// GLOB MATCHING
+// ═══════════════════════════════════════════════════════
+
+bool file_walk_glob_match(const char *pattern, const char *name) {
+    const char *star = nullptr;
+    const char *resume = nullptr;
+
+    while (*name) {
+        if (*pattern == '?' || *pattern == *name) {
+            pattern++;
+            name++;
+        } else if (*pattern == '*') {
+            // Remember the star and first try matching it against nothing
+            star = pattern++;
+            resume = name;
+        } else if (star) {
+            // Let the last star swallow one more character
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+// ═══════════════════════════════════════════════════════
+// FRAME BUILDER
+// ═══════════════════════════════════════════════════════
+
+struct WalkFrame {
+    uint8_t data[WalkConfig::FRAME_BYTES];
+    size_t length;
+    WalkFrameHeader header;
+    unsigned long lastSend;
+
+    void reset() {
+        length = sizeof(WalkFrameHeader);
+        header.count = 0;
+    }
+
+    bool fits(size_t pathLen) const {
+        return length + 10 + pathLen <= sizeof(data);
+    }
+
+    void add(WalkEntryType type, uint32_t size, uint32_t mtime, const String &path) {
+        size_t pathLen = min(path.length(), (unsigned int)255);
+        uint8_t *p = data + length;
+        p[0] = type;
+        memcpy(p + 1, &size, 4);
+        memcpy(p + 5, &mtime, 4);
+        p[9] = pathLen;
+        memcpy(p + 10, path.c_str(), pathLen);
+        length += 10 + pathLen;
+        header.count++;
+        header.matched++;
+    }
+
+    void send() {
+        memcpy(data, &header, sizeof(header));
+        event_msg_send("file_walk_data", data, length);
+        lastSend = millis();
+        reset();
+    }
+};
+
+static WalkFrame g_frame;
+
+// ═══════════════════════════════════════════════════════
+// EVENT HANDLER
+// ═══════════════════════════════════════════════════════
+
+// {"path", "recursive", "dirs", "pattern", "min_size", "modified_since", "cursor", "max_entries"}
+static void handleFileWalk(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(512);
+    deserializeJson(doc, (const char*)data.data(), data.size());
+
+    String root = file_sanitize_path(doc["path"] | "/");
+    bool recursive = doc["recursive"] | true;
+    bool includeDirs = doc["dirs"] | true;
+    String pattern = doc["pattern"] | "";
+    uint32_t minSize = doc["min_size"] | 0;
+    uint32_t modifiedSince = doc["modified_since"] | 0;
+    uint32_t cursor = doc["cursor"] | 0;
+    uint32_t maxEntries = doc["max_entries"] | WalkConfig::DEFAULT_MAX_ENTRIES;
+
+    // Patterns with a '/' are matched against the full path, others against the name
+    bool matchPath = pattern.indexOf('/') >= 0;
+    unsigned long start = millis();
+
+    WalkFrame &frame = g_frame;
+    memset(&frame.header, 0, sizeof(frame.header));
+    frame.header.version = WalkConfig::VERSION;
+    frame.lastSend = millis();
+    frame.reset();
+
+    // Depth-first with an explicit stack; readdir order is stable, so the
+    // cursor (entries visited) resumes the same walk without server state
+    std::vector<String> pending;
+    pending.push_back(root);
+
+    File dir = FILESYSTEM.open(root);
+    if (!dir || !dir.isDirectory()) {
+        frame.header.flags = WALK_LAST_FRAME | WALK_DONE | WALK_ERROR;
+        frame.send();
+        return;
+    }
+    dir.close();
+
+    uint32_t visited = 0;
+    bool stopped = false;
+
+    while (!pending.empty() && !stopped) {
+        String dirPath = pending.back();
+        pending.pop_back();
+
+        dir = FILESYSTEM.open(dirPath);
+        if (!dir) {
+            continue;
+        }
+
+        File entry = dir.openNextFile();
+        while (entry) {
+            bool isDir = entry.isDirectory();
+            String path = String(entry.path());
+
+            // Subdirectories are queued even while skipping up to the cursor
+            if (isDir && recursive) {
+                if (pending.size() < WalkConfig::MAX_PENDING_DIRS) {
+                    pending.push_back(path);
+                } else {
+                    frame.header.flags |= WALK_SKIPPED;
+                }
+            }
+
+            visited++;
+            if (visited > cursor) {
+                uint32_t size = isDir ? 0 : entry.size();
+                uint32_t mtime = (uint32_t)entry.getLastWrite();
+                bool match;
+
+                if (isDir) {
+                    match = includeDirs;
+                } else {
+                    const char *subject = matchPath ? path.c_str() : entry.name();
+                    match = size >= minSize && mtime >= modifiedSince &&
+                            (pattern.isEmpty() || file_walk_glob_match(pattern.c_str(), subject));
+                }
+
+                if (match) {
+                    if (!frame.fits(path.length())) {
+                        frame.header.cursor = visited - 1;
+                        frame.header.pending = pending.size();
+                        frame.send();
+                    }
+                    frame.add(isDir ? WALK_DIR : WALK_FILE, size, mtime, path);
+                }
+
+                // Stop after a full page; the cursor resumes right after this entry
+                if (frame.header.matched >= maxEntries) {
+                    stopped = true;
+                    break;
+                }
+            }
+
+            // Long scans with few matches still report progress
+            if (millis() - frame.lastSend >= WalkConfig::PROGRESS_MS) {
+                frame.header.cursor = visited;
+                frame.header.pending = pending.size();
+                frame.send();
+            }
+
+            entry = dir.openNextFile();
+        }
+        dir.close();
+    }
+
+    frame.header.cursor = visited;
+    frame.header.pending = pending.size();
+    frame.header.flags |= WALK_LAST_FRAME;
+    if (!stopped) {
+        frame.header.flags |= WALK_DONE;
+    }
+    frame.send();
+
+    LOG_DEBUG("FILE", "Walk %s: %u visited, %u matched in %lu ms", root.c_str(),
+              visited, frame.header.matched, millis() - start);
+}
+
+// ═══════════════════════════════════════════════════════
+// PUBLIC API IMPLEMENTATION
+// ═══════════════════════════════════════════════════════
+
+void file_walk_register_handlers() {
+    event_msg_on("file_walk", handleFileWalk);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ═══════════════════════════════════════════════════════
+// FILE WALK CONFIGURATION
+// ═══════════════════════════════════════════════════════
+
+namespace WalkConfig {
+    const uint8_t VERSION = 1;
+    const size_t FRAME_BYTES = 480;              // Max file_walk_data payload
+    const uint32_t DEFAULT_MAX_ENTRIES = 128;    // Records per request before a cursor stop
+    const size_t MAX_PENDING_DIRS = 64;          // Directories queued on the walk stack
+    const unsigned long PROGRESS_MS = 500;       // Send a frame at least this often
+}
+
+// ═══════════════════════════════════════════════════════
+// WIRE FORMAT
+// ═══════════════════════════════════════════════════════
+
+// Flags in WalkFrameHeader
+enum WalkFrameFlags : uint8_t {
+    WALK_LAST_FRAME = 0x01,     // Last frame of this request
+    WALK_DONE = 0x02,           // Tree fully walked (otherwise resume with cursor)
+    WALK_ERROR = 0x04,          // Start path missing / not a directory
+    WALK_SKIPPED = 0x08         // Some directories not entered (stack full)
+};
+
+// Record types
+enum WalkEntryType : uint8_t {
+    WALK_FILE = 0,
+    WALK_DIR = 1
+};
+
+// Payload of "file_walk_data" (little-endian, packed), followed by
+// `count` records: [type u8][size u32][mtime u32][path_len u8][path]
+struct __attribute__((packed)) WalkFrameHeader {
+    uint8_t version;        // WalkConfig::VERSION
+    uint8_t flags;          // WalkFrameFlags
+    uint16_t count;         // Records in this frame
+    uint32_t cursor;        // Entries visited so far - send back to resume
+    uint32_t matched;       // Records sent so far in this request
+    uint16_t pending;       // Directories still queued (progress hint)
+    uint16_t reserved;
+};
+
+// ═══════════════════════════════════════════════════════
+// PUBLIC API
+// ═══════════════════════════════════════════════════════
+
+// Register the file_walk event handler
+void file_walk_register_handlers();
+
+// Match a name against a glob with '*' and '?' (no character classes)
+bool file_walk_glob_match(const char *pattern, const char *name);
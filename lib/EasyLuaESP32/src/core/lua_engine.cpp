@@ -164,6 +164,7 @@ static String code_buffer = "";
 static StateResetCallback state_reset_callback = nullptr;
 static ErrorCallback error_callback = nullptr;
 static StopCallback stop_callback = nullptr;
+static FinishCallback finish_callback = nullptr;
 
 // ═══════════════════════════════════════════════════════
 // DEBUG HOOK (Watchdog prevention + interrupt handling)
@@ -245,6 +246,13 @@ static void lua_task(void *parameter)
             // Execute code (modules already registered in reset_lua_state)
             int result = luaL_dostring(L, code_to_execute.c_str());
 
+            // Work the chunk left running (e.g. spawned tasks) finishes before the reset
+            if (result == LUA_OK && finish_callback != nullptr)
+            {
+                lua_pushcfunction(L, finish_callback);
+                result = lua_pcall(L, 0, 0, 0);
+            }
+
             if (result != LUA_OK)
             {
                 const char *error = lua_tostring(L, -1);
@@ -432,6 +440,11 @@ void lua_engine_on_stop(StopCallback callback)
     stop_callback = callback;
 }
 
+void lua_engine_on_finish(FinishCallback callback)
+{
+    finish_callback = callback;
+}
+
 void lua_engine_print_mem_stats()
 {
     LOG_INFO("LUA_MEM", "═══════════════════════════════════");
@@ -21,6 +21,7 @@
 typedef void (*StateResetCallback)(lua_State* L);  // Called when Lua state is reset (register your modules here)
 typedef void (*ErrorCallback)(const char* error_msg);
 typedef void (*StopCallback)();
+typedef lua_CFunction FinishCallback;              // Called protected after the chunk returns (errors count as script errors)
 
 // Initialize Lua engine (call once in setup)
 void lua_engine_init();
@@ -60,5 +61,8 @@ void lua_engine_on_error(ErrorCallback callback);
 // Set callback for when Lua execution stops (success or interrupt)
 void lua_engine_on_stop(StopCallback callback);
 
+// Set callback for when the main chunk returns, before the state is reset
+void lua_engine_on_finish(FinishCallback callback);
+
 // Print memory allocation statistics
 void lua_engine_print_mem_stats();
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ═══════════════════════════════════════════════════════
+// CHUNK WINDOW - reorder bookkeeping behind file_chunk uploads
+// (keep this header free of Arduino / ESP-IDF includes, tools/host tests it)
+// ═══════════════════════════════════════════════════════
+
+// Where an incoming chunk falls relative to the window
+enum ChunkPlacement : uint8_t {
+    CHUNK_PLACED,           // New chunk, stored in the returned slot
+    CHUNK_DUPLICATE,        // Already held
+    CHUNK_COMMITTED,        // Below base, already committed (our ack was lost)
+    CHUNK_REJECTED          // Misaligned, oversized, beyond the window or short mid-stream
+};
+
+// Bit i of bitmap = chunk at (base + i * chunkSize) is held in slot
+// ((base / chunkSize + i) % slots). The caller owns the slot storage.
+struct ChunkWindow {
+    static const uint8_t MAX_SLOTS = 32;    // One bitmap bit each
+
+    uint8_t slots;          // 0 = no window
+    size_t chunkSize;
+    uint32_t base;          // Every byte below this offset is committed
+    uint32_t end;           // Wire bytes in the stream (0 = unknown)
+    uint32_t bitmap;
+    uint16_t slotLength[MAX_SLOTS];
+
+    void reset(uint8_t windowSlots, size_t size, uint32_t offset, uint32_t total = 0) {
+        slots = windowSlots;
+        chunkSize = size;
+        base = offset;
+        end = total;
+        bitmap = 0;
+    }
+
+    ChunkPlacement place(uint32_t offset, size_t length, size_t *slot) {
+        if (offset < base) {
+            return CHUNK_COMMITTED;
+        }
+        if (length == 0 || length > chunkSize || (offset - base) % chunkSize != 0 ||
+            (offset - base) / chunkSize >= slots) {
+            return CHUNK_REJECTED;
+        }
+
+        // Only the chunk that ends the stream may be short. Anywhere else it is
+        // a truncated frame, and committing it would misalign every later chunk.
+        if (end != 0 && offset + length > end) {
+            return CHUNK_REJECTED;
+        }
+        if (length < chunkSize && (end == 0 || offset + length != end)) {
+            return CHUNK_REJECTED;
+        }
+
+        uint32_t bit = 1u << ((offset - base) / chunkSize);
+        if (bitmap & bit) {
+            return CHUNK_DUPLICATE;
+        }
+
+        *slot = (offset / chunkSize) % slots;
+        slotLength[*slot] = (uint16_t)length;
+        bitmap |= bit;
+        return CHUNK_PLACED;
+    }
+
+    // The chunk at base is held and can be committed
+    bool ready() const {
+        return bitmap & 1;
+    }
+
+    size_t headSlot() const {
+        return (base / chunkSize) % slots;
+    }
+
+    uint16_t headLength() const {
+        return slotLength[headSlot()];
+    }
+
+    // Drop the committed head chunk. A short chunk can only be the last one.
+    void advance() {
+        uint16_t length = headLength();
+        base += length;
+        bitmap >>= 1;
+        if (length < chunkSize) {
+            bitmap = 0;
+        }
+    }
+
+    // The last slot is held, so nothing more fits until the gap is filled
+    bool blocked() const {
+        return slots > 0 && (bitmap & (1u << (slots - 1)));
+    }
+
+    uint8_t pending() const {
+        return (uint8_t)__builtin_popcount(bitmap);
+    }
+};
@@ -1,4 +1,10 @@
 #include "debug.h"
+#include "../event_msg.h"
+#include <atomic>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 // ═══════════════════════════════════════════════════════
 // INTERNAL STATE
@@ -6,6 +12,152 @@
 
 static uint8_t current_log_level = DEBUG_LOG_LEVEL;
 
+uint8_t debug_log_tag_levels[LOG_TAG_COUNT] = {
+    LOG_FLOOR_SYSTEM, LOG_FLOOR_EVENT, LOG_FLOOR_DECODE, LOG_FLOOR_ENCODE,
+    LOG_FLOOR_FILE, LOG_FLOOR_LUA, LOG_FLOOR_BLE, LOG_FLOOR_STORAGE,
+    LOG_FLOOR_ADC, LOG_FLOOR_MANIFEST, LOG_FLOOR_MODULE, LOG_FLOOR_LOG, LOG_FLOOR_OTHER
+};
+
+// Bounded MPMC ring (Vyukov): a slot is free for position p when its
+// sequence is p, holds a record when it is p + 1, and is handed back for
+// the next lap as p + RING_SLOTS. `turn` stores sequence - slot index so
+// the zero-initialized ring is already valid before debug_log_init().
+struct DebugLogSlot {
+    DebugLogEntry entry;        // First member: commit maps the entry back to its slot
+    std::atomic<uint32_t> turn;
+};
+
+static DebugLogSlot log_ring[LogConfig::RING_SLOTS];
+static std::atomic<uint32_t> log_head(0);
+static std::atomic<uint32_t> log_dropped(0);
+static uint32_t log_tail = 0;                   // Consumer side, under log_drain_mutex
+
+// Records logged by the log task itself are printed on the spot
+static DebugLogEntry log_direct;
+
+static TaskHandle_t log_task = NULL;
+static SemaphoreHandle_t log_drain_mutex = NULL;
+static volatile uint8_t log_sinks = LOG_SINK_SERIAL;
+static uint32_t log_reported_dropped = 0;
+
+// "log" event being filled by the drain
+static uint8_t log_frame[LogFormat::FRAME_BYTES];
+static size_t log_frame_len = 0;
+static uint16_t log_frame_count = 0;
+
+static const char *const level_names[] = { "NONE", "ERROR", "INFO", "DEBUG", "TRACE" };
+
+// ═══════════════════════════════════════════════════════
+// OUTPUT
+// ═══════════════════════════════════════════════════════
+
+static void print_entry(const DebugLogEntry *e) {
+    char line[LogConfig::LINE_BYTES];
+    size_t n = 0;
+
+    if (!(e->flags & LOG_RECORD_CONTINUED)) {
+        const char *level = e->level <= LOG_LEVEL_TRACE ? level_names[e->level] : "?";
+        int w = snprintf(line, sizeof(line), "[%s][%s] ", level, e->tag);
+        n = w > 0 ? min((size_t)w, sizeof(line) - 1) : 0;
+    }
+    n += log_format(line + n, sizeof(line) - n, e->fmt, e->args, e->length);
+
+    // Room is kept for the marker and newline
+    if ((e->flags & LOG_RECORD_TRUNCATED) && n + 4 < sizeof(line)) {
+        memcpy(line + n, "...", 3);
+        n += 3;
+    }
+    if (!(e->flags & LOG_RECORD_PARTIAL)) {
+        if (n + 1 >= sizeof(line)) n = sizeof(line) - 2;
+        line[n++] = '\n';
+    }
+    Serial.write((const uint8_t *)line, n);
+}
+
+static void stream_send() {
+    if (log_frame_count == 0) return;
+
+    LogFrameHeader header;
+    header.version = LogFormat::STREAM_VERSION;
+    header.count = log_frame_count;
+    header.dropped = log_dropped.load(std::memory_order_relaxed);
+    header.flags = header.dropped != log_reported_dropped ? LOG_FRAME_DROPPED : 0;
+    memcpy(log_frame, &header, sizeof(header));
+
+    event_msg_send("log", log_frame, log_frame_len);
+    log_frame_len = sizeof(LogFrameHeader);
+    log_frame_count = 0;
+}
+
+static void stream_append(const DebugLogEntry *e) {
+    if (log_frame_len == 0) {
+        log_frame_len = sizeof(LogFrameHeader);
+    }
+    if (log_frame_len + sizeof(LogRecordHeader) + e->length > sizeof(log_frame)) {
+        stream_send();
+    }
+
+    LogRecordHeader record;
+    record.fmt = (uint32_t)(uintptr_t)e->fmt;
+    record.tag = (uint32_t)(uintptr_t)e->tag;
+    record.time_us = e->time_us;
+    record.level = e->level;
+    record.flags = e->flags;
+    record.length = e->length;
+    memcpy(log_frame + log_frame_len, &record, sizeof(record));
+    memcpy(log_frame + log_frame_len + sizeof(record), e->args, e->length);
+    log_frame_len += sizeof(record) + e->length;
+    log_frame_count++;
+}
+
+// Emit every committed record; true if there were any (caller holds log_drain_mutex)
+static bool drain_locked() {
+    bool any = false;
+    uint8_t sinks = log_sinks;
+
+    for (;;) {
+        uint32_t index = log_tail & (LogConfig::RING_SLOTS - 1);
+        DebugLogSlot &slot = log_ring[index];
+        if (slot.turn.load(std::memory_order_acquire) + index != log_tail + 1) {
+            break;      // Empty, or the next record is still being written
+        }
+
+        if (sinks & LOG_SINK_SERIAL) print_entry(&slot.entry);
+        if (sinks & LOG_SINK_STREAM) stream_append(&slot.entry);
+
+        slot.turn.store(log_tail + LogConfig::RING_SLOTS - index, std::memory_order_release);
+        log_tail++;
+        any = true;
+    }
+
+    // Frame headers flag drops not yet reported, so update the mark after sending
+    uint32_t dropped = log_dropped.load(std::memory_order_relaxed);
+    if (dropped != log_reported_dropped && (sinks & LOG_SINK_SERIAL)) {
+        Serial.printf("[ERROR][LOG] %u records dropped (ring full)\n", dropped - log_reported_dropped);
+    }
+    stream_send();
+    log_reported_dropped = dropped;
+    return any;
+}
+
+static void debug_log_task_fn(void *param) {
+    (void)param;
+    for (;;) {
+        xSemaphoreTake(log_drain_mutex, portMAX_DELAY);
+        bool any = drain_locked();
+        xSemaphoreGive(log_drain_mutex);
+
+        if (!any) {
+            vTaskDelay(pdMS_TO_TICKS(LogConfig::POLL_MS));
+        }
+    }
+}
+
+// Runs from esp_restart() so the last messages still reach the host
+static void debug_log_shutdown_handler(void) {
+    debug_log_flush();
+}
+
 // ═══════════════════════════════════════════════════════
 // PUBLIC API
 // ═══════════════════════════════════════════════════════
@@ -13,10 +165,126 @@ static uint8_t current_log_level = DEBUG_LOG_LEVEL;
 void debug_set_level(uint8_t level) {
     if (level <= LOG_LEVEL_TRACE) {
         current_log_level = level;
-        Serial.printf("[DEBUG] Log level set to: %d\n", level);
+        for (uint8_t tag = 0; tag < LOG_TAG_COUNT; tag++) {
+            debug_log_tag_levels[tag] = level;
+        }
+        LOG_INFO("LOG", "Log level set to: %d", level);
     }
 }
 
 uint8_t debug_get_level() {
     return current_log_level;
 }
+
+void debug_set_tag_level(uint8_t tag, uint8_t level) {
+    if (tag < LOG_TAG_COUNT && level <= LOG_LEVEL_TRACE) {
+        debug_log_tag_levels[tag] = level;
+        LOG_INFO("LOG", "Log level of %s set to: %d", LOG_TAG_NAMES[tag], level);
+    }
+}
+
+uint8_t debug_find_tag(const char *name) {
+    for (uint8_t tag = 0; tag < LOG_TAG_COUNT; tag++) {
+        if (strcmp(name, LOG_TAG_NAMES[tag]) == 0) return tag;
+    }
+    return LOG_TAG_COUNT;
+}
+
+void debug_log_init() {
+    if (log_task != NULL) return;
+
+    log_drain_mutex = xSemaphoreCreateMutex();
+    esp_register_shutdown_handler(debug_log_shutdown_handler);
+    xTaskCreatePinnedToCore(debug_log_task_fn, "LogTask", LogConfig::TASK_STACK, NULL,
+                            LogConfig::TASK_PRIORITY, &log_task, 0);
+}
+
+void debug_log_flush() {
+    if (log_drain_mutex == NULL) return;
+
+    xSemaphoreTake(log_drain_mutex, portMAX_DELAY);
+    drain_locked();
+    xSemaphoreGive(log_drain_mutex);
+    Serial.flush();
+}
+
+void debug_log_set_sinks(uint8_t sinks) {
+    log_sinks = sinks;
+}
+
+uint8_t debug_log_get_sinks() {
+    return log_sinks;
+}
+
+uint32_t debug_log_dropped() {
+    return log_dropped.load(std::memory_order_relaxed);
+}
+
+DebugLogEntry *debug_log_reserve() {
+    // The log task prints its own records directly: queued, they would wait
+    // behind (or, via event_msg, feed back into) the output it is producing
+    if (log_task != NULL && !xPortInIsrContext() && xTaskGetCurrentTaskHandle() == log_task) {
+        return &log_direct;
+    }
+
+    uint32_t pos = log_head.load(std::memory_order_relaxed);
+    for (;;) {
+        uint32_t index = pos & (LogConfig::RING_SLOTS - 1);
+        DebugLogSlot &slot = log_ring[index];
+        int32_t diff = (int32_t)(slot.turn.load(std::memory_order_acquire) + index - pos);
+
+        if (diff == 0) {
+            if (log_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return &slot.entry;
+            }
+        } else if (diff < 0) {
+            // Consumer a full lap behind: drop rather than block the caller
+            log_dropped.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        } else {
+            pos = log_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void debug_log_commit(DebugLogEntry *entry) {
+    entry->time_us = micros();
+    if (entry == &log_direct) {
+        if (log_sinks & LOG_SINK_SERIAL) print_entry(entry);
+        return;
+    }
+
+    DebugLogSlot *slot = reinterpret_cast<DebugLogSlot *>(entry);
+    slot->turn.store(slot->turn.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void debug_log_text(uint8_t level, const char *tag, const char *text, size_t len) {
+    uint8_t id = log_tag_id(tag);
+    if (level > LOG_TAG_FLOORS[id] || level > debug_log_tag_levels[id]) return;
+
+#if !DEBUG_LOG_DEFERRED
+    Serial.printf("[%s][%s] %.*s\n", level <= LOG_LEVEL_TRACE ? level_names[level] : "?", tag, (int)len, text);
+#else
+    static const char *const text_fmt = "%s";
+    const size_t chunk = min(LogConfig::ARG_BYTES - 2, (size_t)255);
+    size_t pos = 0;
+
+    // One record per chunk; the first carries the prefix, the last the newline
+    do {
+        DebugLogEntry *entry = debug_log_reserve();
+        if (!entry) return;
+
+        size_t n = min(len - pos, chunk);
+        entry->level = level;
+        entry->tag = tag;
+        entry->fmt = text_fmt;
+        entry->args[0] = LOG_ARG_STR;
+        entry->args[1] = n;
+        memcpy(entry->args + 2, text + pos, n);
+        entry->length = 2 + n;
+        entry->flags = (pos > 0 ? LOG_RECORD_CONTINUED : 0) | (pos + n < len ? LOG_RECORD_PARTIAL : 0);
+        pos += n;
+        debug_log_commit(entry);
+    } while (pos < len);
+#endif
+}
@@ -2,6 +2,8 @@
 #define DEBUG_H
 
 #include <Arduino.h>
+#include <type_traits>
+#include "log_format.h"
 
 // ═══════════════════════════════════════════════════════
 // DEBUG LOG LEVELS
@@ -23,12 +25,145 @@
 #define DEBUG_LOG_LEVEL LOG_LEVEL_INFO
 #endif
 
+// ═══════════════════════════════════════════════════════
+// LOG TAGS
+// ═══════════════════════════════════════════════════════
+//
+// Every tag belongs to one registry entry: "DECODE" and "DECODE_..." both
+// map to LOG_TAG_DECODE, unlisted tags to LOG_TAG_OTHER. Each entry has a
+// compile-time floor (LOG_* messages above it are not compiled in) and a
+// runtime level, set over the log_config event, checked before a message
+// is recorded.
+// Override floors with build flags, e.g. -DLOG_FLOOR_DECODE=LOG_LEVEL_TRACE.
+
+enum LogTag : uint8_t {
+    LOG_TAG_SYSTEM,
+    LOG_TAG_EVENT,
+    LOG_TAG_DECODE,
+    LOG_TAG_ENCODE,
+    LOG_TAG_FILE,
+    LOG_TAG_LUA,
+    LOG_TAG_BLE,
+    LOG_TAG_STORAGE,
+    LOG_TAG_ADC,
+    LOG_TAG_MANIFEST,
+    LOG_TAG_MODULE,
+    LOG_TAG_LOG,
+    LOG_TAG_OTHER,              // Catch-all, keep last
+    LOG_TAG_COUNT
+};
+
+#ifndef LOG_FLOOR_SYSTEM
+#define LOG_FLOOR_SYSTEM DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_EVENT
+#define LOG_FLOOR_EVENT DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_DECODE
+#define LOG_FLOOR_DECODE DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_ENCODE
+#define LOG_FLOOR_ENCODE DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_FILE
+#define LOG_FLOOR_FILE DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_LUA
+#define LOG_FLOOR_LUA DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_BLE
+#define LOG_FLOOR_BLE DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_STORAGE
+#define LOG_FLOOR_STORAGE DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_ADC
+#define LOG_FLOOR_ADC DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_MANIFEST
+#define LOG_FLOOR_MANIFEST DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_MODULE
+#define LOG_FLOOR_MODULE DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_LOG
+#define LOG_FLOOR_LOG DEBUG_LOG_LEVEL
+#endif
+#ifndef LOG_FLOOR_OTHER
+#define LOG_FLOOR_OTHER DEBUG_LOG_LEVEL
+#endif
+
+// Indexed by LogTag
+constexpr const char *LOG_TAG_NAMES[LOG_TAG_COUNT] = {
+    "SYSTEM", "EVENT", "DECODE", "ENCODE", "FILE", "LUA",
+    "BLE", "STORAGE", "ADC", "MANIFEST", "MODULE", "LOG", "OTHER"
+};
+
+constexpr uint8_t LOG_TAG_FLOORS[LOG_TAG_COUNT] = {
+    LOG_FLOOR_SYSTEM, LOG_FLOOR_EVENT, LOG_FLOOR_DECODE, LOG_FLOOR_ENCODE,
+    LOG_FLOOR_FILE, LOG_FLOOR_LUA, LOG_FLOOR_BLE, LOG_FLOOR_STORAGE,
+    LOG_FLOOR_ADC, LOG_FLOOR_MANIFEST, LOG_FLOOR_MODULE, LOG_FLOOR_LOG, LOG_FLOOR_OTHER
+};
+
+// Runtime level per tag (initially its floor)
+extern uint8_t debug_log_tag_levels[LOG_TAG_COUNT];
+
+// `tag` is `name` or starts with `name` + '_'
+constexpr bool log_tag_matches(const char *tag, const char *name) {
+    return *name == '\0' ? (*tag == '\0' || *tag == '_')
+                         : (*tag == *name && log_tag_matches(tag + 1, name + 1));
+}
+
+// Registry entry of a tag; constant for literal tags
+constexpr uint8_t log_tag_id(const char *tag, uint8_t id = 0) {
+    return id >= LOG_TAG_OTHER ? (uint8_t)LOG_TAG_OTHER
+         : log_tag_matches(tag, LOG_TAG_NAMES[id]) ? id
+         : log_tag_id(tag, id + 1);
+}
+
+// Deferred logging: LOG_* only records the format string address and the
+// raw arguments in a lock-free ring; a low-priority task formats them.
+// Set to 0 to print synchronously from the call site (Serial.printf).
+#ifndef DEBUG_LOG_DEFERRED
+#define DEBUG_LOG_DEFERRED 1
+#endif
+
+// ═══════════════════════════════════════════════════════
+// DEFERRED LOG CONFIGURATION
+// ═══════════════════════════════════════════════════════
+
+namespace LogConfig {
+    const uint32_t RING_SLOTS = 64;              // Records in flight (power of two)
+    const size_t ARG_BYTES = 52;                 // Argument bytes per record (strings are cut to fit)
+    const unsigned long POLL_MS = 10;            // Log task sleep when the ring is empty
+    const size_t LINE_BYTES = 256;               // Formatted line, including the prefix
+    const UBaseType_t TASK_PRIORITY = 1;         // Below every worker task
+    const uint32_t TASK_STACK = 3072;
+}
+
+// Where the log task sends records
+enum LogSink : uint8_t {
+    LOG_SINK_SERIAL = 0x01,     // Formatted text on Serial (default)
+    LOG_SINK_STREAM = 0x02      // Binary "log" events, expanded on the host by tools/log_decoder
+};
+
+// One record as captured at the call site
+struct DebugLogEntry {
+    const char *fmt;
+    const char *tag;
+    uint32_t time_us;
+    uint8_t level;
+    uint8_t flags;              // LogRecordFlags
+    uint8_t length;             // Argument bytes used
+    uint8_t args[LogConfig::ARG_BYTES];
+};
+
 // ═══════════════════════════════════════════════════════
 // PUBLIC API
 // ═══════════════════════════════════════════════════════
 
 /**
- * Set the global log level at runtime
+ * Set the global log level at runtime (and the level of every tag)
  * @param level - One of LOG_LEVEL_* constants
  */
 void debug_set_level(uint8_t level);
@@ -39,61 +174,201 @@ void debug_set_level(uint8_t level);
  */
 uint8_t debug_get_level();
 
+/**
+ * Set the runtime level of one tag (above its floor only _RT messages gain)
+ * @param tag - LogTag
+ * @param level - One of LOG_LEVEL_* constants
+ */
+void debug_set_tag_level(uint8_t tag, uint8_t level);
+
+/**
+ * Registry entry of a tag name, LOG_TAG_COUNT if it is not listed
+ */
+uint8_t debug_find_tag(const char *name);
+
+/**
+ * Start the log task (records logged earlier wait in the ring)
+ */
+void debug_log_init();
+
+/**
+ * Register the "log_config" event handler
+ */
+void debug_log_register_handlers();
+
+/**
+ * Format and emit every queued record now (before deep sleep or a restart)
+ */
+void debug_log_flush();
+
+/**
+ * Select the outputs of the log task
+ * @param sinks - LogSink bits
+ */
+void debug_log_set_sinks(uint8_t sinks);
+
+/**
+ * Current outputs of the log task (LogSink bits)
+ */
+uint8_t debug_log_get_sinks();
+
+/**
+ * Records lost because the ring was full
+ */
+uint32_t debug_log_dropped();
+
+/**
+ * Log text of any length (split over several records, no formatting)
+ */
+void debug_log_text(uint8_t level, const char *tag, const char *text, size_t len);
+
+// Claim a ring slot (NULL when full) and publish it once filled
+DebugLogEntry *debug_log_reserve();
+void debug_log_commit(DebugLogEntry *entry);
+
 // ═══════════════════════════════════════════════════════
-// LOG MACROS
+// ARGUMENT CAPTURE
 // ═══════════════════════════════════════════════════════
 
-// ERROR - Critical errors only
-#if DEBUG_LOG_LEVEL >= LOG_LEVEL_ERROR
-    #define LOG_ERROR(tag, fmt, ...) \
-        Serial.printf("[ERROR][%s] " fmt "\n", tag, ##__VA_ARGS__)
+struct DebugLogArgs {
+    uint8_t *pos;
+    uint8_t *end;
+    bool truncated;
+
+    void put(uint8_t type, const void *value, size_t len) {
+        if ((size_t)(end - pos) < 1 + len) {
+            truncated = true;
+            pos = end;
+            return;
+        }
+        *pos++ = type;
+        memcpy(pos, value, len);
+        pos += len;
+    }
+
+    void put_string(const char *s) {
+        if (!s) s = "(null)";
+        size_t room = end - pos;
+        if (room < 2) {
+            truncated = true;
+            pos = end;
+            return;
+        }
+        size_t len = strnlen(s, room - 2 + 1);
+        if (len > room - 2) {
+            len = room - 2;
+            truncated = true;
+        }
+        pos[0] = LOG_ARG_STR;
+        pos[1] = len;
+        memcpy(pos + 2, s, len);
+        pos += 2 + len;
+    }
+};
+
+inline void debug_log_arg(DebugLogArgs &a, const char *s) { a.put_string(s); }
+inline void debug_log_arg(DebugLogArgs &a, char *s) { a.put_string(s); }
+inline void debug_log_arg(DebugLogArgs &a, double v) { a.put(LOG_ARG_DOUBLE, &v, 8); }
+
+// Integers keep their width: printf reads int-sized values unless told "ll"
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+debug_log_arg(DebugLogArgs &a, T v) {
+    if (sizeof(T) > 4) {
+        int64_t wide = (int64_t)v;
+        a.put(LOG_ARG_I64, &wide, 8);
+    } else {
+        int32_t narrow = (int32_t)v;
+        a.put(LOG_ARG_I32, &narrow, 4);
+    }
+}
+
+// Other pointers (%p) are logged by address
+template <typename T>
+inline void debug_log_arg(DebugLogArgs &a, const T *p) {
+    uint32_t address = (uint32_t)(uintptr_t)p;
+    a.put(LOG_ARG_I32, &address, 4);
+}
+
+template <typename... Args>
+inline void debug_log_write(uint8_t level, const char *tag, const char *fmt, Args... args) {
+    DebugLogEntry *entry = debug_log_reserve();
+    if (!entry) return;
+
+    entry->level = level;
+    entry->tag = tag;
+    entry->fmt = fmt;
+    DebugLogArgs a = { entry->args, entry->args + LogConfig::ARG_BYTES, false };
+    int expand[] = { 0, (debug_log_arg(a, args), 0)... };
+    (void)expand;
+    entry->length = a.pos - entry->args;
+    entry->flags = a.truncated ? LOG_RECORD_TRUNCATED : 0;
+    debug_log_commit(entry);
+}
+
+// Never called: lets the compiler check arguments against the format
+inline void debug_log_check_format(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+inline void debug_log_check_format(const char *fmt, ...) { (void)fmt; }
+
+#if DEBUG_LOG_DEFERRED
+    // "" forces literal tags and formats, whose addresses identify them in the ELF
+    #define DEBUG_LOG_EMIT(level, label, tag, fmt, ...) \
+        do { if (0) debug_log_check_format("%s" fmt, "", ##__VA_ARGS__); \
+             debug_log_write(level, "" tag, "" fmt, ##__VA_ARGS__); } while(0)
 #else
-    #define LOG_ERROR(tag, fmt, ...)
+    #define DEBUG_LOG_EMIT(level, label, tag, fmt, ...) \
+        Serial.printf("[" label "][%s] " fmt "\n", tag, ##__VA_ARGS__)
 #endif
 
+// Registry entry of a literal tag, folded at compile time
+#define DEBUG_LOG_TAG_ID(tag) (std::integral_constant<uint8_t, log_tag_id("" tag)>::value)
+
+// Compile-time floor first: a disabled tag leaves a constant-false branch and
+// the call, its format string and arguments are discarded
+#define DEBUG_LOG_GATED(level, label, tag, fmt, ...) \
+    do { if (std::integral_constant<bool, (level) <= LOG_TAG_FLOORS[log_tag_id("" tag)]>::value && \
+             debug_log_tag_levels[DEBUG_LOG_TAG_ID(tag)] >= (level)) \
+        DEBUG_LOG_EMIT(level, label, tag, fmt, ##__VA_ARGS__); } while(0)
+
+// ═══════════════════════════════════════════════════════
+// LOG MACROS
+// ═══════════════════════════════════════════════════════
+
+// ERROR - Critical errors only
+#define LOG_ERROR(tag, fmt, ...) \
+    DEBUG_LOG_GATED(LOG_LEVEL_ERROR, "ERROR", tag, fmt, ##__VA_ARGS__)
+
 // INFO - General information messages
-#if DEBUG_LOG_LEVEL >= LOG_LEVEL_INFO
-    #define LOG_INFO(tag, fmt, ...) \
-        Serial.printf("[INFO][%s] " fmt "\n", tag, ##__VA_ARGS__)
-#else
-    #define LOG_INFO(tag, fmt, ...)
-#endif
+#define LOG_INFO(tag, fmt, ...) \
+    DEBUG_LOG_GATED(LOG_LEVEL_INFO, "INFO", tag, fmt, ##__VA_ARGS__)
 
 // DEBUG - Detailed debugging information
-#if DEBUG_LOG_LEVEL >= LOG_LEVEL_DEBUG
-    #define LOG_DEBUG(tag, fmt, ...) \
-        Serial.printf("[DEBUG][%s] " fmt "\n", tag, ##__VA_ARGS__)
-#else
-    #define LOG_DEBUG(tag, fmt, ...)
-#endif
+#define LOG_DEBUG(tag, fmt, ...) \
+    DEBUG_LOG_GATED(LOG_LEVEL_DEBUG, "DEBUG", tag, fmt, ##__VA_ARGS__)
 
 // TRACE - Very verbose trace information
-#if DEBUG_LOG_LEVEL >= LOG_LEVEL_TRACE
-    #define LOG_TRACE(tag, fmt, ...) \
-        Serial.printf("[TRACE][%s] " fmt "\n", tag, ##__VA_ARGS__)
-#else
-    #define LOG_TRACE(tag, fmt, ...)
-#endif
+#define LOG_TRACE(tag, fmt, ...) \
+    DEBUG_LOG_GATED(LOG_LEVEL_TRACE, "TRACE", tag, fmt, ##__VA_ARGS__)
 
 // ═══════════════════════════════════════════════════════
 // RUNTIME LOG MACROS (check level at runtime)
 // ═══════════════════════════════════════════════════════
 
-// These macros check the runtime log level (can be changed on the fly)
+// Always compiled in, whatever the tag's floor; only the runtime level applies
 #define LOG_ERROR_RT(tag, fmt, ...) \
-    do { if (debug_get_level() >= LOG_LEVEL_ERROR) \
-        Serial.printf("[ERROR][%s] " fmt "\n", tag, ##__VA_ARGS__); } while(0)
+    do { if (debug_log_tag_levels[DEBUG_LOG_TAG_ID(tag)] >= LOG_LEVEL_ERROR) \
+        DEBUG_LOG_EMIT(LOG_LEVEL_ERROR, "ERROR", tag, fmt, ##__VA_ARGS__); } while(0)
 
 #define LOG_INFO_RT(tag, fmt, ...) \
-    do { if (debug_get_level() >= LOG_LEVEL_INFO) \
-        Serial.printf("[INFO][%s] " fmt "\n", tag, ##__VA_ARGS__); } while(0)
+    do { if (debug_log_tag_levels[DEBUG_LOG_TAG_ID(tag)] >= LOG_LEVEL_INFO) \
+        DEBUG_LOG_EMIT(LOG_LEVEL_INFO, "INFO", tag, fmt, ##__VA_ARGS__); } while(0)
 
 #define LOG_DEBUG_RT(tag, fmt, ...) \
-    do { if (debug_get_level() >= LOG_LEVEL_DEBUG) \
-        Serial.printf("[DEBUG][%s] " fmt "\n", tag, ##__VA_ARGS__); } while(0)
+    do { if (debug_log_tag_levels[DEBUG_LOG_TAG_ID(tag)] >= LOG_LEVEL_DEBUG) \
+        DEBUG_LOG_EMIT(LOG_LEVEL_DEBUG, "DEBUG", tag, fmt, ##__VA_ARGS__); } while(0)
 
 #define LOG_TRACE_RT(tag, fmt, ...) \
-    do { if (debug_get_level() >= LOG_LEVEL_TRACE) \
-        Serial.printf("[TRACE][%s] " fmt "\n", tag, ##__VA_ARGS__); } while(0)
+    do { if (debug_log_tag_levels[DEBUG_LOG_TAG_ID(tag)] >= LOG_LEVEL_TRACE) \
+        DEBUG_LOG_EMIT(LOG_LEVEL_TRACE, "TRACE", tag, fmt, ##__VA_ARGS__); } while(0)
 
 #endif // DEBUG_H
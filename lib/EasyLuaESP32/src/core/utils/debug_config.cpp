@@ -0,0 +1,63 @@
+#include "debug.h"
+#include "../event_msg.h"
+#include <ArduinoJson.h>
+
+// The log_config event, apart from debug.cpp so the logging core carries
+// no JSON dependency (tools/host builds it on its own)
+
+// ═══════════════════════════════════════════════════════
+// EVENT HANDLER
+// ═══════════════════════════════════════════════════════
+
+// {"serial", "stream", "level", "tags": {"DECODE": 4, ...}} - all optional;
+// replies with log_status
+static void handleLogConfig(const std::vector<uint8_t> &data) {
+    DynamicJsonDocument doc(512);
+    deserializeJson(doc, (const char *)data.data(), data.size());
+
+    uint8_t sinks = debug_log_get_sinks();
+    if (!doc["serial"].isNull()) {
+        sinks = doc["serial"].as<bool>() ? (sinks | LOG_SINK_SERIAL) : (sinks & ~LOG_SINK_SERIAL);
+    }
+    if (!doc["stream"].isNull()) {
+        sinks = doc["stream"].as<bool>() ? (sinks | LOG_SINK_STREAM) : (sinks & ~LOG_SINK_STREAM);
+    }
+    debug_log_set_sinks(sinks);
+    if (!doc["level"].isNull()) {
+        debug_set_level(doc["level"].as<uint8_t>());
+    }
+
+    // Applied after "level" so a request can lower everything but one tag
+    JsonObject tags = doc["tags"].as<JsonObject>();
+    for (JsonPair kv : tags) {
+        uint8_t tag = debug_find_tag(kv.key().c_str());
+        if (tag < LOG_TAG_COUNT) {
+            debug_set_tag_level(tag, kv.value().as<uint8_t>());
+        } else {
+            LOG_ERROR("LOG", "Unknown log tag: %s", kv.key().c_str());
+        }
+    }
+
+    DynamicJsonDocument reply(768);
+    reply["serial"] = (debug_log_get_sinks() & LOG_SINK_SERIAL) != 0;
+    reply["stream"] = (debug_log_get_sinks() & LOG_SINK_STREAM) != 0;
+    reply["level"] = debug_get_level();
+    reply["deferred"] = DEBUG_LOG_DEFERRED != 0;
+    reply["dropped"] = debug_log_dropped();
+
+    // Per tag: [runtime level, compile-time floor]
+    JsonObject levels = reply.createNestedObject("tags");
+    for (uint8_t tag = 0; tag < LOG_TAG_COUNT; tag++) {
+        JsonArray entry = levels.createNestedArray(LOG_TAG_NAMES[tag]);
+        entry.add(debug_log_tag_levels[tag]);
+        entry.add(LOG_TAG_FLOORS[tag]);
+    }
+
+    String json;
+    serializeJson(reply, json);
+    event_msg_send("log_status", (const uint8_t *)json.c_str(), json.length());
+}
+
+void debug_log_register_handlers() {
+    event_msg_on("log_config", handleLogConfig);
+}
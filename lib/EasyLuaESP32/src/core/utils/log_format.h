@@ -0,0 +1,257 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// ═══════════════════════════════════════════════════════
+// DEFERRED LOG RECORDS - shared by the device and tools/log_decoder
+// (keep this header free of Arduino / ESP-IDF includes)
+// ═══════════════════════════════════════════════════════
+//
+// A LOG_* call stores the address of its format string and tag plus the
+// raw argument values; the text is produced later by the log task, or on
+// the host from the firmware ELF when records are streamed.
+//
+// Arguments: back-to-back [type u8][value]
+//   LOG_ARG_I32 / LOG_ARG_I64   raw little-endian integer
+//   LOG_ARG_DOUBLE              raw little-endian double (floats are promoted)
+//   LOG_ARG_STR                 [len u8][bytes] - copied, cut to fit the record
+
+namespace LogFormat {
+    const uint8_t STREAM_VERSION = 1;
+    const size_t FRAME_BYTES = 480;      // Max "log" event payload
+    const size_t MAX_ARG_BYTES = 255;    // Record length field is one byte
+}
+
+enum LogArgType : uint8_t {
+    LOG_ARG_I32 = 1,
+    LOG_ARG_I64 = 2,
+    LOG_ARG_DOUBLE = 3,
+    LOG_ARG_STR = 4
+};
+
+// Flags in LogRecordHeader
+enum LogRecordFlags : uint8_t {
+    LOG_RECORD_TRUNCATED = 0x01,    // Arguments did not fit; the tail is missing or cut
+    LOG_RECORD_CONTINUED = 0x02,    // Continues the previous record's line (no prefix)
+    LOG_RECORD_PARTIAL = 0x04       // Line continues in the next record (no newline)
+};
+
+// Flags in LogFrameHeader
+enum LogFrameFlags : uint8_t {
+    LOG_FRAME_DROPPED = 0x01        // `dropped` grew since the previous frame
+};
+
+// Payload of "log" (little-endian, packed), followed by `count` records
+struct __attribute__((packed)) LogFrameHeader {
+    uint8_t version;        // LogFormat::STREAM_VERSION
+    uint8_t flags;          // LogFrameFlags
+    uint16_t count;         // Records in this frame
+    uint32_t dropped;       // Records lost to a full ring since boot
+};
+
+// One record in a "log" frame, followed by `length` argument bytes
+struct __attribute__((packed)) LogRecordHeader {
+    uint32_t fmt;           // Format string address (look up in the ELF)
+    uint32_t tag;           // Tag string address
+    uint32_t time_us;       // micros() when logged
+    uint8_t level;          // LOG_LEVEL_*
+    uint8_t flags;          // LogRecordFlags
+    uint8_t length;         // Argument bytes
+};
+
+// Next argument of a record; false when the record has no more
+struct LogArgReader {
+    const uint8_t *pos;
+    const uint8_t *end;
+
+    bool next(uint8_t &type, uint64_t &bits, const char *&str, size_t &len) {
+        if (pos >= end) return false;
+        type = *pos++;
+        bits = 0;
+        str = NULL;
+        len = 0;
+
+        switch (type) {
+            case LOG_ARG_I32:
+                if (end - pos < 4) return false;
+                memcpy(&bits, pos, 4);
+                pos += 4;
+                return true;
+            case LOG_ARG_I64:
+            case LOG_ARG_DOUBLE:
+                if (end - pos < 8) return false;
+                memcpy(&bits, pos, 8);
+                pos += 8;
+                return true;
+            case LOG_ARG_STR:
+                if (pos >= end || (size_t)(end - pos) < 1u + *pos) return false;
+                len = *pos++;
+                str = (const char *)pos;
+                pos += len;
+                return true;
+            default:
+                return false;
+        }
+    }
+};
+
+// Integer argument widened as printf would read it for `conv`
+inline long long log_format_int(uint8_t type, uint64_t bits, char conv, const char *length) {
+    bool is_signed = conv == 'd' || conv == 'i';
+    if (type == LOG_ARG_DOUBLE) {
+        double d;
+        memcpy(&d, &bits, 8);
+        return (long long)d;
+    }
+    if (type == LOG_ARG_I32) {
+        bits = is_signed ? (uint64_t)(int64_t)(int32_t)bits : (bits & 0xFFFFFFFFu);
+    }
+    if (length[0] == 'h' && length[1] == 'h') {
+        return is_signed ? (long long)(int8_t)bits : (long long)(uint8_t)bits;
+    }
+    if (length[0] == 'h') {
+        return is_signed ? (long long)(int16_t)bits : (long long)(uint16_t)bits;
+    }
+    return (long long)bits;
+}
+
+// Expand a format string with recorded arguments. Always NUL-terminates;
+// returns the length written. Missing arguments print as '?'.
+inline size_t log_format(char *out, size_t size, const char *fmt, const uint8_t *args, size_t args_len) {
+    if (size == 0) return 0;
+
+    LogArgReader reader = { args, args + args_len };
+    size_t n = 0;
+
+    #define LOG_FORMAT_PUT(text) \
+        do { int w = (text); if (w > 0) n += (size_t)w < size - n ? (size_t)w : size - n - 1; } while (0)
+
+    while (*fmt && n + 1 < size) {
+        if (*fmt != '%') {
+            out[n++] = *fmt++;
+            continue;
+        }
+        const char *spec_start = fmt++;
+        if (*fmt == '%') {
+            out[n++] = '%';
+            fmt++;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conv; '*' widths take an argument
+        char spec[32];
+        size_t s = 0;
+        spec[s++] = '%';
+        int star_values[2];
+        int stars = 0;
+        while (*fmt && strchr("-+ #0", *fmt) && s < 8) spec[s++] = *fmt++;
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*fmt != '.') break;
+                spec[s++] = *fmt++;
+            }
+            if (*fmt == '*') {
+                uint8_t type;
+                uint64_t bits;
+                const char *str;
+                size_t len;
+                star_values[stars++] = reader.next(type, bits, str, len) ? (int)log_format_int(type, bits, 'd', "") : 0;
+                spec[s++] = '*';
+                fmt++;
+            } else {
+                while (*fmt >= '0' && *fmt <= '9' && s < 20) spec[s++] = *fmt++;
+            }
+        }
+        char length[3] = { 0, 0, 0 };
+        size_t l = 0;
+        while (*fmt && strchr("hlLqjzt", *fmt) && l < 2) length[l++] = *fmt++;
+        char conv = *fmt;
+        if (!conv) break;
+        fmt++;
+
+        uint8_t type;
+        uint64_t bits;
+        const char *str;
+        size_t len;
+        bool have = reader.next(type, bits, str, len);
+        if (!have && conv != 'n') {
+            out[n++] = '?';
+            continue;
+        }
+
+        char *dst = out + n;
+        size_t room = size - n;
+        switch (conv) {
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c': {
+                if (type == LOG_ARG_STR) {
+                    out[n++] = '?';
+                    break;
+                }
+                long long v = log_format_int(type, bits, conv, length);
+                if (conv == 'c') {
+                    spec[s++] = 'c';
+                    spec[s] = '\0';
+                    LOG_FORMAT_PUT(stars == 2 ? snprintf(dst, room, spec, star_values[0], star_values[1], (int)v)
+                                 : stars == 1 ? snprintf(dst, room, spec, star_values[0], (int)v)
+                                 : snprintf(dst, room, spec, (int)v));
+                    break;
+                }
+                spec[s++] = 'l';
+                spec[s++] = 'l';
+                spec[s++] = conv;
+                spec[s] = '\0';
+                LOG_FORMAT_PUT(stars == 2 ? snprintf(dst, room, spec, star_values[0], star_values[1], v)
+                             : stars == 1 ? snprintf(dst, room, spec, star_values[0], v)
+                             : snprintf(dst, room, spec, v));
+                break;
+            }
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                if (type == LOG_ARG_STR) {
+                    out[n++] = '?';
+                    break;
+                }
+                double d;
+                if (type == LOG_ARG_DOUBLE) {
+                    memcpy(&d, &bits, 8);
+                } else {
+                    d = (double)log_format_int(type, bits, 'd', "");
+                }
+                spec[s++] = conv;
+                spec[s] = '\0';
+                LOG_FORMAT_PUT(stars == 2 ? snprintf(dst, room, spec, star_values[0], star_values[1], d)
+                             : stars == 1 ? snprintf(dst, room, spec, star_values[0], d)
+                             : snprintf(dst, room, spec, d));
+                break;
+            }
+            case 's': {
+                if (type != LOG_ARG_STR) {
+                    out[n++] = '?';
+                    break;
+                }
+                char text[LogFormat::MAX_ARG_BYTES + 1];
+                memcpy(text, str, len);
+                text[len] = '\0';
+                spec[s++] = 's';
+                spec[s] = '\0';
+                LOG_FORMAT_PUT(stars == 2 ? snprintf(dst, room, spec, star_values[0], star_values[1], text)
+                             : stars == 1 ? snprintf(dst, room, spec, star_values[0], text)
+                             : snprintf(dst, room, spec, text));
+                break;
+            }
+            case 'p':
+                LOG_FORMAT_PUT(snprintf(dst, room, "0x%08llx", (unsigned long long)bits));
+                break;
+            default:
+                // %n and unknown conversions print the spec itself
+                LOG_FORMAT_PUT(snprintf(dst, room, "%.*s", (int)(fmt - spec_start), spec_start));
+                break;
+        }
+    }
+
+    #undef LOG_FORMAT_PUT
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ═══════════════════════════════════════════════════════
+// DELTA SYNC - shared by the device and tools/delta_sync
+// (keep this header free of Arduino / ESP-IDF includes)
+// ═══════════════════════════════════════════════════════
+
+namespace DeltaSync {
+    const size_t DEFAULT_BLOCK_SIZE = 512;
+    const size_t MIN_BLOCK_SIZE = 64;
+    const size_t MAX_BLOCK_SIZE = 4096;
+
+    // file_signature_data: [first_block u32][{rolling u32, strong u32} ...]
+    const size_t SIG_ENTRY_SIZE = 8;
+    const size_t SIG_ENTRIES_PER_FRAME = 60;
+
+    // file_delta_ops: back-to-back ops, never split across frames
+    const uint8_t OP_COPY = 0x01;       // [op][block u32][count u16] - copy blocks from the old file
+    const uint8_t OP_LITERAL = 0x02;    // [op][length u16][bytes]    - new data
+    const size_t OPS_FRAME_SIZE = 480;  // Max ops payload per frame
+}
+
+// rsync-style weak checksum: a = sum of bytes, b = sum of running a.
+// Can be slid one byte at a time, so the host finds old blocks at any offset.
+struct RollingChecksum {
+    uint32_t a;
+    uint32_t b;
+    size_t length;
+
+    void init(const uint8_t *data, size_t n) {
+        a = 0;
+        b = 0;
+        length = n;
+        for (size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+    }
+
+    // Drop `out` from the front of the window and append `in`
+    void roll(uint8_t out, uint8_t in) {
+        a = a - out + in;
+        b = b - (uint32_t)length * out + a;
+    }
+
+    uint32_t value() const {
+        return (a & 0xFFFF) | (b << 16);
+    }
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ═══════════════════════════════════════════════════════
+// ADC BACKEND - continuous sample source behind adc_capture
+// ═══════════════════════════════════════════════════════
+//
+// adc_backend_read() blocks until `count` samples are in (the hardware
+// paces it) and returns how many arrived. On the classic ESP32 samples
+// come from the I2S peripheral in built-in ADC mode, by DMA; build with
+// -DADC_HOST_MOCK=1 for a synthetic source off-target.
+
+#ifndef ADC_HOST_MOCK
+#define ADC_HOST_MOCK 0
+#endif
+
+#if ADC_HOST_MOCK
+
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Sine wave plus a slow ramp, so blocks can be checked for continuity
+namespace AdcMock {
+    extern float frequency;         // Hz of the sine
+    extern bool realtime;           // Sleep for the block duration (else as fast as read)
+    extern uint32_t position;       // Samples produced since start
+    extern uint32_t rate;
+}
+
+inline bool adc_backend_start(uint8_t pin, uint32_t rate, size_t block_samples) {
+    (void)pin;
+    (void)block_samples;
+    AdcMock::position = 0;
+    AdcMock::rate = rate;
+    return true;
+}
+
+inline size_t adc_backend_read(uint16_t *out, size_t count) {
+    const float TWO_PI_F = 6.2831853f;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t n = AdcMock::position++;
+        float phase = TWO_PI_F * AdcMock::frequency * (float)n / (float)AdcMock::rate;
+        out[i] = (uint16_t)(2048.0f + 1500.0f * sinf(phase) + (float)(n % 256));
+    }
+    if (AdcMock::realtime) {
+        vTaskDelay(pdMS_TO_TICKS(count * 1000 / AdcMock::rate));
+    }
+    return count;
+}
+
+inline void adc_backend_stop() {
+}
+
+#elif CONFIG_IDF_TARGET_ESP32
+
+#include <Arduino.h>
+#include <driver/i2s.h>
+#include <driver/adc.h>
+
+const i2s_port_t ADC_BACKEND_I2S = I2S_NUM_0;      // Only I2S0 can sample the ADC
+
+static uint32_t adc_backend_rate = 0;
+
+inline bool adc_backend_start(uint8_t pin, uint32_t rate, size_t block_samples) {
+    int8_t channel = digitalPinToAnalogChannel(pin);
+    if (channel < 0 || channel >= ADC1_CHANNEL_MAX) {
+        return false;       // I2S sampling is ADC1-only
+    }
+
+    i2s_config_t config = {};
+    config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+    config.sample_rate = rate;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+    config.intr_alloc_flags = 0;
+    config.dma_buf_count = 4;
+    config.dma_buf_len = block_samples > 1024 ? 1024 : block_samples;
+    config.use_apll = false;
+
+    if (i2s_driver_install(ADC_BACKEND_I2S, &config, 0, NULL) != ESP_OK) {
+        return false;
+    }
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten((adc1_channel_t)channel, ADC_ATTEN_DB_11);
+    if (i2s_set_adc_mode(ADC_UNIT_1, (adc1_channel_t)channel) != ESP_OK ||
+        i2s_adc_enable(ADC_BACKEND_I2S) != ESP_OK) {
+        i2s_driver_uninstall(ADC_BACKEND_I2S);
+        return false;
+    }
+    adc_backend_rate = rate;
+    return true;
+}
+
+inline size_t adc_backend_read(uint16_t *out, size_t count) {
+    size_t bytes = 0;
+    // Two block durations before giving up (driver stopped or stalled)
+    TickType_t timeout = pdMS_TO_TICKS(2000 * count / adc_backend_rate + 20);
+    i2s_read(ADC_BACKEND_I2S, out, count * sizeof(uint16_t), &bytes, timeout);
+    size_t n = bytes / sizeof(uint16_t);
+
+    // DMA words hold two samples in swapped order; the top 4 bits carry
+    // the channel number
+    for (size_t i = 0; i + 1 < n; i += 2) {
+        uint16_t first = out[i + 1] & 0x0FFF;
+        out[i + 1] = out[i] & 0x0FFF;
+        out[i] = first;
+    }
+    if (n & 1) out[n - 1] &= 0x0FFF;
+    return n;
+}
+
+inline void adc_backend_stop() {
+    i2s_adc_disable(ADC_BACKEND_I2S);
+    i2s_driver_uninstall(ADC_BACKEND_I2S);
+}
+
+#else
+
+// Other chips have no I2S ADC mode (their continuous ADC driver is not wired up yet)
+inline bool adc_backend_start(uint8_t pin, uint32_t rate, size_t block_samples) {
+    (void)pin;
+    (void)rate;
+    (void)block_samples;
+    return false;
+}
+
+inline size_t adc_backend_read(uint16_t *out, size_t count) {
+    (void)out;
+    (void)count;
+    return 0;
+}
+
+inline void adc_backend_stop() {
+}
+
+#endif
@@ -0,0 +1,261 @@
+#include "adc_capture.h"
+#include "adc_backend.h"
+#include "../../core/event_msg.h"
+#include "../../core/utils/debug.h"
+#include <Arduino.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#if ADC_HOST_MOCK
+namespace AdcMock {
+    float frequency = 50.0f;
+    bool realtime = true;
+    uint32_t position = 0;
+    uint32_t rate = 0;
+}
+#endif
+
+// ═══════════════════════════════════════════════════════
+// INTERNAL STATE
+// ═══════════════════════════════════════════════════════
+
+static AdcCaptureConfig adc_config;
+static AdcBlock adc_blocks[AdcConfig::MAX_BLOCKS];
+static uint16_t *adc_samples = NULL;           // blocks * block_samples, one allocation
+static uint16_t *adc_scratch = NULL;           // Landing area when every block is taken
+
+// Block indexes: free -> capture task -> filled -> consumer -> free
+static QueueHandle_t adc_free_queue = NULL;
+static QueueHandle_t adc_filled_queue = NULL;
+
+static TaskHandle_t adc_task = NULL;
+static TaskHandle_t adc_stream_task = NULL;
+static volatile bool adc_stream_stop = false;
+static void (*adc_stop_callback)() = NULL;
+static TaskHandle_t adc_stopper = NULL;
+static volatile bool adc_stop_requested = false;
+static bool adc_claimed = false;                // A C consumer owns the filled queue
+
+static uint32_t adc_seq = 0;
+static uint32_t adc_dropped = 0;
+
+// ═══════════════════════════════════════════════════════
+// STREAMING
+// ═══════════════════════════════════════════════════════
+
+// "adc_block" payload header (little-endian, packed), followed by samples
+struct __attribute__((packed)) AdcStreamHeader {
+    uint32_t seq;
+    uint32_t time_us;
+    uint32_t rate;
+    uint16_t offset;            // First sample of this event within the block
+    uint16_t count;
+};
+
+static void stream_block(const AdcBlock &block) {
+    uint8_t payload[sizeof(AdcStreamHeader) + AdcConfig::STREAM_SAMPLES * sizeof(uint16_t)];
+    for (uint16_t offset = 0; offset < block.count; offset += AdcConfig::STREAM_SAMPLES) {
+        AdcStreamHeader header;
+        header.seq = block.seq;
+        header.time_us = block.time_us;
+        header.rate = adc_config.rate;
+        header.offset = offset;
+        header.count = min((uint16_t)(block.count - offset), AdcConfig::STREAM_SAMPLES);
+
+        memcpy(payload, &header, sizeof(header));
+        memcpy(payload + sizeof(header), block.samples + offset, header.count * sizeof(uint16_t));
+        event_msg_send(AdcConfig::STREAM_EVENT, payload, sizeof(header) + header.count * sizeof(uint16_t));
+    }
+}
+
+// Ordinary consumer of the filled queue: a slow link drops whole blocks
+// (counted, with a seq gap) instead of stalling the capture task
+static void adc_stream_task_fn(void *param) {
+    (void)param;
+    while (!adc_stream_stop) {
+        const AdcBlock *block = adc_capture_take(50);
+        if (block == NULL) continue;
+        stream_block(*block);
+        adc_capture_release(block);
+    }
+
+    TaskHandle_t stopper = adc_stopper;
+    adc_stream_task = NULL;
+    if (stopper) xTaskNotifyGive(stopper);
+    vTaskDelete(NULL);
+}
+
+// ═══════════════════════════════════════════════════════
+// CAPTURE TASK
+// ═══════════════════════════════════════════════════════
+
+static void adc_capture_task_fn(void *param) {
+    (void)param;
+    uint32_t block_us = (uint32_t)((uint64_t)adc_config.block_samples * 1000000 / adc_config.rate);
+
+    while (!adc_stop_requested) {
+        // Consumer behind: recycle its oldest unread block
+        uint8_t index;
+        bool have = xQueueReceive(adc_free_queue, &index, 0) == pdTRUE;
+        if (!have && xQueueReceive(adc_filled_queue, &index, 0) == pdTRUE) {
+            adc_dropped++;
+            have = true;
+        }
+
+        // Every block held by the consumer: keep the DMA drained regardless
+        uint16_t *target = have ? adc_blocks[index].samples : adc_scratch;
+        size_t n = adc_backend_read(target, adc_config.block_samples);
+        uint32_t now = micros();
+        uint32_t seq = adc_seq++;
+
+        if (!have) {
+            adc_dropped++;
+            continue;
+        }
+        if (n < adc_config.block_samples) {
+            // Stalled or stopping: this block is not contiguous, drop it
+            adc_dropped++;
+            xQueueSend(adc_free_queue, &index, 0);
+            continue;
+        }
+
+        AdcBlock &block = adc_blocks[index];
+        block.seq = seq;
+        block.time_us = now - block_us;
+        block.count = (uint16_t)n;
+
+        xQueueSend(adc_filled_queue, &index, 0);
+    }
+
+    TaskHandle_t stopper = adc_stopper;
+    adc_task = NULL;
+    if (stopper) xTaskNotifyGive(stopper);
+    vTaskDelete(NULL);
+}
+
+// ═══════════════════════════════════════════════════════
+// PUBLIC API
+// ═══════════════════════════════════════════════════════
+
+bool adc_capture_start(const AdcCaptureConfig &config) {
+    adc_capture_stop();
+
+    if (config.rate < AdcConfig::MIN_RATE || config.rate > AdcConfig::MAX_RATE ||
+        config.block_samples == 0 || config.block_samples > AdcConfig::MAX_BLOCK ||
+        config.blocks < 2 || config.blocks > AdcConfig::MAX_BLOCKS) {
+        return false;
+    }
+
+    size_t block_bytes = config.block_samples * sizeof(uint16_t);
+    adc_samples = (uint16_t *)malloc(block_bytes * config.blocks);
+    adc_scratch = (uint16_t *)malloc(block_bytes);
+    adc_free_queue = xQueueCreate(config.blocks, sizeof(uint8_t));
+    adc_filled_queue = xQueueCreate(config.blocks, sizeof(uint8_t));
+    if (!adc_samples || !adc_scratch || !adc_free_queue || !adc_filled_queue) {
+        LOG_ERROR("ADC", "Out of memory for %u x %u samples", config.blocks, config.block_samples);
+        adc_capture_stop();
+        return false;
+    }
+
+    adc_config = config;
+    for (uint8_t i = 0; i < config.blocks; i++) {
+        adc_blocks[i].samples = adc_samples + (size_t)i * config.block_samples;
+        adc_blocks[i].count = 0;
+        xQueueSend(adc_free_queue, &i, 0);
+    }
+
+    if (!adc_backend_start(config.pin, config.rate, config.block_samples)) {
+        LOG_ERROR("ADC", "Continuous sampling unavailable on pin %u", config.pin);
+        adc_capture_stop();
+        return false;
+    }
+
+    adc_seq = 0;
+    adc_dropped = 0;
+    adc_stop_requested = false;
+    xTaskCreatePinnedToCore(adc_capture_task_fn, "AdcCapture", AdcConfig::TASK_STACK, NULL,
+                            AdcConfig::TASK_PRIORITY, &adc_task, 0);
+    if (config.stream) {
+        adc_claimed = true;
+        adc_stream_stop = false;
+        xTaskCreatePinnedToCore(adc_stream_task_fn, "AdcStream", AdcConfig::STREAM_TASK_STACK, NULL,
+                                AdcConfig::STREAM_TASK_PRIORITY, &adc_stream_task, 0);
+    }
+
+    LOG_INFO("ADC", "Sampling pin %u at %u Hz, %u x %u samples%s", config.pin, config.rate,
+             config.blocks, config.block_samples, config.stream ? " (streaming)" : "");
+    return true;
+}
+
+void adc_capture_stop() {
+    if (adc_stream_task != NULL) {
+        // Finishes the event it is sending first
+        adc_stopper = xTaskGetCurrentTaskHandle();
+        adc_stream_stop = true;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        adc_stopper = NULL;
+    }
+
+    if (adc_task != NULL) {
+        if (adc_stop_callback) adc_stop_callback();
+
+        // The task finishes its current read (at most a couple of block times)
+        adc_stopper = xTaskGetCurrentTaskHandle();
+        adc_stop_requested = true;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        adc_stopper = NULL;
+        adc_backend_stop();
+        LOG_INFO("ADC", "Sampling stopped (%u blocks, %u dropped)", adc_seq, adc_dropped);
+    }
+
+    if (adc_free_queue) vQueueDelete(adc_free_queue);
+    if (adc_filled_queue) vQueueDelete(adc_filled_queue);
+    adc_free_queue = NULL;
+    adc_filled_queue = NULL;
+    free(adc_samples);
+    free(adc_scratch);
+    adc_samples = NULL;
+    adc_scratch = NULL;
+    adc_claimed = false;
+}
+
+void adc_capture_on_stop(void (*callback)()) {
+    adc_stop_callback = callback;
+}
+
+bool adc_capture_running() {
+    return adc_task != NULL;
+}
+
+void adc_capture_claim(bool claimed) {
+    adc_claimed = claimed;
+}
+
+bool adc_capture_claimed() {
+    return adc_claimed;
+}
+
+const AdcBlock *adc_capture_take(uint32_t timeout_ms) {
+    uint8_t index;
+    if (adc_filled_queue == NULL || xQueueReceive(adc_filled_queue, &index, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return NULL;
+    }
+    return &adc_blocks[index];
+}
+
+void adc_capture_release(const AdcBlock *block) {
+    if (block == NULL || adc_free_queue == NULL) return;
+    uint8_t index = (uint8_t)(block - adc_blocks);
+    xQueueSend(adc_free_queue, &index, 0);
+}
+
+AdcCaptureStats adc_capture_stats() {
+    AdcCaptureStats stats;
+    stats.running = adc_task != NULL;
+    stats.rate = adc_config.rate;
+    stats.block_samples = adc_config.block_samples;
+    stats.blocks = adc_seq;
+    stats.dropped = adc_dropped;
+    stats.queued = adc_filled_queue ? uxQueueMessagesWaiting(adc_filled_queue) : 0;
+    return stats;
+}
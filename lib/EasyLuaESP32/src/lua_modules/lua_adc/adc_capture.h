@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+
+// ═══════════════════════════════════════════════════════
+// ADC CAPTURE - continuous sampling into a ring of blocks
+// ═══════════════════════════════════════════════════════
+//
+// A capture task reads fixed-size blocks from the ADC backend at a fixed
+// rate. Filled blocks wait in a queue for one consumer (Lua, or C code
+// via adc_capture_take/release); when the consumer falls behind the oldest
+// unread block is recycled and counted as dropped, so `seq` shows the gap.
+// In stream mode that consumer is a low-priority task sending events.
+
+namespace AdcConfig {
+    const uint32_t MIN_RATE = 1000;              // Samples per second
+    const uint32_t MAX_RATE = 200000;
+    const uint16_t DEFAULT_BLOCK = 256;          // Samples per block
+    const uint16_t MAX_BLOCK = 4096;
+    const uint8_t DEFAULT_BLOCKS = 8;            // Blocks in the ring
+    const uint8_t MAX_BLOCKS = 32;
+    const uint16_t STREAM_SAMPLES = 232;         // Samples per "adc_block" event (480-byte payload)
+    const UBaseType_t TASK_PRIORITY = 5;         // Above LuaTask: sampling must not wait for scripts
+    const uint32_t TASK_STACK = 3072;
+    const UBaseType_t STREAM_TASK_PRIORITY = 1;  // Sending may block on BLE; sampling must not
+    const uint32_t STREAM_TASK_STACK = 3072;
+    const char* const STREAM_EVENT = "adc_block";
+}
+
+struct AdcCaptureConfig {
+    uint8_t pin;
+    uint32_t rate;              // Samples per second
+    uint16_t block_samples;
+    uint8_t blocks;
+    bool stream;                // Send blocks as "adc_block" events (from a task of their own)
+};
+
+struct AdcBlock {
+    uint32_t seq;               // Block number since start; gaps mean dropped blocks
+    uint32_t time_us;           // micros() at the first sample
+    uint16_t count;
+    uint16_t *samples;          // 12-bit readings
+};
+
+struct AdcCaptureStats {
+    bool running;
+    uint32_t rate;
+    uint16_t block_samples;
+    uint32_t blocks;            // Blocks captured
+    uint32_t dropped;           // Blocks recycled unread
+    uint32_t queued;            // Blocks waiting for the consumer
+};
+
+/**
+ * Start sampling (stops a running capture first)
+ * @return false if the pin or rate is unusable on this chip
+ */
+bool adc_capture_start(const AdcCaptureConfig &config);
+
+/**
+ * Stop sampling and free the ring; blocks taken and not released are lost
+ */
+void adc_capture_stop();
+
+/**
+ * Called at the start of adc_capture_stop() while sampling, so a consumer
+ * task can let go of the ring before it is freed
+ */
+void adc_capture_on_stop(void (*callback)());
+
+bool adc_capture_running();
+
+/**
+ * Mark the ring as owned by a C consumer (a DSP pipeline, or the stream
+ * task, which claims it itself); adc.read()
+ * refuses while it is claimed. Stopping the capture drops the claim.
+ */
+void adc_capture_claim(bool claimed);
+bool adc_capture_claimed();
+
+/**
+ * Oldest filled block, or NULL after timeout_ms; hand it back with
+ * adc_capture_release() before taking more than `blocks - 1` at once
+ */
+const AdcBlock *adc_capture_take(uint32_t timeout_ms);
+void adc_capture_release(const AdcBlock *block);
+
+AdcCaptureStats adc_capture_stats();
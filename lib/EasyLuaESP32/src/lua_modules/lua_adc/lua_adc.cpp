@@ -0,0 +1,249 @@
+#include "lua_adc.h"
+#include "../../core/utils/debug.h"
+#include <string.h>
+
+// ═══════════════════════════════════════════════════════
+// SAMPLE BUFFERS
+// ═══════════════════════════════════════════════════════
+
+struct AdcBuffer {
+    uint32_t seq;
+    uint32_t time_us;
+    uint32_t rate;
+    uint16_t count;
+    uint16_t capacity;
+    // Followed by `capacity` uint16_t samples
+};
+
+static uint16_t *buffer_samples(AdcBuffer *buf) {
+    return (uint16_t *)(buf + 1);
+}
+
+static AdcBuffer *check_buffer(lua_State *L, int index) {
+    return (AdcBuffer *)luaL_checkudata(L, index, ADC_BUFFER_METATABLE);
+}
+
+// Push the buffer at `index` when it holds `capacity` samples, else a new one.
+// May raise (out of memory), so it runs before a block is taken.
+static AdcBuffer *push_buffer(lua_State *L, int index, uint16_t capacity) {
+    AdcBuffer *buf = index ? (AdcBuffer *)luaL_testudata(L, index, ADC_BUFFER_METATABLE) : NULL;
+    if (buf != NULL && buf->capacity >= capacity) {
+        lua_pushvalue(L, index);
+    } else {
+        buf = (AdcBuffer *)lua_newuserdatauv(L, sizeof(AdcBuffer) + capacity * sizeof(uint16_t), 0);
+        buf->capacity = capacity;
+        buf->count = 0;
+        luaL_setmetatable(L, ADC_BUFFER_METATABLE);
+    }
+    return buf;
+}
+
+// Copy a block into a buffer; cannot raise
+static void fill_buffer(AdcBuffer *buf, const AdcBlock *block, uint32_t rate) {
+    buf->seq = block->seq;
+    buf->time_us = block->time_us;
+    buf->rate = rate;
+    buf->count = block->count < buf->capacity ? block->count : buf->capacity;
+    memcpy(buffer_samples(buf), block->samples, buf->count * sizeof(uint16_t));
+}
+
+// buf[i] (1-based), buf.seq / buf.time_us / buf.rate, or a method
+static int l_buffer_index(lua_State *L) {
+    AdcBuffer *buf = check_buffer(L, 1);
+
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        lua_Integer i = lua_tointeger(L, 2);
+        if (i >= 1 && i <= buf->count) {
+            lua_pushinteger(L, buffer_samples(buf)[i - 1]);
+        } else {
+            lua_pushnil(L);
+        }
+        return 1;
+    }
+
+    const char *key = luaL_checkstring(L, 2);
+    if (strcmp(key, "seq") == 0) {
+        lua_pushinteger(L, (lua_Integer)buf->seq);
+    } else if (strcmp(key, "time_us") == 0) {
+        lua_pushinteger(L, (lua_Integer)buf->time_us);
+    } else if (strcmp(key, "rate") == 0) {
+        lua_pushinteger(L, (lua_Integer)buf->rate);
+    } else {
+        // Methods live in the metatable
+        luaL_getmetatable(L, ADC_BUFFER_METATABLE);
+        lua_getfield(L, -1, key);
+    }
+    return 1;
+}
+
+static int l_buffer_len(lua_State *L) {
+    lua_pushinteger(L, check_buffer(L, 1)->count);
+    return 1;
+}
+
+// t = buf:table()
+static int l_buffer_table(lua_State *L) {
+    AdcBuffer *buf = check_buffer(L, 1);
+    const uint16_t *samples = buffer_samples(buf);
+
+    lua_createtable(L, buf->count, 0);
+    for (uint16_t i = 0; i < buf->count; i++) {
+        lua_pushinteger(L, samples[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+// min, max, mean = buf:stats()
+static int l_buffer_stats(lua_State *L) {
+    AdcBuffer *buf = check_buffer(L, 1);
+    const uint16_t *samples = buffer_samples(buf);
+    if (buf->count == 0) return 0;
+
+    uint16_t lo = samples[0];
+    uint16_t hi = samples[0];
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < buf->count; i++) {
+        uint16_t v = samples[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+        sum += v;
+    }
+    lua_pushinteger(L, lo);
+    lua_pushinteger(L, hi);
+    lua_pushnumber(L, (lua_Number)sum / buf->count);
+    return 3;
+}
+
+// ═══════════════════════════════════════════════════════
+// LUA API
+// ═══════════════════════════════════════════════════════
+
+// Integer field of the options table, or `def`
+static lua_Integer opt_field(lua_State *L, int index, const char *key, lua_Integer def) {
+    lua_getfield(L, index, key);
+    lua_Integer value = lua_isnil(L, -1) ? def : luaL_checkinteger(L, -1);
+    lua_pop(L, 1);
+    return value;
+}
+
+// adc.start{pin=, rate=, block=, blocks=, stream=}
+static int l_adc_start(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    lua_Integer pin = opt_field(L, 1, "pin", -1);
+    lua_Integer rate = opt_field(L, 1, "rate", 10000);
+    lua_Integer block = opt_field(L, 1, "block", AdcConfig::DEFAULT_BLOCK);
+    lua_Integer blocks = opt_field(L, 1, "blocks", AdcConfig::DEFAULT_BLOCKS);
+    lua_getfield(L, 1, "stream");
+    bool stream = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    luaL_argcheck(L, pin >= 0 && pin < 64, 1, "pin required");
+    luaL_argcheck(L, rate >= (lua_Integer)AdcConfig::MIN_RATE && rate <= (lua_Integer)AdcConfig::MAX_RATE, 1,
+                  "rate out of range (1000-200000)");
+    luaL_argcheck(L, block > 0 && block <= AdcConfig::MAX_BLOCK, 1, "block out of range (1-4096)");
+    luaL_argcheck(L, blocks >= 2 && blocks <= AdcConfig::MAX_BLOCKS, 1, "blocks out of range (2-32)");
+
+    AdcCaptureConfig config;
+    config.pin = (uint8_t)pin;
+    config.rate = (uint32_t)rate;
+    config.block_samples = (uint16_t)block;
+    config.blocks = (uint8_t)blocks;
+    config.stream = stream;
+    if (!adc_capture_start(config)) {
+        return luaL_error(L, "adc.start: cannot sample pin %d at %d Hz", (int)pin, (int)rate);
+    }
+    return 0;
+}
+
+// buf = adc.read([timeout_ms [, buf]])
+static int l_adc_read(lua_State *L) {
+    lua_Integer timeout = luaL_optinteger(L, 1, 1000);
+    if (!lua_isnoneornil(L, 2)) check_buffer(L, 2);
+    if (adc_capture_claimed()) {
+        // Taking blocks here would cut holes in the pipeline's or stream's input
+        return luaL_error(L, "adc.read: samples go to a dsp pipeline or the adc_block stream");
+    }
+
+    // Nothing between take and release may raise, or the block leaks from the ring
+    AdcCaptureStats stats = adc_capture_stats();
+    AdcBuffer *buf = push_buffer(L, lua_isnoneornil(L, 2) ? 0 : 2, stats.block_samples);
+
+    const AdcBlock *block = adc_capture_take(timeout > 0 ? (uint32_t)timeout : 0);
+    if (block == NULL) {
+        lua_pop(L, 1);
+        lua_pushnil(L);
+        return 1;
+    }
+    fill_buffer(buf, block, stats.rate);
+    adc_capture_release(block);
+    return 1;
+}
+
+static int l_adc_stop(lua_State *L) {
+    (void)L;
+    adc_capture_stop();
+    return 0;
+}
+
+static int l_adc_stats(lua_State *L) {
+    AdcCaptureStats stats = adc_capture_stats();
+
+    lua_createtable(L, 0, 6);
+    lua_pushboolean(L, stats.running);
+    lua_setfield(L, -2, "running");
+    lua_pushinteger(L, (lua_Integer)stats.rate);
+    lua_setfield(L, -2, "rate");
+    lua_pushinteger(L, stats.block_samples);
+    lua_setfield(L, -2, "block");
+    lua_pushinteger(L, (lua_Integer)stats.blocks);
+    lua_setfield(L, -2, "blocks");
+    lua_pushinteger(L, (lua_Integer)stats.dropped);
+    lua_setfield(L, -2, "dropped");
+    lua_pushinteger(L, (lua_Integer)stats.queued);
+    lua_setfield(L, -2, "queued");
+    return 1;
+}
+
+const uint16_t *lua_adc_tosamples(lua_State *L, int index, size_t *count) {
+    AdcBuffer *buf = (AdcBuffer *)luaL_testudata(L, index, ADC_BUFFER_METATABLE);
+    if (buf == NULL) return NULL;
+    *count = buf->count;
+    return buffer_samples(buf);
+}
+
+// ═══════════════════════════════════════════════════════
+// MODULE REGISTRATION
+// ═══════════════════════════════════════════════════════
+
+static const luaL_Reg adc_functions[] = {
+    {"start", l_adc_start},
+    {"read", l_adc_read},
+    {"stop", l_adc_stop},
+    {"stats", l_adc_stats},
+    {NULL, NULL}
+};
+
+static const luaL_Reg buffer_meta[] = {
+    {"__index", l_buffer_index},
+    {"__len", l_buffer_len},
+    {"table", l_buffer_table},
+    {"stats", l_buffer_stats},
+    {NULL, NULL}
+};
+
+void lua_adc_register(lua_State *L) {
+    luaL_newmetatable(L, ADC_BUFFER_METATABLE);
+    luaL_setfuncs(L, buffer_meta, 0);
+    lua_pop(L, 1);
+
+    luaL_newlib(L, adc_functions);
+    lua_setglobal(L, "adc");
+
+    LOG_DEBUG("MODULE", "ADC module registered");
+}
+
+void lua_adc_cleanup() {
+    adc_capture_stop();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../../core/lua_engine.h"
+#include "adc_capture.h"
+
+// ═══════════════════════════════════════════════════════
+// ADC MODULE - continuous sampling for Lua
+// ═══════════════════════════════════════════════════════
+//
+// adc.start{pin=34, rate=20000, block=256, blocks=8, stream=false}
+// adc.read([timeout_ms [, buf]])   next block as a sample buffer, nil on timeout
+// adc.stop()
+// adc.stats()                      {running, rate, block, blocks, dropped, queued}
+//
+// Sample buffers: #buf, buf[i], buf.seq, buf.time_us, buf.rate,
+// buf:table(), buf:stats() -> min, max, mean. Passing a buffer back to
+// adc.read() refills it instead of allocating a new one.
+
+#define ADC_BUFFER_METATABLE "adc.buffer"
+
+void lua_adc_register(lua_State *L);
+
+// Samples of the adc.buffer at `index`, or NULL if it is not one
+const uint16_t *lua_adc_tosamples(lua_State *L, int index, size_t *count);
+
+// Stop sampling when the script ends
+void lua_adc_cleanup();
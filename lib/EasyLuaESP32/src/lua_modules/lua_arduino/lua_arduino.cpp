@@ -3,20 +3,339 @@
 #include "../../core/lua_engine.h"
 #include "../../core/event_msg.h"
 #include "../../core/utils/debug.h"
+#include "../lua_eventmsg/lua_eventmsg.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <vector>
 
 // ═══════════════════════════════════════════════════════
 // ARDUINO MODULE - Arduino-specific functions for Lua
 // ═══════════════════════════════════════════════════════
 
+// ───────────────────────────────────────────────────────
+// CONSOLE BUFFER - print() output waiting for lua_code_output
+// ───────────────────────────────────────────────────────
+//
+// Lines are appended with a trailing '\n' and sent several per event; the
+// last newline of each event is dropped, so a lone print() produces the
+// same payload as before. An event goes out when a burst of lines or bytes
+// builds up, ConsoleConfig::FLUSH_MS after the first pending line, or when
+// the script ends (arduino_console_flush).
+
+static char console_buf[ConsoleConfig::BUFFER_BYTES];
+static size_t console_len = 0;
+static uint16_t console_lines = 0;
+static SemaphoreHandle_t console_mutex = NULL;
+static TaskHandle_t console_flush_task = NULL;
+static SemaphoreHandle_t sched_wake = NULL;    // Given to end a delay() wait early (SCHEDULER)
+
+// Send pending lines, at most EVENT_BYTES per event and cut at line ends
+// where possible (caller holds console_mutex)
+static void console_flush_locked()
+{
+    size_t pos = 0;
+    while (pos < console_len) {
+        size_t n = console_len - pos;
+        if (n > ConsoleConfig::EVENT_BYTES) {
+            size_t end = ConsoleConfig::EVENT_BYTES;
+            while (end > 0 && console_buf[pos + end - 1] != '\n') end--;
+            if (end == 0) {
+                // A single line longer than an event is sent whole, as before
+                const char *nl = (const char *)memchr(console_buf + pos, '\n', n);
+                end = nl != NULL ? nl - (console_buf + pos) + 1 : n;
+            }
+            n = end;
+        }
+
+        size_t send = n;
+        if (console_buf[pos + send - 1] == '\n') send--;
+        event_msg_send(EVENT_LUA_OUTPUT, (const uint8_t *)console_buf + pos, send);
+        pos += n;
+    }
+    console_len = 0;
+    console_lines = 0;
+}
+
+// Append one line ending in '\n'
+static void console_write(const char *text, size_t len)
+{
+    if (console_mutex == NULL) {
+        event_msg_send(EVENT_LUA_OUTPUT, (const uint8_t *)text, len - 1);
+        return;
+    }
+
+    xSemaphoreTake(console_mutex, portMAX_DELAY);
+    if (console_len + len > sizeof(console_buf)) {
+        console_flush_locked();
+    }
+    bool was_empty = console_len == 0;
+
+    if (len > sizeof(console_buf)) {
+        event_msg_send(EVENT_LUA_OUTPUT, (const uint8_t *)text, len - 1);
+    } else {
+        memcpy(console_buf + console_len, text, len);
+        console_len += len;
+        console_lines++;
+        if (console_lines >= ConsoleConfig::BURST_LINES || console_len >= ConsoleConfig::EVENT_BYTES) {
+            console_flush_locked();
+        }
+    }
+    bool wake = was_empty && console_len > 0;
+    xSemaphoreGive(console_mutex);
+
+    // The flush task sleeps until output is waiting
+    if (wake && console_flush_task != NULL) {
+        xTaskNotifyGive(console_flush_task);
+    }
+}
+
+static void console_flush_task_fn(void *param)
+{
+    (void)param;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(ConsoleConfig::FLUSH_MS));
+        arduino_console_flush();
+    }
+}
+
+void arduino_console_flush()
+{
+    if (console_mutex == NULL) return;
+
+    xSemaphoreTake(console_mutex, portMAX_DELAY);
+    console_flush_locked();
+    xSemaphoreGive(console_mutex);
+}
+
 // ───────────────────────────────────────────────────────
 // INIT (Called once at startup)
 // ───────────────────────────────────────────────────────
 void arduino_module_init()
 {
-    // Nothing to initialize for Arduino functions
+    if (console_mutex == NULL) {
+        console_mutex = xSemaphoreCreateMutex();
+        sched_wake = xSemaphoreCreateBinary();
+        xTaskCreatePinnedToCore(console_flush_task_fn, "ConsoleFlush", 3072, NULL, 1, &console_flush_task, 0);
+    }
     LOG_DEBUG("MODULE", "Arduino module initialized");
 }
 
+// ───────────────────────────────────────────────────────
+// SCHEDULER - delay() that keeps the script responsive
+// ───────────────────────────────────────────────────────
+//
+// In a coroutine started with spawn(), delay() yields and records when the
+// task wants to wake. On the main thread, delay() becomes the scheduler:
+// until its deadline it resumes tasks that are due, runs eventmsg callbacks
+// and other wake handlers (GPIO edges) as they arrive and steps the
+// incremental GC once. Elsewhere (coroutines
+// resumed by script code, event callbacks, non-yieldable C calls) it still
+// blocks, since nothing would resume the caller.
+
+struct SpawnedTask {
+    lua_State *co;
+    int ref;                    // Registry reference keeping the thread alive
+    uint32_t wake_us;           // micros() at which the task wants to run
+    bool running;
+};
+
+static std::vector<SpawnedTask> spawned_tasks;
+static lua_State *sched_current = NULL;        // Task being resumed by the scheduler
+static bool sched_waiting = false;             // Main thread inside delay()
+static bool sched_yield_timed = false;         // Set by delay() just before it yields
+static uint32_t sched_yield_wake = 0;
+
+static ArduinoWakeHandler sched_handlers[DelayConfig::MAX_WAKE_HANDLERS];
+static uint8_t sched_handler_count = 0;
+
+void arduino_scheduler_on_wake(ArduinoWakeHandler handler)
+{
+    for (uint8_t i = 0; i < sched_handler_count; i++) {
+        if (sched_handlers[i] == handler) return;
+    }
+    if (sched_handler_count < DelayConfig::MAX_WAKE_HANDLERS) {
+        sched_handlers[sched_handler_count++] = handler;
+    }
+}
+
+void arduino_scheduler_wake()
+{
+    if (sched_wake != NULL) xSemaphoreGive(sched_wake);
+}
+
+void IRAM_ATTR arduino_scheduler_wake_from_isr()
+{
+    BaseType_t woken = pdFALSE;
+    if (sched_wake != NULL) xSemaphoreGiveFromISR(sched_wake, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void run_wake_handlers(lua_State *L)
+{
+    // An incoming event only gives sched_wake once: come back for the rest of a burst
+    if (lua_eventmsg_process(0, DelayConfig::EVENTS_PER_WAKE) == DelayConfig::EVENTS_PER_WAKE) {
+        arduino_scheduler_wake();
+    }
+    for (uint8_t i = 0; i < sched_handler_count; i++) {
+        sched_handlers[i](L);
+    }
+}
+
+static bool time_reached(uint32_t now, uint32_t when)
+{
+    return (int32_t)(now - when) >= 0;
+}
+
+static SpawnedTask *find_task(int ref)
+{
+    for (SpawnedTask &task : spawned_tasks) {
+        if (task.ref == ref) return &task;
+    }
+    return NULL;
+}
+
+// Resume one task with `nargs` values on its stack; drops it when it finishes
+static void resume_task(lua_State *L, int ref, int nargs)
+{
+    SpawnedTask *task = find_task(ref);
+    lua_State *co = task->co;
+    task->running = true;
+
+    lua_State *previous = sched_current;
+    sched_current = co;
+    sched_yield_timed = false;
+    int nresults = 0;
+    int status = lua_resume(co, L, nargs, &nresults);
+    sched_current = previous;
+
+    task = find_task(ref);
+    if (status == LUA_YIELD) {
+        // A bare coroutine.yield() just gives the other tasks a turn
+        lua_pop(co, nresults);
+        task->wake_us = sched_yield_timed ? sched_yield_wake : micros();
+        task->running = false;
+        return;
+    }
+
+    if (status != LUA_OK) {
+        const char *error = lua_tostring(co, -1);
+        LOG_ERROR("LUA", "Task error: %s", error ? error : "?");
+        char line[160];
+        int len = snprintf(line, sizeof(line) - 1, "task error: %s", error ? error : "?");
+        len = min(len, (int)sizeof(line) - 2);
+        line[len++] = '\n';
+        console_write(line, len);
+    }
+    luaL_unref(L, LUA_REGISTRYINDEX, ref);
+    spawned_tasks.erase(spawned_tasks.begin() + (task - spawned_tasks.data()));
+}
+
+// Resume every task that is due, each at most once
+static void run_due_tasks(lua_State *L)
+{
+    size_t budget = spawned_tasks.size();
+    while (budget-- > 0) {
+        uint32_t now = micros();
+        int due = LUA_NOREF;
+        uint32_t earliest = 0;
+        for (const SpawnedTask &task : spawned_tasks) {
+            if (task.running || !time_reached(now, task.wake_us)) continue;
+            if (due == LUA_NOREF || (int32_t)(task.wake_us - earliest) < 0) {
+                due = task.ref;
+                earliest = task.wake_us;
+            }
+        }
+        if (due == LUA_NOREF) return;
+
+        // Ran this pass: not due again until it yields
+        resume_task(L, due, 0);
+    }
+}
+
+// Microseconds until the next task is due, capped at `limit`
+static uint32_t next_task_in(uint32_t limit)
+{
+    uint32_t now = micros();
+    for (const SpawnedTask &task : spawned_tasks) {
+        if (task.running) continue;
+        int32_t left = (int32_t)(task.wake_us - now);
+        if (left <= 0) return 0;
+        if ((uint32_t)left < limit) limit = left;
+    }
+    return limit;
+}
+
+// Main-thread wait: tasks, events and GC until `total_us` has passed;
+// `precise` busy-waits the last SPIN_US instead of rounding up to a tick
+static void scheduler_wait(lua_State *L, uint32_t total_us, bool precise)
+{
+    uint32_t start = micros();
+    uint8_t gc_steps = 0;
+    sched_waiting = true;
+
+    for (;;) {
+        run_due_tasks(L);
+        run_wake_handlers(L);
+        if (lua_engine_is_stop_requested()) break;
+
+        uint32_t elapsed = micros() - start;
+        if (elapsed >= total_us) break;
+        uint32_t remaining = total_us - elapsed;
+        if (precise && remaining <= DelayConfig::SPIN_US) {
+            delayMicroseconds(remaining);
+            break;
+        }
+
+        uint32_t wait_us = next_task_in(precise ? remaining - DelayConfig::SPIN_US : remaining);
+        if (gc_steps < DelayConfig::GC_STEPS_PER_WAIT && wait_us >= DelayConfig::GC_MIN_US) {
+            // A bounded head start on the collector's own pacing, so a
+            // short delay() in a loop never forces whole cycles; stop early
+            // once a cycle completes (lua_gc returns 1)
+            gc_steps = lua_gc(L, LUA_GCSTEP, DelayConfig::GC_STEP_KB) != 0 ?
+                       DelayConfig::GC_STEPS_PER_WAIT : gc_steps + 1;
+            continue;
+        }
+
+        // Incoming events and interrupts give sched_wake to end the sleep early
+        uint32_t wait_ms = precise ? wait_us / 1000 : (wait_us + 999) / 1000;
+        xSemaphoreTake(sched_wake, pdMS_TO_TICKS(wait_ms));
+    }
+
+    sched_waiting = false;
+}
+
+int arduino_scheduler_drain(lua_State *L)
+{
+    while (!spawned_tasks.empty() && !lua_engine_is_stop_requested()) {
+        scheduler_wait(L, next_task_in(DelayConfig::DRAIN_POLL_US), false);
+    }
+    // Same outcome as a stop while the main chunk was running
+    if (lua_engine_is_stop_requested()) {
+        return luaL_error(L, "Interrupted by user (Ctrl+C)");
+    }
+    return 0;
+}
+
+// How the calling thread may wait: 1 = yield as a task, 2 = schedule, 0 = block
+static int wait_mode(lua_State *L)
+{
+    if (L == sched_current && lua_isyieldable(L)) return 1;
+    if (sched_waiting) return 0;
+    bool main = lua_pushthread(L) == 1;
+    lua_pop(L, 1);
+    return main ? 2 : 0;
+}
+
+// Yield the running task until micros() reaches `wake_us`
+static int task_sleep(lua_State *L, uint32_t wake_us)
+{
+    sched_yield_timed = true;
+    sched_yield_wake = wake_us;
+    return lua_yield(L, 0);
+}
+
 // ───────────────────────────────────────────────────────
 // LUA FUNCTIONS - Time
 // ───────────────────────────────────────────────────────
@@ -35,22 +354,68 @@ static int lua_micros(lua_State *L)
     return 1;
 }
 
-// Delays for specified milliseconds (accepts int or float)
+// Delays for specified milliseconds (accepts int or float); see SCHEDULER
 static int lua_delay(lua_State *L)
 {
     int ms = (int)lua_tonumber(L, 1);
-    delay(ms);
+    if (ms < 0) ms = 0;
+
+    switch (wait_mode(L)) {
+    case 1:
+        return task_sleep(L, micros() + (uint32_t)ms * 1000);
+    case 2:
+        scheduler_wait(L, (uint32_t)ms * 1000, false);
+        break;
+    default:
+        delay(ms);
+        break;
+    }
     return 0;
 }
 
-// Delays for specified microseconds (accepts int or float)
+// Delays for specified microseconds (accepts int or float); short delays busy-wait
 static int lua_delayMicroseconds(lua_State *L)
 {
     int us = (int)lua_tonumber(L, 1);
-    delayMicroseconds(us);
+    if (us < 0) us = 0;
+
+    int mode = (uint32_t)us >= DelayConfig::YIELD_US ? wait_mode(L) : 0;
+    switch (mode) {
+    case 1:
+        return task_sleep(L, micros() + (uint32_t)us);
+    case 2:
+        scheduler_wait(L, (uint32_t)us, true);
+        break;
+    default:
+        delayMicroseconds(us);
+        break;
+    }
     return 0;
 }
 
+// spawn(fn, ...) - run fn as a task that delay() suspends instead of blocking
+static int lua_spawn(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    if (spawned_tasks.size() >= DelayConfig::MAX_TASKS) {
+        return luaL_error(L, "too many tasks (max %d)", (int)DelayConfig::MAX_TASKS);
+    }
+
+    int nargs = lua_gettop(L) - 1;
+    lua_State *co = lua_newthread(L);
+    lua_insert(L, 1);
+    lua_xmove(L, co, nargs + 1);        // fn and its arguments
+    lua_pushvalue(L, 1);
+    int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    SpawnedTask task = {co, ref, (uint32_t)micros(), false};
+    spawned_tasks.push_back(task);
+
+    // Runs until its first delay()
+    resume_task(L, ref, nargs);
+    return 1;
+}
+
 // ───────────────────────────────────────────────────────
 // LUA FUNCTIONS - Digital I/O
 // ───────────────────────────────────────────────────────
@@ -106,95 +471,101 @@ static int lua_analogWrite(lua_State *L)
 // LUA FUNCTIONS - Serial/Debug
 // ───────────────────────────────────────────────────────
 
-// Helper function to convert any Lua value to string representation
-static String lua_value_to_string(lua_State *L, int index) {
-    int type = lua_type(L, index);
+// Decimal digits of v, written backwards ending at `end`; returns the start
+static char *format_integer(char *end, lua_Integer value)
+{
+    unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    char *p = end;
+    do {
+        *--p = '0' + (v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0) *--p = '-';
+    return p;
+}
+
+// Append the text of any Lua value to a buffer
+static void add_value(luaL_Buffer *b, lua_State *L, int index)
+{
     char buffer[64];
+    const char *name;
 
-    switch (type) {
+    switch (lua_type(L, index)) {
         case LUA_TNIL:
-            return String("nil");
+            luaL_addstring(b, "nil");
+            return;
 
         case LUA_TBOOLEAN:
-            if (lua_toboolean(L, index)) {
-                return String("true");
-            } else {
-                return String("false");
-            }
+            luaL_addstring(b, lua_toboolean(L, index) ? "true" : "false");
+            return;
 
-        case LUA_TNUMBER:
+        case LUA_TNUMBER: {
+            char *end = buffer + sizeof(buffer);
             if (lua_isinteger(L, index)) {
-                // Integer
-                lua_Integer val = lua_tointeger(L, index);
-                snprintf(buffer, sizeof(buffer), "%lld", (long long)val);
-                return String(buffer);
-            } else {
-                // Float/Double
-                lua_Number val = lua_tonumber(L, index);
-                // Remove trailing zeros for cleaner output
-                snprintf(buffer, sizeof(buffer), "%.10g", val);
-                return String(buffer);
+                char *start = format_integer(end, lua_tointeger(L, index));
+                luaL_addlstring(b, start, end - start);
+                return;
             }
+            // Whole floats within lua_Integer range print as %.10g would, without snprintf
+            lua_Number val = lua_tonumber(L, index);
+            if (val > -1e9f && val < 1e9f && val == (lua_Number)(lua_Integer)val && !(val == 0 && signbit(val))) {
+                char *start = format_integer(end, (lua_Integer)val);
+                luaL_addlstring(b, start, end - start);
+                return;
+            }
+            int n = snprintf(buffer, sizeof(buffer), "%.10g", val);
+            luaL_addlstring(b, buffer, n > 0 ? min((size_t)n, sizeof(buffer) - 1) : 0);
+            return;
+        }
 
         case LUA_TSTRING: {
             size_t len;
-            const char* str = lua_tolstring(L, index, &len);
-            return String(str);
+            const char *str = lua_tolstring(L, index, &len);
+            luaL_addlstring(b, str, len);
+            return;
         }
 
-        case LUA_TTABLE:
-            snprintf(buffer, sizeof(buffer), "table: %p", lua_topointer(L, index));
-            return String(buffer);
-
-        case LUA_TFUNCTION:
-            snprintf(buffer, sizeof(buffer), "function: %p", lua_topointer(L, index));
-            return String(buffer);
-
-        case LUA_TUSERDATA:
-            snprintf(buffer, sizeof(buffer), "userdata: %p", lua_touserdata(L, index));
-            return String(buffer);
-
-        case LUA_TTHREAD:
-            snprintf(buffer, sizeof(buffer), "thread: %p", lua_topointer(L, index));
-            return String(buffer);
-
-        case LUA_TLIGHTUSERDATA:
-            snprintf(buffer, sizeof(buffer), "lightuserdata: %p", lua_touserdata(L, index));
-            return String(buffer);
+        case LUA_TTABLE:         name = "table"; break;
+        case LUA_TFUNCTION:      name = "function"; break;
+        case LUA_TUSERDATA:      name = "userdata"; break;
+        case LUA_TTHREAD:        name = "thread"; break;
+        case LUA_TLIGHTUSERDATA: name = "lightuserdata"; break;
 
         default:
-            return String("unknown");
+            luaL_addstring(b, "unknown");
+            return;
     }
+
+    int n = snprintf(buffer, sizeof(buffer), "%s: %p", name, lua_topointer(L, index));
+    luaL_addlstring(b, buffer, n > 0 ? min((size_t)n, sizeof(buffer) - 1) : 0);
 }
 
 // Lua print() function - handles multiple arguments of any type
-// Sends output over BLE via event_msg as "lua_code_output"
+// Output is buffered and sent over BLE as "lua_code_output" (see CONSOLE BUFFER)
 static int lua_print(lua_State *L)
 {
     int nargs = lua_gettop(L);  // Get number of arguments
 
-    if (nargs == 0) {
-        // print() with no arguments just prints newline
-        LOG_INFO("LUA_PRINT", "");
-        event_msg_send(EVENT_LUA_OUTPUT, (const uint8_t*)"", 0);
-        return 0;
-    }
-
-    String output = "";
-
-    // Convert all arguments to string and concatenate with tabs
+    luaL_Buffer b;
+    luaL_buffinit(L, &b);
     for (int i = 1; i <= nargs; i++) {
         if (i > 1) {
-            output += "\t";  // Lua standard: separate args with tabs
+            luaL_addchar(&b, '\t');  // Lua standard: separate args with tabs
         }
-        output += lua_value_to_string(L, i);
+        add_value(&b, L, i);
     }
+    luaL_addchar(&b, '\n');
+
+    // Read the buffer in place rather than creating a Lua string; its one
+    // stack slot (placeholder or grown box) is popped below
+    const char *line = luaL_buffaddr(&b);
+    size_t len = luaL_bufflen(&b);
 
-    // Log to Serial for debugging
-    LOG_INFO("LUA_PRINT", "%s", output.c_str());
+    // Log to Serial for debugging (split over log records, so long lines are kept whole)
+    debug_log_text(LOG_LEVEL_INFO, "LUA_PRINT", line, len - 1);
 
-    // Send over BLE via event_msg
-    event_msg_send(EVENT_LUA_OUTPUT, (const uint8_t*)output.c_str(), output.length());
+    console_write(line, len);
+    lua_pop(L, 1);
 
     return 0;  // print() returns no values
 }
@@ -272,6 +643,12 @@ void arduino_module_register(lua_State *L)
     lua_register(L, "micros", lua_micros);
     lua_register(L, "delay", lua_delay);
     lua_register(L, "delayMicroseconds", lua_delayMicroseconds);
+    lua_register(L, "spawn", lua_spawn);
+
+    // Tasks of the previous state died with it
+    spawned_tasks.clear();
+    sched_current = NULL;
+    sched_waiting = false;
 
     // Digital I/O
     lua_register(L, "pinMode", lua_pinMode);
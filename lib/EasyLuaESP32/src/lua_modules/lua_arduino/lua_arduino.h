@@ -2,5 +2,42 @@
 
 #include "../../core/lua_engine.h"
 
+// print() output buffering
+namespace ConsoleConfig {
+    const size_t BUFFER_BYTES = 2048;            // Pending output before a forced flush
+    const size_t EVENT_BYTES = 480;              // Target lua_code_output payload
+    const uint16_t BURST_LINES = 16;             // Lines per event before flushing early
+    const unsigned long FLUSH_MS = 20;           // Max time a line waits to be sent
+}
+
+// delay() / delayMicroseconds() scheduling
+namespace DelayConfig {
+    const uint32_t YIELD_US = 2000;              // delayMicroseconds() at or above this stops busy-waiting
+    const uint32_t SPIN_US = 1000;               // Tail of a delayMicroseconds() busy-waited for accuracy
+    const size_t EVENTS_PER_WAKE = 8;            // Event callbacks run per wake-up while waiting
+    const int GC_STEP_KB = 4;                    // Incremental GC work per step
+    const uint8_t GC_STEPS_PER_WAIT = 1;         // GC steps per delay() call at most
+    const uint32_t GC_MIN_US = 2000;             // Only step the GC when at least this long is left
+    const size_t MAX_TASKS = 32;                 // Coroutines started with spawn()
+    const uint32_t DRAIN_POLL_US = 100000;       // Longest wait between stop checks after the script ends
+    const uint8_t MAX_WAKE_HANDLERS = 4;
+}
+
 void arduino_module_init();
 void arduino_module_register(lua_State *L);
+
+// Send buffered print() output now (before lua_error / lua_result)
+void arduino_console_flush();
+
+// Work for a waiting main-thread delay(): handlers run on the Lua task each
+// time it wakes up (eventmsg callbacks always run)
+typedef void (*ArduinoWakeHandler)(lua_State *L);
+void arduino_scheduler_on_wake(ArduinoWakeHandler handler);
+
+// Run spawned tasks until they all finish or a stop is requested; meant
+// for lua_engine_on_finish so tasks outlive the main chunk
+int arduino_scheduler_drain(lua_State *L);
+
+// Wake a waiting delay() now, from a task or an ISR
+void arduino_scheduler_wake();
+void arduino_scheduler_wake_from_isr();
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// ═══════════════════════════════════════════════════════
+// DSP KERNELS - block-at-a-time float loops
+// ═══════════════════════════════════════════════════════
+//
+// Every kernel takes whole arrays and keeps its inner loop branch-free
+// over contiguous, non-aliasing memory, so GCC can unroll it for the
+// ESP32 FPU pipeline and vectorize it on hosts (and on chips with SIMD).
+// Reductions keep four partial sums rather than one running total: the
+// adds then do not wait on each other.
+
+#if defined(__GNUC__)
+#define DSP_RESTRICT __restrict__
+#else
+#define DSP_RESTRICT
+#endif
+
+// The default -Os build neither unrolls nor vectorizes these loops. The
+// attribute travels with each kernel, so every file including this header
+// builds the same O3 copy
+#if defined(__GNUC__) && !defined(__clang__)
+#define DSP_KERNEL inline __attribute__((optimize("O3")))
+#else
+#define DSP_KERNEL inline
+#endif
+
+// y[i] = x[i]
+DSP_KERNEL void dsp_from_u16(const uint16_t *DSP_RESTRICT x, float *DSP_RESTRICT y, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        y[i] = (float)x[i];
+    }
+}
+
+// y[i] = x[i] * gain + offset, in place
+DSP_KERNEL void dsp_scale(float *x, size_t n, float gain, float offset) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] = x[i] * gain + offset;
+    }
+}
+
+/**
+ * FIR filter: y[i] = sum_k h[k] * x[i + taps - 1 - k]
+ * `x` holds taps - 1 samples of history followed by the n new samples.
+ * Loops over taps outside and samples inside, so the inner loop is one
+ * multiply-add across the whole block.
+ */
+DSP_KERNEL void dsp_fir(const float *DSP_RESTRICT x, const float *DSP_RESTRICT h, size_t taps,
+                    float *DSP_RESTRICT y, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        y[i] = 0.0f;
+    }
+    for (size_t k = 0; k < taps; k++) {
+        const float hk = h[k];
+        const float *DSP_RESTRICT xk = x + (taps - 1 - k);
+        for (size_t i = 0; i < n; i++) {
+            y[i] += hk * xk[i];
+        }
+    }
+}
+
+/**
+ * Biquad, transposed direct form II, in place
+ * c = {b0, b1, b2, a1, a2} with a0 = 1; s = two state words
+ */
+DSP_KERNEL void dsp_biquad(float *x, size_t n, const float *c, float *s) {
+    const float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+    float s1 = s[0], s2 = s[1];
+    for (size_t i = 0; i < n; i++) {
+        float in = x[i];
+        float out = b0 * in + s1;
+        s1 = b1 * in - a1 * out + s2;
+        s2 = b2 * in - a2 * out;
+        x[i] = out;
+    }
+    s[0] = s1;
+    s[1] = s2;
+}
+
+/**
+ * Moving average over `window` samples
+ * `x` holds window samples of history followed by the n new samples.
+ * The window sum is rebuilt from the history each block, so rounding
+ * error never accumulates past one block.
+ */
+DSP_KERNEL void dsp_moving_average(const float *DSP_RESTRICT x, size_t window, float *DSP_RESTRICT y, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < window; i++) {
+        sum += x[i];
+    }
+    const float scale = 1.0f / (float)window;
+    for (size_t i = 0; i < n; i++) {
+        sum += x[window + i] - x[i];
+        y[i] = sum * scale;
+    }
+}
+
+// Keep every factor-th sample starting at x[skip], in place; returns count kept
+DSP_KERNEL size_t dsp_decimate(float *x, size_t n, size_t factor, size_t *skip) {
+    size_t out = 0;
+    size_t i = *skip;
+    for (; i < n; i += factor) {
+        x[out++] = x[i];
+    }
+    *skip = i - n;
+    return out;
+}
+
+// Sum of squares
+DSP_KERNEL float dsp_sum_squares(const float *x, size_t n) {
+    float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 += x[i] * x[i];
+        a1 += x[i + 1] * x[i + 1];
+        a2 += x[i + 2] * x[i + 2];
+        a3 += x[i + 3] * x[i + 3];
+    }
+    for (; i < n; i++) {
+        a0 += x[i] * x[i];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+// Largest value (n > 0)
+DSP_KERNEL float dsp_max(const float *x, size_t n) {
+    float m0 = x[0], m1 = x[0], m2 = x[0], m3 = x[0];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = x[i] > m0 ? x[i] : m0;
+        m1 = x[i + 1] > m1 ? x[i + 1] : m1;
+        m2 = x[i + 2] > m2 ? x[i + 2] : m2;
+        m3 = x[i + 3] > m3 ? x[i + 3] : m3;
+    }
+    for (; i < n; i++) {
+        m0 = x[i] > m0 ? x[i] : m0;
+    }
+    m0 = m1 > m0 ? m1 : m0;
+    m2 = m3 > m2 ? m3 : m2;
+    return m2 > m0 ? m2 : m0;
+}
@@ -0,0 +1,376 @@
+#include "dsp_pipeline.h"
+#include "dsp_kernels.h"
+#include "../lua_adc/adc_capture.h"
+#include "../../core/event_msg.h"
+#include "../../core/utils/debug.h"
+#include <Arduino.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <string.h>
+
+// ═══════════════════════════════════════════════════════
+// INTERNAL STATE
+// ═══════════════════════════════════════════════════════
+
+struct DspStage {
+    DspStageType type;
+    uint16_t length;
+    size_t phase;               // Decimate: samples to skip; rms/peak: samples in the open window
+    float acc;                  // Rms: sum of squares; peak: maximum so far
+    float params[5];
+    float state[2];             // Biquad
+    float *taps;                // FIR coefficients
+    float *work;                // FIR/avg: history followed by room for one chunk
+};
+
+struct DspPipeline {
+    DspStage stages[DspConfig::MAX_STAGES];
+    uint8_t count;
+    uint16_t block;
+    float *buffer;              // One chunk of samples being processed
+
+    // Running on the ADC
+    TaskHandle_t task;
+    TaskHandle_t stopper;
+    volatile bool stop_requested;
+    char event[32];             // Empty: results go to the queue
+    float *out;                 // Results gathered until a block ends or `block` fill up
+    uint16_t out_count;
+    DspResult results[DspConfig::RESULT_CHUNKS];
+    float *result_values;
+    QueueHandle_t free_queue;
+    QueueHandle_t filled_queue;
+
+    uint32_t blocks;
+    uint32_t values;
+    uint32_t dropped;
+    uint32_t busy_us;
+};
+
+static DspPipeline *dsp_active = NULL;
+
+// Samples of history a stage keeps in front of each chunk
+static size_t stage_history(const DspStage &stage) {
+    if (stage.type == DSP_STAGE_FIR) return stage.length - 1;
+    if (stage.type == DSP_STAGE_AVG) return stage.length;
+    return 0;
+}
+
+// ═══════════════════════════════════════════════════════
+// STAGES
+// ═══════════════════════════════════════════════════════
+
+// One window-reducing pass (rms or peak) over a chunk, in place
+static size_t run_window(DspStage &stage, float *x, size_t n) {
+    size_t out = 0;
+    size_t i = 0;
+    while (i < n) {
+        size_t take = min(stage.length - stage.phase, n - i);
+        if (stage.type == DSP_STAGE_RMS) {
+            stage.acc += dsp_sum_squares(x + i, take);
+        } else {
+            float m = dsp_max(x + i, take);
+            stage.acc = (stage.phase == 0 || m > stage.acc) ? m : stage.acc;
+        }
+        stage.phase += take;
+        i += take;
+
+        if (stage.phase == stage.length) {
+            x[out++] = stage.type == DSP_STAGE_RMS ? sqrtf(stage.acc / stage.length) : stage.acc;
+            stage.acc = 0.0f;
+            stage.phase = 0;
+        }
+    }
+    return out;
+}
+
+static size_t run_stage(DspStage &stage, float *x, size_t n) {
+    size_t history = stage_history(stage);
+
+    switch (stage.type) {
+    case DSP_STAGE_SCALE:
+        dsp_scale(x, n, stage.params[0], stage.params[1]);
+        return n;
+    case DSP_STAGE_FIR:
+        memcpy(stage.work + history, x, n * sizeof(float));
+        dsp_fir(stage.work, stage.taps, stage.length, x, n);
+        memmove(stage.work, stage.work + n, history * sizeof(float));
+        return n;
+    case DSP_STAGE_IIR:
+        dsp_biquad(x, n, stage.params, stage.state);
+        return n;
+    case DSP_STAGE_AVG:
+        memcpy(stage.work + history, x, n * sizeof(float));
+        dsp_moving_average(stage.work, stage.length, x, n);
+        memmove(stage.work, stage.work + n, history * sizeof(float));
+        return n;
+    case DSP_STAGE_DECIMATE:
+        return dsp_decimate(x, n, stage.length, &stage.phase);
+    case DSP_STAGE_RMS:
+    case DSP_STAGE_PEAK:
+        return run_window(stage, x, n);
+    }
+    return n;
+}
+
+// ═══════════════════════════════════════════════════════
+// RESULTS
+// ═══════════════════════════════════════════════════════
+
+// Result event payload header (little-endian, packed), followed by float32 values
+struct __attribute__((packed)) DspEventHeader {
+    uint32_t seq;
+    uint16_t count;
+};
+
+static void flush_results(DspPipeline *p, uint32_t seq) {
+    if (p->out_count == 0) return;
+
+    if (p->event[0] != '\0') {
+        uint8_t payload[sizeof(DspEventHeader) + DspConfig::EVENT_VALUES * sizeof(float)];
+        for (uint16_t offset = 0; offset < p->out_count; offset += DspConfig::EVENT_VALUES) {
+            DspEventHeader header;
+            header.seq = seq;
+            header.count = min((uint16_t)(p->out_count - offset), DspConfig::EVENT_VALUES);
+            memcpy(payload, &header, sizeof(header));
+            memcpy(payload + sizeof(header), p->out + offset, header.count * sizeof(float));
+            event_msg_send(p->event, payload, sizeof(header) + header.count * sizeof(float));
+        }
+    } else {
+        // Reader behind: recycle its oldest unread chunk
+        uint8_t index;
+        if (xQueueReceive(p->free_queue, &index, 0) != pdTRUE) {
+            if (xQueueReceive(p->filled_queue, &index, 0) != pdTRUE) {
+                p->dropped++;
+                p->out_count = 0;
+                return;
+            }
+            p->dropped++;
+        }
+        DspResult &result = p->results[index];
+        result.seq = seq;
+        result.count = p->out_count;
+        memcpy(result.values, p->out, p->out_count * sizeof(float));
+        xQueueSend(p->filled_queue, &index, 0);
+    }
+    p->out_count = 0;
+}
+
+// ═══════════════════════════════════════════════════════
+// PIPELINE TASK
+// ═══════════════════════════════════════════════════════
+
+static void dsp_task_fn(void *param) {
+    DspPipeline *p = (DspPipeline *)param;
+
+    while (!p->stop_requested) {
+        const AdcBlock *block = adc_capture_take(50);
+        if (block == NULL) continue;
+
+        uint32_t start = micros();
+        for (uint16_t offset = 0; offset < block->count; offset += p->block) {
+            size_t n = min((uint16_t)(block->count - offset), p->block);
+            dsp_from_u16(block->samples + offset, p->buffer, n);
+            n = dsp_pipeline_process(p, p->buffer, n);
+
+            if (p->out_count + n > p->block) flush_results(p, block->seq);
+            memcpy(p->out + p->out_count, p->buffer, n * sizeof(float));
+            p->out_count += n;
+            p->values += n;
+        }
+        uint32_t seq = block->seq;
+        adc_capture_release(block);
+        p->busy_us += micros() - start;
+        p->blocks++;
+
+        flush_results(p, seq);
+    }
+
+    TaskHandle_t stopper = p->stopper;
+    p->task = NULL;
+    if (stopper) xTaskNotifyGive(stopper);
+    vTaskDelete(NULL);
+}
+
+// Result buffers, only allocated while running
+static void free_run_buffers(DspPipeline *p) {
+    if (p->free_queue) vQueueDelete(p->free_queue);
+    if (p->filled_queue) vQueueDelete(p->filled_queue);
+    p->free_queue = NULL;
+    p->filled_queue = NULL;
+    free(p->out);
+    free(p->result_values);
+    p->out = NULL;
+    p->result_values = NULL;
+}
+
+// ═══════════════════════════════════════════════════════
+// PUBLIC API
+// ═══════════════════════════════════════════════════════
+
+DspPipeline *dsp_pipeline_create(const DspStageConfig *stages, uint8_t count, uint16_t block) {
+    if (count > DspConfig::MAX_STAGES || block == 0 || block > DspConfig::MAX_BLOCK) return NULL;
+    for (uint8_t i = 0; i < count; i++) {
+        const DspStageConfig &config = stages[i];
+        bool sized = config.type != DSP_STAGE_SCALE && config.type != DSP_STAGE_IIR;
+        uint16_t limit = config.type == DSP_STAGE_FIR ? DspConfig::MAX_TAPS : DspConfig::MAX_WINDOW;
+        if (sized && (config.length == 0 || config.length > limit)) return NULL;
+        if (config.type == DSP_STAGE_FIR && config.taps == NULL) return NULL;
+    }
+
+    DspPipeline *p = (DspPipeline *)calloc(1, sizeof(DspPipeline));
+    if (p == NULL) return NULL;
+    p->count = count;
+    p->block = block;
+    p->buffer = (float *)malloc(block * sizeof(float));
+    bool ok = p->buffer != NULL;
+
+    for (uint8_t i = 0; i < count && ok; i++) {
+        DspStage &stage = p->stages[i];
+        stage.type = stages[i].type;
+        stage.length = stages[i].length;
+        memcpy(stage.params, stages[i].params, sizeof(stage.params));
+
+        size_t history = stage_history(stage);
+        if (history > 0 || stage.type == DSP_STAGE_FIR) {
+            stage.work = (float *)malloc((history + block) * sizeof(float));
+            ok = stage.work != NULL;
+        }
+        if (ok && stage.type == DSP_STAGE_FIR) {
+            stage.taps = (float *)malloc(stage.length * sizeof(float));
+            ok = stage.taps != NULL;
+            if (ok) memcpy(stage.taps, stages[i].taps, stage.length * sizeof(float));
+        }
+    }
+
+    if (!ok) {
+        dsp_pipeline_destroy(p);
+        return NULL;
+    }
+    dsp_pipeline_reset(p);
+    return p;
+}
+
+void dsp_pipeline_destroy(DspPipeline *pipeline) {
+    if (pipeline == NULL) return;
+    dsp_pipeline_stop(pipeline);
+    for (uint8_t i = 0; i < pipeline->count; i++) {
+        free(pipeline->stages[i].work);
+        free(pipeline->stages[i].taps);
+    }
+    free(pipeline->buffer);
+    free(pipeline);
+}
+
+size_t dsp_pipeline_process(DspPipeline *pipeline, float *x, size_t n) {
+    for (uint8_t i = 0; i < pipeline->count && n > 0; i++) {
+        n = run_stage(pipeline->stages[i], x, n);
+    }
+    return n;
+}
+
+void dsp_pipeline_reset(DspPipeline *pipeline) {
+    for (uint8_t i = 0; i < pipeline->count; i++) {
+        DspStage &stage = pipeline->stages[i];
+        stage.phase = 0;
+        stage.acc = 0.0f;
+        stage.state[0] = 0.0f;
+        stage.state[1] = 0.0f;
+        if (stage.work) memset(stage.work, 0, stage_history(stage) * sizeof(float));
+    }
+}
+
+bool dsp_pipeline_start(DspPipeline *pipeline, const char *event) {
+    dsp_pipeline_stop_all();
+    if (!adc_capture_running() || adc_capture_claimed()) return false;
+
+    DspPipeline *p = pipeline;
+    p->out = (float *)malloc(p->block * sizeof(float));
+    if (event == NULL) {
+        p->result_values = (float *)malloc((size_t)DspConfig::RESULT_CHUNKS * p->block * sizeof(float));
+        p->free_queue = xQueueCreate(DspConfig::RESULT_CHUNKS, sizeof(uint8_t));
+        p->filled_queue = xQueueCreate(DspConfig::RESULT_CHUNKS, sizeof(uint8_t));
+        if (!p->result_values || !p->free_queue || !p->filled_queue) {
+            free(p->out);
+            p->out = NULL;
+        }
+    }
+    if (p->out == NULL) {
+        LOG_ERROR("ADC", "Out of memory for DSP results");
+        free_run_buffers(p);
+        return false;
+    }
+
+    if (event == NULL) {
+        for (uint8_t i = 0; i < DspConfig::RESULT_CHUNKS; i++) {
+            p->results[i].values = p->result_values + (size_t)i * p->block;
+            p->results[i].count = 0;
+            xQueueSend(p->free_queue, &i, 0);
+        }
+        p->event[0] = '\0';
+    } else {
+        strncpy(p->event, event, sizeof(p->event) - 1);
+        p->event[sizeof(p->event) - 1] = '\0';
+    }
+
+    p->out_count = 0;
+    p->blocks = 0;
+    p->values = 0;
+    p->dropped = 0;
+    p->busy_us = 0;
+    p->stop_requested = false;
+    dsp_active = p;
+    adc_capture_claim(true);
+    adc_capture_on_stop(dsp_pipeline_stop_all);
+    xTaskCreatePinnedToCore(dsp_task_fn, "DspPipeline", DspConfig::TASK_STACK, p,
+                            DspConfig::TASK_PRIORITY, &p->task, 0);
+
+    LOG_INFO("ADC", "DSP pipeline running (%u stages)%s", p->count, event ? " (events)" : "");
+    return true;
+}
+
+void dsp_pipeline_stop(DspPipeline *pipeline) {
+    if (pipeline->task != NULL) {
+        // The task notices within one adc_capture_take() timeout
+        pipeline->stopper = xTaskGetCurrentTaskHandle();
+        pipeline->stop_requested = true;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        pipeline->stopper = NULL;
+        LOG_INFO("ADC", "DSP pipeline stopped (%u blocks, %u results, %u dropped)",
+                 pipeline->blocks, pipeline->values, pipeline->dropped);
+    }
+    if (dsp_active == pipeline) {
+        dsp_active = NULL;
+        adc_capture_claim(false);
+    }
+    free_run_buffers(pipeline);
+}
+
+void dsp_pipeline_stop_all() {
+    if (dsp_active != NULL) dsp_pipeline_stop(dsp_active);
+}
+
+const DspResult *dsp_pipeline_take(DspPipeline *pipeline, uint32_t timeout_ms) {
+    uint8_t index;
+    if (pipeline->filled_queue == NULL ||
+        xQueueReceive(pipeline->filled_queue, &index, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return NULL;
+    }
+    return &pipeline->results[index];
+}
+
+void dsp_pipeline_release(DspPipeline *pipeline, const DspResult *result) {
+    if (result == NULL || pipeline->free_queue == NULL) return;
+    uint8_t index = (uint8_t)(result - pipeline->results);
+    xQueueSend(pipeline->free_queue, &index, 0);
+}
+
+DspPipelineStats dsp_pipeline_stats(const DspPipeline *pipeline) {
+    DspPipelineStats stats;
+    stats.running = pipeline->task != NULL;
+    stats.blocks = pipeline->blocks;
+    stats.values = pipeline->values;
+    stats.dropped = pipeline->dropped;
+    stats.busy_us = pipeline->busy_us;
+    return stats;
+}
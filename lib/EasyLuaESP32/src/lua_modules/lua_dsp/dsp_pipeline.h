@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+
+// ═══════════════════════════════════════════════════════
+// DSP PIPELINE - chain of native stages over sample blocks
+// ═══════════════════════════════════════════════════════
+//
+// A pipeline is compiled once from stage configs. It then runs each
+// chunk of up to `block` samples through every stage in place. Stages
+// keep their state across chunks, so feeding a signal in pieces gives
+// the same output as feeding it whole. Reducing stages (decimate, rms,
+// peak) shorten the chunk.
+//
+// dsp_pipeline_process() runs the chain on the caller's data. Started,
+// a pipeline becomes the consumer of adc_capture blocks on its own task.
+// Its results then go to a queue (dsp_pipeline_take/release) or out as
+// events. One pipeline can run at a time.
+
+namespace DspConfig {
+    const uint8_t MAX_STAGES = 8;
+    const uint16_t MAX_TAPS = 128;               // FIR length
+    const uint16_t MAX_WINDOW = 4096;            // Moving average / rms / peak window, decimation factor
+    const uint16_t DEFAULT_BLOCK = 256;          // Samples per chunk
+    const uint16_t MAX_BLOCK = 4096;
+    const uint8_t RESULT_CHUNKS = 8;             // Result chunks queued for the reader
+    const uint16_t EVENT_VALUES = 118;           // Floats per result event (480-byte payload)
+    const UBaseType_t TASK_PRIORITY = 4;         // Below AdcCapture, above LuaTask
+    const uint32_t TASK_STACK = 3072;
+}
+
+enum DspStageType : uint8_t {
+    DSP_STAGE_SCALE,            // x * gain + offset (params[0], params[1])
+    DSP_STAGE_FIR,              // `length` taps
+    DSP_STAGE_IIR,              // Biquad, params = {b0, b1, b2, a1, a2}
+    DSP_STAGE_AVG,              // Moving average over `length` samples
+    DSP_STAGE_DECIMATE,         // Keep every `length`-th sample
+    DSP_STAGE_RMS,              // One RMS value per `length` samples
+    DSP_STAGE_PEAK              // One maximum per `length` samples
+};
+
+struct DspStageConfig {
+    DspStageType type;
+    uint16_t length;
+    float params[5];
+    const float *taps;          // FIR coefficients, copied at create
+};
+
+struct DspResult {
+    uint32_t seq;               // ADC block that completed this chunk
+    uint16_t count;
+    float *values;
+};
+
+struct DspPipelineStats {
+    bool running;
+    uint32_t blocks;            // ADC blocks processed
+    uint32_t values;            // Results produced
+    uint32_t dropped;           // Result chunks recycled unread
+    uint32_t busy_us;           // Time spent in stages
+};
+
+struct DspPipeline;
+
+/**
+ * Compile a chain of stages
+ * @return NULL on a bad stage config or out of memory
+ */
+DspPipeline *dsp_pipeline_create(const DspStageConfig *stages, uint8_t count, uint16_t block);
+
+// Stops the pipeline first if it is running
+void dsp_pipeline_destroy(DspPipeline *pipeline);
+
+/**
+ * Run `n` samples (at most `block`) through every stage, in place
+ * @return number of results left at the front of `x`
+ */
+size_t dsp_pipeline_process(DspPipeline *pipeline, float *x, size_t n);
+
+// Clear stage state (filter history, partial windows)
+void dsp_pipeline_reset(DspPipeline *pipeline);
+
+/**
+ * Consume adc_capture blocks on a task (stops the running pipeline first)
+ * @param event results go out as this event, or to the queue when NULL
+ * @return false if the ADC is not sampling or out of memory
+ */
+bool dsp_pipeline_start(DspPipeline *pipeline, const char *event);
+void dsp_pipeline_stop(DspPipeline *pipeline);
+
+// Stop whichever pipeline is running
+void dsp_pipeline_stop_all();
+
+/**
+ * Oldest result chunk, or NULL after timeout_ms; hand it back with
+ * dsp_pipeline_release()
+ */
+const DspResult *dsp_pipeline_take(DspPipeline *pipeline, uint32_t timeout_ms);
+void dsp_pipeline_release(DspPipeline *pipeline, const DspResult *result);
+
+DspPipelineStats dsp_pipeline_stats(const DspPipeline *pipeline);
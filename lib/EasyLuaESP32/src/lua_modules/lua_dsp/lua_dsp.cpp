@@ -0,0 +1,322 @@
+#include "lua_dsp.h"
+#include "dsp_kernels.h"
+#include "../lua_adc/lua_adc.h"
+#include "../../core/utils/debug.h"
+#include <string.h>
+
+// Source marker in a stage descriptor's `type`
+static const int DSP_SOURCE_ADC = -1;
+
+struct LuaPipeline {
+    DspPipeline *pipeline;
+    bool adc_source;
+    uint16_t block;
+};
+
+static LuaPipeline *check_pipeline(lua_State *L, int index) {
+    LuaPipeline *p = (LuaPipeline *)luaL_checkudata(L, index, DspLuaConfig::PIPELINE_METATABLE);
+    if (p->pipeline == NULL) luaL_error(L, "dsp pipeline already freed");
+    return p;
+}
+
+// ═══════════════════════════════════════════════════════
+// STAGE DESCRIPTORS
+// ═══════════════════════════════════════════════════════
+//
+// Constructors return plain tables {type=, length=, [1..n]=params or taps},
+// compiled by dsp.pipeline()
+
+static int push_stage(lua_State *L, int type, lua_Integer length) {
+    lua_createtable(L, 0, 2);
+    lua_pushinteger(L, type);
+    lua_setfield(L, -2, "type");
+    lua_pushinteger(L, length);
+    lua_setfield(L, -2, "length");
+    return 1;
+}
+
+static int l_stage_adc(lua_State *L) {
+    return push_stage(L, DSP_SOURCE_ADC, 0);
+}
+
+static int l_stage_scale(lua_State *L) {
+    lua_Number gain = luaL_checknumber(L, 1);
+    lua_Number offset = luaL_optnumber(L, 2, 0);
+    push_stage(L, DSP_STAGE_SCALE, 0);
+    lua_pushnumber(L, gain);
+    lua_rawseti(L, -2, 1);
+    lua_pushnumber(L, offset);
+    lua_rawseti(L, -2, 2);
+    return 1;
+}
+
+// Stage whose numbers come as a table: fir taps, iir coefficients
+static int coefficient_stage(lua_State *L, DspStageType type, lua_Integer min_count, lua_Integer max_count) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer count = (lua_Integer)lua_rawlen(L, 1);
+    luaL_argcheck(L, count >= min_count && count <= max_count, 1, "wrong number of coefficients");
+
+    push_stage(L, type, count);
+    for (lua_Integer i = 1; i <= count; i++) {
+        lua_rawgeti(L, 1, i);
+        lua_pushnumber(L, luaL_checknumber(L, -1));
+        lua_rawseti(L, -3, i);
+        lua_pop(L, 1);
+    }
+    return 1;
+}
+
+static int l_stage_fir(lua_State *L) {
+    return coefficient_stage(L, DSP_STAGE_FIR, 1, DspConfig::MAX_TAPS);
+}
+
+static int l_stage_iir(lua_State *L) {
+    return coefficient_stage(L, DSP_STAGE_IIR, 5, 5);
+}
+
+// Stage sized by one window length: avg, decimate, rms, peak
+static int window_stage(lua_State *L, DspStageType type) {
+    lua_Integer n = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, n >= 1 && n <= DspConfig::MAX_WINDOW, 1, "window out of range (1-4096)");
+    return push_stage(L, type, n);
+}
+
+static int l_stage_avg(lua_State *L) { return window_stage(L, DSP_STAGE_AVG); }
+static int l_stage_decimate(lua_State *L) { return window_stage(L, DSP_STAGE_DECIMATE); }
+static int l_stage_rms(lua_State *L) { return window_stage(L, DSP_STAGE_RMS); }
+static int l_stage_peak(lua_State *L) { return window_stage(L, DSP_STAGE_PEAK); }
+
+// ═══════════════════════════════════════════════════════
+// PIPELINES
+// ═══════════════════════════════════════════════════════
+
+// p = dsp.pipeline({stages...} [, {block=}])
+static int l_dsp_pipeline(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer block = DspConfig::DEFAULT_BLOCK;
+    if (lua_istable(L, 2)) {
+        lua_getfield(L, 2, "block");
+        if (!lua_isnil(L, -1)) block = luaL_checkinteger(L, -1);
+        lua_pop(L, 1);
+    }
+    luaL_argcheck(L, block >= 1 && block <= DspConfig::MAX_BLOCK, 2, "block out of range (1-4096)");
+
+    // FIR taps are staged in a scratch userdata: 4 KB is too much for the Lua task stack
+    DspStageConfig stages[DspConfig::MAX_STAGES];
+    float *taps = (float *)lua_newuserdatauv(L, DspConfig::MAX_STAGES * DspConfig::MAX_TAPS * sizeof(float), 0);
+    uint8_t count = 0;
+    bool adc_source = false;
+
+    lua_Integer total = (lua_Integer)lua_rawlen(L, 1);
+    for (lua_Integer i = 1; i <= total; i++) {
+        lua_rawgeti(L, 1, i);
+        luaL_argcheck(L, lua_istable(L, -1), 1, "stages must come from dsp.*()");
+        lua_getfield(L, -1, "type");
+        lua_getfield(L, -2, "length");
+        int type = (int)luaL_checkinteger(L, -2);
+        lua_Integer length = luaL_checkinteger(L, -1);
+        lua_pop(L, 2);
+
+        if (type == DSP_SOURCE_ADC) {
+            luaL_argcheck(L, i == 1, 1, "dsp.adc() must be the first stage");
+            adc_source = true;
+            lua_pop(L, 1);
+            continue;
+        }
+        luaL_argcheck(L, type >= DSP_STAGE_SCALE && type <= DSP_STAGE_PEAK, 1, "unknown stage type");
+        luaL_argcheck(L, count < DspConfig::MAX_STAGES, 1, "too many stages (max 8)");
+
+        DspStageConfig &stage = stages[count];
+        memset(&stage, 0, sizeof(stage));
+        stage.type = (DspStageType)type;
+        stage.length = (uint16_t)length;
+
+        // Numbered entries: taps for fir, params for the rest
+        float *stage_taps = taps + (size_t)count * DspConfig::MAX_TAPS;
+        float *dest = type == DSP_STAGE_FIR ? stage_taps : stage.params;
+        size_t capacity = type == DSP_STAGE_FIR ? DspConfig::MAX_TAPS : 5;
+        size_t n = min((size_t)lua_rawlen(L, -1), capacity);
+        for (size_t k = 0; k < n; k++) {
+            lua_rawgeti(L, -1, (lua_Integer)k + 1);
+            dest[k] = (float)lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+        if (type == DSP_STAGE_FIR) {
+            stage.taps = stage_taps;
+            stage.length = (uint16_t)n;
+        }
+        count++;
+        lua_pop(L, 1);
+    }
+
+    LuaPipeline *p = (LuaPipeline *)lua_newuserdatauv(L, sizeof(LuaPipeline), 0);
+    p->pipeline = NULL;
+    luaL_setmetatable(L, DspLuaConfig::PIPELINE_METATABLE);
+
+    p->pipeline = dsp_pipeline_create(stages, count, (uint16_t)block);
+    if (p->pipeline == NULL) {
+        return luaL_error(L, "dsp.pipeline: bad stage or out of memory");
+    }
+    p->adc_source = adc_source;
+    p->block = (uint16_t)block;
+    return 1;
+}
+
+// p:start([event])
+static int l_pipeline_start(lua_State *L) {
+    LuaPipeline *p = check_pipeline(L, 1);
+    const char *event = luaL_optstring(L, 2, NULL);
+    if (!p->adc_source) {
+        return luaL_error(L, "pipeline has no source (start it with dsp.adc())");
+    }
+    if (!dsp_pipeline_start(p->pipeline, event)) {
+        return luaL_error(L, "pipeline cannot start: call adc.start() (without stream) first");
+    }
+    return 0;
+}
+
+static int l_pipeline_stop(lua_State *L) {
+    dsp_pipeline_stop(check_pipeline(L, 1)->pipeline);
+    return 0;
+}
+
+// values, seq = p:read([timeout_ms])
+static int l_pipeline_read(lua_State *L) {
+    LuaPipeline *p = check_pipeline(L, 1);
+    lua_Integer timeout = luaL_optinteger(L, 2, 1000);
+
+    // Sized for a whole chunk up front: filling preallocated array slots
+    // cannot raise, so the result always goes back to the pipeline
+    lua_createtable(L, p->block, 0);
+
+    const DspResult *result = dsp_pipeline_take(p->pipeline, timeout > 0 ? (uint32_t)timeout : 0);
+    if (result == NULL) {
+        lua_pop(L, 1);
+        lua_pushnil(L);
+        return 1;
+    }
+    for (uint16_t i = 0; i < result->count; i++) {
+        lua_pushnumber(L, result->values[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushinteger(L, (lua_Integer)result->seq);
+    dsp_pipeline_release(p->pipeline, result);
+    return 2;
+}
+
+// results = p:process(table or adc.buffer)
+static int l_pipeline_process(lua_State *L) {
+    LuaPipeline *p = check_pipeline(L, 1);
+    if (dsp_pipeline_stats(p->pipeline).running) {
+        return luaL_error(L, "pipeline is running on the ADC");
+    }
+
+    size_t total = 0;
+    const uint16_t *samples = lua_adc_tosamples(L, 2, &total);
+    if (samples == NULL) {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        total = lua_rawlen(L, 2);
+    }
+
+    float *chunk = (float *)lua_newuserdatauv(L, p->block * sizeof(float), 0);
+    lua_createtable(L, 0, 0);
+    lua_Integer out = 0;
+
+    for (size_t offset = 0; offset < total; offset += p->block) {
+        size_t n = min(total - offset, (size_t)p->block);
+        if (samples != NULL) {
+            dsp_from_u16(samples + offset, chunk, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                lua_rawgeti(L, 2, (lua_Integer)(offset + i + 1));
+                chunk[i] = (float)lua_tonumber(L, -1);
+                lua_pop(L, 1);
+            }
+        }
+
+        n = dsp_pipeline_process(p->pipeline, chunk, n);
+        for (size_t i = 0; i < n; i++) {
+            lua_pushnumber(L, chunk[i]);
+            lua_rawseti(L, -2, ++out);
+        }
+    }
+    return 1;
+}
+
+static int l_pipeline_reset(lua_State *L) {
+    LuaPipeline *p = check_pipeline(L, 1);
+    if (dsp_pipeline_stats(p->pipeline).running) {
+        return luaL_error(L, "pipeline is running on the ADC");
+    }
+    dsp_pipeline_reset(p->pipeline);
+    return 0;
+}
+
+static int l_pipeline_stats(lua_State *L) {
+    DspPipelineStats stats = dsp_pipeline_stats(check_pipeline(L, 1)->pipeline);
+
+    lua_createtable(L, 0, 5);
+    lua_pushboolean(L, stats.running);
+    lua_setfield(L, -2, "running");
+    lua_pushinteger(L, (lua_Integer)stats.blocks);
+    lua_setfield(L, -2, "blocks");
+    lua_pushinteger(L, (lua_Integer)stats.values);
+    lua_setfield(L, -2, "values");
+    lua_pushinteger(L, (lua_Integer)stats.dropped);
+    lua_setfield(L, -2, "dropped");
+    lua_pushinteger(L, (lua_Integer)stats.busy_us);
+    lua_setfield(L, -2, "busy_us");
+    return 1;
+}
+
+static int l_pipeline_gc(lua_State *L) {
+    LuaPipeline *p = (LuaPipeline *)luaL_checkudata(L, 1, DspLuaConfig::PIPELINE_METATABLE);
+    dsp_pipeline_destroy(p->pipeline);
+    p->pipeline = NULL;
+    return 0;
+}
+
+// ═══════════════════════════════════════════════════════
+// MODULE REGISTRATION
+// ═══════════════════════════════════════════════════════
+
+static const luaL_Reg dsp_functions[] = {
+    {"pipeline", l_dsp_pipeline},
+    {"adc", l_stage_adc},
+    {"scale", l_stage_scale},
+    {"fir", l_stage_fir},
+    {"iir", l_stage_iir},
+    {"avg", l_stage_avg},
+    {"decimate", l_stage_decimate},
+    {"rms", l_stage_rms},
+    {"peak", l_stage_peak},
+    {NULL, NULL}
+};
+
+static const luaL_Reg pipeline_methods[] = {
+    {"start", l_pipeline_start},
+    {"stop", l_pipeline_stop},
+    {"read", l_pipeline_read},
+    {"process", l_pipeline_process},
+    {"reset", l_pipeline_reset},
+    {"stats", l_pipeline_stats},
+    {NULL, NULL}
+};
+
+void lua_dsp_register(lua_State *L) {
+    luaL_newmetatable(L, DspLuaConfig::PIPELINE_METATABLE);
+    luaL_newlib(L, pipeline_methods);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, l_pipeline_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newlib(L, dsp_functions);
+    lua_setglobal(L, "dsp");
+
+    LOG_DEBUG("MODULE", "DSP module registered");
+}
+
+void lua_dsp_cleanup() {
+    dsp_pipeline_stop_all();
+}
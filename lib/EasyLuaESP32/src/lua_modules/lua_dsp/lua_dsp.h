@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../../core/lua_engine.h"
+#include "dsp_pipeline.h"
+
+// ═══════════════════════════════════════════════════════
+// DSP MODULE - native signal-processing pipelines for Lua
+// ═══════════════════════════════════════════════════════
+//
+// Stages:
+//   dsp.adc()                 source: blocks from adc.start() (first stage only)
+//   dsp.scale(gain [, offset])
+//   dsp.fir{h0, h1, ...}      up to 128 taps
+//   dsp.iir{b0, b1, b2, a1, a2}
+//   dsp.avg(n)                moving average
+//   dsp.decimate(n)           keep every n-th sample
+//   dsp.rms(n), dsp.peak(n)   one value per n samples
+//
+// local p = dsp.pipeline({dsp.adc(), dsp.fir{...}, dsp.decimate(4), dsp.rms(64)} [, {block=256}])
+// p:start([event])       run on the ADC; results to p:read(), or sent as `event`
+// p:read([timeout_ms])   next results table and its ADC block seq, nil on timeout
+// p:process(samples)     run a table or adc.buffer through the chain now
+// p:stop(), p:reset(), p:stats()
+//
+// A started pipeline is the ADC consumer (adc.read() raises an error
+// meanwhile) and stops when sampling stops.
+
+namespace DspLuaConfig {
+    const char* const PIPELINE_METATABLE = "dsp.pipeline";
+}
+
+void lua_dsp_register(lua_State *L);
+
+// Stop the running pipeline when the script ends
+void lua_dsp_cleanup();
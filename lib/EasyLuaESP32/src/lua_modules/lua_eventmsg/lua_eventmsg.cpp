@@ -1,5 +1,6 @@
 #include "lua_eventmsg.h"
 #include "../../core/utils/debug.h"
+#include "../lua_arduino/lua_arduino.h"
 #include <Arduino.h>
 #include <set>
 
@@ -78,6 +79,9 @@ static void handleIncomingEvent(const String& eventName, const std::vector<uint8
             delete evPtr;
         }
     }
+
+    // A script sleeping in delay() runs the callback now
+    arduino_scheduler_wake();
 }
 
 // Process pending events and call Lua callbacks
@@ -119,6 +123,10 @@ static size_t drainPending(bool isBlocking, uint32_t timeoutMs, size_t maxEvents
     return processed;
 }
 
+size_t lua_eventmsg_process(uint32_t timeoutMs, size_t maxEvents) {
+    return drainPending(timeoutMs > 0, timeoutMs, maxEvents);
+}
+
 // ═══════════════════════════════════════════════════════
 // LUA API FUNCTIONS
 // ═══════════════════════════════════════════════════════
@@ -132,8 +140,8 @@ static int lua_on(lua_State* L) {
     lua_pushvalue(L, 2);
     int ref = luaL_ref(L, LUA_REGISTRYINDEX);
 
-    // Add to callbacks
-    EventCallback callback = {L, ref};
+    // Add to callbacks; they run on the main thread even if registered from a task
+    EventCallback callback = {mainLuaState ? mainLuaState : L, ref};
     eventCallbacks[eventName].push_back(callback);
 
     // Add to registered events set
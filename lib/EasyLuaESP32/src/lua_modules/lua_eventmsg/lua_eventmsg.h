@@ -9,4 +9,7 @@
 // Lua EventMsg module - wrapper around C event_msg system
 void lua_eventmsg_init();
 void lua_eventmsg_register(lua_State* L);
-void lua_eventmsg_cleanup();
\ No newline at end of file
+void lua_eventmsg_cleanup();
+
+// Wait up to timeoutMs for a pending event, then run at most maxEvents callbacks
+size_t lua_eventmsg_process(uint32_t timeoutMs, size_t maxEvents);
\ No newline at end of file
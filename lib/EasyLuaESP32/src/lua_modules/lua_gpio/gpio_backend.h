@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+
+// ═══════════════════════════════════════════════════════
+// GPIO BACKEND - raw register access behind the gpio module
+// ═══════════════════════════════════════════════════════
+//
+// Masks are 64-bit: bit n is GPIOn. On the chip each call is one
+// W1TS/W1TC store per 32-pin bank; build with -DGPIO_HOST_MOCK=1 to run the
+// module off-target against plain variables (tests, benchmarks). The mock
+// keeps attached ISRs in GpioMock::isr for a test thread to call.
+
+#ifndef GPIO_HOST_MOCK
+#define GPIO_HOST_MOCK 0
+#endif
+
+#if GPIO_HOST_MOCK
+
+namespace GpioMock {
+    extern uint64_t out;            // Output latch
+    extern uint64_t in;             // What read_mask() returns
+    extern uint64_t outputs;        // Pins set to OUTPUT by gpio_backend_mode
+    extern uint32_t writes;         // gpio_backend_write calls
+    extern void (*isr[64])(void *); // Attached interrupt handlers
+    extern void *isr_arg[64];
+    extern int isr_mode[64];
+}
+
+const uint64_t GPIO_BACKEND_OUTPUT_MASK = 0xFFFFFFFFFFull;     // 40 pins
+const uint64_t GPIO_BACKEND_VALID_MASK = 0xFFFFFFFFFFull;
+
+inline void gpio_backend_write(uint64_t set, uint64_t clear) {
+    GpioMock::out = (GpioMock::out | set) & ~clear;
+    GpioMock::writes++;
+}
+
+inline uint64_t gpio_backend_read() {
+    return GpioMock::in;
+}
+
+inline void gpio_backend_mode(uint8_t pin, uint8_t mode) {
+    const uint8_t MOCK_OUTPUT = 0x03;   // Arduino OUTPUT
+    if (mode == MOCK_OUTPUT) {
+        GpioMock::outputs |= 1ull << pin;
+    } else {
+        GpioMock::outputs &= ~(1ull << pin);
+    }
+}
+
+inline void gpio_backend_attach(uint8_t pin, void (*isr)(void *), void *arg, int mode) {
+    GpioMock::isr_arg[pin] = arg;
+    GpioMock::isr_mode[pin] = mode;
+    GpioMock::isr[pin] = isr;
+}
+
+inline void gpio_backend_detach(uint8_t pin) {
+    GpioMock::isr[pin] = NULL;
+}
+
+#else
+
+#include <Arduino.h>
+#include <soc/soc.h>
+#include <soc/soc_caps.h>
+#include <soc/gpio_reg.h>
+
+const uint64_t GPIO_BACKEND_OUTPUT_MASK = SOC_GPIO_VALID_OUTPUT_GPIO_MASK;
+const uint64_t GPIO_BACKEND_VALID_MASK = SOC_GPIO_VALID_GPIO_MASK;
+
+// Set first, then clear: pins in both masks end up low
+inline void gpio_backend_write(uint64_t set, uint64_t clear) {
+    if ((uint32_t)set) REG_WRITE(GPIO_OUT_W1TS_REG, (uint32_t)set);
+    if ((uint32_t)clear) REG_WRITE(GPIO_OUT_W1TC_REG, (uint32_t)clear);
+#if SOC_GPIO_PIN_COUNT > 32
+    if (set >> 32) REG_WRITE(GPIO_OUT1_W1TS_REG, (uint32_t)(set >> 32));
+    if (clear >> 32) REG_WRITE(GPIO_OUT1_W1TC_REG, (uint32_t)(clear >> 32));
+#endif
+}
+
+inline uint64_t gpio_backend_read() {
+    uint64_t value = REG_READ(GPIO_IN_REG);
+#if SOC_GPIO_PIN_COUNT > 32
+    value |= (uint64_t)REG_READ(GPIO_IN1_REG) << 32;
+#endif
+    return value & GPIO_BACKEND_VALID_MASK;
+}
+
+inline void gpio_backend_mode(uint8_t pin, uint8_t mode) {
+    pinMode(pin, mode);
+}
+
+// `isr` must be IRAM_ATTR; mode is RISING, FALLING or CHANGE
+inline void gpio_backend_attach(uint8_t pin, void (*isr)(void *), void *arg, int mode) {
+    attachInterruptArg(pin, isr, arg, mode);
+}
+
+inline void gpio_backend_detach(uint8_t pin) {
+    detachInterrupt(pin);
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "gpio_edges.h"
+#include "gpio_backend.h"
+#include "../lua_arduino/lua_arduino.h"
+#include <Arduino.h>
+#include <atomic>
+
+// ═══════════════════════════════════════════════════════
+// INTERNAL STATE
+// ═══════════════════════════════════════════════════════
+
+struct EdgePin {
+    std::atomic<uint32_t> count;
+    uint32_t last_us;           // Last accepted edge
+    uint32_t debounce_us;
+    bool queue;
+    bool attached;
+};
+
+static EdgePin edge_pins[GpioEdgeConfig::MAX_PINS];
+static GpioEdge edge_ring[GpioEdgeConfig::RING_SIZE];
+static std::atomic<uint32_t> edge_head(0);      // Written by the ISR
+static std::atomic<uint32_t> edge_tail(0);      // Written by the Lua task
+static std::atomic<uint32_t> edge_dropped(0);
+
+// ═══════════════════════════════════════════════════════
+// ISR
+// ═══════════════════════════════════════════════════════
+
+static void IRAM_ATTR edge_isr(void *arg) {
+    uint8_t pin = (uint8_t)(uintptr_t)arg;
+    EdgePin &p = edge_pins[pin];
+    uint32_t now = micros();
+
+    if (p.debounce_us != 0 && now - p.last_us < p.debounce_us) return;
+    p.last_us = now;
+    p.count.fetch_add(1, std::memory_order_relaxed);
+    if (!p.queue) return;
+
+    uint32_t head = edge_head.load(std::memory_order_relaxed);
+    if (head - edge_tail.load(std::memory_order_acquire) >= GpioEdgeConfig::RING_SIZE) {
+        edge_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    GpioEdge &edge = edge_ring[head & (GpioEdgeConfig::RING_SIZE - 1)];
+    edge.time_us = now;
+    edge.pin = pin;
+    edge.level = (uint8_t)((gpio_backend_read() >> pin) & 1);
+
+    // Publish, then check whether the consumer had drained everything. Both
+    // sides store then load (seq_cst), so either it sees this edge or we see
+    // its drained tail and wake it
+    edge_head.store(head + 1);
+    if (edge_tail.load() == head) {
+        arduino_scheduler_wake_from_isr();
+    }
+}
+
+// ═══════════════════════════════════════════════════════
+// PUBLIC API
+// ═══════════════════════════════════════════════════════
+
+bool gpio_edges_attach(uint8_t pin, int mode, uint32_t debounce_us, bool queue) {
+    if (pin >= GpioEdgeConfig::MAX_PINS || !((GPIO_BACKEND_VALID_MASK >> pin) & 1)) return false;
+    if (mode != RISING && mode != FALLING && mode != CHANGE) return false;
+
+    gpio_edges_detach(pin);
+    EdgePin &p = edge_pins[pin];
+    p.count.store(0);
+    p.last_us = micros() - debounce_us;     // First edge is never filtered
+    p.debounce_us = debounce_us;
+    p.queue = queue;
+    p.attached = true;
+    gpio_backend_attach(pin, edge_isr, (void *)(uintptr_t)pin, mode);
+    return true;
+}
+
+void gpio_edges_detach(uint8_t pin) {
+    if (pin >= GpioEdgeConfig::MAX_PINS || !edge_pins[pin].attached) return;
+    gpio_backend_detach(pin);
+    edge_pins[pin].attached = false;
+}
+
+void gpio_edges_detach_all() {
+    for (uint8_t pin = 0; pin < GpioEdgeConfig::MAX_PINS; pin++) {
+        gpio_edges_detach(pin);
+    }
+    edge_tail.store(edge_head.load());
+    edge_dropped.store(0);
+}
+
+uint32_t gpio_edges_count(uint8_t pin, bool reset) {
+    if (pin >= GpioEdgeConfig::MAX_PINS) return 0;
+    return reset ? edge_pins[pin].count.exchange(0) : edge_pins[pin].count.load();
+}
+
+size_t gpio_edges_take(GpioEdge *out, size_t max) {
+    uint32_t tail = edge_tail.load(std::memory_order_relaxed);
+    uint32_t available = edge_head.load() - tail;
+    size_t n = available < max ? available : max;
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = edge_ring[(tail + i) & (GpioEdgeConfig::RING_SIZE - 1)];
+    }
+    if (n > 0) edge_tail.store(tail + n);
+    return n;
+}
+
+uint32_t gpio_edges_queued() {
+    return edge_head.load() - edge_tail.load();
+}
+
+uint32_t gpio_edges_dropped() {
+    return edge_dropped.load();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ═══════════════════════════════════════════════════════
+// GPIO EDGES - pin interrupts timestamped into a lock-free ring
+// ═══════════════════════════════════════════════════════
+//
+// The ISR counts every accepted edge, drops edges closer than the pin's
+// debounce time to the last accepted one, and (for queued pins) writes
+// {time, pin, level} into a single-producer ring. Pins are attached from
+// the Lua task, so their ISRs all run on its core and never overlap; the
+// Lua task is the only consumer. The ISR wakes a waiting delay() when it
+// refills an empty ring, so a burst costs one wake-up.
+
+namespace GpioEdgeConfig {
+    const uint8_t MAX_PINS = 64;
+    const uint32_t RING_SIZE = 256;              // Edges, power of two
+    const size_t DISPATCH_BATCH = 64;            // Edges per dispatch pass
+}
+
+struct GpioEdge {
+    uint32_t time_us;           // micros() in the ISR
+    uint8_t pin;
+    uint8_t level;              // Pin level read in the ISR
+};
+
+/**
+ * Attach the edge ISR to a pin
+ * @param mode RISING, FALLING or CHANGE
+ * @param queue write edges to the ring (otherwise only count them)
+ */
+bool gpio_edges_attach(uint8_t pin, int mode, uint32_t debounce_us, bool queue);
+void gpio_edges_detach(uint8_t pin);
+
+// Detach every pin and discard queued edges
+void gpio_edges_detach_all();
+
+// Accepted edges since attach (or the last reset)
+uint32_t gpio_edges_count(uint8_t pin, bool reset);
+
+// Copy out and consume up to `max` queued edges, oldest first
+size_t gpio_edges_take(GpioEdge *out, size_t max);
+
+uint32_t gpio_edges_queued();
+uint32_t gpio_edges_dropped();     // Lost to a full ring
@@ -0,0 +1,356 @@
+#include "lua_gpio.h"
+#include "gpio_backend.h"
+#include "gpio_edges.h"
+#include "../lua_arduino/lua_arduino.h"
+#include "../../core/utils/debug.h"
+
+#if GPIO_HOST_MOCK
+namespace GpioMock {
+    uint64_t out = 0;
+    uint64_t in = 0;
+    uint64_t outputs = 0;
+    uint32_t writes = 0;
+    void (*isr[64])(void *) = {};
+    void *isr_arg[64] = {};
+    int isr_mode[64] = {};
+}
+#endif
+
+// ═══════════════════════════════════════════════════════
+// PIN GROUPS
+// ═══════════════════════════════════════════════════════
+//
+// A group is compiled once into one lookup table per 4 bits of the value:
+// write() ORs at most 8 table entries into a set mask and issues one
+// W1TS + W1TC store per bank, whatever the pin order.
+
+struct GpioGroup {
+    uint64_t mask;                              // Every pin of the group
+    uint8_t count;
+    uint8_t pins[GpioConfig::GROUP_MAX_PINS];
+    // Followed by the tables: uint64_t[(count + 3) / 4][16]
+};
+
+typedef uint64_t GroupTable[16];
+
+static size_t group_nibbles(const GpioGroup *g) {
+    return (g->count + 3) / 4;
+}
+
+static GroupTable *group_tables(GpioGroup *g) {
+    return (GroupTable *)(g + 1);
+}
+
+static void group_compile(GpioGroup *g) {
+    GroupTable *tables = group_tables(g);
+    for (size_t n = 0; n < group_nibbles(g); n++) {
+        for (uint8_t value = 0; value < 16; value++) {
+            uint64_t set = 0;
+            for (uint8_t bit = 0; bit < 4; bit++) {
+                size_t index = n * 4 + bit;
+                if (index < g->count && (value & (1 << bit))) {
+                    set |= 1ull << g->pins[index];
+                }
+            }
+            tables[n][value] = set;
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════
+// EDGE DISPATCH
+// ═══════════════════════════════════════════════════════
+//
+// Queued edges reach Lua on the Lua task: each wake-up of a waiting
+// delay() (or a gpio.update() call) drains the ring in batches and calls
+// the pin's handler, a function or a sys.publish() topic.
+
+static int edge_handlers[GpioEdgeConfig::MAX_PINS];    // Registry refs, valid while attached
+static bool edge_handled[GpioEdgeConfig::MAX_PINS];
+
+static void call_handler(lua_State *L, const GpioEdge &edge) {
+    int base = lua_gettop(L);
+    int nargs = 3;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, edge_handlers[edge.pin]);
+
+    if (lua_type(L, -1) == LUA_TSTRING) {
+        // Topic: sys.publish(topic, pin, level, time_us) once require("sys") ran
+        lua_getfield(L, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+        if (lua_getfield(L, -1, "sys") != LUA_TTABLE || lua_getfield(L, -1, "publish") != LUA_TFUNCTION) {
+            lua_settop(L, base);
+            return;
+        }
+        lua_pushvalue(L, base + 1);
+        nargs = 4;
+    }
+    lua_pushinteger(L, edge.pin);
+    lua_pushinteger(L, edge.level);
+    lua_pushinteger(L, (lua_Integer)edge.time_us);
+
+    if (lua_pcall(L, nargs, 0, 0) != LUA_OK) {
+        LOG_ERROR("LUA", "GPIO %u handler error: %s", edge.pin, lua_tostring(L, -1));
+    }
+    lua_settop(L, base);
+}
+
+// Run handlers for up to `max` queued edges; returns how many were taken
+static size_t dispatch_edges(lua_State *L, size_t max) {
+    GpioEdge batch[GpioEdgeConfig::DISPATCH_BATCH];
+    size_t total = 0;
+    while (total < max) {
+        size_t want = max - total < GpioEdgeConfig::DISPATCH_BATCH ? max - total : GpioEdgeConfig::DISPATCH_BATCH;
+        size_t n = gpio_edges_take(batch, want);
+        if (n == 0) break;
+        for (size_t i = 0; i < n; i++) {
+            if (edge_handled[batch[i].pin]) call_handler(L, batch[i]);
+        }
+        total += n;
+    }
+    return total;
+}
+
+// Wake handler of a waiting delay(): one batch, then yield to the other work
+static void edge_wake_handler(lua_State *L) {
+    dispatch_edges(L, GpioEdgeConfig::DISPATCH_BATCH);
+
+    // The ISR only wakes on an empty ring: come back for the rest
+    if (gpio_edges_queued() > 0) arduino_scheduler_wake();
+}
+
+static void release_handler(lua_State *L, uint8_t pin) {
+    if (edge_handled[pin]) {
+        luaL_unref(L, LUA_REGISTRYINDEX, edge_handlers[pin]);
+        edge_handled[pin] = false;
+    }
+}
+
+// ═══════════════════════════════════════════════════════
+// HELPER FUNCTIONS
+// ═══════════════════════════════════════════════════════
+
+// 32-bit Lua integer as an unsigned bank mask (bit 31 arrives negative)
+static uint32_t check_mask(lua_State *L, int index) {
+    return (uint32_t)luaL_checkinteger(L, index);
+}
+
+// Optional bank argument as a shift into the 64-bit pin mask
+static int check_bank(lua_State *L, int index) {
+    lua_Integer bank = luaL_optinteger(L, index, 0);
+    luaL_argcheck(L, bank == 0 || bank == 1, index, "bank must be 0 or 1");
+    return (int)bank * 32;
+}
+
+// ═══════════════════════════════════════════════════════
+// LUA API
+// ═══════════════════════════════════════════════════════
+
+// gpio.write_mask(set_mask, clear_mask [, bank])
+static int l_gpio_write_mask(lua_State *L) {
+    int shift = check_bank(L, 3);
+    uint64_t set = (uint64_t)check_mask(L, 1) << shift;
+    uint64_t clear = (uint64_t)(uint32_t)luaL_optinteger(L, 2, 0) << shift;
+
+    luaL_argcheck(L, !(set & ~GPIO_BACKEND_OUTPUT_MASK), 1, "mask includes pins that cannot drive an output");
+    luaL_argcheck(L, !(clear & ~GPIO_BACKEND_OUTPUT_MASK), 2, "mask includes pins that cannot drive an output");
+    gpio_backend_write(set, clear);
+    return 0;
+}
+
+// mask = gpio.read_mask([bank])
+static int l_gpio_read_mask(lua_State *L) {
+    int shift = check_bank(L, 1);
+    lua_pushinteger(L, (lua_Integer)(uint32_t)(gpio_backend_read() >> shift));
+    return 1;
+}
+
+// gpio.mode(mask, mode [, bank])
+static int l_gpio_mode(lua_State *L) {
+    int shift = check_bank(L, 3);
+    uint64_t mask = (uint64_t)check_mask(L, 1) << shift;
+    uint8_t mode = (uint8_t)luaL_checkinteger(L, 2);
+
+    luaL_argcheck(L, !(mask & ~GPIO_BACKEND_VALID_MASK), 1, "mask includes pins that do not exist");
+    for (uint8_t pin = 0; pin < 64; pin++) {
+        if (mask & (1ull << pin)) {
+            gpio_backend_mode(pin, mode);
+        }
+    }
+    return 0;
+}
+
+// group = gpio.group({pin1, pin2, ...}) - bit 0 of values maps to pin1
+static int l_gpio_group(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer count = luaL_len(L, 1);
+    luaL_argcheck(L, count > 0 && count <= GpioConfig::GROUP_MAX_PINS, 1, "group needs 1 to 32 pins");
+
+    size_t tables = (count + 3) / 4;
+    GpioGroup *g = (GpioGroup *)lua_newuserdatauv(L, sizeof(GpioGroup) + tables * sizeof(GroupTable), 0);
+    g->mask = 0;
+    g->count = (uint8_t)count;
+    for (lua_Integer i = 0; i < count; i++) {
+        lua_rawgeti(L, 1, i + 1);
+        lua_Integer pin = luaL_checkinteger(L, -1);
+        lua_pop(L, 1);
+
+        if (pin < 0 || pin >= 64 || !(GPIO_BACKEND_OUTPUT_MASK & (1ull << pin))) {
+            return luaL_error(L, "gpio.group: pin %d cannot drive an output", (int)pin);
+        }
+        if (g->mask & (1ull << pin)) {
+            return luaL_error(L, "gpio.group: pin %d listed twice", (int)pin);
+        }
+        g->pins[i] = (uint8_t)pin;
+        g->mask |= 1ull << pin;
+    }
+    group_compile(g);
+
+    luaL_setmetatable(L, GpioConfig::GROUP_METATABLE);
+    return 1;
+}
+
+// group:write(value)
+static int l_group_write(lua_State *L) {
+    GpioGroup *g = (GpioGroup *)luaL_checkudata(L, 1, GpioConfig::GROUP_METATABLE);
+    uint32_t value = check_mask(L, 2);
+
+    GroupTable *tables = group_tables(g);
+    uint64_t set = 0;
+    for (size_t n = 0; n < group_nibbles(g); n++) {
+        set |= tables[n][(value >> (n * 4)) & 0x0F];
+    }
+    gpio_backend_write(set, g->mask & ~set);
+    return 0;
+}
+
+// value = group:read()
+static int l_group_read(lua_State *L) {
+    GpioGroup *g = (GpioGroup *)luaL_checkudata(L, 1, GpioConfig::GROUP_METATABLE);
+    uint64_t levels = gpio_backend_read();
+
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < g->count; i++) {
+        value |= (uint32_t)((levels >> g->pins[i]) & 1) << i;
+    }
+    lua_pushinteger(L, (lua_Integer)value);
+    return 1;
+}
+
+// mask = group:mask([bank])
+static int l_group_mask(lua_State *L) {
+    GpioGroup *g = (GpioGroup *)luaL_checkudata(L, 1, GpioConfig::GROUP_METATABLE);
+    int shift = check_bank(L, 2);
+    lua_pushinteger(L, (lua_Integer)(uint32_t)(g->mask >> shift));
+    return 1;
+}
+
+// gpio.attach(pin, mode, handler [, debounce_us])
+// handler: function(pin, level, time_us), a sys.publish topic, or nil to only count
+static int l_gpio_attach(lua_State *L) {
+    lua_Integer pin = luaL_checkinteger(L, 1);
+    lua_Integer mode = luaL_checkinteger(L, 2);
+    int type = lua_type(L, 3);
+    luaL_argcheck(L, type == LUA_TFUNCTION || type == LUA_TSTRING || type <= LUA_TNIL, 3,
+                  "function, topic or nil expected");
+    lua_Integer debounce = luaL_optinteger(L, 4, 0);
+    luaL_argcheck(L, pin >= 0 && pin < GpioEdgeConfig::MAX_PINS, 1, "invalid pin");
+    luaL_argcheck(L, debounce >= 0, 4, "negative debounce");
+
+    // A refused attach leaves the pin and its old handler as they were
+    bool queue = type > LUA_TNIL;
+    if (!gpio_edges_attach((uint8_t)pin, (int)mode, (uint32_t)debounce, queue)) {
+        return luaL_error(L, "gpio.attach: pin %d cannot interrupt in mode %d", (int)pin, (int)mode);
+    }
+    release_handler(L, (uint8_t)pin);
+    if (queue) {
+        lua_pushvalue(L, 3);
+        edge_handlers[pin] = luaL_ref(L, LUA_REGISTRYINDEX);
+        edge_handled[pin] = true;
+    }
+    return 0;
+}
+
+static int l_gpio_detach(lua_State *L) {
+    lua_Integer pin = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, pin >= 0 && pin < GpioEdgeConfig::MAX_PINS, 1, "invalid pin");
+    gpio_edges_detach((uint8_t)pin);
+    release_handler(L, (uint8_t)pin);
+    return 0;
+}
+
+// gpio.count(pin [, reset])
+static int l_gpio_count(lua_State *L) {
+    lua_Integer pin = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, pin >= 0 && pin < GpioEdgeConfig::MAX_PINS, 1, "invalid pin");
+    lua_pushinteger(L, (lua_Integer)gpio_edges_count((uint8_t)pin, lua_toboolean(L, 2)));
+    return 1;
+}
+
+// gpio.update([max]) - run handlers for queued edges now
+static int l_gpio_update(lua_State *L) {
+    lua_Integer max = luaL_optinteger(L, 1, GpioEdgeConfig::RING_SIZE);
+    lua_pushinteger(L, (lua_Integer)dispatch_edges(L, max > 0 ? (size_t)max : 0));
+    return 1;
+}
+
+// gpio.edge_stats() -> {queued, dropped}
+static int l_gpio_edge_stats(lua_State *L) {
+    lua_createtable(L, 0, 2);
+    lua_pushinteger(L, (lua_Integer)gpio_edges_queued());
+    lua_setfield(L, -2, "queued");
+    lua_pushinteger(L, (lua_Integer)gpio_edges_dropped());
+    lua_setfield(L, -2, "dropped");
+    return 1;
+}
+
+// ═══════════════════════════════════════════════════════
+// MODULE REGISTRATION
+// ═══════════════════════════════════════════════════════
+
+static const luaL_Reg gpio_functions[] = {
+    {"write_mask", l_gpio_write_mask},
+    {"read_mask", l_gpio_read_mask},
+    {"mode", l_gpio_mode},
+    {"group", l_gpio_group},
+    {"attach", l_gpio_attach},
+    {"detach", l_gpio_detach},
+    {"count", l_gpio_count},
+    {"update", l_gpio_update},
+    {"edge_stats", l_gpio_edge_stats},
+    {NULL, NULL}
+};
+
+static const luaL_Reg group_methods[] = {
+    {"write", l_group_write},
+    {"read", l_group_read},
+    {"mask", l_group_mask},
+    {NULL, NULL}
+};
+
+void lua_gpio_register(lua_State *L) {
+    // Group metatable, methods reached through __index
+    luaL_newmetatable(L, GpioConfig::GROUP_METATABLE);
+    luaL_newlib(L, group_methods);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    luaL_newlib(L, gpio_functions);
+    lua_pushinteger(L, RISING);
+    lua_setfield(L, -2, "RISING");
+    lua_pushinteger(L, FALLING);
+    lua_setfield(L, -2, "FALLING");
+    lua_pushinteger(L, CHANGE);
+    lua_setfield(L, -2, "CHANGE");
+    lua_setglobal(L, "gpio");
+
+    arduino_scheduler_on_wake(edge_wake_handler);
+
+    LOG_DEBUG("MODULE", "GPIO module registered");
+}
+
+void lua_gpio_cleanup() {
+    // Handler refs died with the Lua state
+    gpio_edges_detach_all();
+    for (uint8_t pin = 0; pin < GpioEdgeConfig::MAX_PINS; pin++) {
+        edge_handled[pin] = false;
+    }
+}
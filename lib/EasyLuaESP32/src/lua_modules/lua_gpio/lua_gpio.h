@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include "../../core/lua_engine.h"
+
+// ═══════════════════════════════════════════════════════
+// GPIO MODULE - whole-bank and pin-group I/O for Lua
+// ═══════════════════════════════════════════════════════
+//
+// gpio.write_mask(set, clear [, bank])   one register store per mask
+// gpio.read_mask([bank])                 input levels of 32 pins
+// gpio.mode(mask, mode [, bank])         pinMode() on every pin in mask
+// gpio.group({pins...})                  precompiled pin group:
+//     group:write(value)                 bit i of value drives pins[i]
+//     group:read()                       pins[i] level as bit i
+//     group:mask([bank])                 pins of the group as a mask
+// gpio.attach(pin, mode, handler [, debounce_us])
+//                                        mode gpio.RISING / FALLING / CHANGE;
+//                                        handler(pin, level, time_us), a
+//                                        sys.publish topic, or nil to count only
+// gpio.detach(pin)
+// gpio.count(pin [, reset])              edges accepted since attach
+// gpio.update([max])                     run handlers for queued edges now
+// gpio.edge_stats()                      {queued, dropped}
+//
+// Edge handlers run on the Lua task while it waits in delay() or calls
+// gpio.update(); see gpio_edges.h for the ISR side.
+//
+// Lua integers are 32-bit, so masks cover one bank: bank 0 is GPIO0-31,
+// bank 1 is GPIO32 and up (bit 0 = GPIO32).
+
+namespace GpioConfig {
+    const uint8_t GROUP_MAX_PINS = 32;          // Bits in a Lua integer
+    const char* const GROUP_METATABLE = "gpio.group";
+}
+
+void lua_gpio_register(lua_State *L);
+
+// Detach pin interrupts when the script ends
+void lua_gpio_cleanup();
@@ -0,0 +1,275 @@
+#include "lua_periodic.h"
+#include "periodic_timer.h"
+#include "../lua_arduino/lua_arduino.h"
+#include "../../core/utils/debug.h"
+#include <atomic>
+
+// ═══════════════════════════════════════════════════════
+// INTERNAL STATE
+// ═══════════════════════════════════════════════════════
+//
+// Slots are static so a tick still in flight on the timer task after a
+// stop only touches memory that stays valid. A slot belongs to its Lua
+// handle until that is collected, so stats() still works after stop().
+
+struct TimingStats {
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint32_t hist[PeriodicConfig::HIST_BINS];
+};
+
+struct PeriodicSlot {
+    std::atomic<uint32_t> fired;    // Ticks counted by the timer callback
+    PeriodicTimerHandle timer;
+    bool used;                      // Owned by a handle
+    bool active;                    // Timer running, refs held
+    bool calling;
+    int fn_ref;
+    int self_ref;                   // Keeps the handle alive while active
+    uint32_t period_us;
+    int64_t start_us;               // Tick n is due at start_us + n * period_us
+    uint32_t done;                  // Last tick run
+    uint32_t runs;
+    uint32_t skipped;
+    uint32_t overruns;
+    TimingStats jitter;
+    TimingStats exec;
+};
+
+struct PeriodicHandle {
+    uint8_t slot;
+};
+
+static PeriodicSlot periodic_slots[PeriodicConfig::MAX_TIMERS];
+
+// ═══════════════════════════════════════════════════════
+// TIMING STATISTICS
+// ═══════════════════════════════════════════════════════
+
+static void stats_clear(TimingStats *s) {
+    *s = TimingStats();
+}
+
+static uint8_t hist_bin(int32_t us) {
+    if (us < 16) return 0;
+    uint8_t bin = (uint8_t)(31 - __builtin_clz((uint32_t)us) - 3);
+    return bin < PeriodicConfig::HIST_BINS ? bin : PeriodicConfig::HIST_BINS - 1;
+}
+
+static void stats_add(TimingStats *s, uint32_t runs, int64_t us) {
+    int32_t value = us > INT32_MAX ? INT32_MAX : (int32_t)us;
+    if (runs == 0 || value < s->min) s->min = value;
+    if (runs == 0 || value > s->max) s->max = value;
+    s->sum += value;
+    s->hist[hist_bin(value)]++;
+}
+
+static void push_stats(lua_State *L, const TimingStats *s, uint32_t runs) {
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, s->min);
+    lua_setfield(L, -2, "min");
+    lua_pushnumber(L, runs > 0 ? (lua_Number)s->sum / runs : 0);
+    lua_setfield(L, -2, "avg");
+    lua_pushinteger(L, s->max);
+    lua_setfield(L, -2, "max");
+    lua_createtable(L, PeriodicConfig::HIST_BINS, 0);
+    for (uint8_t i = 0; i < PeriodicConfig::HIST_BINS; i++) {
+        lua_pushinteger(L, (lua_Integer)s->hist[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "hist");
+}
+
+// ═══════════════════════════════════════════════════════
+// TIMER AND DISPATCH
+// ═══════════════════════════════════════════════════════
+
+// esp_timer task: count the tick and wake a waiting delay()
+static void periodic_tick(void *arg) {
+    ((PeriodicSlot *)arg)->fired.fetch_add(1, std::memory_order_relaxed);
+    arduino_scheduler_wake();
+}
+
+static void slot_stop(lua_State *L, PeriodicSlot &s) {
+    if (!s.active) return;
+    periodic_timer_stop(s.timer);
+    s.active = false;
+    luaL_unref(L, LUA_REGISTRYINDEX, s.fn_ref);
+    luaL_unref(L, LUA_REGISTRYINDEX, s.self_ref);
+}
+
+// Run each periodic whose next tick has come, once, with the latest tick
+static void periodic_wake_handler(lua_State *L) {
+    for (uint8_t i = 0; i < PeriodicConfig::MAX_TIMERS; i++) {
+        PeriodicSlot &s = periodic_slots[i];
+        if (!s.active || s.calling) continue;
+        uint32_t fired = s.fired.load(std::memory_order_relaxed);
+        if (fired == s.done) continue;
+
+        s.skipped += fired - s.done - 1;
+        s.done = fired;
+        int64_t deadline = s.start_us + (int64_t)fired * s.period_us;
+
+        s.calling = true;
+        int64_t begin = periodic_timer_now_us();
+        lua_rawgeti(L, LUA_REGISTRYINDEX, s.fn_ref);
+        lua_pushinteger(L, (lua_Integer)fired);
+        int status = lua_pcall(L, 1, 0, 0);
+        int64_t end = periodic_timer_now_us();
+        s.calling = false;
+
+        stats_add(&s.jitter, s.runs, begin - deadline);
+        stats_add(&s.exec, s.runs, end - begin);
+        s.runs++;
+        if (end > deadline + s.period_us) s.overruns++;
+
+        if (status != LUA_OK) {
+            LOG_ERROR("LUA", "Periodic error: %s", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            slot_stop(L, s);
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════
+// LUA FUNCTIONS
+// ═══════════════════════════════════════════════════════
+
+static PeriodicSlot &check_slot(lua_State *L) {
+    PeriodicHandle *h = (PeriodicHandle *)luaL_checkudata(L, 1, PeriodicConfig::METATABLE);
+    return periodic_slots[h->slot];
+}
+
+static uint8_t free_slot() {
+    uint8_t index = 0;
+    while (index < PeriodicConfig::MAX_TIMERS && periodic_slots[index].used) index++;
+    return index;
+}
+
+// periodic(fn, period_us)
+static int l_periodic(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    lua_Integer period = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, period >= (lua_Integer)PeriodicConfig::MIN_PERIOD_US, 2, "period too short");
+
+    uint8_t index = free_slot();
+    if (index == PeriodicConfig::MAX_TIMERS) {
+        // Stopped handles hold their slot until collected
+        lua_gc(L, LUA_GCCOLLECT, 0);
+        index = free_slot();
+    }
+    if (index == PeriodicConfig::MAX_TIMERS) {
+        return luaL_error(L, "periodic: all %d timers in use", PeriodicConfig::MAX_TIMERS);
+    }
+
+    // Everything that can raise comes before the timer starts; the handle
+    // owns no slot (and its __gc does nothing) until then
+    PeriodicHandle *h = (PeriodicHandle *)lua_newuserdata(L, sizeof(PeriodicHandle));
+    h->slot = PeriodicConfig::MAX_TIMERS;
+    luaL_setmetatable(L, PeriodicConfig::METATABLE);
+    lua_pushvalue(L, 1);
+    int fn_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_pushvalue(L, -1);
+    int self_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    PeriodicSlot &s = periodic_slots[index];
+    s.fired.store(0);
+    s.done = 0;
+    s.period_us = (uint32_t)period;
+    s.runs = s.skipped = s.overruns = 0;
+    stats_clear(&s.jitter);
+    stats_clear(&s.exec);
+    s.calling = false;
+    s.start_us = periodic_timer_now_us();
+    if (!periodic_timer_start(&s.timer, s.period_us, periodic_tick, &s)) {
+        luaL_unref(L, LUA_REGISTRYINDEX, fn_ref);
+        luaL_unref(L, LUA_REGISTRYINDEX, self_ref);
+        return luaL_error(L, "periodic: timer start failed");
+    }
+    s.fn_ref = fn_ref;
+    s.self_ref = self_ref;
+    s.used = true;
+    s.active = true;
+    h->slot = index;
+    return 1;
+}
+
+static int l_periodic_stop(lua_State *L) {
+    slot_stop(L, check_slot(L));
+    return 0;
+}
+
+static int l_periodic_reset(lua_State *L) {
+    PeriodicSlot &s = check_slot(L);
+    s.runs = s.skipped = s.overruns = 0;
+    stats_clear(&s.jitter);
+    stats_clear(&s.exec);
+    return 0;
+}
+
+static int l_periodic_stats(lua_State *L) {
+    PeriodicSlot &s = check_slot(L);
+    lua_createtable(L, 0, 7);
+    lua_pushinteger(L, (lua_Integer)s.period_us);
+    lua_setfield(L, -2, "period_us");
+    lua_pushinteger(L, (lua_Integer)s.runs);
+    lua_setfield(L, -2, "runs");
+    lua_pushinteger(L, (lua_Integer)s.skipped);
+    lua_setfield(L, -2, "skipped");
+    lua_pushinteger(L, (lua_Integer)s.overruns);
+    lua_setfield(L, -2, "overruns");
+    push_stats(L, &s.jitter, s.runs);
+    lua_setfield(L, -2, "jitter");
+    push_stats(L, &s.exec, s.runs);
+    lua_setfield(L, -2, "exec");
+    return 1;
+}
+
+// Only reached once stopped (self_ref holds active handles) or in lua_close
+static int l_periodic_gc(lua_State *L) {
+    PeriodicHandle *h = (PeriodicHandle *)luaL_checkudata(L, 1, PeriodicConfig::METATABLE);
+    if (h->slot >= PeriodicConfig::MAX_TIMERS) return 0;     // Never started
+    PeriodicSlot &s = periodic_slots[h->slot];
+    if (s.active) periodic_timer_stop(s.timer);
+    s.active = false;
+    s.used = false;
+    return 0;
+}
+
+// ═══════════════════════════════════════════════════════
+// MODULE REGISTRATION
+// ═══════════════════════════════════════════════════════
+
+static const luaL_Reg periodic_methods[] = {
+    {"stop", l_periodic_stop},
+    {"reset", l_periodic_reset},
+    {"stats", l_periodic_stats},
+    {NULL, NULL}
+};
+
+void lua_periodic_register(lua_State *L) {
+    // Handle metatable, methods reached through __index
+    luaL_newmetatable(L, PeriodicConfig::METATABLE);
+    luaL_newlib(L, periodic_methods);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, l_periodic_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    lua_register(L, "periodic", l_periodic);
+
+    arduino_scheduler_on_wake(periodic_wake_handler);
+
+    LOG_DEBUG("MODULE", "Periodic module registered");
+}
+
+void lua_periodic_cleanup() {
+    // Refs died with the Lua state
+    for (uint8_t i = 0; i < PeriodicConfig::MAX_TIMERS; i++) {
+        PeriodicSlot &s = periodic_slots[i];
+        if (s.active) periodic_timer_stop(s.timer);
+        s.active = false;
+        s.used = false;
+    }
+}
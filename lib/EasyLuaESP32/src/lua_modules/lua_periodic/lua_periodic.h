@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include "../../core/lua_engine.h"
+
+// ═══════════════════════════════════════════════════════
+// PERIODIC MODULE - fixed-rate callbacks with timing statistics
+// ═══════════════════════════════════════════════════════
+//
+// local p = periodic(fn, period_us)    fn(tick) at start + tick * period_us
+// p:stats()     {period_us, runs, skipped, overruns,
+//                jitter = {min, avg, max, hist}, exec = {min, avg, max, hist}}
+// p:reset()     clear the statistics
+// p:stop()
+//
+// A hardware timer keeps the deadlines; callbacks run on the Lua task while
+// the script waits in delay(), like eventmsg callbacks. Jitter is how late
+// fn started after its deadline, exec how long it ran (microseconds).
+// Ticks that pass while fn is still pending are skipped (coalesced into
+// one call); a run that ends after the next deadline is an overrun.
+// hist[1] counts values under 16 us and each further bin doubles the range
+// ([16, 32), [32, 64), ...); the last bin holds everything from 16 ms up.
+
+namespace PeriodicConfig {
+    const uint8_t MAX_TIMERS = 8;
+    const uint32_t MIN_PERIOD_US = 100;
+    const uint8_t HIST_BINS = 12;                // Last bin starts at 16 ms
+    const char* const METATABLE = "periodic";
+}
+
+void lua_periodic_register(lua_State *L);
+
+// Stop the timers when the script ends
+void lua_periodic_cleanup();
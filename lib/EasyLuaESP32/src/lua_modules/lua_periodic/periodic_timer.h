@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+
+// ═══════════════════════════════════════════════════════
+// PERIODIC TIMER BACKEND - fixed-rate ticks behind periodic()
+// ═══════════════════════════════════════════════════════
+//
+// A periodic esp_timer re-arms from its previous alarm, not from when the
+// callback ran, so ticks stay on absolute deadlines. The callback runs on
+// the esp_timer task and must only record the tick and wake someone.
+// Build with -DPERIODIC_HOST_MOCK=1 to use a POSIX interval timer
+// off-target.
+
+#ifndef PERIODIC_HOST_MOCK
+#define PERIODIC_HOST_MOCK 0
+#endif
+
+typedef void (*PeriodicTick)(void *arg);
+
+#if PERIODIC_HOST_MOCK
+
+#include <signal.h>
+#include <time.h>
+
+typedef timer_t PeriodicTimerHandle;
+
+inline int64_t periodic_timer_now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Expirations while a notification is pending are merged into one, so
+// replay the overrun count to keep the tick count exact
+inline void periodic_timer_thunk(union sigval value) {
+    void **target = (void **)value.sival_ptr;
+    int ticks = 1 + timer_getoverrun(*(timer_t *)target[2]);
+    for (int i = 0; i < ticks; i++) {
+        ((PeriodicTick)target[0])(target[1]);
+    }
+}
+
+inline bool periodic_timer_start(PeriodicTimerHandle *handle, uint32_t period_us,
+                                 PeriodicTick tick, void *arg) {
+    // Leaked per timer: the slot it points at is static anyway
+    void **target = new void *[3];
+    target[0] = (void *)tick;
+    target[1] = arg;
+    target[2] = handle;
+
+    struct sigevent event = {};
+    event.sigev_notify = SIGEV_THREAD;
+    event.sigev_notify_function = periodic_timer_thunk;
+    event.sigev_value.sival_ptr = target;
+    if (timer_create(CLOCK_MONOTONIC, &event, handle) != 0) return false;
+
+    struct itimerspec spec = {};
+    spec.it_interval.tv_sec = period_us / 1000000;
+    spec.it_interval.tv_nsec = (long)(period_us % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    return timer_settime(*handle, 0, &spec, NULL) == 0;
+}
+
+inline void periodic_timer_stop(PeriodicTimerHandle handle) {
+    timer_delete(handle);
+}
+
+#else
+
+#include <esp_timer.h>
+
+typedef esp_timer_handle_t PeriodicTimerHandle;
+
+inline int64_t periodic_timer_now_us() {
+    return esp_timer_get_time();
+}
+
+inline bool periodic_timer_start(PeriodicTimerHandle *handle, uint32_t period_us,
+                                 PeriodicTick tick, void *arg) {
+    esp_timer_create_args_t args = {};
+    args.callback = tick;
+    args.arg = arg;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "periodic";
+    if (esp_timer_create(&args, handle) != ESP_OK) return false;
+    if (esp_timer_start_periodic(*handle, period_us) != ESP_OK) {
+        esp_timer_delete(*handle);
+        return false;
+    }
+    return true;
+}
+
+inline void periodic_timer_stop(PeriodicTimerHandle handle) {
+    esp_timer_stop(handle);
+    esp_timer_delete(handle);
+}
+
+#endif
@@ -1,8 +1,18 @@
 #include "lua_storage.h"
+#include "storage_keymap.h"
+#include "storage_table.h"
+#include "storage_log.h"
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <cstring>
+#include <nvs.h>
+#include <esp_system.h>
+#include <esp_idf_version.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 
 #include "../../core/lua_engine.h"
 
@@ -10,16 +20,626 @@
 // ==================== Static Variables (Instead of Class Members) ====================
 static bool storage_initialized = false;
 static Preferences storage_prefs;
+static nvs_handle_t storage_nvs = 0;     // Raw handle so a flush commits once
 static const char* storage_default_namespace = "lua_storage";
 static String storage_current_namespace;
+static StorageBackend storage_backend = STORAGE_BACKEND_NVS;
 static String storage_temp_buffer; // For string returns
 
+// ==================== Write-Back Cache ====================
+
+struct StorageCacheEntry {
+    StorageValueType type;
+    bool dirty;
+    union {
+        storage_int_t i;
+        storage_number_t n;
+        bool b;
+    } v;
+    String s;
+    std::vector<uint8_t> blob;
+
+    size_t payload() const { return s.length() + blob.size(); }
+};
+
+// Keyed by the NVS key (see storage_keymap.h)
+static std::map<String, StorageCacheEntry> storage_cache;
+static SemaphoreHandle_t storage_mutex = NULL;
+static TaskHandle_t storage_flush_task = NULL;
+static size_t storage_cache_bytes = 0;
+static uint32_t storage_dirty_count = 0;
+static unsigned long storage_first_dirty = 0;
+
+// Open transaction: staged writes, visible only to the task that began it.
+// Keyed by the script's key, so a long key gets its NVS name (and index
+// slot) only when the transaction commits.
+static bool storage_txn_active = false;
+static TaskHandle_t storage_txn_owner = NULL;
+static std::map<String, StorageCacheEntry> storage_txn;
+static size_t storage_txn_bytes = 0;
+static uint32_t storage_generation = 0;
+static uint32_t storage_txn_commits = 0;
+static uint32_t storage_txn_rollbacks = 0;
+
+static uint32_t storage_writes = 0;
+static uint32_t storage_flash_writes = 0;
+static uint32_t storage_flushes = 0;
+static uint32_t storage_last_flush_us = 0;
+static unsigned long storage_rate_start = 0;
+static uint32_t storage_rate_writes = 0;
+static float storage_rate = 0;
+
+// ==================== Key Index ====================
+
+// Live keys of the namespace as scripts name them, sorted so a prefix
+// scan is one range walk. Built at init, then kept current by every write.
+static std::set<String> storage_key_index;
+
+// Script-visible key of a backend key; empty for unknown hashed names
+static String index_name_locked(const String& nvs_key) {
+    if (storage_backend == STORAGE_BACKEND_NVS && nvs_key.length() > 0 && nvs_key[0] == '#') {
+        return storage_keymap_name(nvs_key);
+    }
+    return nvs_key;
+}
+
+static void index_note_locked(const String& key, StorageValueType type) {
+    if (key.length() == 0) return;
+    if (type == STORAGE_REMOVED) {
+        storage_key_index.erase(key);
+    } else {
+        storage_key_index.insert(key);
+    }
+}
+
+static void index_add_entry_locked(nvs_iterator_t it) {
+    nvs_entry_info_t info;
+    nvs_entry_info(it, &info);
+    // '~' names are internal records (key index, journal, generation)
+    if (info.key[0] != '~') {
+        index_note_locked(index_name_locked(String(info.key)), STORAGE_INT);
+    }
+}
+
+// One pass over the namespace at init (after the journal replay)
+static void index_build_locked() {
+    storage_key_index.clear();
+    unsigned long start = micros();
+
+    if (storage_backend == STORAGE_BACKEND_LOG) {
+        std::vector<String> keys;
+        storage_log_keys(keys);
+        storage_key_index.insert(keys.begin(), keys.end());
+    } else {
+        const char* ns = storage_current_namespace.c_str();
+#if ESP_IDF_VERSION_MAJOR >= 5
+        nvs_iterator_t it = NULL;
+        esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, ns, NVS_TYPE_ANY, &it);
+        while (err == ESP_OK) {
+            index_add_entry_locked(it);
+            err = nvs_entry_next(&it);
+        }
+        nvs_release_iterator(it);
+#else
+        // IDF 4.x returns NULL (and frees the iterator) at the end
+        for (nvs_iterator_t it = nvs_entry_find(NVS_DEFAULT_PART_NAME, ns, NVS_TYPE_ANY); it != NULL;
+             it = nvs_entry_next(it)) {
+            index_add_entry_locked(it);
+        }
+#endif
+    }
+
+    LOG_DEBUG(STORAGE_TAG, "Key index: %u keys in %lu us", (unsigned)storage_key_index.size(), micros() - start);
+}
+
 // ==================== Helper Functions ====================
-static String compress_key(const String& key) {
-    if (key.length() > 15) {
-        return key.substring(0, 15);
+// Backend key for `key`: log namespaces use it verbatim, NVS goes through
+// the long-key index. Empty when unusable (caller holds storage_mutex).
+static String resolve_key_locked(const char* key, bool create) {
+    if (storage_backend == STORAGE_BACKEND_LOG) {
+        return strlen(key) <= StorageLogConfig::MAX_KEY_LENGTH ? String(key) : String();
+    }
+    return storage_keymap_resolve(String(key), create);
+}
+
+// Raw value bytes of an entry, as stored in the journal and the log
+static void entry_to_bytes(const StorageCacheEntry& e, std::vector<uint8_t>& out) {
+    const uint8_t* value = NULL;
+    size_t len = 0;
+    uint8_t flag;
+    switch (e.type) {
+        case STORAGE_INT:    value = (const uint8_t*)&e.v.i; len = sizeof(e.v.i); break;
+        case STORAGE_NUMBER: value = (const uint8_t*)&e.v.n; len = sizeof(e.v.n); break;
+        case STORAGE_BOOL:   flag = e.v.b; value = &flag; len = 1; break;
+        case STORAGE_STRING: value = (const uint8_t*)e.s.c_str(); len = e.s.length(); break;
+        case STORAGE_BLOB:   value = e.blob.data(); len = e.blob.size(); break;
+        default: break;
+    }
+    out.assign(value, value + len);
+}
+
+static bool entry_from_bytes(StorageValueType type, const uint8_t* value, size_t len, StorageCacheEntry& e) {
+    e.type = type;
+    e.dirty = false;
+    switch (type) {
+        case STORAGE_INT:    if (len != sizeof(e.v.i)) return false; memcpy(&e.v.i, value, len); break;
+        case STORAGE_NUMBER: if (len != sizeof(e.v.n)) return false; memcpy(&e.v.n, value, len); break;
+        case STORAGE_BOOL:   if (len != 1) return false; e.v.b = value[0] != 0; break;
+        case STORAGE_STRING: e.s = String(); e.s.reserve(len); for (size_t j = 0; j < len; j++) e.s += (char)value[j]; break;
+        case STORAGE_BLOB:   e.blob.assign(value, value + len); break;
+        case STORAGE_REMOVED: break;
+        default: return false;
+    }
+    return true;
+}
+
+static bool same_value(const StorageCacheEntry& a, const StorageCacheEntry& b) {
+    if (a.type != b.type) return false;
+    switch (a.type) {
+        case STORAGE_INT:    return a.v.i == b.v.i;
+        case STORAGE_NUMBER: return memcmp(&a.v.n, &b.v.n, sizeof(a.v.n)) == 0;
+        case STORAGE_BOOL:   return a.v.b == b.v.b;
+        case STORAGE_STRING: return a.s == b.s;
+        case STORAGE_BLOB:   return a.blob == b.blob;
+        default:             return true;
+    }
+}
+
+// Writes-per-second over windows of at least one second
+static void count_write() {
+    unsigned long now = millis();
+    storage_writes++;
+    storage_rate_writes++;
+    if (now - storage_rate_start >= 1000) {
+        storage_rate = storage_rate_writes * 1000.0f / (now - storage_rate_start);
+        storage_rate_start = now;
+        storage_rate_writes = 0;
+    }
+}
+
+// Write one dirty entry with the same NVS encodings Preferences uses,
+// so values read back through storage_prefs unchanged
+static esp_err_t write_entry(const String& key, const StorageCacheEntry& e) {
+    switch (e.type) {
+        case STORAGE_INT:    return nvs_set_i64(storage_nvs, key.c_str(), e.v.i);
+        case STORAGE_NUMBER: return nvs_set_blob(storage_nvs, key.c_str(), &e.v.n, sizeof(e.v.n));
+        case STORAGE_STRING: return nvs_set_str(storage_nvs, key.c_str(), e.s.c_str());
+        case STORAGE_BOOL:   return nvs_set_u8(storage_nvs, key.c_str(), e.v.b ? 1 : 0);
+        case STORAGE_BLOB:   return nvs_set_blob(storage_nvs, key.c_str(), e.blob.data(), e.blob.size());
+        default: {
+            esp_err_t err = nvs_erase_key(storage_nvs, key.c_str());
+            return err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+        }
+    }
+}
+
+// Caller holds storage_mutex. Transactions pass commit=false and close
+// the batch themselves.
+static bool flush_locked(bool commit = true) {
+    if (storage_dirty_count == 0) return true;
+    if (storage_nvs == 0) return false;
+
+    unsigned long start = micros();
+    uint32_t written = 0;
+    bool ok = true;
+
+    for (std::map<String, StorageCacheEntry>::iterator it = storage_cache.begin(); it != storage_cache.end(); ++it) {
+        if (!it->second.dirty) continue;
+
+        esp_err_t err = write_entry(it->first, it->second);
+        if (err != ESP_OK) {
+            LOG_ERROR(STORAGE_TAG, "Flush of %s failed: %s", it->first.c_str(), esp_err_to_name(err));
+            ok = false;
+            continue;
+        }
+        it->second.dirty = false;
+        storage_dirty_count--;
+        written++;
+
+        if (it->second.type == STORAGE_REMOVED) {
+            storage_keymap_forget(it->first);
+        }
+    }
+
+    // Index goes in the same batch as the values it names
+    if (!storage_keymap_save(storage_nvs)) {
+        ok = false;
+    }
+
+    // One commit for the whole batch
+    if (commit && written > 0 && nvs_commit(storage_nvs) != ESP_OK) {
+        ok = false;
+    }
+
+    storage_flash_writes += written;
+    if (written > 0) {
+        storage_flushes++;
+        storage_last_flush_us = micros() - start;
+        LOG_DEBUG(STORAGE_TAG, "Flushed %u keys in %u us", written, storage_last_flush_us);
+    }
+    storage_first_dirty = millis();
+    return ok;
+}
+
+// Drop clean entries to make room (caller holds storage_mutex)
+static void evict_clean_locked() {
+    for (std::map<String, StorageCacheEntry>::iterator it = storage_cache.begin(); it != storage_cache.end();) {
+        if (!it->second.dirty) {
+            storage_cache_bytes -= it->second.payload();
+            storage_cache.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Record a write in the cache without making room first; the cache may
+// run over its limits until the next flush (caller holds storage_mutex)
+static void cache_store_locked(const String& nvs_key, const StorageCacheEntry& value) {
+    std::map<String, StorageCacheEntry>::iterator it = storage_cache.find(nvs_key);
+    count_write();
+
+    if (it != storage_cache.end() && same_value(it->second, value)) {
+        // Unchanged (or already pending) - nothing new for flash
+    } else {
+        if (it == storage_cache.end()) {
+            it = storage_cache.insert(std::make_pair(nvs_key, value)).first;
+        } else {
+            storage_cache_bytes -= it->second.payload();
+            bool was_dirty = it->second.dirty;
+            it->second = value;
+            it->second.dirty = was_dirty;
+        }
+        storage_cache_bytes += value.payload();
+
+        if (!it->second.dirty) {
+            it->second.dirty = true;
+            if (storage_dirty_count++ == 0) {
+                storage_first_dirty = millis();
+            }
+        }
+    }
+
+    // Past half the cache dirty: let the flush task write early
+    if (storage_dirty_count >= StorageConfig::CACHE_MAX_ENTRIES / 2 && storage_flush_task) {
+        xTaskNotifyGive(storage_flush_task);
+    }
+}
+
+// Record a write in the cache; NVS sees it on the next flush (caller holds storage_mutex)
+static bool cache_put_locked(const String& nvs_key, const StorageCacheEntry& value) {
+    if (storage_cache.find(nvs_key) == storage_cache.end() &&
+        (storage_cache.size() >= StorageConfig::CACHE_MAX_ENTRIES ||
+         storage_cache_bytes + value.payload() > StorageConfig::CACHE_MAX_BYTES)) {
+        bool ok = flush_locked();
+        evict_clean_locked();
+        if (!ok) return false;
+    }
+    cache_store_locked(nvs_key, value);
+    return true;
+}
+
+static bool in_own_txn() {
+    return storage_txn_active && storage_txn_owner == xTaskGetCurrentTaskHandle();
+}
+
+// Stage a write in the open transaction (caller holds storage_mutex)
+static bool txn_stage_locked(const String& key, const StorageCacheEntry& value) {
+    std::map<String, StorageCacheEntry>::iterator it = storage_txn.find(key);
+    size_t old_bytes = it != storage_txn.end() ? key.length() + it->second.payload() + 12 : 0;
+    size_t new_bytes = key.length() + value.payload() + 12;
+
+    if (storage_txn_bytes - old_bytes + new_bytes > StorageConfig::TXN_MAX_BYTES) {
+        LOG_ERROR(STORAGE_TAG, "Transaction too large, %s not staged", key.c_str());
+        return false;
+    }
+    storage_txn_bytes = storage_txn_bytes - old_bytes + new_bytes;
+    storage_txn[key] = value;
+    return true;
+}
+
+static bool cache_store(const char* key, const StorageCacheEntry& value) {
+    if (!storage_initialized && !storage_init_c()) return false;
+    if (!key || strlen(key) == 0) return false;
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+
+    // Staging only checks the key fits; its mapping is made at commit
+    bool staging = in_own_txn();
+    bool mapped = resolve_key_locked(key, false).length() > 0;
+    size_t max_key = storage_backend == STORAGE_BACKEND_LOG ? StorageLogConfig::MAX_KEY_LENGTH
+                                                            : StorageKeyConfig::MAX_KEY_LENGTH;
+    String nvs_key = staging ? String() : resolve_key_locked(key, true);
+    bool ok;
+    if (staging ? strlen(key) > max_key : nvs_key.length() == 0) {
+        LOG_ERROR(STORAGE_TAG, "Cannot store key %s", key);
+        ok = false;
+    } else if (staging) {
+        ok = txn_stage_locked(String(key), value);
+    } else if (storage_backend == STORAGE_BACKEND_LOG) {
+        // Appends are cheap, so the log bypasses the write-back cache
+        std::vector<uint8_t> bytes;
+        entry_to_bytes(value, bytes);
+        count_write();
+        ok = storage_log_put(nvs_key.c_str(), value.type, bytes.data(), bytes.size());
+        if (ok) {
+            storage_flash_writes++;
+        }
+    } else {
+        ok = cache_put_locked(nvs_key, value);
+        if (!ok && !mapped) {
+            // Nothing was stored under the slot just taken
+            storage_keymap_forget(nvs_key);
+        }
+    }
+    if (ok && !staging) {
+        index_note_locked(String(key), value.type);
+    }
+
+    xSemaphoreGive(storage_mutex);
+    return ok;
+}
+
+// Look up a key; true with `out` filled on a hit (including cached removals).
+// `nvs_key` is empty for a long key that has no mapping yet.
+static bool cache_lookup_locked(const char* key, const String& nvs_key, StorageCacheEntry& out) {
+    // A transaction reads its own staged writes
+    std::map<String, StorageCacheEntry>::const_iterator it;
+    bool hit = false;
+    if (in_own_txn()) {
+        it = storage_txn.find(String(key));
+        hit = it != storage_txn.end();
+    }
+    if (!hit && nvs_key.length() == 0) {
+        return false;
     }
-    return key;
+    if (!hit && storage_backend == STORAGE_BACKEND_LOG) {
+        // The log index is authoritative: a miss is a known "not found"
+        StorageValueType type;
+        std::vector<uint8_t> bytes;
+        if (!storage_log_get(nvs_key.c_str(), type, bytes) || !entry_from_bytes(type, bytes.data(), bytes.size(), out)) {
+            out.type = STORAGE_REMOVED;
+        }
+        return true;
+    }
+    if (!hit) {
+        it = storage_cache.find(nvs_key);
+        hit = it != storage_cache.end();
+    }
+    if (hit) {
+        out = it->second;
+    }
+    return hit;
+}
+
+static bool cache_lookup(const char* key, const String& nvs_key, StorageCacheEntry& out) {
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    bool hit = cache_lookup_locked(key, nvs_key, out);
+    xSemaphoreGive(storage_mutex);
+    return hit;
+}
+
+// Value stored in NVS under `name`, with the type it was stored as
+static bool read_nvs_locked(const char* name, StorageCacheEntry& out) {
+    out.dirty = false;
+    switch (storage_prefs.getType(name)) {
+        case PT_I64:
+            out.type = STORAGE_INT;
+            out.v.i = storage_prefs.getLong64(name, 0);
+            return true;
+        case PT_U8:
+            out.type = STORAGE_BOOL;
+            out.v.b = storage_prefs.getBool(name, false);
+            return true;
+        case PT_STR:
+            out.type = STORAGE_STRING;
+            out.s = storage_prefs.getString(name, String());
+            return true;
+        case PT_BLOB: {
+            out.blob.resize(storage_prefs.getBytesLength(name));
+            if (out.blob.empty() || storage_prefs.getBytes(name, out.blob.data(), out.blob.size()) != out.blob.size()) {
+                return false;
+            }
+            // Doubles are 8-byte blobs (Preferences::putDouble); tables carry a header
+            if (out.blob.size() == sizeof(out.v.n) && !storage_table_is_blob(out.blob.data(), out.blob.size())) {
+                out.type = STORAGE_NUMBER;
+                memcpy(&out.v.n, out.blob.data(), sizeof(out.v.n));
+                out.blob.clear();
+            } else {
+                out.type = STORAGE_BLOB;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Firmware before the key index stored long keys under their first 15
+// characters. Move such a value to the key's hashed name, in the next
+// flush batch; returns that name, or empty when there is nothing to move
+// (caller holds storage_mutex).
+static String migrate_legacy_locked(const char* key) {
+    size_t len = strlen(key);
+    if (storage_backend != STORAGE_BACKEND_NVS || len <= StorageKeyConfig::NVS_KEY_MAX ||
+        len > StorageKeyConfig::MAX_KEY_LENGTH) {
+        return String();
+    }
+
+    String legacy = String(key).substring(0, StorageKeyConfig::NVS_KEY_MAX);
+    StorageCacheEntry value;
+    std::map<String, StorageCacheEntry>::const_iterator it = storage_cache.find(legacy);
+    if (it != storage_cache.end()) {
+        value = it->second;
+        value.dirty = false;
+    } else if (!read_nvs_locked(legacy.c_str(), value)) {
+        return String();
+    }
+    if (value.type == STORAGE_REMOVED) return String();
+
+    String nvs_key = storage_keymap_resolve(String(key), true);
+    if (nvs_key.length() == 0) return String();
+
+    StorageCacheEntry removed;
+    removed.type = STORAGE_REMOVED;
+    removed.dirty = false;
+    cache_store_locked(nvs_key, value);
+    cache_store_locked(legacy, removed);
+    index_note_locked(legacy, STORAGE_REMOVED);
+    index_note_locked(String(key), value.type);
+
+    LOG_INFO(STORAGE_TAG, "Moved %s from legacy key %s", key, legacy.c_str());
+    return nvs_key;
+}
+
+// Backend key for a read; empty when a long key was never stored
+// (caller holds storage_mutex)
+static String read_key_locked(const char* key) {
+    String nvs_key = resolve_key_locked(key, false);
+    return nvs_key.length() > 0 ? nvs_key : migrate_legacy_locked(key);
+}
+
+static String lookup_key(const char* key) {
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    String nvs_key = read_key_locked(key);
+    xSemaphoreGive(storage_mutex);
+    return nvs_key;
+}
+
+// Value of `key` with the type it was stored as; false when missing
+// (caller holds storage_mutex)
+static bool fetch_entry_locked(const String& key, StorageCacheEntry& out) {
+    String nvs_key = read_key_locked(key.c_str());
+    if (cache_lookup_locked(key.c_str(), nvs_key, out)) {
+        return out.type != STORAGE_REMOVED;
+    }
+    return nvs_key.length() > 0 && read_nvs_locked(nvs_key.c_str(), out);
+}
+
+// Look up a batch under one lock; missing keys come back as STORAGE_REMOVED
+static void fetch_entries(const std::vector<String>& keys, std::vector<StorageCacheEntry>& out) {
+    out.resize(keys.size());
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (!fetch_entry_locked(keys[i], out[i])) {
+            out[i].type = STORAGE_REMOVED;
+        }
+    }
+    xSemaphoreGive(storage_mutex);
+}
+
+// ==================== Transaction Journal ====================
+
+// Redo journal under StorageConfig::TXN_JOURNAL_KEY:
+//   [version u8][reserved u8][count u16][generation u32]
+//   count x [type u8][key_len u8][key][value_len u16][value]
+// Written before any staged value, erased once all of them are in NVS.
+static void journal_append(std::vector<uint8_t>& out, const String& key, const StorageCacheEntry& e) {
+    std::vector<uint8_t> value;
+    entry_to_bytes(e, value);
+
+    uint8_t header[2] = { (uint8_t)e.type, (uint8_t)key.length() };
+    out.insert(out.end(), header, header + 2);
+    out.insert(out.end(), (const uint8_t*)key.c_str(), (const uint8_t*)key.c_str() + key.length());
+    out.push_back(value.size() & 0xFF);
+    out.push_back(value.size() >> 8);
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static bool journal_parse(const std::vector<uint8_t>& data, uint32_t& generation,
+                          std::vector<std::pair<String, StorageCacheEntry> >& entries) {
+    if (data.size() < 8 || data[0] != StorageConfig::TXN_JOURNAL_VERSION) return false;
+
+    uint16_t count = data[2] | (data[3] << 8);
+    memcpy(&generation, &data[4], 4);
+
+    size_t pos = 8;
+    for (uint16_t i = 0; i < count; i++) {
+        if (pos + 2 > data.size()) return false;
+        uint8_t type = data[pos];
+        uint8_t key_len = data[pos + 1];
+        if (type > STORAGE_REMOVED || pos + 4 + key_len > data.size()) return false;
+
+        char key[StorageKeyConfig::NVS_KEY_MAX + 1];
+        if (key_len > StorageKeyConfig::NVS_KEY_MAX) return false;
+        memcpy(key, &data[pos + 2], key_len);
+        key[key_len] = '\0';
+        pos += 2 + key_len;
+
+        size_t len = data[pos] | (data[pos + 1] << 8);
+        pos += 2;
+        if (pos + len > data.size()) return false;
+
+        StorageCacheEntry e;
+        if (!entry_from_bytes((StorageValueType)type, &data[pos], len, e)) return false;
+        pos += len;
+        entries.push_back(std::make_pair(String(key), e));
+    }
+    return true;
+}
+
+// Finish a transaction interrupted by a reset: apply the whole journal again
+static void journal_replay() {
+    size_t size = 0;
+    if (storage_nvs == 0 ||
+        nvs_get_blob(storage_nvs, StorageConfig::TXN_JOURNAL_KEY, NULL, &size) != ESP_OK) {
+        return;
+    }
+
+    std::vector<uint8_t> data(size);
+    uint32_t generation = 0;
+    std::vector<std::pair<String, StorageCacheEntry> > entries;
+    if (nvs_get_blob(storage_nvs, StorageConfig::TXN_JOURNAL_KEY, data.data(), &size) != ESP_OK ||
+        !journal_parse(data, generation, entries)) {
+        // A journal blob is written whole or not at all, so this is not a torn write
+        LOG_ERROR(STORAGE_TAG, "Transaction journal unreadable, discarding");
+        nvs_erase_key(storage_nvs, StorageConfig::TXN_JOURNAL_KEY);
+        nvs_commit(storage_nvs);
+        return;
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        write_entry(entries[i].first, entries[i].second);
+        if (entries[i].second.type == STORAGE_REMOVED) {
+            storage_keymap_forget(entries[i].first);
+        }
+    }
+    storage_keymap_save(storage_nvs);
+    nvs_set_u32(storage_nvs, StorageConfig::TXN_GENERATION_KEY, generation);
+    nvs_erase_key(storage_nvs, StorageConfig::TXN_JOURNAL_KEY);
+    nvs_commit(storage_nvs);
+    storage_generation = generation;
+
+    LOG_INFO(STORAGE_TAG, "Replayed transaction %u (%u keys)", generation, (unsigned)entries.size());
+}
+
+static void txn_discard_locked() {
+    storage_txn.clear();
+    storage_txn_bytes = 0;
+    storage_txn_active = false;
+    storage_txn_owner = NULL;
+}
+
+static void storage_flush_task_fn(void* param) {
+    (void)param;
+    for (;;) {
+        bool notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(StorageConfig::FLUSH_CHECK_MS)) > 0;
+
+        xSemaphoreTake(storage_mutex, portMAX_DELAY);
+        if (storage_initialized && storage_backend == STORAGE_BACKEND_LOG) {
+            storage_log_service();
+        }
+        if (storage_initialized && storage_dirty_count > 0 &&
+            (notified || millis() - storage_first_dirty >= StorageConfig::WRITE_BACK_MS)) {
+            flush_locked();
+        }
+        xSemaphoreGive(storage_mutex);
+    }
+}
+
+// Runs from esp_restart() so pending keys survive a software reset
+static void storage_shutdown_handler(void) {
+    storage_flush_c();
 }
 
 // ==================== C++ Function Implementation ====================
@@ -27,43 +647,101 @@ static String compress_key(const String& key) {
 bool storage_init_c(void) {
     if (storage_initialized) return true;
 
-    // Use Arduino C++ features
-    storage_prefs.begin(storage_current_namespace.c_str(), false);
+    // Flush task and shutdown hook live for the whole session
+    if (storage_mutex == NULL) {
+        storage_mutex = xSemaphoreCreateMutex();
+        esp_register_shutdown_handler(storage_shutdown_handler);
+        xTaskCreatePinnedToCore(storage_flush_task_fn, "StorageFlush", 3072, NULL, 1, &storage_flush_task, 0);
+    }
+
+    storage_generation = 0;
+    if (storage_backend == STORAGE_BACKEND_LOG) {
+        if (!storage_log_open(storage_current_namespace.c_str())) {
+            return false;
+        }
+    } else {
+        // Use Arduino C++ features
+        storage_prefs.begin(storage_current_namespace.c_str(), false);
+        if (nvs_open(storage_current_namespace.c_str(), NVS_READWRITE, &storage_nvs) != ESP_OK) {
+            storage_nvs = 0;
+            LOG_ERROR(STORAGE_TAG, "nvs_open failed, writes will stay cached");
+        }
+        storage_keymap_load(storage_nvs);
+
+        if (storage_nvs != 0) {
+            nvs_get_u32(storage_nvs, StorageConfig::TXN_GENERATION_KEY, &storage_generation);
+        }
+        journal_replay();
+    }
+    index_build_locked();
+
+    storage_txn_commits = 0;
+    storage_txn_rollbacks = 0;
+    storage_writes = 0;
+    storage_flash_writes = 0;
+    storage_flushes = 0;
+    storage_last_flush_us = 0;
+    storage_rate_start = millis();
+    storage_rate_writes = 0;
+    storage_rate = 0;
     storage_initialized = true;
 
-    LOG_INFO(STORAGE_TAG, "Storage initialized with namespace: %s", storage_current_namespace.c_str());
+    LOG_INFO(STORAGE_TAG, "Storage initialized with namespace: %s (%s)", storage_current_namespace.c_str(),
+             storage_backend == STORAGE_BACKEND_LOG ? "log" : "nvs");
     return true;
 }
 
 void storage_stop_c(void) {
     if (!storage_initialized) return;
-    
-    storage_prefs.end();
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    if (storage_txn_active) {
+        LOG_ERROR(STORAGE_TAG, "Transaction left open, %u keys discarded", (unsigned)storage_txn.size());
+        txn_discard_locked();
+    }
+    flush_locked();
+    LOG_INFO(STORAGE_TAG, "%u writes, %u reached flash", storage_writes, storage_flash_writes);
+
+    storage_cache.clear();
+    storage_cache_bytes = 0;
+    storage_dirty_count = 0;
+    storage_key_index.clear();
+    if (storage_backend == STORAGE_BACKEND_LOG) {
+        storage_log_close();
+    } else {
+        if (storage_nvs != 0) {
+            nvs_close(storage_nvs);
+            storage_nvs = 0;
+        }
+        storage_prefs.end();
+    }
     storage_temp_buffer = "";
     storage_initialized = false;
+    xSemaphoreGive(storage_mutex);
 
     LOG_INFO(STORAGE_TAG, "Storage stopped and cleaned up");
 }
 
 bool storage_set_int_c(const char* key, storage_int_t value) {
-    if (!storage_initialized && !storage_init_c()) return false;
-    if (!key || strlen(key) == 0) return false;
-    
-    String compressed_key = compress_key(String(key));
-    bool result = storage_prefs.putLong64(compressed_key.c_str(), value) > 0;
+    StorageCacheEntry e;
+    e.type = STORAGE_INT;
+    e.dirty = false;
+    e.v.i = value;
+
+    bool result = cache_store(key, e);
     if (result) {
-        LOG_DEBUG(STORAGE_TAG, "Set int: %s = %lld", key, value);
+        LOG_DEBUG(STORAGE_TAG, "Set int: %s = %lld", key, (long long)value);
     }
     return result;
 }
 
 bool storage_set_number_c(const char* key, storage_number_t value) {
-    if (!storage_initialized && !storage_init_c()) return false;
-    if (!key || strlen(key) == 0) return false;
-    
-    String compressed_key = compress_key(String(key));
-    bool result = storage_prefs.putDouble(compressed_key.c_str(), value) > 0;
+    StorageCacheEntry e;
+    e.type = STORAGE_NUMBER;
+    e.dirty = false;
+    e.v.n = value;
 
+    bool result = cache_store(key, e);
     if (result) {
         LOG_DEBUG(STORAGE_TAG, "Set number: %s = %f", key, value);
     }
@@ -71,13 +749,14 @@ bool storage_set_number_c(const char* key, storage_number_t value) {
 }
 
 bool storage_set_string_c(const char* key, const char* value) {
-    if (!storage_initialized && !storage_init_c()) return false;
-    if (!key || strlen(key) == 0) return false;
     if (!value) value = "";
-    
-    String compressed_key = compress_key(String(key));
-    bool result = storage_prefs.putString(compressed_key.c_str(), String(value)) > 0;
 
+    StorageCacheEntry e;
+    e.type = STORAGE_STRING;
+    e.dirty = false;
+    e.s = value;
+
+    bool result = cache_store(key, e);
     if (result) {
         LOG_DEBUG(STORAGE_TAG, "Set string: %s = %s", key, value);
     }
@@ -85,12 +764,12 @@ bool storage_set_string_c(const char* key, const char* value) {
 }
 
 bool storage_set_bool_c(const char* key, bool value) {
-    if (!storage_initialized && !storage_init_c()) return false;
-    if (!key || strlen(key) == 0) return false;
-    
-    String compressed_key = compress_key(String(key));
-    bool result = storage_prefs.putBool(compressed_key.c_str(), value) > 0;
+    StorageCacheEntry e;
+    e.type = STORAGE_BOOL;
+    e.dirty = false;
+    e.v.b = value;
 
+    bool result = cache_store(key, e);
     if (result) {
         LOG_DEBUG(STORAGE_TAG, "Set bool: %s = %d", key, value);
     }
@@ -98,24 +777,28 @@ bool storage_set_bool_c(const char* key, bool value) {
 }
 
 bool storage_set_blob_c(const char* key, const void* data, size_t len) {
-    if (!storage_initialized && !storage_init_c()) return false;
-    if (!key || strlen(key) == 0 || !data || len == 0) return false;
-    
-    String compressed_key = compress_key(String(key));
-    bool result = storage_prefs.putBytes(compressed_key.c_str(), data, len) > 0;
-    
-    if (result) {
-        //LLOGI("Set blob: %s (%d bytes)", key, len);
-    }
-    return result;
+    if (!data || len == 0) return false;
+
+    StorageCacheEntry e;
+    e.type = STORAGE_BLOB;
+    e.dirty = false;
+    e.blob.assign((const uint8_t*)data, (const uint8_t*)data + len);
+
+    return cache_store(key, e);
 }
 
+// Cached values of another type read as missing, like NVS type mismatches
 storage_int_t storage_get_int_c(const char* key, storage_int_t defaultValue) {
     if (!storage_initialized && !storage_init_c()) return defaultValue;
     if (!key || strlen(key) == 0) return defaultValue;
     
-    String compressed_key = compress_key(String(key));
-    storage_int_t result = storage_prefs.getLong64(compressed_key.c_str(), defaultValue);
+    String nvs_key = lookup_key(key);
+    StorageCacheEntry cached;
+    if (cache_lookup(key, nvs_key, cached)) {
+        return cached.type == STORAGE_INT ? cached.v.i : defaultValue;
+    }
+    if (nvs_key.length() == 0) return defaultValue;
+    storage_int_t result = storage_prefs.getLong64(nvs_key.c_str(), defaultValue);
     
     return result;
 }
@@ -124,8 +807,13 @@ storage_number_t storage_get_number_c(const char* key, storage_number_t defaultV
     if (!storage_initialized && !storage_init_c()) return defaultValue;
     if (!key || strlen(key) == 0) return defaultValue;
     
-    String compressed_key = compress_key(String(key));
-    storage_number_t result = storage_prefs.getDouble(compressed_key.c_str(), defaultValue);
+    String nvs_key = lookup_key(key);
+    StorageCacheEntry cached;
+    if (cache_lookup(key, nvs_key, cached)) {
+        return cached.type == STORAGE_NUMBER ? cached.v.n : defaultValue;
+    }
+    if (nvs_key.length() == 0) return defaultValue;
+    storage_number_t result = storage_prefs.getDouble(nvs_key.c_str(), defaultValue);
     
     return result;
 }
@@ -140,8 +828,17 @@ const char* storage_get_string_c(const char* key, const char* defaultValue) {
         return storage_temp_buffer.c_str();
     }
     
-    String compressed_key = compress_key(String(key));
-    storage_temp_buffer = storage_prefs.getString(compressed_key.c_str(), 
+    String nvs_key = lookup_key(key);
+    StorageCacheEntry cached;
+    if (cache_lookup(key, nvs_key, cached)) {
+        storage_temp_buffer = cached.type == STORAGE_STRING ? cached.s : String(defaultValue ? defaultValue : "");
+        return storage_temp_buffer.c_str();
+    }
+    if (nvs_key.length() == 0) {
+        storage_temp_buffer = String(defaultValue ? defaultValue : "");
+        return storage_temp_buffer.c_str();
+    }
+    storage_temp_buffer = storage_prefs.getString(nvs_key.c_str(), 
                                                   String(defaultValue ? defaultValue : ""));
     
     return storage_temp_buffer.c_str();
@@ -151,8 +848,13 @@ bool storage_get_bool_c(const char* key, bool defaultValue) {
     if (!storage_initialized && !storage_init_c()) return defaultValue;
     if (!key || strlen(key) == 0) return defaultValue;
     
-    String compressed_key = compress_key(String(key));
-    bool result = storage_prefs.getBool(compressed_key.c_str(), defaultValue);
+    String nvs_key = lookup_key(key);
+    StorageCacheEntry cached;
+    if (cache_lookup(key, nvs_key, cached)) {
+        return cached.type == STORAGE_BOOL ? cached.v.b : defaultValue;
+    }
+    if (nvs_key.length() == 0) return defaultValue;
+    bool result = storage_prefs.getBool(nvs_key.c_str(), defaultValue);
     
     return result;
 }
@@ -161,8 +863,15 @@ size_t storage_get_blob_c(const char* key, void* buffer, size_t bufferSize) {
     if (!storage_initialized && !storage_init_c()) return 0;
     if (!key || strlen(key) == 0 || !buffer || bufferSize == 0) return 0;
     
-    String compressed_key = compress_key(String(key));
-    size_t result = storage_prefs.getBytes(compressed_key.c_str(), buffer, bufferSize);
+    String nvs_key = lookup_key(key);
+    StorageCacheEntry cached;
+    if (cache_lookup(key, nvs_key, cached)) {
+        if (cached.type != STORAGE_BLOB || cached.blob.size() > bufferSize) return 0;
+        memcpy(buffer, cached.blob.data(), cached.blob.size());
+        return cached.blob.size();
+    }
+    if (nvs_key.length() == 0) return 0;
+    size_t result = storage_prefs.getBytes(nvs_key.c_str(), buffer, bufferSize);
     
     return result;
 }
@@ -171,31 +880,260 @@ bool storage_remove_c(const char* key) {
     if (!storage_initialized && !storage_init_c()) return false;
     if (!key || strlen(key) == 0) return false;
     
-    String compressed_key = compress_key(String(key));
-    bool result = storage_prefs.remove(compressed_key.c_str());
-    
-    if (result) {
-        //LLOGI("Removed key: %s", key);
-    }
-    return result;
+    // Report whether the key existed, as Preferences::remove does
+    String nvs_key = lookup_key(key);
+    StorageCacheEntry cached;
+    bool existed = cache_lookup(key, nvs_key, cached) ? cached.type != STORAGE_REMOVED
+                                                      : nvs_key.length() > 0 && storage_prefs.isKey(nvs_key.c_str());
+    // A long key never stored has nothing to remove
+    if (!existed && nvs_key.length() == 0) return false;
+
+    StorageCacheEntry e;
+    e.type = STORAGE_REMOVED;
+    e.dirty = false;
+    return cache_store(key, e) && existed;
 }
 
 void storage_clear_c(void) {
     if (!storage_initialized && !storage_init_c()) return;
 
-    storage_prefs.clear();
+    // Pending writes are dropped rather than flushed and then erased
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    txn_discard_locked();
+    storage_cache.clear();
+    storage_cache_bytes = 0;
+    storage_dirty_count = 0;
+    storage_key_index.clear();
+    if (storage_backend == STORAGE_BACKEND_LOG) {
+        storage_log_clear();
+    } else {
+        storage_keymap_clear();
+        storage_prefs.clear();
+    }
+    xSemaphoreGive(storage_mutex);
     //LLOGI("Storage cleared");
 }
 
+size_t storage_keys_c(const char* prefix, std::vector<String>& out) {
+    if (!storage_initialized && !storage_init_c()) return 0;
+    String start(prefix ? prefix : "");
+    size_t first = out.size();
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    for (std::set<String>::const_iterator it = storage_key_index.lower_bound(start);
+         it != storage_key_index.end() && it->startsWith(start); ++it) {
+        out.push_back(*it);
+    }
+
+    // Inside a transaction the caller also sees its staged keys
+    if (in_own_txn() && !storage_txn.empty()) {
+        std::set<String> view(out.begin() + first, out.end());
+        for (std::map<String, StorageCacheEntry>::const_iterator it = storage_txn.begin(); it != storage_txn.end(); ++it) {
+            if (!it->first.startsWith(start)) continue;
+            if (it->second.type == STORAGE_REMOVED) {
+                view.erase(it->first);
+            } else {
+                view.insert(it->first);
+            }
+        }
+        out.erase(out.begin() + first, out.end());
+        out.insert(out.end(), view.begin(), view.end());
+    }
+    xSemaphoreGive(storage_mutex);
+    return out.size() - first;
+}
+
+bool storage_flush_c(void) {
+    if (!storage_initialized || storage_mutex == NULL) return true;
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    bool ok = storage_backend == STORAGE_BACKEND_LOG ? storage_log_sync() : flush_locked();
+    xSemaphoreGive(storage_mutex);
+    return ok;
+}
+
+bool storage_begin_c(void) {
+    if (!storage_initialized && !storage_init_c()) return false;
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    bool ok = !storage_txn_active;
+    if (ok) {
+        storage_txn_active = true;
+        storage_txn_owner = xTaskGetCurrentTaskHandle();
+    }
+    xSemaphoreGive(storage_mutex);
+    return ok;
+}
+
+// Map the staged keys, journal, apply, then mark the generation
+// (caller holds storage_mutex)
+static bool commit_nvs_locked() {
+    uint32_t generation = storage_generation + 1;
+
+    // Earlier writes go out first, so the batch below holds only this
+    // transaction and staging it never has to flush halfway
+    bool ok = storage_nvs != 0 && flush_locked();
+    evict_clean_locked();
+    if (!ok) return false;
+
+    // Long keys get their index slots only now; removing a long key that
+    // was never stored needs no write at all
+    std::vector<std::pair<String, const StorageCacheEntry*> > writes;
+    std::vector<String> created;
+    for (std::map<String, StorageCacheEntry>::const_iterator it = storage_txn.begin(); ok && it != storage_txn.end(); ++it) {
+        String nvs_key = storage_keymap_resolve(it->first, false);
+        if (nvs_key.length() == 0 && it->second.type == STORAGE_REMOVED) continue;
+        if (nvs_key.length() == 0) {
+            nvs_key = storage_keymap_resolve(it->first, true);
+            ok = nvs_key.length() > 0;
+            if (ok) created.push_back(nvs_key);
+        }
+        writes.push_back(std::make_pair(nvs_key, &it->second));
+    }
+
+    std::vector<uint8_t> journal(8, 0);
+    journal[0] = StorageConfig::TXN_JOURNAL_VERSION;
+    journal[2] = writes.size() & 0xFF;
+    journal[3] = writes.size() >> 8;
+    memcpy(&journal[4], &generation, 4);
+    for (size_t i = 0; ok && i < writes.size(); i++) {
+        journal_append(journal, writes[i].first, *writes[i].second);
+    }
+
+    // nvs_set_* is durable on return, so the journal (and the index naming
+    // its long keys) lands before any value; one nvs_commit closes the batch
+    ok = ok && storage_keymap_save(storage_nvs) &&
+         nvs_set_blob(storage_nvs, StorageConfig::TXN_JOURNAL_KEY, journal.data(), journal.size()) == ESP_OK;
+
+    if (!ok) {
+        // No value was written: give the new slots back
+        for (size_t i = 0; i < created.size(); i++) {
+            storage_keymap_forget(created[i]);
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < writes.size(); i++) {
+        cache_store_locked(writes[i].first, *writes[i].second);
+    }
+    // Any failed key keeps the journal, which the next init replays
+    ok = flush_locked(false);
+
+    if (ok) {
+        nvs_set_u32(storage_nvs, StorageConfig::TXN_GENERATION_KEY, generation);
+        nvs_erase_key(storage_nvs, StorageConfig::TXN_JOURNAL_KEY);
+        storage_generation = generation;
+    }
+    nvs_commit(storage_nvs);
+    return ok;
+}
+
+// Log namespaces bracket the batch with markers instead of a journal
+static bool commit_log_locked() {
+    std::vector<StorageLogRecord> records;
+    for (std::map<String, StorageCacheEntry>::const_iterator it = storage_txn.begin(); it != storage_txn.end(); ++it) {
+        StorageLogRecord r;
+        r.key = it->first;
+        r.type = it->second.type;
+        entry_to_bytes(it->second, r.value);
+        records.push_back(r);
+        count_write();
+    }
+
+    bool ok = storage_log_write_batch(records);
+    if (ok) {
+        storage_flash_writes += records.size();
+        storage_generation++;
+    }
+    return ok;
+}
+
+bool storage_commit_c(void) {
+    if (!storage_initialized) return false;
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    if (!in_own_txn()) {
+        xSemaphoreGive(storage_mutex);
+        return false;
+    }
+
+    bool ok = true;
+    if (!storage_txn.empty()) {
+        ok = storage_backend == STORAGE_BACKEND_LOG ? commit_log_locked() : commit_nvs_locked();
+        if (ok) {
+            for (std::map<String, StorageCacheEntry>::const_iterator it = storage_txn.begin(); it != storage_txn.end(); ++it) {
+                index_note_locked(it->first, it->second.type);
+            }
+            storage_txn_commits++;
+            LOG_DEBUG(STORAGE_TAG, "Committed transaction %u (%u keys)", storage_generation, (unsigned)storage_txn.size());
+        } else {
+            // A written NVS journal is replayed at the next init
+            LOG_ERROR(STORAGE_TAG, "Transaction commit failed");
+            storage_txn_rollbacks++;
+        }
+    }
+
+    txn_discard_locked();
+    xSemaphoreGive(storage_mutex);
+    return ok;
+}
+
+void storage_rollback_c(void) {
+    if (storage_mutex == NULL) return;
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    if (in_own_txn()) {
+        txn_discard_locked();
+        storage_txn_rollbacks++;
+    }
+    xSemaphoreGive(storage_mutex);
+}
+
+void storage_get_stats_c(StorageStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (storage_mutex == NULL) return;
+
+    xSemaphoreTake(storage_mutex, portMAX_DELAY);
+    stats->writes = storage_writes;
+    stats->flash_writes = storage_flash_writes;
+    stats->dirty = storage_dirty_count;
+    stats->saved = storage_writes - storage_flash_writes - storage_dirty_count;
+    stats->flushes = storage_flushes;
+    stats->cached = storage_cache.size();
+    stats->cache_bytes = storage_cache_bytes;
+    stats->last_flush_us = storage_last_flush_us;
+    stats->long_keys = storage_keymap_count();
+    stats->keys = storage_key_index.size();
+    stats->transactions = storage_txn_commits;
+    stats->rollbacks = storage_txn_rollbacks;
+    stats->generation = storage_generation;
+
+    // A window still open after 2s means writes slowed down; use its running rate
+    unsigned long idle = millis() - storage_rate_start;
+    stats->writes_per_sec = idle >= 2000 ? storage_rate_writes * 1000.0f / idle : storage_rate;
+    xSemaphoreGive(storage_mutex);
+}
+
 bool storage_set_namespace_c(const char* namespace_name) {
+    return storage_set_namespace_backend_c(namespace_name, STORAGE_BACKEND_NVS);
+}
+
+bool storage_set_namespace_backend_c(const char* namespace_name, StorageBackend backend) {
     if (!namespace_name || strlen(namespace_name) == 0) return false;
 
+    // Log namespaces name a file under StorageLogConfig::DIR
+    if (backend == STORAGE_BACKEND_LOG && (strchr(namespace_name, '/') || strlen(namespace_name) > 32)) {
+        return false;
+    }
+
     // If already initialized, need to stop and restart with new namespace
     if (storage_initialized) {
         storage_stop_c();
     }
 
     storage_current_namespace = String(namespace_name);
+    storage_backend = backend;
 
     // Initialize with new namespace
     return storage_init_c();
@@ -208,6 +1146,7 @@ bool storage_reset_namespace_c(void) {
     }
 
     storage_current_namespace = storage_default_namespace;
+    storage_backend = STORAGE_BACKEND_NVS;
 
     // Initialize with default namespace
     return storage_init_c();
@@ -218,9 +1157,62 @@ const char* storage_get_namespace_c(void) {
     return storage_temp_buffer.c_str();
 }
 
+StorageBackend storage_get_backend_c(void) {
+    return storage_backend;
+}
+
 
 // ==================== Lua Interface Implementation ====================
 
+// Push a table stored by storage.set; JSON strings from older firmware are
+// decoded when a `json` module is loaded
+static bool push_stored_table(lua_State *L, const char* key) {
+    std::vector<uint8_t> blob(StorageTableConfig::MAX_BYTES);
+    size_t len = storage_get_blob_c(key, blob.data(), blob.size());
+    if (len > 0) {
+        return storage_table_decode(L, blob.data(), len);
+    }
+
+    const char* json_str = storage_get_string_c(key, nullptr);
+    if (!json_str || strlen(json_str) == 0) {
+        return false;
+    }
+
+    lua_getglobal(L, "json");
+    if (lua_istable(L, -1)) {
+        lua_getfield(L, -1, "decode");
+        if (lua_isfunction(L, -1)) {
+            lua_pushstring(L, json_str);
+            if (lua_pcall(L, 1, 1, 0) == LUA_OK && lua_istable(L, -1)) {
+                lua_remove(L, -2); // Remove json table
+                return true;
+            }
+        }
+        lua_pop(L, 1); // Pop decode function, result or error
+    }
+    lua_pop(L, 1); // Pop json table
+    return false;
+}
+
+// Push a fetched value as the Lua type it was stored from (nil when missing)
+static void push_entry(lua_State *L, const StorageCacheEntry& e) {
+    switch (e.type) {
+        case STORAGE_INT:    lua_pushinteger(L, e.v.i); break;
+        case STORAGE_NUMBER: lua_pushnumber(L, e.v.n); break;
+        case STORAGE_BOOL:   lua_pushboolean(L, e.v.b); break;
+        case STORAGE_STRING: lua_pushlstring(L, e.s.c_str(), e.s.length()); break;
+        case STORAGE_BLOB:
+            if (!storage_table_is_blob(e.blob.data(), e.blob.size())) {
+                // Raw blob from storage_set_blob_c
+                lua_pushlstring(L, (const char*)e.blob.data(), e.blob.size());
+            } else if (!storage_table_decode(L, e.blob.data(), e.blob.size())) {
+                lua_pushnil(L);
+            }
+            break;
+        default:             lua_pushnil(L); break;
+    }
+}
+
 static int l_storage_set(lua_State *L) {
     const char* key = luaL_checkstring(L, 1);
     
@@ -243,28 +1235,20 @@ static int l_storage_set(lua_State *L) {
         result = storage_set_bool_c(key, value);
     }
     else if (lua_istable(L, 2)) {
-        // Convert table to JSON and store as string
-        lua_getglobal(L, "json");
-        if (!lua_isnil(L, -1)) {
-            lua_getfield(L, -1, "encode");
-            if (lua_isfunction(L, -1)) {
-                lua_pushvalue(L, 2); // Push the table
-                if (lua_pcall(L, 1, 1, 0) == LUA_OK) {
-                    if (lua_isstring(L, -1)) {
-                        const char* json_str = lua_tostring(L, -1);
-                        result = storage_set_string_c(key, json_str);
-                    }
-                    lua_pop(L, 1); // Pop result
-                }
-                else {
-                    lua_pop(L, 1); // Pop error
-                }
-            }
-            else {
-                lua_pop(L, 1); // Pop encode function
+        // Native binary encoding, stored as a blob. The buffer is released
+        // before luaL_error, which longjmps past destructors.
+        const char* error = NULL;
+        bool encoded;
+        {
+            std::vector<uint8_t> blob;
+            encoded = storage_table_encode(L, 2, blob, &error);
+            if (encoded) {
+                result = storage_set_blob_c(key, blob.data(), blob.size());
             }
         }
-        lua_pop(L, 1); // Pop json table
+        if (!encoded) {
+            return luaL_error(L, "storage.set: %s", error);
+        }
     }
     else {
         return luaL_error(L, "Unsupported data type for storage.set");
@@ -304,44 +1288,105 @@ static int l_storage_get(lua_State *L) {
             return 1;
         }
         else if (lua_istable(L, 2)) {
-            // Try to get string and decode as JSON
-            const char* json_str = storage_get_string_c(key, nullptr);
-            if (json_str && strlen(json_str) > 0) {
-                lua_getglobal(L, "json");
-                if (!lua_isnil(L, -1)) {
-                    lua_getfield(L, -1, "decode");
-                    if (lua_isfunction(L, -1)) {
-                        lua_pushstring(L, json_str);
-                        if (lua_pcall(L, 1, 1, 0) == LUA_OK) {
-                            lua_remove(L, -2); // Remove json table
-                            return 1;
-                        }
-                        lua_pop(L, 1); // Pop error
-                    }
-                    else {
-                        lua_pop(L, 1); // Pop decode function
-                    }
-                }
-                lua_pop(L, 1); // Pop json table
+            if (push_stored_table(L, key)) {
+                return 1;
             }
 
-            // Return default table if string decode failed
+            // Return default table if nothing decodable is stored
             lua_pushvalue(L, 2);
             return 1;
         }
     }
     
-    // No default provided, try string first
-    const char* result = storage_get_string_c(key, nullptr);
-    if (result && strlen(result) > 0) {
-        lua_pushstring(L, result);
-    }
-    else {
+    // No default provided: return the value as the type it was stored as
+    std::vector<String> keys(1, String(key));
+    std::vector<StorageCacheEntry> values;
+    if (storage_initialized || storage_init_c()) {
+        fetch_entries(keys, values);
+        push_entry(L, values[0]);
+    } else {
         lua_pushnil(L);
     }
     return 1;
 }
 
+// storage.keys([prefix]) -> sorted array of keys
+static int l_storage_keys(lua_State *L) {
+    const char* prefix = luaL_optstring(L, 1, "");
+
+    std::vector<String> keys;
+    storage_keys_c(prefix, keys);
+
+    lua_createtable(L, keys.size(), 0);
+    for (size_t i = 0; i < keys.size(); i++) {
+        lua_pushlstring(L, keys[i].c_str(), keys[i].length());
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+// storage.get_many({key, ...}) -> {key = value, ...}, missing keys left out.
+// One lock and no per-key Lua/C round trips.
+static int l_storage_get_many(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer count = luaL_len(L, 1);
+
+    std::vector<String> keys;
+    keys.reserve(count);
+    for (lua_Integer i = 1; i <= count; i++) {
+        if (lua_rawgeti(L, 1, i) == LUA_TSTRING) {
+            keys.push_back(String(lua_tostring(L, -1)));
+        }
+        lua_pop(L, 1);
+    }
+
+    std::vector<StorageCacheEntry> values;
+    if (storage_initialized || storage_init_c()) {
+        fetch_entries(keys, values);
+    }
+
+    lua_createtable(L, 0, values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        if (values[i].type == STORAGE_REMOVED) continue;
+        lua_pushlstring(L, keys[i].c_str(), keys[i].length());
+        push_entry(L, values[i]);
+        lua_settable(L, -3);
+    }
+    return 1;
+}
+
+// Iterator step: upvalue 1 = key snapshot, upvalue 2 = position
+static int l_storage_iter_next(lua_State *L) {
+    lua_Integer pos = lua_tointeger(L, lua_upvalueindex(2));
+
+    for (;;) {
+        pos++;
+        if (lua_rawgeti(L, lua_upvalueindex(1), pos) != LUA_TSTRING) {
+            return 0;
+        }
+
+        // Keys removed since the snapshot are skipped
+        std::vector<String> keys(1, String(lua_tostring(L, -1)));
+        std::vector<StorageCacheEntry> values;
+        fetch_entries(keys, values);
+        if (values[0].type != STORAGE_REMOVED) {
+            lua_pushinteger(L, pos);
+            lua_replace(L, lua_upvalueindex(2));
+            push_entry(L, values[0]);
+            return 2;
+        }
+        lua_pop(L, 1);
+    }
+}
+
+// for key, value in storage.iter([prefix]) do ... end
+static int l_storage_iter(lua_State *L) {
+    l_storage_keys(L);
+    lua_pushinteger(L, 0);
+    lua_pushcclosure(L, l_storage_iter_next, 2);
+    return 1;
+}
+
 static int l_storage_remove(lua_State *L) {
     const char* key = luaL_checkstring(L, 1);
     bool result = storage_remove_c(key);
@@ -356,14 +1401,103 @@ static int l_storage_clear(lua_State *L) {
 
 
 
+static int l_storage_flush(lua_State *L) {
+    lua_pushboolean(L, storage_flush_c());
+    return 1;
+}
+
+// storage.transaction(fn, ...): fn's writes land together or not at all
+static int l_storage_transaction(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    if (!storage_begin_c()) {
+        return luaL_error(L, "storage.transaction: a transaction is already open");
+    }
+
+    if (lua_pcall(L, lua_gettop(L) - 1, 0, 0) != LUA_OK) {
+        storage_rollback_c();
+        return lua_error(L);
+    }
+
+    lua_pushboolean(L, storage_commit_c());
+    return 1;
+}
+
+static int l_storage_stats(lua_State *L) {
+    StorageStats stats;
+    storage_get_stats_c(&stats);
+
+    lua_newtable(L);
+    lua_pushinteger(L, stats.writes);
+    lua_setfield(L, -2, "writes");
+    lua_pushinteger(L, stats.flash_writes);
+    lua_setfield(L, -2, "flash_writes");
+    lua_pushinteger(L, stats.saved);
+    lua_setfield(L, -2, "saved");
+    lua_pushinteger(L, stats.flushes);
+    lua_setfield(L, -2, "flushes");
+    lua_pushinteger(L, stats.dirty);
+    lua_setfield(L, -2, "dirty");
+    lua_pushinteger(L, stats.cached);
+    lua_setfield(L, -2, "cached");
+    lua_pushinteger(L, stats.cache_bytes);
+    lua_setfield(L, -2, "cache_bytes");
+    lua_pushnumber(L, stats.writes_per_sec);
+    lua_setfield(L, -2, "writes_per_sec");
+    lua_pushinteger(L, stats.last_flush_us);
+    lua_setfield(L, -2, "last_flush_us");
+    lua_pushinteger(L, stats.long_keys);
+    lua_setfield(L, -2, "long_keys");
+    lua_pushinteger(L, stats.keys);
+    lua_setfield(L, -2, "keys");
+    lua_pushinteger(L, stats.transactions);
+    lua_setfield(L, -2, "transactions");
+    lua_pushinteger(L, stats.rollbacks);
+    lua_setfield(L, -2, "rollbacks");
+    lua_pushinteger(L, stats.generation);
+    lua_setfield(L, -2, "generation");
+    lua_pushstring(L, storage_backend == STORAGE_BACKEND_LOG ? "log" : "nvs");
+    lua_setfield(L, -2, "backend");
+
+    if (storage_backend == STORAGE_BACKEND_LOG) {
+        StorageLogStats log;
+        storage_log_get_stats(&log);
+
+        lua_newtable(L);
+        lua_pushinteger(L, log.keys);
+        lua_setfield(L, -2, "keys");
+        lua_pushinteger(L, log.live_bytes);
+        lua_setfield(L, -2, "live_bytes");
+        lua_pushinteger(L, log.file_bytes);
+        lua_setfield(L, -2, "file_bytes");
+        lua_pushinteger(L, log.appends);
+        lua_setfield(L, -2, "appends");
+        lua_pushinteger(L, log.syncs);
+        lua_setfield(L, -2, "syncs");
+        lua_pushinteger(L, log.compactions);
+        lua_setfield(L, -2, "compactions");
+        lua_pushinteger(L, log.last_compact_ms);
+        lua_setfield(L, -2, "last_compact_ms");
+        lua_pushinteger(L, log.replayed);
+        lua_setfield(L, -2, "replayed");
+        lua_pushinteger(L, log.dropped);
+        lua_setfield(L, -2, "dropped");
+        lua_pushinteger(L, log.recovery_ms);
+        lua_setfield(L, -2, "recovery_ms");
+        lua_setfield(L, -2, "log");
+    }
+    return 1;
+}
+
 static int l_storage_stop(lua_State *L) {
     storage_stop_c();
     return 0;
 }
 
 static int l_storage_set_namespace(lua_State *L) {
+    static const char* const backends[] = { "nvs", "log", NULL };
     const char* namespace_name = luaL_checkstring(L, 1);
-    bool result = storage_set_namespace_c(namespace_name);
+    StorageBackend backend = (StorageBackend)luaL_checkoption(L, 2, "nvs", backends);
+    bool result = storage_set_namespace_backend_c(namespace_name, backend);
     lua_pushboolean(L, result);
     return 1;
 }
@@ -377,12 +1511,14 @@ static int l_storage_reset_namespace(lua_State *L) {
 static int l_storage_get_namespace(lua_State *L) {
     const char* namespace_name = storage_get_namespace_c();
     lua_pushstring(L, namespace_name);
-    return 1;
+    lua_pushstring(L, storage_backend == STORAGE_BACKEND_LOG ? "log" : "nvs");
+    return 2;
 }
 
 static int l_storage_init(lua_State *L) {
     // Reset to default namespace on every Lua init
     storage_current_namespace = storage_default_namespace;
+    storage_backend = STORAGE_BACKEND_NVS;
 
     // Stop storage if already initialized to reset to default namespace
     if (storage_initialized) {
@@ -407,9 +1543,27 @@ static int l_storage_init(lua_State *L) {
     lua_pushcfunction(L, l_storage_remove);
     lua_setfield(L, -2, "remove");
 
+    lua_pushcfunction(L, l_storage_keys);
+    lua_setfield(L, -2, "keys");
+
+    lua_pushcfunction(L, l_storage_get_many);
+    lua_setfield(L, -2, "get_many");
+
+    lua_pushcfunction(L, l_storage_iter);
+    lua_setfield(L, -2, "iter");
+
     lua_pushcfunction(L, l_storage_clear);
     lua_setfield(L, -2, "clear");
 
+    lua_pushcfunction(L, l_storage_flush);
+    lua_setfield(L, -2, "flush");
+
+    lua_pushcfunction(L, l_storage_stats);
+    lua_setfield(L, -2, "stats");
+
+    lua_pushcfunction(L, l_storage_transaction);
+    lua_setfield(L, -2, "transaction");
+
     lua_pushcfunction(L, l_storage_stop);
     lua_setfield(L, -2, "stop");
 
@@ -21,6 +21,53 @@ typedef double storage_number_t; // Use double for all floating point
 // Define tag for logging
 #define STORAGE_TAG "STORAGE"
 
+// Stored value types (also the record kinds of the log backend)
+enum StorageValueType : uint8_t {
+    STORAGE_INT,
+    STORAGE_NUMBER,
+    STORAGE_STRING,
+    STORAGE_BOOL,
+    STORAGE_BLOB,
+    STORAGE_REMOVED     // Erase / tombstone
+};
+
+// Where a namespace keeps its keys
+enum StorageBackend : uint8_t {
+    STORAGE_BACKEND_NVS,    // Preferences/NVS with the write-back cache (default)
+    STORAGE_BACKEND_LOG     // Append-only log on LittleFS, for high-churn data
+};
+
+// Write-back cache tuning
+namespace StorageConfig {
+    const size_t CACHE_MAX_ENTRIES = 64;         // Keys held in RAM before a forced flush
+    const size_t CACHE_MAX_BYTES = 8192;         // String/blob payload held in RAM
+    const unsigned long WRITE_BACK_MS = 2000;    // Max age of a dirty key before the timer flushes it
+    const unsigned long FLUSH_CHECK_MS = 500;    // Flush task poll interval
+
+    const size_t TXN_MAX_BYTES = 16384;          // Staged data per transaction
+    const char* const TXN_JOURNAL_KEY = "~txn";  // Redo journal of the committing transaction
+    const char* const TXN_GENERATION_KEY = "~gen";
+    const uint8_t TXN_JOURNAL_VERSION = 1;
+}
+
+// Counters since storage_init_c (see storage.stats())
+struct StorageStats {
+    uint32_t writes;            // set/remove calls accepted
+    uint32_t flash_writes;      // NVS set/erase operations actually issued
+    uint32_t saved;             // Writes coalesced or skipped (never reached flash)
+    uint32_t flushes;           // Flushes that wrote at least one key
+    uint32_t dirty;             // Keys waiting for the next flush
+    uint32_t cached;            // Keys held in the cache
+    uint32_t cache_bytes;       // String/blob payload held in the cache
+    float writes_per_sec;       // Over the last rate window
+    uint32_t last_flush_us;     // Duration of the last flush
+    uint32_t long_keys;         // Keys stored under a hashed NVS name
+    uint32_t keys;              // Live keys in the namespace (key index)
+    uint32_t transactions;      // Transactions committed
+    uint32_t rollbacks;         // Transactions discarded or failed
+    uint32_t generation;        // Last committed transaction (persisted)
+};
+
 // ==================== C++ Function Interface (No Classes) ====================
 
 // Initialization and cleanup
@@ -45,11 +92,28 @@ size_t storage_get_blob_c(const char* key, void* buffer, size_t bufferSize);
 bool storage_remove_c(const char* key);
 void storage_clear_c(void);
 
+// Keys starting with `prefix` (all keys when NULL or empty), sorted
+size_t storage_keys_c(const char* prefix, std::vector<String>& out);
+
+// Write-back cache: commit dirty keys to NVS now (call before sleep or power-off)
+bool storage_flush_c(void);
+void storage_get_stats_c(StorageStats* stats);
+
+// Transactions: set/remove calls from this task are staged until commit,
+// then written as one batch behind a redo journal (replayed at init after a reset)
+bool storage_begin_c(void);
+bool storage_commit_c(void);
+void storage_rollback_c(void);
+
 // Namespace management functions
 bool storage_set_namespace_c(const char* namespace_name);
 bool storage_reset_namespace_c(void);
 const char* storage_get_namespace_c(void);
 
+// Switch namespace and backend (storage_set_namespace_c always selects NVS)
+bool storage_set_namespace_backend_c(const char* namespace_name, StorageBackend backend);
+StorageBackend storage_get_backend_c(void);
+
 // Lua module registration function
 int luaopen_storage(lua_State* L);
 
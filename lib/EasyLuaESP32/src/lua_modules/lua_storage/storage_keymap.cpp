@@ -0,0 +1,219 @@
+#include "storage_keymap.h"
+#include "lua_storage.h"
+#include <unordered_map>
+#include <vector>
+
+// ==================== Static Variables ====================
+
+struct KeySlot {
+    uint8_t slot;
+    String key;
+};
+
+// Hash -> keys sharing it; one bucket lookup plus a short compare per access
+static std::unordered_map<uint32_t, std::vector<KeySlot>> keymap_buckets;
+static size_t keymap_count = 0;
+static bool keymap_dirty = false;
+
+// ==================== Helper Functions ====================
+
+static uint32_t fnv1a(const String& key) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < key.length(); i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static String slot_name(uint32_t hash, uint8_t slot) {
+    char name[StorageKeyConfig::NVS_KEY_MAX + 1];
+    if (slot == 0) {
+        snprintf(name, sizeof(name), "#%08x", (unsigned)hash);
+    } else {
+        snprintf(name, sizeof(name), "#%08x.%x", (unsigned)hash, slot);
+    }
+    return String(name);
+}
+
+// Short keys are stored verbatim unless they could clash with hashed
+// names or internal records
+static bool needs_mapping(const String& key) {
+    return key.length() > StorageKeyConfig::NVS_KEY_MAX || key[0] == '#' || key[0] == '~';
+}
+
+static bool parse_slot_name(const String& nvs_key, uint32_t& hash, uint8_t& slot) {
+    if (nvs_key.length() < 9 || nvs_key[0] != '#') return false;
+    hash = strtoul(nvs_key.substring(1, 9).c_str(), NULL, 16);
+    slot = nvs_key.length() > 10 ? strtoul(nvs_key.c_str() + 10, NULL, 16) : 0;
+    return true;
+}
+
+// ==================== Persistence ====================
+
+// Layout: [version u8][reserved u8][count u16]
+//         count x [hash u32][slot u8][key_len u8][key]
+void storage_keymap_load(nvs_handle_t handle) {
+    storage_keymap_clear();
+    keymap_dirty = false;
+
+    size_t size = 0;
+    if (handle == 0 || nvs_get_blob(handle, StorageKeyConfig::INDEX_KEY, NULL, &size) != ESP_OK || size < 4) {
+        return;
+    }
+
+    std::vector<uint8_t> blob(size);
+    if (nvs_get_blob(handle, StorageKeyConfig::INDEX_KEY, blob.data(), &size) != ESP_OK ||
+        blob[0] != StorageKeyConfig::INDEX_VERSION) {
+        LOG_ERROR(STORAGE_TAG, "Key index unreadable, long keys unavailable");
+        return;
+    }
+
+    uint16_t count = blob[2] | (blob[3] << 8);
+    size_t pos = 4;
+    for (uint16_t i = 0; i < count && pos + 6 <= size; i++) {
+        uint32_t hash;
+        memcpy(&hash, &blob[pos], 4);
+        uint8_t slot = blob[pos + 4];
+        uint8_t len = blob[pos + 5];
+        if (pos + 6 + len > size) break;
+
+        char key[256];
+        memcpy(key, &blob[pos + 6], len);
+        key[len] = '\0';
+
+        KeySlot entry;
+        entry.slot = slot;
+        entry.key = String(key);
+        keymap_buckets[hash].push_back(entry);
+        keymap_count++;
+        pos += 6 + len;
+    }
+
+    LOG_DEBUG(STORAGE_TAG, "Key index: %u long keys", (unsigned)keymap_count);
+}
+
+bool storage_keymap_save(nvs_handle_t handle) {
+    if (!keymap_dirty) return true;
+    if (handle == 0) return false;
+
+    if (keymap_count == 0) {
+        esp_err_t err = nvs_erase_key(handle, StorageKeyConfig::INDEX_KEY);
+        keymap_dirty = false;
+        return err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    std::vector<uint8_t> blob(4);
+    blob[0] = StorageKeyConfig::INDEX_VERSION;
+    blob[1] = 0;
+    blob[2] = keymap_count & 0xFF;
+    blob[3] = keymap_count >> 8;
+
+    for (std::unordered_map<uint32_t, std::vector<KeySlot>>::const_iterator it = keymap_buckets.begin();
+         it != keymap_buckets.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); i++) {
+            const KeySlot& entry = it->second[i];
+            uint8_t header[6];
+            memcpy(header, &it->first, 4);
+            header[4] = entry.slot;
+            header[5] = entry.key.length();
+            blob.insert(blob.end(), header, header + 6);
+            blob.insert(blob.end(), (const uint8_t*)entry.key.c_str(), (const uint8_t*)entry.key.c_str() + entry.key.length());
+        }
+    }
+
+    if (nvs_set_blob(handle, StorageKeyConfig::INDEX_KEY, blob.data(), blob.size()) != ESP_OK) {
+        LOG_ERROR(STORAGE_TAG, "Key index write failed");
+        return false;
+    }
+    keymap_dirty = false;
+    return true;
+}
+
+// ==================== Mapping ====================
+
+String storage_keymap_resolve(const String& key, bool create) {
+    if (key.length() == 0 || key.length() > StorageKeyConfig::MAX_KEY_LENGTH) return String();
+    if (!needs_mapping(key)) return key;
+
+    uint32_t hash = fnv1a(key);
+    std::vector<KeySlot>& bucket = keymap_buckets[hash];
+
+    uint16_t used = 0;
+    for (size_t i = 0; i < bucket.size(); i++) {
+        if (bucket[i].key == key) {
+            return slot_name(hash, bucket[i].slot);
+        }
+        used |= 1 << bucket[i].slot;
+    }
+
+    if (!create || keymap_count >= StorageKeyConfig::MAX_LONG_KEYS) {
+        if (bucket.empty()) keymap_buckets.erase(hash);
+        if (create) LOG_ERROR(STORAGE_TAG, "Key index full, cannot store %s", key.c_str());
+        return String();
+    }
+
+    // Lowest free slot; a full bucket needs 16 keys with one 32-bit hash
+    for (uint8_t slot = 0; slot < StorageKeyConfig::MAX_SLOTS; slot++) {
+        if (!(used & (1 << slot))) {
+            KeySlot entry;
+            entry.slot = slot;
+            entry.key = key;
+            bucket.push_back(entry);
+            keymap_count++;
+            keymap_dirty = true;
+            if (slot > 0) {
+                LOG_DEBUG(STORAGE_TAG, "Hash collision for %s, slot %u", key.c_str(), slot);
+            }
+            return slot_name(hash, slot);
+        }
+    }
+    return String();
+}
+
+String storage_keymap_name(const String& nvs_key) {
+    uint32_t hash;
+    uint8_t slot;
+    if (!parse_slot_name(nvs_key, hash, slot)) return String();
+
+    std::unordered_map<uint32_t, std::vector<KeySlot>>::const_iterator it = keymap_buckets.find(hash);
+    if (it == keymap_buckets.end()) return String();
+
+    for (size_t i = 0; i < it->second.size(); i++) {
+        if (it->second[i].slot == slot) {
+            return it->second[i].key;
+        }
+    }
+    return String();
+}
+
+void storage_keymap_forget(const String& nvs_key) {
+    uint32_t hash;
+    uint8_t slot;
+    if (!parse_slot_name(nvs_key, hash, slot)) return;
+
+    std::unordered_map<uint32_t, std::vector<KeySlot>>::iterator it = keymap_buckets.find(hash);
+    if (it == keymap_buckets.end()) return;
+
+    for (size_t i = 0; i < it->second.size(); i++) {
+        if (it->second[i].slot == slot) {
+            it->second.erase(it->second.begin() + i);
+            keymap_count--;
+            keymap_dirty = true;
+            break;
+        }
+    }
+    if (it->second.empty()) {
+        keymap_buckets.erase(it);
+    }
+}
+
+void storage_keymap_clear(void) {
+    keymap_buckets.clear();
+    keymap_count = 0;
+    keymap_dirty = true;
+}
+
+size_t storage_keymap_count(void) {
+    return keymap_count;
+}
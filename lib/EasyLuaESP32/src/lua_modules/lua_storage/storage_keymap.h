@@ -0,0 +1,45 @@
+#ifndef STORAGE_KEYMAP_H
+#define STORAGE_KEYMAP_H
+
+#include <Arduino.h>
+#include <nvs.h>
+
+// ==================== Long Key Mapping ====================
+//
+// NVS keys are limited to 15 characters. Longer keys (and keys starting
+// with a reserved prefix) are stored under "#<fnv1a32>" or "#<fnv1a32>.<slot>"
+// when hashes collide. A blob under INDEX_KEY maps each hashed name back to
+// the full key, for collision resolution and enumeration.
+
+namespace StorageKeyConfig {
+    const size_t NVS_KEY_MAX = 15;               // NVS_KEY_NAME_MAX_SIZE - 1
+    const size_t MAX_KEY_LENGTH = 64;            // Longest key accepted from scripts
+    const size_t MAX_LONG_KEYS = 128;            // Index entries per namespace
+    const uint8_t MAX_SLOTS = 16;                // Keys sharing one hash
+    const char* const INDEX_KEY = "~keyidx";
+    const uint8_t INDEX_VERSION = 1;
+}
+
+// Reload the index for the namespace opened on `handle`
+void storage_keymap_load(nvs_handle_t handle);
+
+// Write the index if it changed (no commit - batched with the caller's writes)
+bool storage_keymap_save(nvs_handle_t handle);
+
+// NVS key for `key`. Unmapped long keys get a new slot when `create` is set,
+// otherwise (or when the index is full) an empty string is returned.
+String storage_keymap_resolve(const String& key, bool create);
+
+// Full key stored under a hashed NVS name; empty when unknown
+String storage_keymap_name(const String& nvs_key);
+
+// Drop the mapping of a hashed NVS key whose value was erased
+void storage_keymap_forget(const String& nvs_key);
+
+// Forget every mapping (after the namespace was cleared)
+void storage_keymap_clear(void);
+
+// Long keys currently mapped
+size_t storage_keymap_count(void);
+
+#endif // STORAGE_KEYMAP_H
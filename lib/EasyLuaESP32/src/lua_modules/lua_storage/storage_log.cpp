@@ -0,0 +1,450 @@
+#include "storage_log.h"
+#include "../../core/file_transfer.h"
+#include <unordered_map>
+#include <string>
+
+// ==================== Static Variables ====================
+
+struct LogIndexEntry {
+    StorageValueType type;
+    uint16_t len;
+    uint32_t offset;                                    // Value position in the log
+    uint8_t data[StorageLogConfig::INLINE_VALUE_MAX];   // Copy of small values
+};
+
+static std::unordered_map<std::string, LogIndexEntry> log_index;
+static bool log_open = false;
+static String log_path;
+static String log_tmp_path;
+static File log_file;                   // Append handle
+static uint32_t log_size = 0;           // Bytes in the log, including unsynced appends
+static uint32_t log_live_bytes = 0;
+static uint32_t log_unsynced = 0;
+static unsigned long log_first_unsynced = 0;
+static StorageLogStats log_stats;
+
+// ==================== Helper Functions ====================
+
+static uint32_t record_size(size_t key_len, size_t value_len) {
+    return StorageLogConfig::RECORD_OVERHEAD + key_len + value_len;
+}
+
+// Serialize one record into `out` (appended)
+static void build_record(std::vector<uint8_t>& out, uint8_t kind, const char* key, size_t key_len,
+                         const void* value, size_t value_len) {
+    size_t start = out.size();
+    out.push_back(StorageLogConfig::RECORD_MAGIC);
+    out.push_back(kind);
+    out.push_back(key_len);
+    out.push_back(value_len & 0xFF);
+    out.push_back(value_len >> 8);
+    out.insert(out.end(), (const uint8_t*)key, (const uint8_t*)key + key_len);
+    if (value_len > 0) {
+        out.insert(out.end(), (const uint8_t*)value, (const uint8_t*)value + value_len);
+    }
+
+    CRC32 crc;
+    crc.update(&out[start + 1], out.size() - start - 1);
+    uint32_t sum = crc.finalize();
+    uint8_t tail[4] = { (uint8_t)sum, (uint8_t)(sum >> 8), (uint8_t)(sum >> 16), (uint8_t)(sum >> 24) };
+    out.insert(out.end(), tail, tail + 4);
+}
+
+// Point the index at a record whose value starts at `offset`
+static void index_apply(const std::string& key, StorageValueType type, uint32_t offset,
+                        const uint8_t* value, size_t len) {
+    std::unordered_map<std::string, LogIndexEntry>::iterator it = log_index.find(key);
+    if (it != log_index.end()) {
+        log_live_bytes -= record_size(key.length(), it->second.len);
+    }
+
+    if (type == STORAGE_REMOVED) {
+        if (it != log_index.end()) {
+            log_index.erase(it);
+        }
+        return;
+    }
+
+    LogIndexEntry& entry = log_index[key];
+    entry.type = type;
+    entry.len = len;
+    entry.offset = offset;
+    if (len <= StorageLogConfig::INLINE_VALUE_MAX && value) {
+        memcpy(entry.data, value, len);
+    }
+    log_live_bytes += record_size(key.length(), len);
+}
+
+static bool read_value(const LogIndexEntry& entry, std::vector<uint8_t>& value) {
+    value.resize(entry.len);
+    if (entry.len <= StorageLogConfig::INLINE_VALUE_MAX) {
+        memcpy(value.data(), entry.data, entry.len);
+        return true;
+    }
+
+    // Reads go through their own handle, which only sees synced data
+    if (log_unsynced > 0) {
+        storage_log_sync();
+    }
+    File file = FILESYSTEM.open(log_path, FILE_READ);
+    bool ok = file && file.seek(entry.offset) && file.read(value.data(), entry.len) == entry.len;
+    file.close();
+    return ok;
+}
+
+static bool append(const std::vector<uint8_t>& bytes) {
+    if (!log_file || log_file.write(bytes.data(), bytes.size()) != bytes.size()) {
+        LOG_ERROR(STORAGE_TAG, "Log append failed (%s)", log_path.c_str());
+        return false;
+    }
+    if (log_unsynced++ == 0) {
+        log_first_unsynced = millis();
+    }
+    return true;
+}
+
+// ==================== Recovery ====================
+
+struct PendingRecord {
+    std::string key;
+    StorageValueType type;
+    uint32_t offset;
+    std::vector<uint8_t> value;     // Small values only
+    uint16_t len;
+};
+
+// Replay the log into the index. Returns the end of the last complete
+// record (or batch); anything after it is discarded.
+static uint32_t replay(File& file) {
+    std::vector<uint8_t> record;
+    std::vector<PendingRecord> batch;
+    bool in_batch = false;
+    uint32_t pos = 0;
+    uint32_t valid_end = 0;
+    uint32_t size = file.size();
+
+    while (pos + StorageLogConfig::RECORD_OVERHEAD <= size) {
+        uint8_t header[5];
+        if (file.read(header, 5) != 5 || header[0] != StorageLogConfig::RECORD_MAGIC) break;
+
+        uint8_t kind = header[1];
+        uint8_t key_len = header[2];
+        uint16_t value_len = header[3] | (header[4] << 8);
+        uint32_t body = key_len + value_len + 4;
+        if (pos + 5 + body > size) break;
+
+        record.resize(body);
+        if (file.read(record.data(), body) != body) break;
+
+        CRC32 crc;
+        crc.update(&header[1], 4);
+        crc.update(record.data(), key_len + value_len);
+        uint32_t stored = record[body - 4] | (record[body - 3] << 8) | (record[body - 2] << 16) |
+                          ((uint32_t)record[body - 1] << 24);
+        if (crc.finalize() != stored) break;
+
+        std::string key((const char*)record.data(), key_len);
+        const uint8_t* value = record.data() + key_len;
+        uint32_t value_offset = pos + 5 + key_len;
+        pos += 5 + body;
+        log_stats.replayed++;
+
+        if (kind == LOG_BATCH_BEGIN) {
+            batch.clear();
+            in_batch = true;
+        } else if (kind == LOG_BATCH_END) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                PendingRecord& r = batch[i];
+                index_apply(r.key, r.type, r.offset, r.value.data(), r.len);
+            }
+            batch.clear();
+            in_batch = false;
+            valid_end = pos;
+        } else if (kind <= STORAGE_REMOVED) {
+            if (in_batch) {
+                PendingRecord r;
+                r.key = key;
+                r.type = (StorageValueType)kind;
+                r.offset = value_offset;
+                r.len = value_len;
+                if (value_len <= StorageLogConfig::INLINE_VALUE_MAX) {
+                    r.value.assign(value, value + value_len);
+                }
+                batch.push_back(r);
+            } else {
+                index_apply(key, (StorageValueType)kind, value_offset, value, value_len);
+                valid_end = pos;
+            }
+        } else {
+            break;
+        }
+    }
+
+    log_stats.dropped += batch.size();
+    return valid_end;
+}
+
+// ==================== Public API ====================
+
+bool storage_log_open(const char* ns) {
+    storage_log_close();
+
+    unsigned long start = millis();
+    memset(&log_stats, 0, sizeof(log_stats));
+    log_index.clear();
+    log_live_bytes = 0;
+
+    FILESYSTEM.mkdir(StorageLogConfig::DIR);
+    log_path = String(StorageLogConfig::DIR) + "/" + ns + ".log";
+    log_tmp_path = String(StorageLogConfig::DIR) + "/" + ns + ".tmp";
+
+    // A .tmp next to the log never finished its swap and the log still
+    // holds everything; a .tmp alone is the log a swap lost half-way
+    if (FILESYSTEM.exists(log_tmp_path)) {
+        if (FILESYSTEM.exists(log_path)) {
+            FILESYSTEM.remove(log_tmp_path);
+        } else if (!FILESYSTEM.rename(log_tmp_path, log_path)) {
+            LOG_ERROR(STORAGE_TAG, "Cannot finish compaction of %s", log_path.c_str());
+            return false;
+        }
+    }
+
+    uint32_t valid_end = 0;
+    uint32_t file_size = 0;
+    File file = FILESYSTEM.open(log_path, FILE_READ);
+    if (file) {
+        file_size = file.size();
+        valid_end = replay(file);
+        file.close();
+    }
+
+    log_open = true;
+    log_size = valid_end;
+    log_file = FILESYSTEM.open(log_path, FILE_APPEND, true);
+    if (!log_file) {
+        LOG_ERROR(STORAGE_TAG, "Cannot open %s", log_path.c_str());
+        log_open = false;
+        return false;
+    }
+
+    // A torn tail would sit in front of new appends; rewrite without it
+    if (valid_end < file_size) {
+        LOG_ERROR(STORAGE_TAG, "%s: dropped %u bytes after offset %u", log_path.c_str(),
+                  file_size - valid_end, valid_end);
+        log_stats.dropped++;
+
+        // Appends behind the tear would be lost on the next replay, and
+        // the file cannot be truncated in place: refuse to open instead
+        if (!storage_log_compact()) {
+            LOG_ERROR(STORAGE_TAG, "%s: cannot rewrite without the torn tail", log_path.c_str());
+            storage_log_close();
+            return false;
+        }
+    }
+
+    log_stats.recovery_ms = millis() - start;
+    LOG_INFO(STORAGE_TAG, "Log %s: %u keys from %u records in %u ms", log_path.c_str(),
+             (unsigned)log_index.size(), log_stats.replayed, log_stats.recovery_ms);
+    return true;
+}
+
+void storage_log_close(void) {
+    if (!log_open) return;
+
+    storage_log_sync();
+    log_file.close();
+    log_index.clear();
+    log_open = false;
+}
+
+bool storage_log_put(const char* key, StorageValueType type, const void* data, size_t len) {
+    size_t key_len = strlen(key);
+    if (!log_open || key_len == 0 || key_len > StorageLogConfig::MAX_KEY_LENGTH ||
+        len > StorageLogConfig::MAX_VALUE_SIZE) {
+        return false;
+    }
+
+    // Removing a missing key needs no tombstone
+    if (type == STORAGE_REMOVED && !log_index.count(std::string(key, key_len))) {
+        return true;
+    }
+
+    std::vector<uint8_t> bytes;
+    bytes.reserve(record_size(key_len, len));
+    build_record(bytes, type, key, key_len, data, len);
+    if (!append(bytes)) return false;
+
+    index_apply(std::string(key, key_len), type, log_size + 5 + key_len, (const uint8_t*)data, len);
+    log_size += bytes.size();
+    log_stats.appends++;
+    return true;
+}
+
+bool storage_log_get(const char* key, StorageValueType& type, std::vector<uint8_t>& value) {
+    if (!log_open) return false;
+
+    std::unordered_map<std::string, LogIndexEntry>::const_iterator it = log_index.find(key);
+    if (it == log_index.end()) return false;
+
+    type = it->second.type;
+    return read_value(it->second, value);
+}
+
+bool storage_log_contains(const char* key) {
+    return log_open && log_index.count(key) > 0;
+}
+
+void storage_log_keys(std::vector<String>& out) {
+    out.reserve(out.size() + log_index.size());
+    for (std::unordered_map<std::string, LogIndexEntry>::const_iterator it = log_index.begin();
+         it != log_index.end(); ++it) {
+        out.push_back(String(it->first.c_str()));
+    }
+}
+
+bool storage_log_write_batch(const std::vector<StorageLogRecord>& records) {
+    if (!log_open) return false;
+
+    std::vector<uint8_t> bytes;
+    build_record(bytes, LOG_BATCH_BEGIN, "", 0, NULL, 0);
+
+    std::vector<uint32_t> offsets;
+    for (size_t i = 0; i < records.size(); i++) {
+        const StorageLogRecord& r = records[i];
+        if (r.key.length() == 0 || r.key.length() > StorageLogConfig::MAX_KEY_LENGTH ||
+            r.value.size() > StorageLogConfig::MAX_VALUE_SIZE) {
+            return false;
+        }
+        offsets.push_back(log_size + bytes.size() + 5 + r.key.length());
+        build_record(bytes, r.type, r.key.c_str(), r.key.length(), r.value.data(), r.value.size());
+    }
+    build_record(bytes, LOG_BATCH_END, "", 0, NULL, 0);
+
+    // One write, then sync: the END marker is what makes the batch count
+    if (!append(bytes) || !storage_log_sync()) return false;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const StorageLogRecord& r = records[i];
+        index_apply(std::string(r.key.c_str()), r.type, offsets[i], r.value.data(), r.value.size());
+    }
+    log_size += bytes.size();
+    log_stats.appends += records.size() + 2;
+    return true;
+}
+
+void storage_log_clear(void) {
+    if (!log_open) return;
+
+    log_file.close();
+    log_file = FILESYSTEM.open(log_path, FILE_WRITE);
+    log_file.close();
+    log_file = FILESYSTEM.open(log_path, FILE_APPEND, true);
+
+    log_index.clear();
+    log_live_bytes = 0;
+    log_size = 0;
+    log_unsynced = 0;
+}
+
+bool storage_log_sync(void) {
+    if (!log_open || log_unsynced == 0) return true;
+
+    log_file.flush();
+    log_unsynced = 0;
+    log_stats.syncs++;
+    return true;
+}
+
+void storage_log_service(void) {
+    if (!log_open) return;
+
+    if (log_unsynced > 0 && millis() - log_first_unsynced >= StorageConfig::WRITE_BACK_MS) {
+        storage_log_sync();
+    }
+    if (log_size >= StorageLogConfig::COMPACT_MIN_BYTES &&
+        log_size > (uint32_t)StorageLogConfig::COMPACT_RATIO * log_live_bytes) {
+        storage_log_compact();
+    }
+}
+
+bool storage_log_compact(void) {
+    if (!log_open) return false;
+
+    unsigned long start = millis();
+    storage_log_sync();
+
+    File tmp = FILESYSTEM.open(log_tmp_path, FILE_WRITE);
+    if (!tmp) return false;
+
+    // Copy live records; offsets are applied only once the swap succeeded
+    std::vector<std::pair<std::string, uint32_t> > offsets;
+    std::vector<uint8_t> value;
+    std::vector<uint8_t> bytes;
+    uint32_t pos = 0;
+    bool ok = true;
+
+    for (std::unordered_map<std::string, LogIndexEntry>::const_iterator it = log_index.begin();
+         ok && it != log_index.end(); ++it) {
+        ok = read_value(it->second, value);
+        if (!ok) break;
+
+        bytes.clear();
+        build_record(bytes, it->second.type, it->first.c_str(), it->first.length(), value.data(), value.size());
+        ok = tmp.write(bytes.data(), bytes.size()) == bytes.size();
+        offsets.push_back(std::make_pair(it->first, pos + 5 + (uint32_t)it->first.length()));
+        pos += bytes.size();
+    }
+    tmp.close();
+
+    if (!ok) {
+        FILESYSTEM.remove(log_tmp_path);
+        LOG_ERROR(STORAGE_TAG, "Log compaction failed (%s)", log_path.c_str());
+        return false;
+    }
+
+    // LittleFS renames over the log in one step; SPIFFS needs the log
+    // removed first, and from then until the rename lands the .tmp is the
+    // only copy. open() finishes the swap if a reset falls in between.
+    log_file.close();
+    bool swapped = FILESYSTEM.rename(log_tmp_path, log_path);
+    if (!swapped && FILESYSTEM.remove(log_path)) {
+        swapped = FILESYSTEM.rename(log_tmp_path, log_path);
+        if (!swapped) {
+            // Appending to a fresh log here would make open() discard the
+            // .tmp: stop until the next open finishes the swap
+            LOG_ERROR(STORAGE_TAG, "Log swap failed, %s kept for the next open", log_tmp_path.c_str());
+            log_index.clear();
+            log_live_bytes = 0;
+            log_unsynced = 0;
+            log_open = false;
+            return false;
+        }
+    }
+    if (!swapped) {
+        // The log was never touched: keep appending to it
+        FILESYSTEM.remove(log_tmp_path);
+        log_file = FILESYSTEM.open(log_path, FILE_APPEND, true);
+        LOG_ERROR(STORAGE_TAG, "Log compaction failed (%s)", log_path.c_str());
+        return false;
+    }
+    log_file = FILESYSTEM.open(log_path, FILE_APPEND, true);
+
+    for (size_t i = 0; i < offsets.size(); i++) {
+        log_index[offsets[i].first].offset = offsets[i].second;
+    }
+
+    LOG_DEBUG(STORAGE_TAG, "Compacted %s: %u -> %u bytes", log_path.c_str(), log_size, pos);
+    log_size = pos;
+    log_stats.compactions++;
+    log_stats.last_compact_ms = millis() - start;
+    return true;
+}
+
+void storage_log_get_stats(StorageLogStats* stats) {
+    if (!stats) return;
+
+    *stats = log_stats;
+    stats->keys = log_index.size();
+    stats->live_bytes = log_live_bytes;
+    stats->file_bytes = log_size;
+}
@@ -0,0 +1,88 @@
+#ifndef STORAGE_LOG_H
+#define STORAGE_LOG_H
+
+#include <Arduino.h>
+#include <vector>
+#include "lua_storage.h"
+
+// ==================== Log-Structured Backend ====================
+//
+// Each namespace is one append-only file, <DIR>/<namespace>.log. Every
+// write appends a record and an in-RAM hash index points at the latest
+// value of each key. Opening replays the log, dropping a torn tail and
+// any unfinished batch. Compaction rewrites the live records to a .tmp
+// file and renames it over the log; if the swap fails half-way the .tmp
+// is kept and the log stays closed until the next open finishes it.
+//
+// Record: [magic u8][kind u8][key_len u8][value_len u16][key][value][crc32 u32]
+// The CRC covers kind through value. Kinds are StorageValueType, plus
+// LOG_BATCH_BEGIN/END around transaction commits.
+
+namespace StorageLogConfig {
+    const char* const DIR = "/.kv";
+    const uint8_t RECORD_MAGIC = 0xA5;
+    const size_t RECORD_OVERHEAD = 9;            // Header + CRC
+    const size_t MAX_KEY_LENGTH = 64;
+    const size_t MAX_VALUE_SIZE = 8192;
+    const size_t INLINE_VALUE_MAX = 16;          // Values this small are served from RAM
+    const size_t COMPACT_MIN_BYTES = 16384;      // Never compact a log smaller than this
+    const uint8_t COMPACT_RATIO = 3;             // Compact when the file is this many times the live data
+}
+
+enum StorageLogMarker : uint8_t {
+    LOG_BATCH_BEGIN = 0x10,
+    LOG_BATCH_END = 0x11
+};
+
+// One write of a batch (transaction commit)
+struct StorageLogRecord {
+    String key;
+    StorageValueType type;
+    std::vector<uint8_t> value;
+};
+
+struct StorageLogStats {
+    uint32_t keys;              // Live keys
+    uint32_t live_bytes;        // Bytes of the live records
+    uint32_t file_bytes;        // Current log size
+    uint32_t appends;           // Records appended since open
+    uint32_t syncs;
+    uint32_t compactions;
+    uint32_t replayed;          // Records read at open
+    uint32_t dropped;           // Torn or unfinished records discarded at open
+    uint32_t recovery_ms;       // Time spent replaying at open
+    uint32_t last_compact_ms;
+};
+
+// Open (creating if needed) and replay the log of a namespace
+bool storage_log_open(const char* ns);
+void storage_log_close(void);
+
+// Append a value; STORAGE_REMOVED writes a tombstone
+bool storage_log_put(const char* key, StorageValueType type, const void* data, size_t len);
+
+// Latest value of `key`; false when missing
+bool storage_log_get(const char* key, StorageValueType& type, std::vector<uint8_t>& value);
+bool storage_log_contains(const char* key);
+
+// Append every live key to `out` (unordered)
+void storage_log_keys(std::vector<String>& out);
+
+// Append records between batch markers; replay applies all or none of them
+bool storage_log_write_batch(const std::vector<StorageLogRecord>& records);
+
+// Drop every key (truncates the log)
+void storage_log_clear(void);
+
+// Make appended records durable
+bool storage_log_sync(void);
+
+// Periodic work from the storage flush task: sync stale appends, compact when worthwhile
+void storage_log_service(void);
+
+// Rewrite the log with live records only
+bool storage_log_compact(void);
+
+void storage_log_get_stats(StorageLogStats* stats);
+
+#endif // STORAGE_LOG_H
@@ -0,0 +1,269 @@
+#include "storage_table.h"
+#include "lua.hpp"
+#include <string.h>
+#include <map>
+
+enum TableTag : uint8_t {
+    TAG_END = 0,
+    TAG_FALSE = 1,
+    TAG_TRUE = 2,
+    TAG_INT = 3,
+    TAG_FLOAT = 4,
+    TAG_STRING = 5,
+    TAG_TABLE = 6,
+    TAG_REF = 7
+};
+
+static const uint8_t TABLE_MAGIC[3] = { 'L', 'T', 'B' };
+
+// ==================== Encoder ====================
+
+struct TableEncoder {
+    lua_State* L;
+    std::vector<uint8_t>& out;
+    std::map<const void*, uint32_t> tables;     // Already written -> index for TAG_REF
+    const char* error;
+
+    TableEncoder(lua_State* state, std::vector<uint8_t>& buffer) : L(state), out(buffer), error(NULL) {}
+
+    bool fail(const char* message) {
+        if (!error) error = message;
+        return false;
+    }
+
+    bool put(uint8_t byte) {
+        if (out.size() >= StorageTableConfig::MAX_BYTES) return fail("table too large");
+        out.push_back(byte);
+        return true;
+    }
+
+    bool putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            if (!put((uint8_t)(value | 0x80))) return false;
+            value >>= 7;
+        }
+        return put((uint8_t)value);
+    }
+
+    bool putBytes(const void* data, size_t len) {
+        if (out.size() + len > StorageTableConfig::MAX_BYTES) return fail("table too large");
+        out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + len);
+        return true;
+    }
+
+    bool value(int index, int depth) {
+        switch (lua_type(L, index)) {
+            case LUA_TBOOLEAN:
+                return put(lua_toboolean(L, index) ? TAG_TRUE : TAG_FALSE);
+
+            case LUA_TNUMBER:
+                if (lua_isinteger(L, index)) {
+                    int64_t v = lua_tointeger(L, index);
+                    return put(TAG_INT) && putVarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+                } else {
+                    double v = lua_tonumber(L, index);
+                    return put(TAG_FLOAT) && putBytes(&v, sizeof(v));
+                }
+
+            case LUA_TSTRING: {
+                size_t len;
+                const char* s = lua_tolstring(L, index, &len);
+                return put(TAG_STRING) && putVarint(len) && putBytes(s, len);
+            }
+
+            case LUA_TTABLE:
+                return table(index, depth + 1);
+
+            default:
+                return fail("unsupported value type in table");
+        }
+    }
+
+    bool table(int index, int depth) {
+        index = lua_absindex(L, index);
+
+        // Shared or cyclic tables are written once and referenced afterwards
+        const void* ptr = lua_topointer(L, index);
+        std::map<const void*, uint32_t>::const_iterator seen = tables.find(ptr);
+        if (seen != tables.end()) {
+            return put(TAG_REF) && putVarint(seen->second);
+        }
+        if (depth > StorageTableConfig::MAX_DEPTH) return fail("table nested too deeply");
+        if (!lua_checkstack(L, 4)) return fail("out of Lua stack");
+
+        uint32_t id = tables.size();
+        tables[ptr] = id;
+
+        // Array part: 1..n up to the first nil
+        lua_Integer count = 0;
+        lua_Integer len = (lua_Integer)lua_rawlen(L, index);
+        while (count < len) {
+            bool present = lua_rawgeti(L, index, count + 1) != LUA_TNIL;
+            lua_pop(L, 1);
+            if (!present) break;
+            count++;
+        }
+
+        if (!put(TAG_TABLE) || !putVarint(count)) return false;
+
+        for (lua_Integer i = 1; i <= count; i++) {
+            lua_rawgeti(L, index, i);
+            bool ok = value(-1, depth);
+            lua_pop(L, 1);
+            if (!ok) return false;
+        }
+
+        // Remaining pairs, skipping keys already in the array part
+        lua_pushnil(L);
+        while (lua_next(L, index) != 0) {
+            if (lua_isinteger(L, -2)) {
+                lua_Integer k = lua_tointeger(L, -2);
+                if (k >= 1 && k <= count) {
+                    lua_pop(L, 1);
+                    continue;
+                }
+            }
+            if (!value(-2, depth) || !value(-1, depth)) {
+                lua_pop(L, 2);
+                return false;
+            }
+            lua_pop(L, 1);
+        }
+
+        return put(TAG_END);
+    }
+};
+
+bool storage_table_encode(lua_State* L, int index, std::vector<uint8_t>& out, const char** error) {
+    out.clear();
+    out.insert(out.end(), TABLE_MAGIC, TABLE_MAGIC + 3);
+    out.push_back(StorageTableConfig::VERSION);
+
+    TableEncoder encoder(L, out);
+    bool ok = encoder.table(index, 1);
+    if (!ok && error) {
+        *error = encoder.error;
+    }
+    return ok;
+}
+
+// ==================== Decoder ====================
+
+struct TableDecoder {
+    lua_State* L;
+    const uint8_t* pos;
+    const uint8_t* end;
+    int refs;               // Stack index of the index -> table list
+    uint32_t tableCount;
+
+    bool getVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= end) return false;
+            uint8_t byte = *pos++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Push one value; `tag` has already been read
+    bool value(uint8_t tag, int depth) {
+        uint64_t v;
+        switch (tag) {
+            case TAG_FALSE:
+            case TAG_TRUE:
+                lua_pushboolean(L, tag == TAG_TRUE);
+                return true;
+
+            case TAG_INT:
+                if (!getVarint(v)) return false;
+                lua_pushinteger(L, (lua_Integer)((v >> 1) ^ (~(v & 1) + 1)));
+                return true;
+
+            case TAG_FLOAT: {
+                double d;
+                if (end - pos < (ptrdiff_t)sizeof(d)) return false;
+                memcpy(&d, pos, sizeof(d));
+                pos += sizeof(d);
+                lua_pushnumber(L, d);
+                return true;
+            }
+
+            case TAG_STRING:
+                if (!getVarint(v) || v > (uint64_t)(end - pos)) return false;
+                lua_pushlstring(L, (const char*)pos, v);
+                pos += v;
+                return true;
+
+            case TAG_TABLE:
+                return table(depth + 1);
+
+            case TAG_REF:
+                if (!getVarint(v) || v >= tableCount) return false;
+                lua_rawgeti(L, refs, v + 1);
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    bool table(int depth) {
+        uint64_t count;
+        if (depth > StorageTableConfig::MAX_DEPTH || !lua_checkstack(L, 4) || !getVarint(count) ||
+            count > (uint64_t)(end - pos)) {
+            return false;
+        }
+
+        lua_createtable(L, (int)count, 0);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, refs, ++tableCount);
+        int index = lua_gettop(L);
+
+        for (uint64_t i = 1; i <= count; i++) {
+            if (pos >= end || !value(*pos++, depth)) return false;
+            lua_rawseti(L, index, (lua_Integer)i);
+        }
+
+        for (;;) {
+            if (pos >= end) return false;
+            uint8_t tag = *pos++;
+            if (tag == TAG_END) return true;
+
+            if (!value(tag, depth)) return false;
+            if (lua_isnil(L, -1) || pos >= end || !value(*pos++, depth)) return false;
+            lua_rawset(L, index);
+        }
+    }
+};
+
+bool storage_table_is_blob(const uint8_t* data, size_t len) {
+    return data && len > StorageTableConfig::HEADER_SIZE && memcmp(data, TABLE_MAGIC, 3) == 0 &&
+           data[3] == StorageTableConfig::VERSION;
+}
+
+bool storage_table_decode(lua_State* L, const uint8_t* data, size_t len) {
+    if (!storage_table_is_blob(data, len) || data[StorageTableConfig::HEADER_SIZE] != TAG_TABLE) {
+        return false;
+    }
+
+    int top = lua_gettop(L);
+    lua_newtable(L);
+
+    TableDecoder decoder;
+    decoder.L = L;
+    decoder.pos = data + StorageTableConfig::HEADER_SIZE + 1;
+    decoder.end = data + len;
+    decoder.refs = lua_gettop(L);
+    decoder.tableCount = 0;
+
+    // Trailing bytes mean a damaged blob as much as missing ones do
+    if (!decoder.table(1) || decoder.pos != decoder.end) {
+        lua_settop(L, top);
+        return false;
+    }
+
+    lua_remove(L, decoder.refs);
+    return true;
+}
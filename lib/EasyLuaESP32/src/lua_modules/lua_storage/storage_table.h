@@ -0,0 +1,34 @@
+#ifndef STORAGE_TABLE_H
+#define STORAGE_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+struct lua_State;
+
+// ==================== Binary Table Format ====================
+//
+// Tables are stored as NVS blobs: "LTB" + version, then one tagged value.
+//   TABLE: [tag][array_count varint][array values...][key value]...[END]
+//   REF:   [tag][table index varint] - a table already written (shared or cyclic)
+// Integers are zigzag varints, floats raw little-endian doubles,
+// strings [len varint][bytes].
+
+namespace StorageTableConfig {
+    const uint8_t VERSION = 1;
+    const size_t HEADER_SIZE = 4;
+    const size_t MAX_BYTES = 8192;       // Encoded size limit per key
+    const int MAX_DEPTH = 16;            // Nesting limit on encode and decode
+}
+
+// Encode the table at `index`; false with `error` set on unsupported values or limits
+bool storage_table_encode(lua_State* L, int index, std::vector<uint8_t>& out, const char** error);
+
+// Push the decoded table; false (nothing pushed) if the blob is not a valid table
+bool storage_table_decode(lua_State* L, const uint8_t* data, size_t len);
+
+// True when a blob starts with the table header
+bool storage_table_is_blob(const uint8_t* data, size_t len);
+
+#endif // STORAGE_TABLE_H
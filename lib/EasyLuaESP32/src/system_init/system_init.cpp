@@ -8,7 +8,13 @@
 #include "core/comms/ble_comm.h"
 #include "core/utils/debug.h"
 #include "core/file_transfer.h"
+#include "core/file_manifest.h"
+#include "core/file_walk.h"
 #include "../lua_modules/lua_arduino/lua_arduino.h"
+#include "../lua_modules/lua_gpio/lua_gpio.h"
+#include "../lua_modules/lua_periodic/lua_periodic.h"
+#include "../lua_modules/lua_adc/lua_adc.h"
+#include "../lua_modules/lua_dsp/lua_dsp.h"
 #include "../lua_modules/lua_storage/lua_storage.h"
 // ═══════════════════════════════════════════════════════════
 // MODULE DECLARATIONS
@@ -44,6 +50,18 @@ static void onLuaStateReset(lua_State *L)
     // Register Arduino module (GPIO, timers, etc.)
     arduino_module_register(L);
 
+    // Register GPIO module (pin masks and groups)
+    lua_gpio_register(L);
+
+    // Register periodic() (fixed-rate callbacks)
+    lua_periodic_register(L);
+
+    // Register ADC module (continuous sampling)
+    lua_adc_register(L);
+
+    // Register DSP module (native pipelines over ADC blocks)
+    lua_dsp_register(L);
+
     // Register EventMsg module (event communication)
     lua_eventmsg_register(L);
 
@@ -63,6 +81,7 @@ static void onLuaStateReset(lua_State *L)
 static void onLuaError(const char *error_msg)
 {
     LOG_ERROR("LUA", "Lua error: %s", error_msg);
+    arduino_console_flush();    // Output printed before the error arrives first
     event_msg_send(EVENT_LUA_ERROR, (const uint8_t *)error_msg, strlen(error_msg));
 }
 
@@ -70,6 +89,9 @@ static void onLuaStop()
 {
     LOG_INFO("LUA", "Lua execution finished");
 
+    // Buffered print() output goes out before the completion events
+    arduino_console_flush();
+
     // ─────────────────────────────────────────────────────────
     // SYSTEM CLEANUP (automatic)
     // ─────────────────────────────────────────────────────────
@@ -77,6 +99,17 @@ static void onLuaStop()
     // Cleanup lua_eventmsg resources
     lua_eventmsg_cleanup();
 
+    // Stop the DSP pipeline, then ADC sampling, left running by the script
+    lua_dsp_cleanup();
+    lua_adc_cleanup();
+
+    // Detach pin interrupts and stop periodic timers the script left
+    lua_gpio_cleanup();
+    lua_periodic_cleanup();
+
+    // Write cached storage keys now rather than on the next timer tick
+    storage_flush_c();
+
     // ─────────────────────────────────────────────────────────
     // USER CLEANUP (provided by user callback)
     // ─────────────────────────────────────────────────────────
@@ -181,6 +214,9 @@ static void system_init_serial()
     Serial.begin(115200);
     delay(1000); // Wait for serial to stabilize
 
+    // Log task formats LOG_* records queued since boot
+    debug_log_init();
+
     LOG_INFO("SYSTEM", "═══════════════════════════════════════");
     LOG_INFO("SYSTEM", "  ESP32 Lua System Starting...");
     LOG_INFO("SYSTEM", "═══════════════════════════════════════");
@@ -203,6 +239,9 @@ static void system_init_lua()
     lua_engine_on_error(onLuaError);
     lua_engine_on_stop(onLuaStop);
 
+    // Keep running spawn() tasks after the main chunk returns
+    lua_engine_on_finish(arduino_scheduler_drain);
+
     // Initialize Lua engine (creates RTOS task internally)
     lua_engine_init();
     delay(500); // Wait for Lua engine to stabilize
@@ -240,6 +279,10 @@ static void system_init_events()
     // Initialize and register file transfer module
     file_transfer_init();
     file_transfer_register_handlers();
+    file_manifest_init();
+    file_manifest_register_handlers();
+    file_walk_register_handlers();
+    debug_log_register_handlers();
 
     LOG_INFO("SYSTEM", "✓ Event system ready");
     LOG_INFO("SYSTEM", "  Registered Lua events:");
@@ -250,9 +293,12 @@ static void system_init_events()
     LOG_INFO("SYSTEM", "    - %s (run buffer)", EVENT_LUA_CODE_RUN);
     LOG_INFO("SYSTEM", "    - %s (stop execution)", EVENT_LUA_CODE_STOP);
     LOG_INFO("SYSTEM", "  Registered File events:");
-    LOG_INFO("SYSTEM", "    - file_init, file_create, file_append, file_flush");
-    LOG_INFO("SYSTEM", "    - file_seek, file_close, file_read, file_delete");
-    LOG_INFO("SYSTEM", "    - file_list, file_info");
+    LOG_INFO("SYSTEM", "    - file_init, file_create, file_append, file_write, file_chunk, file_flush");
+    LOG_INFO("SYSTEM", "    - file_seek, file_close, file_resume_query, file_read, file_stream, file_delete");
+    LOG_INFO("SYSTEM", "    - file_signature, file_delta_begin, file_delta_ops, file_delta_end");
+    LOG_INFO("SYSTEM", "    - file_list, file_walk, file_info, file_manifest");
+    LOG_INFO("SYSTEM", "  Registered Log events:");
+    LOG_INFO("SYSTEM", "    - log_config (log / log_status)");
 }
 
 static void system_init_storage()
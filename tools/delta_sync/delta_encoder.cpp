@@ -0,0 +1,482 @@
+// ═══════════════════════════════════════════════════════
+// DELTA SYNC ENCODER (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Builds file_delta_ops frames that turn OLD into NEW, using the same
+// block signatures the device returns for file_signature.
+//
+// Build:
+//   g++ -std=c++11 -O2 -o delta_encoder delta_encoder.cpp
+//
+// Usage:
+//   delta_encoder <old> <new> [block_size] [-o frames.bin]
+//       Encode, verify by applying, print transfer sizes. With -o, writes
+//       each frame as [length u16 LE][payload] for a host script to send.
+//   delta_encoder --bench [script.lua]
+//       Measure bytes transferred for typical edits of a script
+//       (a generated 40KB Lua file when none is given).
+
+#include "../../lib/EasyLuaESP32/src/core/utils/rolling_checksum.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+typedef std::vector<uint8_t> Bytes;
+
+// Same result as the ESP32 ROM crc32_le(0, data, len)
+static uint32_t crc32(const uint8_t *data, size_t length) {
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+    }
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// ═══════════════════════════════════════════════════════
+// SIGNATURES (what the device sends back)
+// ═══════════════════════════════════════════════════════
+
+struct BlockSignature {
+    uint32_t rolling;
+    uint32_t strong;
+    size_t length;
+};
+
+static std::vector<BlockSignature> computeSignatures(const Bytes &file, size_t blockSize) {
+    std::vector<BlockSignature> sigs;
+    for (size_t offset = 0; offset < file.size(); offset += blockSize) {
+        size_t length = std::min(blockSize, file.size() - offset);
+        RollingChecksum weak;
+        weak.init(&file[offset], length);
+
+        BlockSignature sig = { weak.value(), crc32(&file[offset], length), length };
+        sigs.push_back(sig);
+    }
+    return sigs;
+}
+
+// Bytes on the wire for the signature download (data frames only)
+static size_t signatureWireBytes(size_t blocks) {
+    size_t frames = (blocks + DeltaSync::SIG_ENTRIES_PER_FRAME - 1) / DeltaSync::SIG_ENTRIES_PER_FRAME;
+    return frames * 4 + blocks * DeltaSync::SIG_ENTRY_SIZE;
+}
+
+// ═══════════════════════════════════════════════════════
+// ENCODER
+// ═══════════════════════════════════════════════════════
+
+class DeltaEncoder {
+public:
+    DeltaEncoder()
+        : copyOps(0), literalOps(0), copiedBytes(0), literalBytes(0),
+          lastCopyEnd(0), copyOpen(false), copyAt(0) {}
+
+    std::vector<Bytes> frames;
+    size_t copyOps;
+    size_t literalOps;
+    size_t copiedBytes;
+    size_t literalBytes;
+
+    void encode(const std::vector<BlockSignature> &sigs, size_t blockSize, const Bytes &next) {
+        // Index full blocks by weak checksum; a short last block only matches at the end
+        std::unordered_map<uint32_t, std::vector<uint32_t> > index;
+        for (uint32_t i = 0; i < sigs.size(); i++) {
+            if (sigs[i].length == blockSize) {
+                index[sigs[i].rolling].push_back(i);
+            }
+        }
+
+        size_t pos = 0;
+        size_t literalStart = 0;
+        RollingChecksum weak;
+        bool weakValid = false;
+
+        while (pos + blockSize <= next.size()) {
+            if (!weakValid) {
+                weak.init(&next[pos], blockSize);
+                weakValid = true;
+            }
+
+            int match = -1;
+            auto it = index.find(weak.value());
+            if (it != index.end()) {
+                uint32_t strong = crc32(&next[pos], blockSize);
+                for (uint32_t block : it->second) {
+                    if (sigs[block].strong == strong) {
+                        match = block;
+                        // Prefer the block that extends the current copy run
+                        if (copyOpen && block == lastCopyEnd) {
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (match >= 0) {
+                literal(next, literalStart, pos);
+                copy(match, blockSize);
+                pos += blockSize;
+                literalStart = pos;
+                weakValid = false;
+            } else {
+                if (pos + blockSize < next.size()) {
+                    weak.roll(next[pos], next[pos + blockSize]);
+                } else {
+                    weakValid = false;
+                }
+                pos++;
+            }
+        }
+
+        // Tail: reuse the old short last block if it is unchanged
+        size_t tail = next.size() - pos;
+        if (!sigs.empty() && tail > 0 && tail < blockSize && tail == sigs.back().length &&
+            crc32(&next[pos], tail) == sigs.back().strong) {
+            literal(next, literalStart, pos);
+            copy(sigs.size() - 1, tail);
+            literalStart = next.size();
+        }
+
+        literal(next, literalStart, next.size());
+        closeFrame();
+    }
+
+private:
+    Bytes current;
+    uint32_t lastCopyEnd;
+    bool copyOpen;
+    size_t copyAt;      // Offset of the open COPY op in `current`
+
+    void closeFrame() {
+        if (!current.empty()) {
+            frames.push_back(current);
+            current.clear();
+        }
+        copyOpen = false;
+    }
+
+    void reserve(size_t bytes) {
+        if (current.size() + bytes > DeltaSync::OPS_FRAME_SIZE) {
+            closeFrame();
+        }
+    }
+
+    void copy(uint32_t block, size_t length) {
+        copiedBytes += length;
+
+        // Extend the previous COPY when blocks are consecutive
+        if (copyOpen && block == lastCopyEnd) {
+            uint16_t count = current[copyAt + 5] | (current[copyAt + 6] << 8);
+            if (count < 0xFFFF) {
+                count++;
+                current[copyAt + 5] = count & 0xFF;
+                current[copyAt + 6] = count >> 8;
+                lastCopyEnd++;
+                return;
+            }
+        }
+
+        reserve(7);
+        copyAt = current.size();
+        current.push_back(DeltaSync::OP_COPY);
+        for (int i = 0; i < 4; i++) {
+            current.push_back((block >> (8 * i)) & 0xFF);
+        }
+        current.push_back(1);
+        current.push_back(0);
+        copyOpen = true;
+        lastCopyEnd = block + 1;
+        copyOps++;
+    }
+
+    void literal(const Bytes &next, size_t from, size_t to) {
+        while (from < to) {
+            reserve(3 + 1);
+            size_t room = DeltaSync::OPS_FRAME_SIZE - current.size() - 3;
+            size_t length = std::min(room, to - from);
+
+            current.push_back(DeltaSync::OP_LITERAL);
+            current.push_back(length & 0xFF);
+            current.push_back(length >> 8);
+            current.insert(current.end(), next.begin() + from, next.begin() + from + length);
+
+            from += length;
+            literalBytes += length;
+            literalOps++;
+            copyOpen = false;
+        }
+    }
+};
+
+// ═══════════════════════════════════════════════════════
+// DECODER (mirrors handleFileDeltaOps, used to verify)
+// ═══════════════════════════════════════════════════════
+
+static bool applyDelta(const Bytes &base, size_t blockSize, const std::vector<Bytes> &frames, Bytes &out) {
+    out.clear();
+    for (const Bytes &frame : frames) {
+        size_t pos = 0;
+        while (pos < frame.size()) {
+            if (frame[pos] == DeltaSync::OP_COPY && pos + 7 <= frame.size()) {
+                uint32_t block = frame[pos + 1] | (frame[pos + 2] << 8) |
+                                 (frame[pos + 3] << 16) | ((uint32_t)frame[pos + 4] << 24);
+                uint16_t count = frame[pos + 5] | (frame[pos + 6] << 8);
+                size_t offset = (size_t)block * blockSize;
+                size_t end = std::min(base.size(), offset + (size_t)count * blockSize);
+                if (offset >= base.size()) {
+                    return false;
+                }
+                out.insert(out.end(), base.begin() + offset, base.begin() + end);
+                pos += 7;
+            } else if (frame[pos] == DeltaSync::OP_LITERAL && pos + 3 <= frame.size()) {
+                uint16_t length = frame[pos + 1] | (frame[pos + 2] << 8);
+                pos += 3;
+                if (pos + length > frame.size()) {
+                    return false;
+                }
+                out.insert(out.end(), frame.begin() + pos, frame.begin() + pos + length);
+                pos += length;
+            } else {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════
+// REPORTING
+// ═══════════════════════════════════════════════════════
+
+struct DeltaResult {
+    size_t signatureBytes;
+    size_t opsBytes;
+    size_t frames;
+    size_t copiedBytes;
+    size_t literalBytes;
+    bool verified;
+};
+
+static DeltaResult runDelta(const Bytes &base, const Bytes &next, size_t blockSize,
+                            std::vector<Bytes> *framesOut = nullptr) {
+    std::vector<BlockSignature> sigs = computeSignatures(base, blockSize);
+
+    DeltaEncoder encoder;
+    encoder.encode(sigs, blockSize, next);
+
+    Bytes rebuilt;
+    DeltaResult result;
+    result.signatureBytes = signatureWireBytes(sigs.size());
+    result.opsBytes = 0;
+    for (const Bytes &frame : encoder.frames) {
+        result.opsBytes += frame.size();
+    }
+    result.frames = encoder.frames.size();
+    result.copiedBytes = encoder.copiedBytes;
+    result.literalBytes = encoder.literalBytes;
+    result.verified = applyDelta(base, blockSize, encoder.frames, rebuilt) && rebuilt == next;
+
+    if (framesOut) {
+        *framesOut = encoder.frames;
+    }
+    return result;
+}
+
+static bool readFile(const char *path, Bytes &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        out.insert(out.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Deterministic stand-in for a typical 40KB Lua script
+static Bytes generateScript(size_t targetSize) {
+    std::string text;
+    unsigned seed = 12345;
+    int fn = 0;
+    while (text.size() < targetSize) {
+        char line[256];
+        seed = seed * 1103515245 + 12345;
+        snprintf(line, sizeof(line),
+                 "local function handler_%d(value)\n"
+                 "    local result = value * %u + sensor.read(%u)\n"
+                 "    if result > %u then\n"
+                 "        print(\"handler_%d over limit\", result)\n"
+                 "    end\n"
+                 "    return result\n"
+                 "end\n\n",
+                 fn, (seed >> 8) % 97, (seed >> 4) % 8, (seed >> 12) % 1000, fn);
+        text += line;
+        fn++;
+    }
+    return Bytes(text.begin(), text.end());
+}
+
+static size_t findLine(const Bytes &text, size_t fraction) {
+    size_t pos = text.size() * fraction / 100;
+    while (pos < text.size() && text[pos] != '\n') {
+        pos++;
+    }
+    return std::min(pos + 1, text.size());
+}
+
+static void insertText(Bytes &text, size_t pos, const char *s) {
+    text.insert(text.begin() + pos, s, s + strlen(s));
+}
+
+static int runBench(const char *path) {
+    Bytes base;
+    if (path) {
+        if (!readFile(path, base)) {
+            fprintf(stderr, "Cannot read %s\n", path);
+            return 1;
+        }
+    } else {
+        base = generateScript(40 * 1024);
+    }
+
+    struct Edit {
+        const char *name;
+        Bytes next;
+    };
+    std::vector<Edit> edits;
+
+    {   // Change one line in the middle
+        Bytes next = base;
+        size_t at = findLine(next, 50);
+        next[at + 4] = next[at + 4] == 'x' ? 'y' : 'x';
+        edits.push_back({ "one-line change", next });
+    }
+    {   // Insert a line near the top
+        Bytes next = base;
+        insertText(next, findLine(next, 1), "local DEBUG = true\n");
+        edits.push_back({ "insert line at top", next });
+    }
+    {   // Append a function
+        Bytes next = base;
+        insertText(next, next.size(), "\nfunction on_stop()\n    print(\"bye\")\nend\n");
+        edits.push_back({ "append function", next });
+    }
+    {   // Delete ~10 lines in the middle
+        Bytes next = base;
+        size_t from = findLine(next, 40);
+        size_t to = from;
+        for (int i = 0; i < 10 && to < next.size(); i++) {
+            while (to < next.size() && next[to] != '\n') {
+                to++;
+            }
+            to = std::min(to + 1, next.size());
+        }
+        next.erase(next.begin() + from, next.begin() + to);
+        edits.push_back({ "delete 10 lines", next });
+    }
+    {   // Small edits scattered through the file
+        Bytes next = base;
+        for (int pct = 5; pct < 100; pct += 10) {
+            size_t at = findLine(next, pct);
+            next[at] = next[at] == '-' ? '+' : '-';
+        }
+        edits.push_back({ "10 scattered edits", next });
+    }
+
+    const size_t blockSizes[] = { 256, 512, 1024 };
+
+    printf("Base file: %zu bytes\n\n", base.size());
+    printf("%-20s %6s %9s %9s %9s %8s %7s\n",
+           "edit", "block", "sig (B)", "ops (B)", "total", "full", "saved");
+    for (const Edit &edit : edits) {
+        for (size_t blockSize : blockSizes) {
+            DeltaResult r = runDelta(base, edit.next, blockSize);
+            size_t total = r.signatureBytes + r.opsBytes;
+            printf("%-20s %6zu %9zu %9zu %9zu %8zu %6.1f%%%s\n",
+                   edit.name, blockSize, r.signatureBytes, r.opsBytes, total,
+                   edit.next.size(), 100.0 * (1.0 - (double)total / edit.next.size()),
+                   r.verified ? "" : "  VERIFY FAILED");
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        return runBench(argc >= 3 ? argv[2] : nullptr);
+    }
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <old> <new> [block_size] [-o frames.bin]\n"
+                        "       %s --bench [script.lua]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    size_t blockSize = DeltaSync::DEFAULT_BLOCK_SIZE;
+    const char *outPath = nullptr;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else {
+            blockSize = strtoul(argv[i], nullptr, 10);
+        }
+    }
+    if (blockSize < DeltaSync::MIN_BLOCK_SIZE || blockSize > DeltaSync::MAX_BLOCK_SIZE) {
+        fprintf(stderr, "block_size must be %zu..%zu\n", DeltaSync::MIN_BLOCK_SIZE, DeltaSync::MAX_BLOCK_SIZE);
+        return 1;
+    }
+
+    Bytes base, next;
+    if (!readFile(argv[1], base) || !readFile(argv[2], next)) {
+        fprintf(stderr, "Cannot read input files\n");
+        return 1;
+    }
+
+    std::vector<Bytes> frames;
+    DeltaResult r = runDelta(base, next, blockSize, &frames);
+
+    printf("block_size:     %zu\n", blockSize);
+    printf("new size:       %zu (crc 0x%08X)\n", next.size(), crc32(next.data(), next.size()));
+    printf("copied:         %zu bytes\n", r.copiedBytes);
+    printf("literal:        %zu bytes\n", r.literalBytes);
+    printf("signature:      %zu bytes\n", r.signatureBytes);
+    printf("ops:            %zu bytes in %zu frames\n", r.opsBytes, r.frames);
+    printf("total:          %zu bytes vs %zu full upload (%.1f%% saved)\n",
+           r.signatureBytes + r.opsBytes, next.size(),
+           100.0 * (1.0 - (double)(r.signatureBytes + r.opsBytes) / std::max<size_t>(next.size(), 1)));
+    printf("verified:       %s\n", r.verified ? "yes" : "NO");
+
+    if (outPath) {
+        FILE *f = fopen(outPath, "wb");
+        if (!f) {
+            fprintf(stderr, "Cannot write %s\n", outPath);
+            return 1;
+        }
+        for (const Bytes &frame : frames) {
+            uint8_t header[2] = { (uint8_t)(frame.size() & 0xFF), (uint8_t)(frame.size() >> 8) };
+            fwrite(header, 1, 2, f);
+            fwrite(frame.data(), 1, frame.size(), f);
+        }
+        fclose(f);
+    }
+
+    return r.verified ? 0 : 1;
+}
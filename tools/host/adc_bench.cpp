@@ -0,0 +1,143 @@
+// ═══════════════════════════════════════════════════════
+// ADC BENCH (host side, ADC_HOST_MOCK)
+// ═══════════════════════════════════════════════════════
+//
+// Checks that blocks taken from the ring carry the mock samples their seq
+// says they do, then times reading samples from Lua: an analogRead() loop,
+// adc.read(buf) + buf:stats(), and adc.read(buf) with a buf[i] loop. The
+// shim's analogRead() costs no conversion, unlike the chip's. Last, a
+// stream=true capture at 20 kHz into a 20 ms-per-event link must drop
+// whole blocks rather than slow the capture task.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_adc/adc_capture.h"
+#include "lua_modules/lua_adc/adc_backend.h"
+#include "lua_modules/lua_adc/lua_adc.h"
+
+#include <math.h>
+
+static const int BENCH_SAMPLES = 4000000;
+
+// Sample n of the mock source (adc_backend_read)
+static uint16_t mockSample(uint32_t n, uint32_t rate) {
+    const float TWO_PI_F = 6.2831853f;
+    float phase = TWO_PI_F * AdcMock::frequency * (float)n / (float)rate;
+    return (uint16_t)(2048.0f + 1500.0f * sinf(phase) + (float)(n % 256));
+}
+
+static void testContinuity() {
+    AdcMock::realtime = false;
+    AdcCaptureConfig config = { 34, 20000, 256, 8, false };
+    CHECK(adc_capture_start(config));
+
+    uint32_t lastSeq = 0;
+    uint32_t gaps = 0;
+    int mismatched = 0;
+    for (int i = 0; i < 200; i++) {
+        const AdcBlock *block = adc_capture_take(1000);
+        CHECK(block != NULL);
+        if (!block) break;
+
+        CHECK_EQ(block->count, 256);
+        for (uint16_t k = 0; k < block->count; k++) {
+            int expected = mockSample(block->seq * 256 + k, 20000);
+            if (abs((int)block->samples[k] - expected) > 1) mismatched++;
+        }
+        if (i > 0) {
+            CHECK(block->seq > lastSeq);
+            gaps += block->seq - lastSeq - 1;
+        }
+        lastSeq = block->seq;
+        adc_capture_release(block);
+    }
+    AdcCaptureStats stats = adc_capture_stats();
+    adc_capture_stop();
+
+    // Every seq skipped was recycled (or never had a free block) and counted
+    CHECK_EQ(mismatched, 0);
+    CHECK(gaps <= stats.dropped);
+    AdcMock::realtime = true;
+}
+
+// Runs `code` and prints Msamples/s for BENCH_SAMPLES samples
+static void bench(lua_State *L, const char *name, const char *code) {
+    double start = Host::seconds();
+    Host::runLua(L, code);
+    double elapsed = Host::seconds() - start;
+    printf("  %-28s %6.1f Msamples/s\n", name, BENCH_SAMPLES / elapsed / 1e6);
+}
+
+static void benchLua(lua_State *L) {
+    char code[64];
+    snprintf(code, sizeof(code), "N = %d", BENCH_SAMPLES);
+    Host::runLua(L, code);
+
+    AdcMock::realtime = false;
+    Host::runLua(L, "adc.start{pin = 34, rate = 200000, block = 256, blocks = 8}");
+
+    printf("samples consumed from Lua:\n");
+    bench(L, "analogRead() loop",
+          "local sum = 0\n"
+          "for i = 1, N do sum = sum + analogRead(34) end\n");
+    bench(L, "adc.read(buf) + buf:stats()",
+          "local buf, n, sum = nil, 0, 0\n"
+          "while n < N do\n"
+          "  buf = adc.read(100, buf)\n"
+          "  local lo, hi, mean = buf:stats()\n"
+          "  sum, n = sum + mean * #buf, n + #buf\n"
+          "end\n");
+    bench(L, "adc.read(buf) + buf[i] loop",
+          "local buf, n, sum = nil, 0, 0\n"
+          "while n < N do\n"
+          "  buf = adc.read(100, buf)\n"
+          "  for i = 1, #buf do sum = sum + buf[i] end\n"
+          "  n = n + #buf\n"
+          "end\n");
+
+    // A timeout hands the buffer back to the GC and returns nil
+    Host::runLua(L,
+        "local buf = adc.read(100)\n"
+        "adc.stop()\n"
+        "assert(adc.read(1) == nil and adc.read(1, buf) == nil)\n");
+    AdcMock::realtime = true;
+}
+
+static void testStream() {
+    Host::events = 0;
+    Host::eventDelayUs = 20000;
+
+    AdcCaptureConfig config = { 34, 20000, 256, 8, true };
+    CHECK(adc_capture_start(config));
+    delay(1280);
+    AdcCaptureStats stats = adc_capture_stats();
+    adc_capture_stop();
+    Host::eventDelayUs = 0;
+
+    // 256 samples go out as two events
+    uint32_t streamed = Host::events / 2;
+    printf("stream, 20 kHz into a 20 ms/event link: %u blocks captured, %u dropped, %u streamed\n",
+           (unsigned)stats.blocks, (unsigned)stats.dropped, (unsigned)streamed);
+
+    // The capture task kept its pace (100 blocks in 1.28 s) and dropped the rest
+    CHECK(stats.blocks >= 80);
+    CHECK(stats.dropped > 0);
+    CHECK(streamed + stats.dropped <= stats.blocks);
+    CHECK(streamed + stats.dropped + stats.queued + 2 >= stats.blocks);
+}
+
+int main() {
+    testContinuity();
+
+    lua_State *L = Host::openLua();
+    lua_adc_register(L);
+    benchLua(L);
+    lua_adc_cleanup();
+    lua_close(L);
+
+    testStream();
+    return host_check_result("adc_bench");
+}
@@ -0,0 +1,221 @@
+// ═══════════════════════════════════════════════════════
+// CHUNK WINDOW LOOPBACK TEST (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Runs file_chunk uploads through a lossy link: a sender that only resends
+// the holes a file_chunk_ack reports, and the device's ChunkWindow committing
+// into a plain buffer. The link drops, duplicates, reorders and truncates
+// frames, and every run must rebuild the stream byte for byte.
+//
+// Build and run:
+//   make -C tools/host check
+
+#include "host.h"
+#include "core/utils/chunk_window.h"
+
+#include <deque>
+
+typedef std::vector<uint8_t> Bytes;
+
+struct Frame {
+    uint32_t offset;
+    Bytes payload;
+};
+
+// Receiving side of handleFileChunk/commitWindow, minus the flash writes
+struct Receiver {
+    ChunkWindow window;
+    Bytes slotData;
+    Bytes committed;
+    uint32_t dropped = 0;
+
+    Receiver(uint8_t slots, size_t chunkSize, uint32_t total) : slotData(slots * chunkSize) {
+        window.reset(slots, chunkSize, 0, total);
+    }
+
+    void receive(const Frame &f) {
+        size_t slot = 0;
+        ChunkPlacement placement = window.place(f.offset, f.payload.size(), &slot);
+        if (placement == CHUNK_REJECTED) {
+            dropped++;
+            return;
+        }
+        if (placement == CHUNK_PLACED) {
+            memcpy(&slotData[slot * window.chunkSize], f.payload.data(), f.payload.size());
+        }
+        while (window.ready()) {
+            const uint8_t *chunk = &slotData[window.headSlot() * window.chunkSize];
+            committed.insert(committed.end(), chunk, chunk + window.headLength());
+            window.advance();
+        }
+    }
+};
+
+struct LinkProfile {
+    const char *name;
+    int dropPct;
+    int duplicatePct;
+    int reorderPct;
+    int truncatePct;
+};
+
+static Bytes makeData(size_t size) {
+    Bytes data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)(rand() >> 4);
+    }
+    return data;
+}
+
+// Send `data` through `link` until the receiver's base reaches the end.
+// Returns the number of ack round trips, or -1 when the upload stalls.
+static int upload(const Bytes &data, uint8_t slots, size_t chunkSize, const LinkProfile &link,
+                  Receiver &rx) {
+    uint32_t total = data.size();
+    uint32_t ackBase = 0;
+    uint32_t ackBitmap = 0;
+
+    for (int round = 1; round <= 10000; round++) {
+        // Every chunk of the window the last ack did not report as received.
+        // Chunks keep their file offsets, like a sender with frames already queued.
+        std::deque<Frame> inFlight;
+        uint32_t first = ackBase / chunkSize;
+        for (uint32_t k = first; k < first + slots; k++) {
+            uint32_t offset = k * chunkSize;
+            if (offset >= total) {
+                break;
+            }
+            if (offset < ackBase || (offset - ackBase) % chunkSize != 0 ||
+                (ackBitmap & (1u << ((offset - ackBase) / chunkSize)))) {
+                continue;
+            }
+            size_t len = std::min((size_t)(total - offset), chunkSize);
+            Frame f = { offset, Bytes(data.begin() + offset, data.begin() + offset + len) };
+
+            if (rand() % 100 < link.truncatePct && len > 1) {
+                f.payload.resize(1 + rand() % (len - 1));
+            }
+            if (rand() % 100 < link.dropPct) {
+                continue;
+            }
+            if (rand() % 100 < link.duplicatePct) {
+                inFlight.push_back(f);
+            }
+            if (!inFlight.empty() && rand() % 100 < link.reorderPct) {
+                inFlight.push_front(f);
+            } else {
+                inFlight.push_back(f);
+            }
+        }
+
+        for (const Frame &f : inFlight) {
+            rx.receive(f);
+        }
+
+        // file_chunk_ack
+        ackBase = rx.window.base;
+        ackBitmap = rx.window.bitmap;
+        if (ackBase >= total) {
+            return round;
+        }
+    }
+    return -1;
+}
+
+static void testLink(const LinkProfile &link) {
+    srand(51);
+    for (int run = 0; run < 50; run++) {
+        uint8_t slots = 1 + rand() % ChunkWindow::MAX_SLOTS;
+        size_t chunkSize = 16 << (rand() % 6);
+        Bytes data = makeData(1 + rand() % 40000);
+
+        Receiver rx(slots, chunkSize, data.size());
+        int rounds = upload(data, slots, chunkSize, link, rx);
+
+        CHECK(rounds > 0);
+        CHECK(rx.committed == data);
+        CHECK_EQ(rx.window.bitmap, 0);
+        if (link.truncatePct == 0) {
+            CHECK_EQ(rx.dropped, 0);
+        }
+        if (rounds <= 0 || rx.committed != data) {
+            printf("  %s run %d: %u bytes, %u x %u\n", link.name, run, (unsigned)data.size(),
+                   slots, (unsigned)chunkSize);
+            return;
+        }
+    }
+    printf("%-10s 50 uploads ok\n", link.name);
+}
+
+// A truncated frame mid-stream is dropped, and the resent chunk still fits
+static void testShortChunkMidStream() {
+    Receiver rx(4, 64, 1000);
+    Bytes chunk(64, 0xAA);
+
+    rx.receive({ 0, Bytes(chunk.begin(), chunk.begin() + 20) });
+    CHECK_EQ(rx.window.base, 0);
+    CHECK_EQ(rx.dropped, 1);
+
+    rx.receive({ 0, chunk });
+    rx.receive({ 64, chunk });
+    CHECK_EQ(rx.window.base, 128);
+    CHECK_EQ(rx.window.bitmap, 0);
+}
+
+static void testStreamEnd() {
+    size_t slot = 0;
+
+    // 1000 = 15 x 64 + 40: only the 40-byte chunk at 960 may be short
+    ChunkWindow w;
+    w.reset(32, 64, 0, 1000);
+    CHECK_EQ(w.place(960, 40, &slot), CHUNK_PLACED);
+    CHECK_EQ(w.place(896, 63, &slot), CHUNK_REJECTED);
+    CHECK_EQ(w.place(960, 40, &slot), CHUNK_DUPLICATE);
+
+    // Nothing may run past the declared end
+    w.reset(32, 64, 0, 1000);
+    CHECK_EQ(w.place(960, 64, &slot), CHUNK_REJECTED);
+    CHECK_EQ(w.place(1024, 64, &slot), CHUNK_REJECTED);
+
+    // Unknown size: full chunks only
+    w.reset(32, 64, 0, 0);
+    CHECK_EQ(w.place(0, 64, &slot), CHUNK_PLACED);
+    CHECK_EQ(w.place(64, 10, &slot), CHUNK_REJECTED);
+}
+
+static void testPlacement() {
+    size_t slot = 0;
+    ChunkWindow w;
+    w.reset(8, 100, 1000, 0);
+
+    CHECK_EQ(w.place(900, 100, &slot), CHUNK_COMMITTED);
+    CHECK_EQ(w.place(1050, 100, &slot), CHUNK_REJECTED);
+    CHECK_EQ(w.place(1800, 100, &slot), CHUNK_REJECTED);
+    CHECK_EQ(w.place(1000, 101, &slot), CHUNK_REJECTED);
+    CHECK_EQ(w.place(1000, 0, &slot), CHUNK_REJECTED);
+
+    CHECK_EQ(w.place(1700, 100, &slot), CHUNK_PLACED);
+    CHECK_EQ(slot, 17 % 8);
+    CHECK(w.blocked());
+    CHECK(!w.ready());
+    CHECK_EQ(w.place(1700, 100, &slot), CHUNK_DUPLICATE);
+    CHECK_EQ(w.pending(), 1);
+}
+
+int main() {
+    testPlacement();
+    testStreamEnd();
+    testShortChunkMidStream();
+
+    const LinkProfile links[] = {
+        { "clean",     0,  0,  0,  0 },
+        { "lossy",     20, 0,  0,  0 },
+        { "shuffled",  5,  10, 40, 0 },
+        { "truncating", 5, 5,  20, 10 },
+    };
+    for (const LinkProfile &link : links) {
+        testLink(link);
+    }
+
+    return host_check_result("chunk_window_test");
+}
@@ -0,0 +1,129 @@
+// ═══════════════════════════════════════════════════════
+// DELAY BENCH (host side)
+// ═══════════════════════════════════════════════════════
+//
+// A thread injects an event every 7.3 ms while the script sleeps; latency
+// is measured to its eventmsg.on callback with delay(100) blocking (a
+// coroutine the scheduler does not own, eventmsg.update() afterwards),
+// delay(100) scheduling, and delayMicroseconds(50000) scheduling. Then four
+// spawn() tasks loop on delay(10) for 600 ms, and spawned tasks left when
+// the chunk returns must be run to the end by arduino_scheduler_drain().
+// Latency includes host thread wake-up.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_arduino/lua_arduino.h"
+
+#include <atomic>
+#include <thread>
+
+static int luaInt(lua_State *L, const char *global) {
+    lua_getglobal(L, global);
+    int value = (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    return value;
+}
+
+// Runs `wait` (one sleep of the script) until 1.2 s have passed, with a
+// "ping" carrying micros() every 7.3 ms; returns the average latency in us
+static int eventLatency(lua_State *L, const char *name, const char *wait) {
+    Host::runLua(L,
+        "lat = {}\n"
+        "eventmsg.on('ping', function(sent) lat[#lat + 1] = micros() - tonumber(sent) end)\n");
+
+    std::atomic<bool> stop(false);
+    std::thread injector([&]() {
+        while (!stop) {
+            delayMicroseconds(7300);
+            String sent((unsigned long)micros());
+            Host::deliver("ping", std::vector<uint8_t>(sent.c_str(), sent.c_str() + sent.length()));
+        }
+    });
+
+    lua_pushstring(L, wait);
+    lua_setglobal(L, "wait_code");
+    Host::runLua(L,
+        "local wait = load(wait_code)\n"
+        "local deadline = millis() + 1200\n"
+        "while millis() < deadline do wait() end\n");
+    stop = true;
+    injector.join();
+
+    Host::runLua(L,
+        "eventmsg.off('ping')\n"
+        "received = #lat\n"
+        "table.sort(lat)\n"
+        "local sum = 0\n"
+        "for i = 1, #lat do sum = sum + lat[i] end\n"
+        "avg, max = sum // math.max(#lat, 1), lat[#lat] or 0\n");
+    int avg = luaInt(L, "avg");
+    printf("  %-44s avg %6d us  max %6d us  (%d events)\n", name, avg, luaInt(L, "max"),
+           luaInt(L, "received"));
+    CHECK(luaInt(L, "received") > 100);
+    return avg;
+}
+
+static void benchEvents(lua_State *L) {
+    printf("event every 7.3 ms, latency to the Lua callback:\n");
+    int blocking = eventLatency(L, "delay(100) blocking, eventmsg.update() after",
+                                "coroutine.wrap(function() delay(100) end)()\n"
+                                "eventmsg.update(false, 0, 16)\n");
+    int scheduled = eventLatency(L, "delay(100) scheduling", "delay(100)");
+    int micro = eventLatency(L, "delayMicroseconds(50000) scheduling", "delayMicroseconds(50000)");
+
+    CHECK(blocking > 20000);
+    CHECK(scheduled < blocking / 10);
+    CHECK(micro < blocking / 10);
+}
+
+static void benchTasks(lua_State *L) {
+    Host::runLua(L,
+        "wakes, late = 0, {}\n"
+        "for t = 1, 4 do\n"
+        "  spawn(function()\n"
+        "    while true do\n"
+        "      local due = micros() + 10000\n"
+        "      delay(10)\n"
+        "      wakes = wakes + 1\n"
+        "      late[#late + 1] = micros() - due\n"
+        "    end\n"
+        "  end)\n"
+        "end\n"
+        "delay(600)\n"
+        "table.sort(late)\n"
+        "p50, max = late[#late // 2 + 1], late[#late]\n");
+    int wakes = luaInt(L, "wakes");
+    printf("four tasks on delay(10): %d wakes in 600 ms, lateness p50 %d us, max %d us\n",
+           wakes, luaInt(L, "p50"), luaInt(L, "max"));
+    CHECK(wakes >= 150);
+}
+
+static void testDrain() {
+    // A fresh state: the endless tasks above would keep a drain going
+    lua_State *L = Host::openLua();
+    Host::runLua(L,
+        "done = 0\n"
+        "for t = 1, 3 do\n"
+        "  spawn(function() for k = 1, 5 do delay(5) done = done + 1 end end)\n"
+        "end\n");
+    CHECK_EQ(luaInt(L, "done"), 0);
+
+    // What the engine does once the chunk returns
+    lua_pushcfunction(L, arduino_scheduler_drain);
+    CHECK_EQ(lua_pcall(L, 0, 0, 0), LUA_OK);
+    CHECK_EQ(luaInt(L, "done"), 15);
+    lua_close(L);
+}
+
+int main() {
+    lua_State *L = Host::openLua();
+    benchEvents(L);
+    benchTasks(L);
+    lua_close(L);
+
+    testDrain();
+    return host_check_result("delay_bench");
+}
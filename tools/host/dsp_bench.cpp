@@ -0,0 +1,214 @@
+// ═══════════════════════════════════════════════════════
+// DSP BENCH (host side, ADC_HOST_MOCK)
+// ═══════════════════════════════════════════════════════
+//
+// Per-stage throughput of dsp_pipeline_process() in 256-sample chunks, the
+// fir16 + decimate4 + rms64 chain written element by element in Lua against
+// p:process(), and the same chain started on the mock ADC end to end.
+// Checks that chunking does not change a pipeline's output.
+//
+// Kernels build at O3 under GCC whatever the file's level (DSP_KERNEL), so
+// `make bench CXXFLAGS=...` only moves the glue around them.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_adc/adc_capture.h"
+#include "lua_modules/lua_adc/adc_backend.h"
+#include "lua_modules/lua_adc/lua_adc.h"
+#include "lua_modules/lua_dsp/dsp_pipeline.h"
+#include "lua_modules/lua_dsp/lua_dsp.h"
+
+#include <math.h>
+
+static const size_t CHUNK = 256;
+static const size_t STAGE_SAMPLES = 1 << 24;
+static const float PI_F = 3.14159265f;
+
+static float taps[64];
+
+static DspStageConfig stage(DspStageType type, uint16_t length) {
+    DspStageConfig s = {};
+    s.type = type;
+    s.length = length;
+    s.taps = taps;
+    return s;
+}
+
+// Sine plus a slow ramp, 12-bit range like the ADC
+static std::vector<float> makeSignal(size_t n) {
+    std::vector<float> x(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = 2048.0f + 1500.0f * sinf(2.0f * PI_F * 50.0f * (float)i / 20000.0f) + (float)(i % 256);
+    }
+    return x;
+}
+
+// Msamples/s of `pipeline` over STAGE_SAMPLES input samples
+static double stageRate(DspPipeline *pipeline, const std::vector<float> &signal) {
+    float chunk[CHUNK];
+    float sink = 0.0f;
+    double start = Host::seconds();
+    for (size_t done = 0; done < STAGE_SAMPLES; done += CHUNK) {
+        memcpy(chunk, &signal[done % signal.size()], sizeof(chunk));
+        size_t n = dsp_pipeline_process(pipeline, chunk, CHUNK);
+        if (n) sink += chunk[0];
+    }
+    double elapsed = Host::seconds() - start;
+    CHECK(sink == sink);        // Keeps the results live
+    return STAGE_SAMPLES / elapsed / 1e6;
+}
+
+static void benchStages(const std::vector<float> &signal) {
+    DspStageConfig scale = stage(DSP_STAGE_SCALE, 0);
+    scale.params[0] = 0.5f;
+    scale.params[1] = -1024.0f;
+    DspStageConfig biquad = stage(DSP_STAGE_IIR, 0);
+    const float lowpass[5] = { 0.0675f, 0.1349f, 0.0675f, -1.1430f, 0.4128f };
+    memcpy(biquad.params, lowpass, sizeof(lowpass));
+
+    struct { const char *name; DspStageConfig config; } stages[] = {
+        { "scale",     scale },
+        { "fir16",     stage(DSP_STAGE_FIR, 16) },
+        { "fir64",     stage(DSP_STAGE_FIR, 64) },
+        { "biquad",    biquad },
+        { "avg32",     stage(DSP_STAGE_AVG, 32) },
+        { "decimate4", stage(DSP_STAGE_DECIMATE, 4) },
+        { "rms64",     stage(DSP_STAGE_RMS, 64) },
+        { "peak64",    stage(DSP_STAGE_PEAK, 64) },
+    };
+
+    printf("per stage, %u-sample chunks:\n", (unsigned)CHUNK);
+    for (auto &s : stages) {
+        DspPipeline *pipeline = dsp_pipeline_create(&s.config, 1, CHUNK);
+        CHECK(pipeline != NULL);
+        if (!pipeline) continue;
+        printf("  %-10s %8.1f Msamples/s\n", s.name, stageRate(pipeline, signal));
+        dsp_pipeline_destroy(pipeline);
+    }
+}
+
+// Output of the chain for `signal` fed in chunks of `block`
+static std::vector<float> runChain(const std::vector<float> &signal, uint16_t block) {
+    DspStageConfig chain[] = {
+        stage(DSP_STAGE_FIR, 16), stage(DSP_STAGE_DECIMATE, 4), stage(DSP_STAGE_RMS, 64)
+    };
+    DspPipeline *pipeline = dsp_pipeline_create(chain, 3, block);
+    std::vector<float> out;
+    std::vector<float> chunk(block);
+    for (size_t offset = 0; offset < signal.size(); offset += block) {
+        size_t n = std::min(signal.size() - offset, (size_t)block);
+        memcpy(chunk.data(), &signal[offset], n * sizeof(float));
+        n = dsp_pipeline_process(pipeline, chunk.data(), n);
+        out.insert(out.end(), chunk.begin(), chunk.begin() + n);
+    }
+    dsp_pipeline_destroy(pipeline);
+    return out;
+}
+
+static void testChunking() {
+    std::vector<float> signal = makeSignal(20000);
+    std::vector<float> whole = runChain(signal, 4096);
+    std::vector<float> pieces = runChain(signal, 37);
+
+    CHECK_EQ(whole.size(), 20000 / 4 / 64);
+    CHECK_EQ(pieces.size(), whole.size());
+    for (size_t i = 0; i < whole.size() && i < pieces.size(); i++) {
+        // rms sums in partial sums, so only rounding may differ
+        if (fabsf(whole[i] - pieces[i]) > whole[i] * 1e-4f) {
+            CHECK(fabsf(whole[i] - pieces[i]) <= whole[i] * 1e-4f);
+            break;
+        }
+    }
+}
+
+static void benchLua(lua_State *L) {
+    const int SAMPLES = 1 << 16;
+    char code[128];
+    snprintf(code, sizeof(code), "samples = {} for i = 1, %d do samples[i] = 2048 + (i * 37) %% 1500 end", SAMPLES);
+    Host::runLua(L,
+        "h = {} for k = 1, 16 do h[k] = 1 / 16 end\n"
+        "p = dsp.pipeline({dsp.fir(h), dsp.decimate(4), dsp.rms(64)})\n");
+    Host::runLua(L, code);
+
+    double start = Host::seconds();
+    Host::runLua(L,
+        "local hist, out, phase, acc, count = {}, {}, 0, 0, 0\n"
+        "for k = 1, 15 do hist[k] = 0 end\n"
+        "for i = 1, #samples do\n"
+        "  hist[#hist + 1] = samples[i]\n"
+        "  local y = 0\n"
+        "  for k = 1, 16 do y = y + h[k] * hist[#hist - k + 1] end\n"
+        "  table.remove(hist, 1)\n"
+        "  if phase == 0 then\n"
+        "    acc, count = acc + y * y, count + 1\n"
+        "    if count == 64 then out[#out + 1] = math.sqrt(acc / 64); acc, count = 0, 0 end\n"
+        "  end\n"
+        "  phase = (phase + 1) % 4\n"
+        "end\n"
+        "lua_out = #out\n");
+    double element = Host::seconds() - start;
+
+    start = Host::seconds();
+    Host::runLua(L, "native_out = #p:process(samples)");
+    double native = Host::seconds() - start;
+
+    Host::runLua(L, "assert(lua_out == native_out)");
+    printf("fir16 + decimate4 + rms64 from Lua:\n");
+    printf("  element by element  %8.1f Msamples/s\n", SAMPLES / element / 1e6);
+    printf("  p:process(table)    %8.1f Msamples/s\n", SAMPLES / native / 1e6);
+}
+
+// The chain as the ADC consumer, mock source running flat out
+static void benchAdc() {
+    AdcMock::realtime = false;
+    AdcCaptureConfig config = { 34, AdcConfig::MAX_RATE, 256, 8, false };
+    CHECK(adc_capture_start(config));
+
+    DspStageConfig chain[] = {
+        stage(DSP_STAGE_FIR, 16), stage(DSP_STAGE_DECIMATE, 4), stage(DSP_STAGE_RMS, 64)
+    };
+    DspPipeline *pipeline = dsp_pipeline_create(chain, 3, 256);
+    CHECK(dsp_pipeline_start(pipeline, NULL));
+
+    // Results are read as they come, like p:read() in a loop
+    double start = Host::seconds();
+    while (Host::seconds() - start < 1.0) {
+        const DspResult *result = dsp_pipeline_take(pipeline, 10);
+        if (result) dsp_pipeline_release(pipeline, result);
+    }
+    DspPipelineStats stats = dsp_pipeline_stats(pipeline);
+    AdcCaptureStats capture = adc_capture_stats();
+    double elapsed = Host::seconds() - start;
+
+    adc_capture_stop();
+    CHECK(!dsp_pipeline_stats(pipeline).running);
+    dsp_pipeline_destroy(pipeline);
+    AdcMock::realtime = true;
+
+    printf("mock ADC -> pipeline task: %.1f Msamples/s, %u of %u blocks dropped at the ring\n",
+           stats.blocks * 256.0 / elapsed / 1e6, (unsigned)capture.dropped, (unsigned)capture.blocks);
+}
+
+int main() {
+    for (size_t k = 0; k < 64; k++) {
+        taps[k] = 1.0f / 64;
+    }
+    std::vector<float> signal = makeSignal(CHUNK * 64);
+
+    testChunking();
+    benchStages(signal);
+
+    lua_State *L = Host::openLua();
+    lua_adc_register(L);
+    lua_dsp_register(L);
+    benchLua(L);
+    lua_dsp_cleanup();
+    lua_adc_cleanup();
+    lua_close(L);
+
+    benchAdc();
+    return host_check_result("dsp_bench");
+}
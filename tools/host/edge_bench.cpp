@@ -0,0 +1,165 @@
+// ═══════════════════════════════════════════════════════
+// EDGE BENCH (host side, GPIO_HOST_MOCK)
+// ═══════════════════════════════════════════════════════
+//
+// A std::thread stands in for the GPIO interrupt and calls the ISR that
+// gpio.attach() left in GpioMock::isr, while the script waits in delay().
+// Measures ISR-to-handler latency for spaced edges, checks that a burst,
+// debouncing and a refused re-attach behave, and reports saturated handler
+// and count-only throughput. Latency here includes host thread wake-up,
+// which the chip's FreeRTOS scheduler does not pay.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_gpio/lua_gpio.h"
+#include "lua_modules/lua_gpio/gpio_backend.h"
+#include "lua_modules/lua_gpio/gpio_edges.h"
+
+#include <algorithm>
+#include <thread>
+
+static const uint8_t PIN = 5;
+
+// `count` rising edges on PIN, `gap_us` apart (0 = back to back)
+static std::thread fireEdges(uint8_t pin, int count, uint32_t gap_us) {
+    return std::thread([=]() {
+        for (int i = 0; i < count; i++) {
+            if (gap_us) delayMicroseconds(gap_us);
+            GpioMock::in |= 1ull << pin;
+            if (GpioMock::isr[pin]) GpioMock::isr[pin](GpioMock::isr_arg[pin]);
+        }
+    });
+}
+
+static int luaInt(lua_State *L, const char *global) {
+    lua_getglobal(L, global);
+    int value = (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    return value;
+}
+
+static void benchLatency(lua_State *L) {
+    const int EDGES = 400;
+    Host::runLua(L,
+        "lat = {}\n"
+        "gpio.attach(5, gpio.RISING, function(pin, level, t)\n"
+        "  assert(pin == 5 and level == 1)\n"
+        "  lat[#lat + 1] = micros() - t\n"
+        "end)\n");
+
+    std::thread isr = fireEdges(PIN, EDGES, 1300);
+    Host::runLua(L,
+        "local deadline = millis() + 2000\n"
+        "while #lat < 400 and millis() < deadline do delay(10) end\n"
+        "received = #lat\n"
+        "table.sort(lat)\n"
+        "local sum = 0\n"
+        "for i = 1, #lat do sum = sum + lat[i] end\n"
+        "avg, p50, max = sum // math.max(#lat, 1), lat[#lat // 2 + 1] or 0, lat[#lat] or 0\n");
+    isr.join();
+
+    CHECK_EQ(luaInt(L, "received"), EDGES);
+    printf("edge every 1.3 ms, script in delay(): ISR->handler avg %d us, p50 %d us, max %d us\n",
+           luaInt(L, "avg"), luaInt(L, "p50"), luaInt(L, "max"));
+}
+
+static void testBurst(lua_State *L) {
+    Host::runLua(L, "calls = 0\ngpio.attach(5, gpio.RISING, function() calls = calls + 1 end)");
+
+    std::thread isr = fireEdges(PIN, 200, 0);
+    isr.join();
+    Host::runLua(L,
+        "local deadline = millis() + 1000\n"
+        "while calls < 200 and millis() < deadline do delay(10) end\n"
+        "dropped = gpio.edge_stats().dropped\n"
+        "counted = gpio.count(5)\n");
+
+    CHECK_EQ(luaInt(L, "calls"), 200);
+    CHECK_EQ(luaInt(L, "counted"), 200);
+    CHECK_EQ(luaInt(L, "dropped"), 0);
+    printf("burst of 200 edges: %d delivered, %d dropped\n", luaInt(L, "calls"), luaInt(L, "dropped"));
+}
+
+static void testDebounce(lua_State *L) {
+    // Ten back-to-back edges count once against a 5 ms debounce; one more
+    // after the window counts again
+    Host::runLua(L, "gpio.attach(6, gpio.RISING, nil, 5000)");
+    for (int i = 0; i < 10; i++) {
+        GpioMock::isr[6](GpioMock::isr_arg[6]);
+    }
+    delay(6);
+    GpioMock::isr[6](GpioMock::isr_arg[6]);
+    Host::runLua(L, "debounced = gpio.count(6)");
+    CHECK_EQ(luaInt(L, "debounced"), 2);
+}
+
+static void testRefusedAttach(lua_State *L) {
+    // A bad mode is refused before the pin's current handler is dropped
+    Host::runLua(L,
+        "calls = 0\ngpio.attach(5, gpio.RISING, function() calls = calls + 1 end)\n"
+        "refused = not pcall(gpio.attach, 5, 99, function() calls = calls + 100 end)\n");
+    GpioMock::isr[5](GpioMock::isr_arg[5]);
+    Host::runLua(L, "gpio.update()\nrefused = refused and 1 or 0");
+    CHECK_EQ(luaInt(L, "refused"), 1);
+    CHECK_EQ(luaInt(L, "calls"), 1);
+}
+
+// fire_edges(pin, n): n ISR calls from the Lua task itself
+static int l_fire_edges(lua_State *L) {
+    int pin = (int)luaL_checkinteger(L, 1);
+    int n = (int)luaL_checkinteger(L, 2);
+    for (int i = 0; i < n; i++) {
+        GpioMock::isr[pin](GpioMock::isr_arg[pin]);
+    }
+    return 0;
+}
+
+static void benchSaturated(lua_State *L) {
+    // Handler calls: fill the whole ring, drain it, repeat. Firing from the
+    // Lua task keeps the figure independent of how many host cores there are
+    lua_register(L, "fire_edges", l_fire_edges);
+    Host::runLua(L, "calls = 0\ngpio.attach(5, gpio.RISING, function() calls = calls + 1 end)");
+    double start = Host::seconds();
+    Host::runLua(L,
+        "for round = 1, 2000 do\n"
+        "  fire_edges(5, 256)\n"
+        "  gpio.update()\n"
+        "end\n"
+        "dropped = gpio.edge_stats().dropped\n");
+    double elapsed = Host::seconds() - start;
+    CHECK_EQ(luaInt(L, "calls"), 2000 * 256);
+    CHECK_EQ(luaInt(L, "dropped"), 0);
+    double handlers = luaInt(L, "calls") / elapsed / 1e6;
+
+    // Count only: the ISR alone
+    Host::runLua(L, "gpio.attach(7, gpio.RISING, nil)");
+    const int EDGES = 5000000;
+    start = Host::seconds();
+    for (int i = 0; i < EDGES; i++) {
+        GpioMock::isr[7](GpioMock::isr_arg[7]);
+    }
+    elapsed = Host::seconds() - start;
+    Host::runLua(L, "counted = gpio.count(7)");
+    CHECK_EQ(luaInt(L, "counted"), EDGES);
+
+    printf("saturated: %.2f M Lua handler calls/s; count-only %.1f M edges/s\n",
+           handlers, EDGES / elapsed / 1e6);
+}
+
+int main() {
+    lua_State *L = Host::openLua();
+    lua_gpio_register(L);
+
+    benchLatency(L);
+    testBurst(L);
+    testDebounce(L);
+    testRefusedAttach(L);
+    benchSaturated(L);
+
+    lua_gpio_cleanup();
+    lua_close(L);
+    return host_check_result("edge_bench");
+}
@@ -0,0 +1,163 @@
+// ═══════════════════════════════════════════════════════
+// GPIO BENCH (host side, GPIO_HOST_MOCK)
+// ═══════════════════════════════════════════════════════
+//
+// Checks what the gpio module stores into GpioMock::out for masks and
+// groups, then times three ways of driving an 8-bit bus from Lua:
+// digitalWrite() per pin, gpio.write_mask() with a mask built in Lua, and a
+// precompiled group:write(). The shim's digitalWrite() is a no-op, so its
+// figure is the Lua call overhead alone; on the chip each call also goes
+// through the Arduino pin driver.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_gpio/lua_gpio.h"
+#include "lua_modules/lua_gpio/gpio_backend.h"
+
+static const int BENCH_WRITES = 200000;
+
+// Bus pins in value bit order; out of order on purpose
+static const char *BUS_SETUP =
+    "pins = {4, 5, 18, 19, 21, 22, 23, 25}\n"
+    "bus = gpio.group(pins)\n";
+
+// GpioMock::out bits a bus value should leave set
+static uint64_t busBits(uint32_t value) {
+    static const uint8_t pins[] = { 4, 5, 18, 19, 21, 22, 23, 25 };
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+        if (value & (1u << i)) bits |= 1ull << pins[i];
+    }
+    return bits;
+}
+
+static uint64_t busMask() {
+    return busBits(0xFF);
+}
+
+static void testWriteMask(lua_State *L) {
+    GpioMock::out = 0;
+    Host::runLua(L, "gpio.write_mask(0x0F, 0)");
+    CHECK_EQ(GpioMock::out, 0x0F);
+
+    // Set and clear in one call
+    Host::runLua(L, "gpio.write_mask(0x30, 0x03)");
+    CHECK_EQ(GpioMock::out, 0x3C);
+
+    // Bit 31 arrives as a negative Lua integer
+    Host::runLua(L, "gpio.write_mask(1 << 31, 0)");
+    CHECK_EQ(GpioMock::out, 0x8000003Cull);
+
+    // Bank 1 is GPIO32 and up; the mock has 40 pins
+    Host::runLua(L, "gpio.write_mask(0x81, 0, 1)");
+    CHECK_EQ(GpioMock::out >> 32, 0x81);
+    Host::runLua(L, "assert(not pcall(gpio.write_mask, 1 << 8, 0, 1))");
+    Host::runLua(L, "assert(not pcall(gpio.write_mask, 1, 0, 2))");
+    CHECK_EQ(GpioMock::out >> 32, 0x81);
+}
+
+static void testGroup(lua_State *L) {
+    Host::runLua(L, BUS_SETUP);
+    GpioMock::out = 0x2;            // Pin 1 is not in the group and stays set
+
+    Host::runLua(L, "bus:write(0xA5)");
+    CHECK_EQ(GpioMock::out, busBits(0xA5) | 0x2);
+    Host::runLua(L, "bus:write(0x5A)");
+    CHECK_EQ(GpioMock::out, busBits(0x5A) | 0x2);
+
+    uint32_t writes = GpioMock::writes;
+    Host::runLua(L, "bus:write(0xFF)");
+    CHECK_EQ(GpioMock::writes - writes, 1);
+    CHECK_EQ(GpioMock::out, busMask() | 0x2);
+
+    char code[64];
+    snprintf(code, sizeof(code), "assert(bus:mask() == %u)", (unsigned)busMask());
+    Host::runLua(L, code);
+
+    GpioMock::in = busBits(0x3C) | 0x1;
+    Host::runLua(L, "assert(bus:read() == 0x3C)");
+    snprintf(code, sizeof(code), "assert(gpio.read_mask() == %u)", (unsigned)GpioMock::in);
+    Host::runLua(L, code);
+
+    Host::runLua(L, "assert(not pcall(gpio.group, {4, 4}))");
+    Host::runLua(L, "assert(not pcall(gpio.group, {40}))");
+}
+
+static void testMode(lua_State *L) {
+    GpioMock::outputs = 0;
+    Host::runLua(L, "gpio.mode(0x30, OUTPUT)");
+    CHECK_EQ(GpioMock::outputs, 0x30);
+    Host::runLua(L, "gpio.mode(0x10, INPUT)");
+    CHECK_EQ(GpioMock::outputs, 0x20);
+}
+
+// Runs `loop` (a Lua function of n) and prints ns per bus value
+static void bench(lua_State *L, const char *name, const char *loop) {
+    lua_settop(L, 0);
+    if (luaL_loadstring(L, loop) != LUA_OK || lua_pcall(L, 0, 1, 0) != LUA_OK) {
+        printf("lua error: %s\n", lua_tostring(L, -1));
+        host_check_failures++;
+        lua_settop(L, 0);
+        return;
+    }
+    lua_pushinteger(L, BENCH_WRITES);
+
+    uint32_t writes = GpioMock::writes;
+    double start = Host::seconds();
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+        printf("lua error: %s\n", lua_tostring(L, -1));
+        host_check_failures++;
+        lua_settop(L, 0);
+        return;
+    }
+    double elapsed = Host::seconds() - start;
+
+    printf("%-14s %7.1f ns/value  %u backend writes\n", name, elapsed * 1e9 / BENCH_WRITES,
+           (unsigned)(GpioMock::writes - writes));
+}
+
+int main() {
+    lua_State *L = Host::openLua();
+    lua_gpio_register(L);
+
+    testWriteMask(L);
+    testGroup(L);
+    testMode(L);
+
+    Host::runLua(L, BUS_SETUP);
+    GpioMock::out = 0;
+
+    bench(L, "digitalWrite",
+          "return function(n)\n"
+          "  for i = 1, n do\n"
+          "    local v = i & 0xFF\n"
+          "    for b = 0, 7 do digitalWrite(pins[b + 1], (v >> b) & 1) end\n"
+          "  end\n"
+          "end\n");
+
+    bench(L, "write_mask",
+          "return function(n)\n"
+          "  for i = 1, n do\n"
+          "    local v, set = i & 0xFF, 0\n"
+          "    for b = 0, 7 do\n"
+          "      if (v >> b) & 1 == 1 then set = set | (1 << pins[b + 1]) end\n"
+          "    end\n"
+          "    gpio.write_mask(set, bus:mask() & ~set)\n"
+          "  end\n"
+          "end\n");
+    CHECK_EQ(GpioMock::out, busBits(BENCH_WRITES & 0xFF));
+
+    GpioMock::out = 0;
+    bench(L, "group:write",
+          "return function(n)\n"
+          "  for i = 1, n do bus:write(i & 0xFF) end\n"
+          "end\n");
+    CHECK_EQ(GpioMock::out, busBits(BENCH_WRITES & 0xFF));
+
+    lua_gpio_cleanup();
+    lua_close(L);
+    return host_check_result("gpio_bench");
+}
@@ -0,0 +1,93 @@
+// ═══════════════════════════════════════════════════════
+// DEFERRED LOG BENCH (host side)
+// ═══════════════════════════════════════════════════════
+//
+// What a LOG_* call costs its caller with DEBUG_LOG_DEFERRED (claim a ring
+// slot, copy the raw arguments, publish), against snprintf-ing the same
+// line as the synchronous path does before Serial sees it. The third
+// column is the log task's share per record with the stream sink on
+// (packing into "log" events, counted by the shim). This bench and
+// debug.cpp build deferred; the rest of tools/host logs synchronously.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "core/utils/debug.h"
+
+static const int CALLS = 256000;
+static const int BATCH = LogConfig::RING_SLOTS;
+
+static volatile uint32_t writes = 1234;
+static volatile uint32_t flashWrites = 56;
+static volatile int64_t value = -9000000001LL;
+static const char *volatile key = "sensor.calibration.offset";
+static const char *volatile path = "/.kv/settings.log";
+
+struct Cost {
+    double caller;
+    double snprintfNs;
+    double task;
+};
+
+// `log` makes one LOG_* call, `format` the equivalent snprintf
+template <typename Log, typename Format>
+static Cost measure(Log log, Format format) {
+    Cost cost = { 0, 0, 0 };
+    for (int done = 0; done < CALLS; done += BATCH) {
+        double t0 = Host::seconds();
+        for (int i = 0; i < BATCH; i++) {
+            log();
+        }
+        double t1 = Host::seconds();
+        debug_log_flush();
+        cost.caller += t1 - t0;
+        cost.task += Host::seconds() - t1;
+    }
+
+    char line[LogConfig::LINE_BYTES];
+    size_t sink = 0;
+    double t0 = Host::seconds();
+    for (int i = 0; i < CALLS; i++) {
+        sink += format(line, sizeof(line));
+    }
+    cost.snprintfNs = (Host::seconds() - t0) * 1e9 / CALLS;
+    CHECK(sink > 0);
+
+    cost.caller *= 1e9 / CALLS;
+    cost.task *= 1e9 / CALLS;
+    return cost;
+}
+
+static void report(const char *name, const Cost &cost) {
+    printf("  %-36s %6.1f ns  %6.1f ns  %6.1f ns\n", name, cost.caller, cost.snprintfNs, cost.task);
+}
+
+int main() {
+    debug_log_set_sinks(LOG_SINK_STREAM);
+    debug_log_init();
+
+    printf("per call                               LOG_*     snprintf   log task\n");
+    report("two ints", measure(
+        [] { LOG_INFO("STORAGE", "%u writes, %u reached flash", writes, flashWrites); },
+        [](char *out, size_t size) {
+            return snprintf(out, size, "[INFO][%s] %u writes, %u reached flash\n", "STORAGE",
+                            writes, flashWrites);
+        }));
+    report("string and int64", measure(
+        [] { LOG_INFO("STORAGE", "Set int: %s = %lld", key, (long long)value); },
+        [](char *out, size_t size) {
+            return snprintf(out, size, "[INFO][%s] Set int: %s = %lld\n", "STORAGE", key, (long long)value);
+        }));
+    report("string and two ints", measure(
+        [] { LOG_INFO("STORAGE", "Compacted %s: %u -> %u bytes", path, writes, flashWrites); },
+        [](char *out, size_t size) {
+            return snprintf(out, size, "[INFO][%s] Compacted %s: %u -> %u bytes\n", "STORAGE",
+                            path, writes, flashWrites);
+        }));
+
+    // Every batch fits the ring, so nothing may have been dropped
+    CHECK_EQ(debug_log_dropped(), 0);
+    CHECK(Host::events > 0);
+    return host_check_result("log_bench");
+}
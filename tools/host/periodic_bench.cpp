@@ -0,0 +1,88 @@
+// ═══════════════════════════════════════════════════════
+// PERIODIC BENCH (host side, PERIODIC_HOST_MOCK)
+// ═══════════════════════════════════════════════════════
+//
+// 2 ms of busy work at 100 Hz for 2 s, scheduled two ways: a
+// work(); delay(10) loop, whose period stretches by the work, and
+// periodic(work, 10000) on the POSIX interval timer. Then a 1.5 ms body at
+// a 1 ms period, where every run must be flagged as an overrun and the
+// ticks in between skipped. Jitter includes host thread wake-up.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_periodic/lua_periodic.h"
+
+static int luaInt(lua_State *L, const char *global) {
+    lua_getglobal(L, global);
+    int value = (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    return value;
+}
+
+static void benchDelayLoop(lua_State *L) {
+    Host::runLua(L,
+        "local deadline = millis() + 2000\n"
+        "loops = 0\n"
+        "while millis() < deadline do\n"
+        "  work()\n"
+        "  loops = loops + 1\n"
+        "  delay(10)\n"
+        "end\n");
+    int loops = luaInt(L, "loops");
+    printf("work(); delay(10) loop:  %d iterations, %.1f Hz effective\n", loops, loops / 2.0);
+    CHECK(loops < 200);
+}
+
+static void benchPeriodic(lua_State *L) {
+    Host::runLua(L,
+        "local p = periodic(work, 10000)\n"
+        "delay(2000)\n"
+        "p:stop()\n"
+        "local s = p:stats()\n"
+        "runs, skipped, overruns = s.runs, s.skipped, s.overruns\n"
+        "jmin, javg, jmax = s.jitter.min, math.floor(s.jitter.avg), s.jitter.max\n");
+    int runs = luaInt(L, "runs");
+    int skipped = luaInt(L, "skipped");
+    printf("periodic(work, 10000):   %d runs, %d skipped, %d overruns, jitter min/avg/max %d/%d/%d us\n",
+           runs, skipped, luaInt(L, "overruns"), luaInt(L, "jmin"), luaInt(L, "javg"), luaInt(L, "jmax"));
+
+    // Deadlines are absolute: every tick of the 2 s either ran or was skipped
+    CHECK(runs + skipped >= 195 && runs + skipped <= 201);
+    CHECK(runs > 150);
+}
+
+static void testOverrun(lua_State *L) {
+    Host::runLua(L,
+        "local p = periodic(function() busy(1500) end, 1000)\n"
+        "delay(500)\n"
+        "p:stop()\n"
+        "local s = p:stats()\n"
+        "runs, skipped, overruns = s.runs, s.skipped, s.overruns\n");
+    int runs = luaInt(L, "runs");
+    int skipped = luaInt(L, "skipped");
+    int overruns = luaInt(L, "overruns");
+    printf("1 ms period, 1.5 ms body: %d runs, %d overruns, %d skipped\n", runs, overruns, skipped);
+
+    CHECK(runs > 0);
+    CHECK_EQ(overruns, runs);
+    CHECK(skipped >= runs / 2);
+}
+
+int main() {
+    lua_State *L = Host::openLua();
+    lua_periodic_register(L);
+    Host::runLua(L,
+        "function busy(us) local t = micros() while micros() - t < us do end end\n"
+        "function work() busy(2000) end\n");
+
+    benchDelayLoop(L);
+    benchPeriodic(L);
+    testOverrun(L);
+
+    lua_periodic_cleanup();
+    lua_close(L);
+    return host_check_result("periodic_bench");
+}
@@ -0,0 +1,74 @@
+// ═══════════════════════════════════════════════════════
+// PRINT BENCH (host side)
+// ═══════════════════════════════════════════════════════
+//
+// print() throughput into the console buffer, and how many lua_code_output
+// events it takes. Every event drops the newline of its last line, so the
+// bytes sent must equal the text printed plus one newline per line, minus
+// one per event; the bench rebuilds each line's text in Lua to check it.
+// Event sends are counted by the shim, not framed, and the host String is
+// std::string, so this is not a device figure.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_arduino/lua_arduino.h"
+#include "core/utils/debug.h"
+
+static const int PRINTS = 200000;
+
+// Runs `loop` (prints PRINTS lines), then `text` which sets `bytes` to the
+// length of all those lines without their newlines
+static void bench(lua_State *L, const char *name, const char *loop, const char *text) {
+    uint32_t events = Host::events;
+    uint32_t eventBytes = Host::eventBytes;
+
+    double start = Host::seconds();
+    Host::runLua(L, loop);
+    arduino_console_flush();
+    double elapsed = Host::seconds() - start;
+
+    events = Host::events - events;
+    eventBytes = Host::eventBytes - eventBytes;
+    Host::runLua(L, text);
+    lua_getglobal(L, "bytes");
+    uint32_t bytes = (uint32_t)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+
+    CHECK_EQ(eventBytes, bytes + PRINTS - events);
+    CHECK(events < PRINTS / 8);
+    printf("%-30s %6.2f M prints/s  %6u events\n", name, PRINTS / elapsed / 1e6, (unsigned)events);
+}
+
+int main() {
+    lua_State *L = Host::openLua();
+
+    // print() also logs each line under LUA; keep the bench output readable
+    uint8_t level = debug_log_tag_levels[log_tag_id("LUA")];
+    debug_log_tag_levels[log_tag_id("LUA")] = LOG_LEVEL_ERROR;
+
+    char code[64];
+    snprintf(code, sizeof(code), "N = %d", PRINTS);
+    Host::runLua(L, code);
+    Host::runLua(L,
+        "function num(x)\n"
+        "  if math.type(x) == 'integer' or x == math.floor(x) then return string.format('%d', x) end\n"
+        "  return string.format('%.10g', x)\n"
+        "end\n");
+
+    bench(L, "print(i)",
+          "for i = 1, N do print(i) end",
+          "bytes = 0 for i = 1, N do bytes = bytes + #num(i) end");
+    bench(L, "print('t', i, i * 0.5, true)",
+          "for i = 1, N do print('t', i, i * 0.5, true) end",
+          "bytes = 0 for i = 1, N do bytes = bytes + #('t\\t' .. num(i) .. '\\t' .. num(i * 0.5) .. '\\ttrue') end");
+    bench(L, "print('temperature', 21.375)",
+          "for i = 1, N do print('temperature', 21.375) end",
+          "bytes = N * #'temperature\\t21.375'");
+
+    debug_log_tag_levels[log_tag_id("LUA")] = level;
+    lua_close(L);
+    return host_check_result("print_bench");
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+// ═══════════════════════════════════════════════════════
+// ARDUINO SHIM (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Just enough of the Arduino core for the modules tools/host builds.
+// Pins read as 0 and ignore writes; timing is the host's steady clock.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define IRAM_ATTR
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+#define OPEN_DRAIN 0x10
+#define OUTPUT_OPEN_DRAIN 0x12
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ═══════════════════════════════════════════════════════
+// STRING
+// ═══════════════════════════════════════════════════════
+
+class String {
+public:
+    String() {}
+    String(const char *s) : s_(s ? s : "") {}
+    explicit String(char c) : s_(1, c) {}
+    explicit String(int v) : s_(std::to_string(v)) {}
+    explicit String(unsigned int v) : s_(std::to_string(v)) {}
+    explicit String(long v) : s_(std::to_string(v)) {}
+    explicit String(unsigned long v) : s_(std::to_string(v)) {}
+    explicit String(float v, unsigned char decimals = 2) : String((double)v, decimals) {}
+    explicit String(double v, unsigned char decimals = 2) {
+        char buf[40];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        s_ = buf;
+    }
+
+    const char *c_str() const { return s_.c_str(); }
+    unsigned int length() const { return s_.size(); }
+    bool isEmpty() const { return s_.empty(); }
+    bool reserve(unsigned int size) { s_.reserve(size); return true; }
+    bool concat(const char *p, unsigned int n) { s_.append(p, n); return true; }
+
+    char operator[](unsigned int i) const { return i < s_.size() ? s_[i] : '\0'; }
+    String &operator+=(const String &o) { s_ += o.s_; return *this; }
+    String &operator+=(const char *o) { s_ += o; return *this; }
+    String &operator+=(char c) { s_ += c; return *this; }
+
+    bool startsWith(const String &p) const { return s_.compare(0, p.s_.size(), p.s_) == 0; }
+    bool endsWith(const String &p) const {
+        return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0;
+    }
+    int indexOf(char c) const { size_t p = s_.find(c); return p == std::string::npos ? -1 : (int)p; }
+    int lastIndexOf(char c) const { size_t p = s_.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+    String substring(unsigned int from) const { return substring(from, s_.size()); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from >= s_.size() ? String() : String(s_.substr(from, to - from).c_str());
+    }
+
+    bool operator==(const String &o) const { return s_ == o.s_; }
+    bool operator!=(const String &o) const { return s_ != o.s_; }
+    bool operator<(const String &o) const { return s_ < o.s_; }
+
+    friend String operator+(const String &a, const String &b) { String r(a); r += b; return r; }
+    friend String operator+(const String &a, const char *b) { String r(a); r += b; return r; }
+    friend String operator+(const char *a, const String &b) { String r(a); r += b; return r; }
+
+private:
+    std::string s_;
+};
+
+// ═══════════════════════════════════════════════════════
+// CORE API
+// ═══════════════════════════════════════════════════════
+
+struct HardwareSerial {
+    void begin(unsigned long) {}
+    int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char *s) { return fputs(s, stdout) < 0 ? 0 : strlen(s); }
+    size_t println(const char *s) { return print(s) + print("\n"); }
+    size_t write(const uint8_t *data, size_t len) { return fwrite(data, 1, len, stdout); }
+    void flush() { fflush(stdout); }
+};
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
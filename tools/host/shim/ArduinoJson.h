@@ -0,0 +1,9 @@
+#pragma once
+
+// ═══════════════════════════════════════════════════════
+// ARDUINOJSON PLACEHOLDER (host side)
+// ═══════════════════════════════════════════════════════
+//
+// The modules tools/host builds only reach ArduinoJson through shared
+// headers (file_transfer.h, lua_storage.h) and never use it. A module that
+// does needs the real library, which the host build does not carry.
@@ -0,0 +1,85 @@
+#pragma once
+
+// ═══════════════════════════════════════════════════════
+// FS SHIM (host side)
+// ═══════════════════════════════════════════════════════
+//
+// The Arduino fs::FS / fs::File calls the firmware makes, over a scratch
+// directory on the host (see host_fs.cpp). Like on LittleFS, bytes written
+// through one handle reach other handles once it is flushed or closed.
+
+#include <Arduino.h>
+#include <memory>
+#include <time.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct FileImpl;
+
+class File {
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> impl) : _impl(impl) {}
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t size);
+    size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    int available();
+    int read();
+    size_t read(uint8_t *buf, size_t size);
+    int peek();
+    void flush();
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const;
+    time_t getLastWrite();
+    const char *path() const;
+    const char *name() const;
+
+    bool isDirectory(void);
+    File openNextFile(const char *mode = FILE_READ);
+    void rewindDirectory(void);
+
+private:
+    std::shared_ptr<FileImpl> _impl;
+};
+
+class FS {
+public:
+    File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+    File open(const String &path, const char *mode = FILE_READ, const bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+
+    bool exists(const char *path);
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path);
+    bool remove(const String &path) { return remove(path.c_str()); }
+    bool rename(const char *pathFrom, const char *pathTo);
+    bool rename(const String &pathFrom, const String &pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+    bool mkdir(const char *path);
+    bool mkdir(const String &path) { return mkdir(path.c_str()); }
+    bool rmdir(const char *path);
+    bool rmdir(const String &path) { return rmdir(path.c_str()); }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
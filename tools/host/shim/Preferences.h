@@ -0,0 +1,45 @@
+#pragma once
+
+// ═══════════════════════════════════════════════════════
+// PREFERENCES SHIM (host side)
+// ═══════════════════════════════════════════════════════
+//
+// The Arduino Preferences calls the storage module makes, on top of the
+// NVS emulator with the same encodings as the ESP32 core: doubles are
+// 8-byte blobs, bools are u8.
+
+#include <Arduino.h>
+#include <nvs.h>
+
+typedef enum {
+    PT_I8, PT_U8, PT_I16, PT_U16, PT_I32, PT_U32, PT_I64, PT_U64, PT_STR, PT_BLOB, PT_INVALID
+} PreferenceType;
+
+class Preferences {
+public:
+    bool begin(const char *name, bool readOnly = false, const char *partition_label = NULL);
+    void end();
+
+    bool clear();
+    bool remove(const char *key);
+    bool isKey(const char *key);
+    PreferenceType getType(const char *key);
+
+    size_t putLong64(const char *key, int64_t value);
+    size_t putDouble(const char *key, double value);
+    size_t putBool(const char *key, bool value);
+    size_t putString(const char *key, const char *value);
+    size_t putBytes(const char *key, const void *value, size_t len);
+
+    int64_t getLong64(const char *key, int64_t defaultValue = 0);
+    double getDouble(const char *key, double defaultValue = NAN);
+    bool getBool(const char *key, bool defaultValue = false);
+    String getString(const char *key, String defaultValue = String());
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+private:
+    nvs_handle_t _handle = 0;
+    bool _started = false;
+    bool _readOnly = false;
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+// The NVS shim follows the ESP-IDF 5 iterator API
+#define ESP_IDF_VERSION_MAJOR 5
+#define ESP_IDF_VERSION_MINOR 1
+#define ESP_IDF_VERSION_PATCH 0
@@ -0,0 +1,16 @@
+#pragma once
+
+// ═══════════════════════════════════════════════════════
+// ESP SYSTEM SHIM (host side)
+// ═══════════════════════════════════════════════════════
+
+#include <stdint.h>
+#include <nvs.h>
+
+typedef void (*shutdown_handler_t)(void);
+
+// Handlers run from esp_restart(), which then exits the host process
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
+void esp_restart(void) __attribute__((noreturn));
+
+uint32_t esp_random(void);
@@ -0,0 +1,40 @@
+#pragma once
+
+// ═══════════════════════════════════════════════════════
+// FREERTOS SHIM (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Tasks are detached std::threads, queues and semaphores are
+// mutex + condition variable (see host_rtos.cpp). Priorities and core
+// pinning are ignored; one tick is one millisecond.
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+// Critical sections only exclude other cores on the chip; the shim's
+// ISR threads rely on the atomics in the code under test instead
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+#define portENTER_CRITICAL_ISR(mux) (void)(mux)
+#define portEXIT_CRITICAL_ISR(mux) (void)(mux)
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+inline bool xPortInIsrContext() { return false; }
@@ -0,0 +1,67 @@
+#pragma once
+
+// ═══════════════════════════════════════════════════════
+// HOST HARNESS - hooks for benches and tests
+// ═══════════════════════════════════════════════════════
+
+#include <Arduino.h>
+#include <atomic>
+#include <vector>
+
+struct lua_State;
+
+namespace Host {
+    // event_msg_send() output, counted instead of framed onto a link
+    extern std::atomic<uint32_t> events;
+    extern std::atomic<uint32_t> eventBytes;
+    extern volatile uint32_t eventDelayUs;      // Simulated link time per event
+
+    // Deliver an incoming event to the handler lua_eventmsg registered
+    void deliver(const char *name, const std::vector<uint8_t> &data);
+
+    // Wall-clock seconds since start (for throughput figures)
+    double seconds();
+
+    // Fresh Lua state with the standard libraries, arduino and eventmsg
+    // (link shim/host_lua.cpp); close it with lua_close()
+    lua_State *openLua();
+
+    // Run a chunk on L; an error is printed and counts as a check failure
+    bool runLua(lua_State *L, const char *code);
+
+    // NVS emulator traffic (link shim/host_nvs.cpp); gets and sets/erases
+    extern std::atomic<uint32_t> nvsReads;
+    extern std::atomic<uint32_t> nvsWrites;
+
+    // Wipe every namespace, as a fresh flash would be
+    void nvsErase();
+
+    // LittleFS scratch directory (link shim/host_fs.cpp): host path of a
+    // firmware path, and a wipe of everything in it
+    std::string fsPath(const char *path);
+    void fsReset();
+
+    // Fail the next N renames / removes (interrupted-swap tests)
+    extern std::atomic<int> fsFailRenames;
+    extern std::atomic<int> fsFailRemoves;
+}
+
+// ═══════════════════════════════════════════════════════
+// CHECKS (tests)
+// ═══════════════════════════════════════════════════════
+
+extern int host_check_failures;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { host_check_failures++; \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { long long va_ = (long long)(a), vb_ = (long long)(b); if (va_ != vb_) { host_check_failures++; \
+        printf("%s:%d: CHECK_EQ failed: %s == %s (%lld vs %lld)\n", __FILE__, __LINE__, #a, #b, va_, vb_); } } while (0)
+
+// Exit status of a test program
+inline int host_check_result(const char *name) {
+    printf("%s: %s\n", name, host_check_failures ? "FAILED" : "ok");
+    return host_check_failures ? 1 : 0;
+}
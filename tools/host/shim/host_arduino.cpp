@@ -0,0 +1,161 @@
+// ═══════════════════════════════════════════════════════
+// ARDUINO SHIM (host side) - timing, pins, events, esp_system
+// ═══════════════════════════════════════════════════════
+
+#include "host.h"
+#include "core/event_msg.h"
+#include "core/lua_engine.h"
+#include "core/utils/debug.h"
+#include <esp_system.h>
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+HardwareSerial Serial;
+int host_check_failures = 0;
+
+static const std::chrono::steady_clock::time_point host_start = std::chrono::steady_clock::now();
+
+// ═══════════════════════════════════════════════════════
+// CORE API
+// ═══════════════════════════════════════════════════════
+
+int HardwareSerial::printf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n;
+}
+
+unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - host_start).count();
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    (void)pin;
+    (void)value;
+}
+
+int digitalRead(uint8_t pin) {
+    (void)pin;
+    return LOW;
+}
+
+// Varies with the pin so a summing loop is not folded away
+uint16_t analogRead(uint8_t pin) {
+    return (pin * 7) & 0x0FFF;
+}
+
+void analogWrite(uint8_t pin, int value) {
+    (void)pin;
+    (void)value;
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return in_max == in_min ? out_min : (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+long random(long max) {
+    return max > 0 ? rand() % max : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+    srand(seed);
+}
+
+// ═══════════════════════════════════════════════════════
+// EVENTS
+// ═══════════════════════════════════════════════════════
+
+namespace Host {
+    std::atomic<uint32_t> events(0);
+    std::atomic<uint32_t> eventBytes(0);
+    volatile uint32_t eventDelayUs = 0;
+}
+
+static UnhandledEventHandler host_unhandled = NULL;
+
+void event_msg_on(const char *event_name, EventHandler handler) {
+    (void)event_name;
+    (void)handler;
+}
+
+void event_msg_on_unhandled(UnhandledEventHandler handler) {
+    host_unhandled = handler;
+}
+
+void event_msg_send(const char *name, const uint8_t *data, uint16_t len) {
+    (void)name;
+    (void)data;
+    Host::events++;
+    Host::eventBytes += len;
+    if (Host::eventDelayUs) {
+        usleep(Host::eventDelayUs);
+    }
+}
+
+void Host::deliver(const char *name, const std::vector<uint8_t> &data) {
+    if (host_unhandled) {
+        host_unhandled(String(name), data);
+    }
+}
+
+double Host::seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - host_start).count();
+}
+
+bool lua_engine_is_stop_requested() {
+    return false;
+}
+
+// ═══════════════════════════════════════════════════════
+// ESP SYSTEM
+// ═══════════════════════════════════════════════════════
+
+static std::vector<shutdown_handler_t> shutdown_handlers;
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    shutdown_handlers.push_back(handler);
+    return ESP_OK;
+}
+
+void esp_restart(void) {
+    for (size_t i = 0; i < shutdown_handlers.size(); i++) {
+        shutdown_handlers[i]();
+    }
+    exit(0);
+}
+
+uint32_t esp_random(void) {
+    static std::mt19937 generator(std::random_device{}());
+    return generator();
+}
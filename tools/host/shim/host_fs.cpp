@@ -0,0 +1,312 @@
+// ═══════════════════════════════════════════════════════
+// FS SHIM (host side) - LittleFS over a scratch directory, ROM CRC
+// ═══════════════════════════════════════════════════════
+
+#include "host.h"
+#include <FS.h>
+#include <LittleFS.h>
+#include <rom/crc.h>
+#include "core/file_transfer.h"
+
+#include <dirent.h>
+#include <filesystem>
+#include <sys/stat.h>
+
+namespace stdfs = std::filesystem;
+
+fs::LittleFSFS LittleFS;
+
+namespace Host {
+    std::atomic<int> fsFailRenames(0);
+    std::atomic<int> fsFailRemoves(0);
+}
+
+// ═══════════════════════════════════════════════════════
+// SCRATCH DIRECTORY
+// ═══════════════════════════════════════════════════════
+
+static void removeRoot();
+
+static const std::string &root() {
+    static std::string dir;
+    if (dir.empty()) {
+        char tmpl[] = "/tmp/easylua-fs-XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            perror("mkdtemp");
+            exit(1);
+        }
+        dir = tmpl;
+        atexit(removeRoot);
+    }
+    return dir;
+}
+
+static void removeRoot() {
+    std::error_code ec;
+    stdfs::remove_all(root(), ec);
+}
+
+std::string Host::fsPath(const char *path) {
+    return root() + (path[0] == '/' ? "" : "/") + path;
+}
+
+void Host::fsReset() {
+    std::error_code ec;
+    for (stdfs::directory_iterator it(root(), ec), end; !ec && it != end; it.increment(ec)) {
+        stdfs::remove_all(it->path(), ec);
+    }
+}
+
+// ═══════════════════════════════════════════════════════
+// FILE
+// ═══════════════════════════════════════════════════════
+
+namespace fs {
+
+struct FileImpl {
+    FILE *fp = NULL;
+    DIR *dir = NULL;
+    std::string path;           // Firmware path ("/.kv/app.log")
+    std::string name;
+
+    ~FileImpl() {
+        if (fp) fclose(fp);
+        if (dir) closedir(dir);
+    }
+};
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buf, size_t size) {
+    if (!_impl || !_impl->fp) return 0;
+    return fwrite(buf, 1, size, _impl->fp);
+}
+
+int File::available() {
+    if (!_impl || !_impl->fp) return 0;
+    return (int)(size() - position());
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+    if (!_impl || !_impl->fp) return 0;
+    return fread(buf, 1, size, _impl->fp);
+}
+
+int File::peek() {
+    if (!_impl || !_impl->fp) return -1;
+    int c = fgetc(_impl->fp);
+    if (c != EOF) ungetc(c, _impl->fp);
+    return c == EOF ? -1 : c;
+}
+
+void File::flush() {
+    if (_impl && _impl->fp) fflush(_impl->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_impl || !_impl->fp) return false;
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return fseek(_impl->fp, pos, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!_impl || !_impl->fp) return 0;
+    long pos = ftell(_impl->fp);
+    return pos < 0 ? 0 : (size_t)pos;
+}
+
+// Includes bytes still buffered in this handle, as LittleFS does
+size_t File::size() const {
+    if (!_impl || !_impl->fp) return 0;
+    fflush(_impl->fp);
+    struct stat st;
+    return fstat(fileno(_impl->fp), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+    _impl.reset();
+}
+
+File::operator bool() const {
+    return _impl && (_impl->fp || _impl->dir);
+}
+
+time_t File::getLastWrite() {
+    struct stat st;
+    if (!_impl || stat(Host::fsPath(_impl->path.c_str()).c_str(), &st) != 0) return 0;
+    return st.st_mtime;
+}
+
+const char *File::path() const {
+    return _impl ? _impl->path.c_str() : NULL;
+}
+
+const char *File::name() const {
+    return _impl ? _impl->name.c_str() : NULL;
+}
+
+bool File::isDirectory(void) {
+    return _impl && _impl->dir;
+}
+
+File File::openNextFile(const char *mode) {
+    if (!_impl || !_impl->dir) return File();
+
+    struct dirent *entry;
+    while ((entry = readdir(_impl->dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = _impl->path == "/" ? "/" + std::string(entry->d_name)
+                                                : _impl->path + "/" + entry->d_name;
+        return LittleFS.open(child.c_str(), mode);
+    }
+    return File();
+}
+
+void File::rewindDirectory(void) {
+    if (_impl && _impl->dir) rewinddir(_impl->dir);
+}
+
+// ═══════════════════════════════════════════════════════
+// FS
+// ═══════════════════════════════════════════════════════
+
+File FS::open(const char *path, const char *mode, const bool create) {
+    std::string host = Host::fsPath(path);
+    std::shared_ptr<FileImpl> impl(new FileImpl());
+    impl->path = path;
+    size_t slash = impl->path.find_last_of('/');
+    impl->name = slash == std::string::npos ? impl->path : impl->path.substr(slash + 1);
+
+    std::error_code ec;
+    if (stdfs::is_directory(host, ec)) {
+        if (mode[0] != 'r') return File();
+        impl->dir = opendir(host.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+
+    if (create && mode[0] != 'r') {
+        stdfs::create_directories(stdfs::path(host).parent_path(), ec);
+    }
+    std::string fmode = std::string(mode) + "b";
+    impl->fp = fopen(host.c_str(), fmode.c_str());
+    return impl->fp ? File(impl) : File();
+}
+
+bool FS::exists(const char *path) {
+    std::error_code ec;
+    return stdfs::exists(Host::fsPath(path), ec);
+}
+
+bool FS::remove(const char *path) {
+    if (Host::fsFailRemoves > 0) {
+        Host::fsFailRemoves--;
+        return false;
+    }
+    std::error_code ec;
+    std::string host = Host::fsPath(path);
+    return stdfs::is_regular_file(host, ec) && stdfs::remove(host, ec);
+}
+
+// Replaces an existing target in one step, like LittleFS
+bool FS::rename(const char *pathFrom, const char *pathTo) {
+    if (Host::fsFailRenames > 0) {
+        Host::fsFailRenames--;
+        return false;
+    }
+    return ::rename(Host::fsPath(pathFrom).c_str(), Host::fsPath(pathTo).c_str()) == 0;
+}
+
+bool FS::mkdir(const char *path) {
+    std::error_code ec;
+    stdfs::create_directory(Host::fsPath(path), ec);
+    return !ec;
+}
+
+bool FS::rmdir(const char *path) {
+    std::error_code ec;
+    std::string host = Host::fsPath(path);
+    return stdfs::is_directory(host, ec) && stdfs::remove(host, ec);
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel) {
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    return !root().empty();
+}
+
+bool LittleFSFS::format() {
+    Host::fsReset();
+    return true;
+}
+
+// A 1.5 MB partition, as in the default ESP32 layout
+size_t LittleFSFS::totalBytes() {
+    return 1536 * 1024;
+}
+
+size_t LittleFSFS::usedBytes() {
+    size_t used = 0;
+    std::error_code ec;
+    for (stdfs::recursive_directory_iterator it(root(), ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec)) used += it->file_size(ec);
+    }
+    return used;
+}
+
+} // namespace fs
+
+// ═══════════════════════════════════════════════════════
+// ROM CRC
+// ═══════════════════════════════════════════════════════
+
+struct CrcTable {
+    uint32_t entry[256];
+
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entry[i] = c;
+        }
+    }
+};
+
+uint32_t crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len) {
+    static const CrcTable table;
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc = table.entry[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// file_transfer.cpp holds the firmware's CRC32, but needs ArduinoJson
+CRC32::CRC32() : crc_value(0) {}
+
+void CRC32::reset() {
+    crc_value = 0;
+}
+
+void CRC32::update(const uint8_t *data, size_t length) {
+    crc_value = crc32_le(crc_value, data, length);
+}
+
+uint32_t CRC32::finalize() const {
+    return crc_value;
+}
+
+void CRC32::seed(uint32_t value) {
+    crc_value = value;
+}
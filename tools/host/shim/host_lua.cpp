@@ -0,0 +1,34 @@
+// ═══════════════════════════════════════════════════════
+// LUA SHIM (host side) - states for Lua-level tests and benches
+// ═══════════════════════════════════════════════════════
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_arduino/lua_arduino.h"
+#include "lua_modules/lua_eventmsg/lua_eventmsg.h"
+
+lua_State *Host::openLua() {
+    static bool initialized = false;
+    if (!initialized) {
+        arduino_module_init();
+        lua_eventmsg_init();
+        initialized = true;
+    }
+
+    lua_State *L = luaL_newstate();
+    luaL_openlibs(L);
+    arduino_module_register(L);
+    lua_eventmsg_register(L);
+    return L;
+}
+
+bool Host::runLua(lua_State *L, const char *code) {
+    if (luaL_dostring(L, code) == LUA_OK) {
+        lua_settop(L, 0);
+        return true;
+    }
+    printf("lua error: %s\n", lua_tostring(L, -1));
+    lua_settop(L, 0);
+    host_check_failures++;
+    return false;
+}
@@ -0,0 +1,369 @@
+// ═══════════════════════════════════════════════════════
+// NVS EMULATOR (host side) - nvs.h and Preferences
+// ═══════════════════════════════════════════════════════
+
+#include "host.h"
+#include <Preferences.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Host {
+    std::atomic<uint32_t> nvsReads(0);
+    std::atomic<uint32_t> nvsWrites(0);
+}
+
+// ═══════════════════════════════════════════════════════
+// STORE
+// ═══════════════════════════════════════════════════════
+
+struct NvsItem {
+    nvs_type_t type;
+    std::vector<uint8_t> data;
+};
+
+typedef std::map<std::string, NvsItem> NvsNamespace;
+
+// The flush task and the script reach it from different threads
+static std::mutex nvs_mutex;
+static std::map<std::string, NvsNamespace> nvs_store;
+static std::map<nvs_handle_t, std::string> nvs_handles;
+static nvs_handle_t nvs_next_handle = 1;
+
+struct nvs_opaque_iterator_t {
+    std::vector<nvs_entry_info_t> entries;
+    size_t pos;
+};
+
+void Host::nvsErase() {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs_store.clear();
+}
+
+static bool validKey(const char *key) {
+    return key && key[0] && strlen(key) < NVS_KEY_NAME_MAX_SIZE;
+}
+
+// Namespace behind a handle (caller holds nvs_mutex)
+static NvsNamespace *lookupNamespace(nvs_handle_t handle) {
+    std::map<nvs_handle_t, std::string>::iterator it = nvs_handles.find(handle);
+    return it == nvs_handles.end() ? NULL : &nvs_store[it->second];
+}
+
+static esp_err_t setItem(nvs_handle_t handle, const char *key, nvs_type_t type, const void *data, size_t len) {
+    if (!key || !key[0]) return ESP_ERR_NVS_INVALID_NAME;
+    if (!validKey(key)) return ESP_ERR_NVS_KEY_TOO_LONG;
+
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    NvsNamespace *ns = lookupNamespace(handle);
+    if (!ns) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    NvsItem &item = (*ns)[key];
+    item.type = type;
+    item.data.assign((const uint8_t *)data, (const uint8_t *)data + len);
+    Host::nvsWrites++;
+    return ESP_OK;
+}
+
+// Copies the item into `out`; a stored item of another type is a miss
+static esp_err_t getItem(nvs_handle_t handle, const char *key, nvs_type_t type, std::vector<uint8_t> &out) {
+    if (!validKey(key)) return ESP_ERR_NVS_NOT_FOUND;
+
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    NvsNamespace *ns = lookupNamespace(handle);
+    if (!ns) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    Host::nvsReads++;
+    NvsNamespace::const_iterator it = ns->find(key);
+    if (it == ns->end() || it->second.type != type) return ESP_ERR_NVS_NOT_FOUND;
+    out = it->second.data;
+    return ESP_OK;
+}
+
+// ═══════════════════════════════════════════════════════
+// NVS API
+// ═══════════════════════════════════════════════════════
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    (void)open_mode;
+    if (!name || !name[0] || strlen(name) >= 16) return ESP_ERR_NVS_INVALID_NAME;
+
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    *out_handle = nvs_next_handle++;
+    nvs_handles[*out_handle] = name;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    nvs_handles.erase(handle);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    return nvs_handles.count(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value) {
+    return setItem(handle, key, NVS_TYPE_U8, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value) {
+    return setItem(handle, key, NVS_TYPE_U32, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char *key, int64_t value) {
+    return setItem(handle, key, NVS_TYPE_I64, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+    return setItem(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    return setItem(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+// Fixed-size integer gets
+template <typename T>
+static esp_err_t getScalar(nvs_handle_t handle, const char *key, nvs_type_t type, T *out_value) {
+    std::vector<uint8_t> data;
+    esp_err_t err = getItem(handle, key, type, data);
+    if (err == ESP_OK) {
+        memcpy(out_value, data.data(), sizeof(T));
+    }
+    return err;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value) {
+    return getScalar(handle, key, NVS_TYPE_U8, out_value);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value) {
+    return getScalar(handle, key, NVS_TYPE_U32, out_value);
+}
+
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char *key, int64_t *out_value) {
+    return getScalar(handle, key, NVS_TYPE_I64, out_value);
+}
+
+// A NULL buffer asks for the length; a short one is an error, as on the chip
+static esp_err_t getVariable(nvs_handle_t handle, const char *key, nvs_type_t type, void *out_value, size_t *length) {
+    std::vector<uint8_t> data;
+    esp_err_t err = getItem(handle, key, type, data);
+    if (err != ESP_OK) return err;
+
+    if (out_value) {
+        if (*length < data.size()) return ESP_ERR_NVS_INVALID_LENGTH;
+        memcpy(out_value, data.data(), data.size());
+    }
+    *length = data.size();
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length) {
+    return getVariable(handle, key, NVS_TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    return getVariable(handle, key, NVS_TYPE_BLOB, out_value, length);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    NvsNamespace *ns = lookupNamespace(handle);
+    if (!ns) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!key || ns->erase(key) == 0) return ESP_ERR_NVS_NOT_FOUND;
+    Host::nvsWrites++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    NvsNamespace *ns = lookupNamespace(handle);
+    if (!ns) return ESP_ERR_NVS_INVALID_HANDLE;
+    ns->clear();
+    Host::nvsWrites++;
+    return ESP_OK;
+}
+
+// Iterators walk a snapshot of the namespace taken by nvs_entry_find
+esp_err_t nvs_entry_find(const char *part_name, const char *namespace_name, nvs_type_t type,
+                         nvs_iterator_t *output_iterator) {
+    (void)part_name;
+    *output_iterator = NULL;
+
+    nvs_opaque_iterator_t *it = new nvs_opaque_iterator_t();
+    it->pos = 0;
+    {
+        std::lock_guard<std::mutex> lock(nvs_mutex);
+        const NvsNamespace &ns = nvs_store[namespace_name];
+        for (NvsNamespace::const_iterator item = ns.begin(); item != ns.end(); ++item) {
+            if (type != NVS_TYPE_ANY && item->second.type != type) continue;
+            nvs_entry_info_t info = {};
+            snprintf(info.namespace_name, sizeof(info.namespace_name), "%s", namespace_name);
+            snprintf(info.key, sizeof(info.key), "%s", item->first.c_str());
+            info.type = item->second.type;
+            it->entries.push_back(info);
+        }
+    }
+
+    if (it->entries.empty()) {
+        delete it;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *output_iterator = it;
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_next(nvs_iterator_t *iterator) {
+    if (!iterator || !*iterator) return ESP_ERR_INVALID_ARG;
+    if (++(*iterator)->pos >= (*iterator)->entries.size()) {
+        delete *iterator;
+        *iterator = NULL;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_info(const nvs_iterator_t iterator, nvs_entry_info_t *out_info) {
+    if (!iterator || !out_info) return ESP_ERR_INVALID_ARG;
+    *out_info = iterator->entries[iterator->pos];
+    return ESP_OK;
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator) {
+    delete iterator;
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                     return "ESP_OK";
+        case ESP_FAIL:                   return "ESP_FAIL";
+        case ESP_ERR_INVALID_ARG:        return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_NVS_NOT_FOUND:      return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_INVALID_HANDLE: return "ESP_ERR_NVS_INVALID_HANDLE";
+        case ESP_ERR_NVS_INVALID_NAME:   return "ESP_ERR_NVS_INVALID_NAME";
+        case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+        case ESP_ERR_NVS_KEY_TOO_LONG:   return "ESP_ERR_NVS_KEY_TOO_LONG";
+        default:                         return "UNKNOWN ERROR";
+    }
+}
+
+// ═══════════════════════════════════════════════════════
+// PREFERENCES
+// ═══════════════════════════════════════════════════════
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition_label) {
+    (void)partition_label;
+    if (_started) return false;
+    _readOnly = readOnly;
+    _started = nvs_open(name, readOnly ? NVS_READONLY : NVS_READWRITE, &_handle) == ESP_OK;
+    return _started;
+}
+
+void Preferences::end() {
+    if (!_started) return;
+    nvs_close(_handle);
+    _started = false;
+}
+
+bool Preferences::clear() {
+    return _started && !_readOnly && nvs_erase_all(_handle) == ESP_OK;
+}
+
+bool Preferences::remove(const char *key) {
+    return _started && !_readOnly && nvs_erase_key(_handle, key) == ESP_OK;
+}
+
+PreferenceType Preferences::getType(const char *key) {
+    if (!_started || !validKey(key)) return PT_INVALID;
+
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    NvsNamespace *ns = lookupNamespace(_handle);
+    NvsNamespace::const_iterator it = ns ? ns->find(key) : NvsNamespace::const_iterator();
+    if (!ns || it == ns->end()) return PT_INVALID;
+
+    switch (it->second.type) {
+        case NVS_TYPE_I8:   return PT_I8;
+        case NVS_TYPE_U8:   return PT_U8;
+        case NVS_TYPE_I16:  return PT_I16;
+        case NVS_TYPE_U16:  return PT_U16;
+        case NVS_TYPE_I32:  return PT_I32;
+        case NVS_TYPE_U32:  return PT_U32;
+        case NVS_TYPE_I64:  return PT_I64;
+        case NVS_TYPE_U64:  return PT_U64;
+        case NVS_TYPE_STR:  return PT_STR;
+        case NVS_TYPE_BLOB: return PT_BLOB;
+        default:            return PT_INVALID;
+    }
+}
+
+bool Preferences::isKey(const char *key) {
+    return getType(key) != PT_INVALID;
+}
+
+size_t Preferences::putLong64(const char *key, int64_t value) {
+    return _started && !_readOnly && nvs_set_i64(_handle, key, value) == ESP_OK ? sizeof(value) : 0;
+}
+
+size_t Preferences::putDouble(const char *key, double value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+size_t Preferences::putBool(const char *key, bool value) {
+    return _started && !_readOnly && nvs_set_u8(_handle, key, value ? 1 : 0) == ESP_OK ? 1 : 0;
+}
+
+size_t Preferences::putString(const char *key, const char *value) {
+    return _started && !_readOnly && nvs_set_str(_handle, key, value) == ESP_OK ? strlen(value) : 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+    return _started && !_readOnly && nvs_set_blob(_handle, key, value, len) == ESP_OK ? len : 0;
+}
+
+int64_t Preferences::getLong64(const char *key, int64_t defaultValue) {
+    int64_t value = defaultValue;
+    if (_started) nvs_get_i64(_handle, key, &value);
+    return value;
+}
+
+double Preferences::getDouble(const char *key, double defaultValue) {
+    double value = defaultValue;
+    size_t len = sizeof(value);
+    if (!_started || getBytesLength(key) != sizeof(value) || nvs_get_blob(_handle, key, &value, &len) != ESP_OK) {
+        return defaultValue;
+    }
+    return value;
+}
+
+bool Preferences::getBool(const char *key, bool defaultValue) {
+    uint8_t value = defaultValue ? 1 : 0;
+    if (_started) nvs_get_u8(_handle, key, &value);
+    return value != 0;
+}
+
+String Preferences::getString(const char *key, String defaultValue) {
+    size_t len = 0;
+    if (!_started || nvs_get_str(_handle, key, NULL, &len) != ESP_OK) return defaultValue;
+
+    std::vector<char> value(len);
+    if (nvs_get_str(_handle, key, value.data(), &len) != ESP_OK) return defaultValue;
+    return String(value.data());
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+    size_t len = 0;
+    if (!_started || nvs_get_blob(_handle, key, NULL, &len) != ESP_OK) return 0;
+    return len;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+    size_t len = getBytesLength(key);
+    if (len == 0 || !buf || len > maxLen) return 0;
+    if (nvs_get_blob(_handle, key, buf, &len) != ESP_OK) return 0;
+    return len;
+}
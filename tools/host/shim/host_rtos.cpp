@@ -0,0 +1,290 @@
+// ═══════════════════════════════════════════════════════
+// FREERTOS SHIM (host side) - tasks, notifications, queues, semaphores
+// ═══════════════════════════════════════════════════════
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+// ═══════════════════════════════════════════════════════
+// HELPERS
+// ═══════════════════════════════════════════════════════
+
+// portMAX_DELAY waits forever, 0 polls
+static bool waitFor(std::unique_lock<std::mutex> &lock, std::condition_variable &cv, TickType_t ticks,
+                    const std::function<bool()> &ready) {
+    if (ticks == portMAX_DELAY) {
+        cv.wait(lock, ready);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+// ═══════════════════════════════════════════════════════
+// TASKS
+// ═══════════════════════════════════════════════════════
+
+struct HostTask {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t notify = 0;
+};
+
+// Thrown by vTaskDelete(NULL) to unwind a task thread
+struct HostTaskExit {};
+
+// Threads not started by xTaskCreate (main) get a task on first use
+static thread_local HostTask *current_task = nullptr;
+
+static HostTask *currentTask() {
+    if (!current_task) {
+        current_task = new HostTask();
+    }
+    return current_task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+    (void)name;
+    (void)stack;
+    (void)priority;
+    (void)core;
+
+    // Leaked on exit: a stopper may still be notifying it
+    HostTask *task = new HostTask();
+    if (handle) {
+        *handle = task;
+    }
+    std::thread([fn, arg, task] {
+        current_task = task;
+        try {
+            fn(arg);
+        } catch (const HostTaskExit &) {
+        }
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, handle, tskNO_AFFINITY);
+}
+
+// Only self-deletion is supported, the way every module here stops its tasks
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == current_task) {
+        throw HostTaskExit();
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return currentTask();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    HostTask *task = currentTask();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    if (!waitFor(lock, task->cv, ticks, [task] { return task->notify > 0; })) {
+        return 0;
+    }
+    uint32_t value = task->notify;
+    task->notify = clear ? 0 : value - 1;
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+    HostTask *task = (HostTask *)handle;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notify++;
+    }
+    task->cv.notify_all();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    xTaskNotifyGive(task);
+}
+
+// ═══════════════════════════════════════════════════════
+// QUEUES
+// ═══════════════════════════════════════════════════════
+
+struct HostQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    HostQueue *q = new HostQueue();
+    q->length = length;
+    q->itemSize = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete (HostQueue *)queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    HostQueue *q = (HostQueue *)queue;
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitFor(lock, q->cv, ticks, [q] { return q->items.size() < q->length; })) {
+        return pdFALSE;
+    }
+    q->items.emplace_back((const uint8_t *)item, (const uint8_t *)item + q->itemSize);
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    HostQueue *q = (HostQueue *)queue;
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitFor(lock, q->cv, ticks, [q] { return !q->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    HostQueue *q = (HostQueue *)queue;
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitFor(lock, q->cv, ticks, [q] { return !q->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    HostQueue *q = (HostQueue *)queue;
+    {
+        std::lock_guard<std::mutex> lock(q->mutex);
+        q->items.clear();
+    }
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    HostQueue *q = (HostQueue *)queue;
+    std::lock_guard<std::mutex> lock(q->mutex);
+    return q->items.size();
+}
+
+// ═══════════════════════════════════════════════════════
+// SEMAPHORES
+// ═══════════════════════════════════════════════════════
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t count;
+    uint32_t max;
+    std::recursive_mutex recursive;     // Recursive mutexes only
+};
+
+static HostSemaphore *newSemaphore(uint32_t max, uint32_t initial) {
+    HostSemaphore *s = new HostSemaphore();
+    s->max = max;
+    s->count = initial;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return newSemaphore(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+    return newSemaphore(max, initial);
+}
+
+// No priority inheritance or owner check, which the host does not need
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return newSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    return newSemaphore(1, 1);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    delete (HostSemaphore *)sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    HostSemaphore *s = (HostSemaphore *)sem;
+    std::unique_lock<std::mutex> lock(s->mutex);
+    if (!waitFor(lock, s->cv, ticks, [s] { return s->count > 0; })) {
+        return pdFALSE;
+    }
+    s->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    HostSemaphore *s = (HostSemaphore *)sem;
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        if (s->count >= s->max) {
+            return pdFALSE;
+        }
+        s->count++;
+    }
+    s->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks) {
+    (void)ticks;
+    ((HostSemaphore *)sem)->recursive.lock();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+    ((HostSemaphore *)sem)->recursive.unlock();
+    return pdTRUE;
+}
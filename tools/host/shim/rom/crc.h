@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// ROM CRC-32 (IEEE, reflected); chains like the ROM routine, crc32_le(0, ...) to start
+uint32_t crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len);
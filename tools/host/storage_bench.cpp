@@ -0,0 +1,107 @@
+// ═══════════════════════════════════════════════════════
+// STORAGE BENCH (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Loading a 100-key profile from Lua right after init: one storage.get per
+// key against one storage.get_many, and storage.keys(prefix) picking the
+// profile out of 300 keys. Reads do not fill the write-back cache, so a
+// second load costs the same. The NVS emulator has no flash latency, so the
+// NVS reads per load are the figure that carries over to a device; the
+// times are the Lua/C and lock overhead.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_storage/lua_storage.h"
+
+static const int ROUNDS = 500;
+
+static const char *SETUP =
+    "storage.set_namespace('bench')\n"
+    "storage.clear()\n"
+    "profile = {}\n"
+    "for i = 1, 100 do\n"
+    "  -- a fifth of the keys are too long for NVS and go through the key map\n"
+    "  local key = i % 5 == 0 and string.format('profile.display.setting.%03d', i)\n"
+    "                          or string.format('profile.%03d', i)\n"
+    "  profile[i] = key\n"
+    "  if i % 3 == 0 then storage.set(key, 'value ' .. i)\n"
+    "  elseif i % 3 == 1 then storage.set(key, i)\n"
+    "  else storage.set(key, i * 0.5) end\n"
+    "end\n"
+    "for i = 1, 200 do storage.set(string.format('log.%03d', i), i) end\n"
+    "storage.flush()\n"
+    "function load_each()\n"
+    "  local t = {}\n"
+    "  for i = 1, #profile do t[profile[i]] = storage.get(profile[i]) end\n"
+    "  return t\n"
+    "end\n"
+    "function load_many()\n"
+    "  return storage.get_many(profile)\n"
+    "end\n"
+    "function list_profile()\n"
+    "  return storage.keys('profile.')\n"
+    "end\n"
+    "assert(#list_profile() == 100)\n"
+    "local a, b = load_each(), load_many()\n"
+    "for i = 1, #profile do assert(a[profile[i]] == b[profile[i]] and a[profile[i]] ~= nil) end\n";
+
+struct Load {
+    double us;
+    double reads;
+};
+
+// Average time and NVS reads of one call to the global Lua function `fn`;
+// `restart` stops and starts storage (empty cache) before every call
+static Load measure(lua_State *L, const char *fn, bool restart) {
+    double total = 0;
+    uint32_t reads = 0;
+    for (int i = 0; i < ROUNDS; i++) {
+        if (restart) {
+            storage_stop_c();
+            storage_init_c();
+        }
+        lua_getglobal(L, fn);
+        uint32_t before = Host::nvsReads;
+        double t0 = Host::seconds();
+        if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
+            printf("lua error: %s\n", lua_tostring(L, -1));
+            host_check_failures++;
+        }
+        total += Host::seconds() - t0;
+        reads += Host::nvsReads - before;
+        lua_pop(L, 1);
+    }
+    Load load = { total * 1e6 / ROUNDS, (double)reads / ROUNDS };
+    return load;
+}
+
+int main() {
+    Host::nvsErase();
+    lua_State *L = Host::openLua();
+    luaopen_storage(L);
+
+    // Every restart logs init and stop; keep the bench output readable
+    uint8_t level = debug_log_tag_levels[log_tag_id(STORAGE_TAG)];
+    debug_log_tag_levels[log_tag_id(STORAGE_TAG)] = LOG_LEVEL_ERROR;
+
+    Host::runLua(L, SETUP);
+
+    Load each = measure(L, "load_each", true);
+    Load many = measure(L, "load_many", true);
+    Load keys = measure(L, "list_profile", false);
+
+    CHECK(many.reads <= each.reads);
+    CHECK(keys.reads == 0);
+    printf("100-key profile load            time      NVS reads\n");
+    printf("  storage.get x100           %7.1f us   %5.1f\n", each.us, each.reads);
+    printf("  storage.get_many           %7.1f us   %5.1f\n", many.us, many.reads);
+    printf("  storage.keys('profile.')   %7.1f us   %5.1f  (100 of 300 keys)\n", keys.us, keys.reads);
+
+    debug_log_tag_levels[log_tag_id(STORAGE_TAG)] = level;
+    storage_stop_c();
+    lua_close(L);
+    return host_check_result("storage_bench");
+}
@@ -0,0 +1,252 @@
+// ═══════════════════════════════════════════════════════
+// STORAGE KEY MAP TEST (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Drives storage_keymap against the NVS emulator: which keys get hashed
+// names, slot assignment when two keys share an FNV-1a hash, the ~keyidx
+// blob surviving a reload, the 64-character limit and the index cap.
+// Ends with the cost of a hit and a miss, the lookup every storage call
+// on a long key makes.
+//
+// Build and run:
+//   make -C tools/host check
+
+#include "host.h"
+#include "lua_modules/lua_storage/storage_keymap.h"
+
+#include <unordered_map>
+
+static uint32_t fnv1a(const std::string &key) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < key.size(); i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static String hashedName(const std::string &key, int slot = 0) {
+    char name[16];
+    if (slot == 0) {
+        snprintf(name, sizeof(name), "#%08x", (unsigned)fnv1a(key));
+    } else {
+        snprintf(name, sizeof(name), "#%08x.%x", (unsigned)fnv1a(key), slot);
+    }
+    return String(name);
+}
+
+static String longKey(unsigned i) {
+    char key[32];
+    snprintf(key, sizeof(key), "sensor.calibration.%06u", i);
+    return String(key);
+}
+
+// Two long keys with one 32-bit hash (birthday search, ~100k candidates)
+static bool findCollision(String &a, String &b) {
+    std::unordered_map<uint32_t, unsigned> seen;
+    for (unsigned i = 0; i < 2000000; i++) {
+        String key = longKey(i);
+        uint32_t hash = fnv1a(key.c_str());
+        std::unordered_map<uint32_t, unsigned>::const_iterator it = seen.find(hash);
+        if (it != seen.end()) {
+            a = longKey(it->second);
+            b = key;
+            return true;
+        }
+        seen[hash] = i;
+    }
+    return false;
+}
+
+static bool indexStored(nvs_handle_t handle) {
+    size_t size = 0;
+    return nvs_get_blob(handle, StorageKeyConfig::INDEX_KEY, NULL, &size) == ESP_OK;
+}
+
+static void testMapping() {
+    storage_keymap_clear();
+
+    // Short keys are their own NVS name
+    CHECK(storage_keymap_resolve("wifi_ssid", true) == "wifi_ssid");
+    CHECK(storage_keymap_resolve("exactly15chars!", true) == "exactly15chars!");
+    CHECK_EQ(storage_keymap_count(), 0);
+
+    // Reserved prefixes are hashed even when short
+    CHECK(storage_keymap_resolve("#a1b2c3d4", true) == hashedName("#a1b2c3d4"));
+    CHECK(storage_keymap_resolve("~keyidx", true) == hashedName("~keyidx"));
+    CHECK(storage_keymap_resolve("~keyidx", true) != StorageKeyConfig::INDEX_KEY);
+    CHECK_EQ(storage_keymap_count(), 2);
+
+    // 16 to 64 characters are hashed, longer and empty keys are refused
+    String k16 = "sixteen-chars-ok";
+    String k64(std::string(64, 'k').c_str());
+    String k65(std::string(65, 'k').c_str());
+    CHECK(storage_keymap_resolve(k16, true) == hashedName(k16.c_str()));
+    CHECK(storage_keymap_resolve(k64, true) == hashedName(k64.c_str()));
+    CHECK(storage_keymap_resolve(k65, true).length() == 0);
+    CHECK(storage_keymap_resolve("", true).length() == 0);
+    CHECK_EQ(storage_keymap_count(), 4);
+
+    // A read of an unknown long key takes no slot
+    CHECK(storage_keymap_resolve("never.written.before.key", false).length() == 0);
+    CHECK_EQ(storage_keymap_count(), 4);
+
+    // Hashed names map back; verbatim ones are not in the index
+    CHECK(storage_keymap_name(hashedName(k64.c_str())) == k64);
+    CHECK(storage_keymap_name("wifi_ssid").length() == 0);
+    CHECK(storage_keymap_name("#00000000").length() == 0);
+}
+
+static void testCollisions() {
+    storage_keymap_clear();
+
+    String a, b;
+    CHECK(findCollision(a, b));
+    if (a.length() == 0) return;
+    printf("collision: %s / %s -> #%08x\n", a.c_str(), b.c_str(), (unsigned)fnv1a(a.c_str()));
+
+    String nameA = storage_keymap_resolve(a, true);
+    String nameB = storage_keymap_resolve(b, true);
+    CHECK(nameA == hashedName(a.c_str()));
+    CHECK(nameB == hashedName(b.c_str(), 1));
+    CHECK(storage_keymap_name(nameA) == a);
+    CHECK(storage_keymap_name(nameB) == b);
+
+    // Stable on repeat lookups, whichever order they come in
+    CHECK(storage_keymap_resolve(b, false) == nameB);
+    CHECK(storage_keymap_resolve(a, false) == nameA);
+
+    // Forgetting slot 0 leaves slot 1 alone; the freed slot is reused
+    storage_keymap_forget(nameA);
+    CHECK(storage_keymap_resolve(a, false).length() == 0);
+    CHECK(storage_keymap_resolve(b, false) == nameB);
+    CHECK(storage_keymap_resolve(a, true) == nameA);
+    CHECK_EQ(storage_keymap_count(), 2);
+}
+
+static void testIndexFull() {
+    storage_keymap_clear();
+
+    for (unsigned i = 0; i < StorageKeyConfig::MAX_LONG_KEYS; i++) {
+        CHECK(storage_keymap_resolve(longKey(i), true).length() > 0);
+    }
+    CHECK_EQ(storage_keymap_count(), StorageKeyConfig::MAX_LONG_KEYS);
+
+    // Full: new long keys are refused, mapped and short ones still resolve
+    String extra = longKey(StorageKeyConfig::MAX_LONG_KEYS);
+    CHECK(storage_keymap_resolve(extra, true).length() == 0);
+    CHECK(storage_keymap_resolve(longKey(0), true) == hashedName(longKey(0).c_str()));
+    CHECK(storage_keymap_resolve("short", true) == "short");
+
+    storage_keymap_forget(hashedName(longKey(0).c_str()));
+    CHECK(storage_keymap_resolve(extra, true) == hashedName(extra.c_str()));
+}
+
+static void testPersistence() {
+    Host::nvsErase();
+    nvs_handle_t handle;
+    CHECK_EQ(nvs_open("keymap_test", NVS_READWRITE, &handle), ESP_OK);
+
+    storage_keymap_load(handle);
+    CHECK_EQ(storage_keymap_count(), 0);
+
+    String a, b;
+    findCollision(a, b);
+    String keys[] = { a, b, "#short", "~tilde", String(std::string(64, 'x').c_str()) };
+    String names[5];
+    for (int i = 0; i < 5; i++) {
+        names[i] = storage_keymap_resolve(keys[i], true);
+    }
+
+    CHECK(storage_keymap_save(handle));
+    CHECK(indexStored(handle));
+
+    // Nothing changed, nothing written
+    uint32_t writes = Host::nvsWrites;
+    CHECK(storage_keymap_save(handle));
+    CHECK_EQ(Host::nvsWrites - writes, 0);
+
+    // A reload (reboot) gives every key its old name, slots included
+    storage_keymap_clear();
+    storage_keymap_load(handle);
+    CHECK_EQ(storage_keymap_count(), 5);
+    for (int i = 0; i < 5; i++) {
+        CHECK(storage_keymap_resolve(keys[i], false) == names[i]);
+        CHECK(storage_keymap_name(names[i]) == keys[i]);
+    }
+
+    // A load is not a change
+    writes = Host::nvsWrites;
+    CHECK(storage_keymap_save(handle));
+    CHECK_EQ(Host::nvsWrites - writes, 0);
+
+    // Emptied, the index record is erased rather than left empty
+    for (int i = 0; i < 5; i++) {
+        storage_keymap_forget(names[i]);
+    }
+    CHECK_EQ(storage_keymap_count(), 0);
+    CHECK(storage_keymap_save(handle));
+    CHECK(!indexStored(handle));
+
+    // A corrupt index loads as empty
+    uint8_t junk[8] = { 0xEE, 0, 1, 0, 1, 2, 3, 4 };
+    nvs_set_blob(handle, StorageKeyConfig::INDEX_KEY, junk, sizeof(junk));
+    storage_keymap_load(handle);
+    CHECK_EQ(storage_keymap_count(), 0);
+
+    nvs_close(handle);
+}
+
+static void benchLookup() {
+    storage_keymap_clear();
+    const unsigned keys = StorageKeyConfig::MAX_LONG_KEYS;
+    std::vector<String> mapped;
+    for (unsigned i = 0; i < keys; i++) {
+        mapped.push_back(longKey(i));
+        storage_keymap_resolve(mapped.back(), true);
+    }
+    std::vector<String> unknown;
+    for (unsigned i = 0; i < keys; i++) {
+        unknown.push_back(longKey(keys + i));
+    }
+
+    const unsigned rounds = 4000;
+    size_t sink = 0;
+
+    double t0 = Host::seconds();
+    for (unsigned r = 0; r < rounds; r++) {
+        for (unsigned i = 0; i < keys; i++) {
+            sink += storage_keymap_resolve(mapped[i], false).length();
+        }
+    }
+    double hit = (Host::seconds() - t0) * 1e9 / (rounds * keys);
+
+    t0 = Host::seconds();
+    for (unsigned r = 0; r < rounds; r++) {
+        for (unsigned i = 0; i < keys; i++) {
+            sink += storage_keymap_resolve(unknown[i], false).length();
+        }
+    }
+    double miss = (Host::seconds() - t0) * 1e9 / (rounds * keys);
+
+    t0 = Host::seconds();
+    for (unsigned r = 0; r < rounds; r++) {
+        for (unsigned i = 0; i < keys; i++) {
+            sink += storage_keymap_resolve("wifi_ssid", false).length();
+        }
+    }
+    double verbatim = (Host::seconds() - t0) * 1e9 / (rounds * keys);
+
+    CHECK_EQ(sink, (size_t)rounds * keys * (9 + 9));
+    printf("lookup, %u mapped keys: hit %.0f ns, miss %.0f ns, short key %.0f ns\n",
+           keys, hit, miss, verbatim);
+}
+
+int main() {
+    testMapping();
+    testCollisions();
+    testIndexFull();
+    testPersistence();
+    benchLookup();
+    return host_check_result("storage_keymap_test");
+}
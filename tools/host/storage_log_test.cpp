@@ -0,0 +1,337 @@
+// ═══════════════════════════════════════════════════════
+// STORAGE LOG TEST (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Runs the log-structured storage backend on the LittleFS shim: appends and
+// replay, a torn tail and an unfinished batch dropped at open, compaction,
+// and a compaction swap interrupted at each step (failed renames/removes,
+// a .tmp left behind). Ends with put throughput on a few hot keys, with
+// the flush task's storage_log_service() compacting, and the replay time
+// of a long log.
+//
+// Build and run:
+//   make -C tools/host check
+
+#include "host.h"
+#include "lua_modules/lua_storage/storage_log.h"
+#include <LittleFS.h>
+
+#include <filesystem>
+
+static const char *LOG_FILE = "/.kv/test.log";
+static const char *TMP_FILE = "/.kv/test.tmp";
+
+static bool putInt(const char *key, int64_t value) {
+    return storage_log_put(key, STORAGE_INT, &value, sizeof(value));
+}
+
+static bool getInt(const char *key, int64_t &value) {
+    StorageValueType type;
+    std::vector<uint8_t> data;
+    if (!storage_log_get(key, type, data) || type != STORAGE_INT || data.size() != sizeof(value)) return false;
+    memcpy(&value, data.data(), sizeof(value));
+    return true;
+}
+
+static bool hasInt(const char *key, int64_t expected) {
+    int64_t value;
+    return getInt(key, value) && value == expected;
+}
+
+static size_t logSize() {
+    std::error_code ec;
+    size_t size = std::filesystem::file_size(Host::fsPath(LOG_FILE), ec);
+    return ec ? 0 : size;
+}
+
+static void truncateLog(size_t size) {
+    std::filesystem::resize_file(Host::fsPath(LOG_FILE), size);
+}
+
+static StorageLogStats stats() {
+    StorageLogStats s;
+    storage_log_get_stats(&s);
+    return s;
+}
+
+static void testAppendReplay() {
+    Host::fsReset();
+    CHECK(storage_log_open("test"));
+
+    std::vector<uint8_t> big(200, 0x5A);
+    CHECK(putInt("count", 1));
+    CHECK(storage_log_put("name", STORAGE_STRING, "hi", 2));
+    CHECK(storage_log_put("calibration.table", STORAGE_BLOB, big.data(), big.size()));
+    CHECK(putInt("gone", 3));
+    CHECK(storage_log_put("gone", STORAGE_REMOVED, NULL, 0));
+    CHECK(storage_log_put("never", STORAGE_REMOVED, NULL, 0));
+    CHECK(putInt("count", 2));
+    CHECK_EQ(stats().keys, 3);
+    CHECK_EQ(stats().appends, 6);
+
+    // A large value is read back from the file, past the unsynced appends
+    StorageValueType type;
+    std::vector<uint8_t> value;
+    CHECK(storage_log_get("calibration.table", type, value) && value == big);
+    storage_log_close();
+
+    CHECK(storage_log_open("test"));
+    CHECK_EQ(stats().keys, 3);
+    CHECK_EQ(stats().replayed, 6);
+    CHECK_EQ(stats().dropped, 0);
+    CHECK_EQ(stats().file_bytes, logSize());
+    CHECK(hasInt("count", 2));
+    CHECK(storage_log_get("name", type, value) && type == STORAGE_STRING && value.size() == 2);
+    CHECK(storage_log_get("calibration.table", type, value) && type == STORAGE_BLOB && value == big);
+    CHECK(!storage_log_contains("gone"));
+    storage_log_close();
+}
+
+static void testTornTail() {
+    Host::fsReset();
+    CHECK(storage_log_open("test"));
+    char key[16];
+    for (int i = 0; i < 10; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        putInt(key, i);
+    }
+    storage_log_close();
+
+    // Power lost three bytes short of the last record
+    size_t record = logSize() / 10;
+    truncateLog(logSize() - 3);
+
+    CHECK(storage_log_open("test"));
+    CHECK_EQ(stats().dropped, 1);
+    CHECK(hasInt("k8", 8));
+    CHECK(!storage_log_contains("k9"));
+    CHECK_EQ(logSize(), 9 * record);
+
+    // Appends made after the tear must survive the next replay
+    CHECK(putInt("after", 42));
+    storage_log_close();
+    CHECK(storage_log_open("test"));
+    CHECK_EQ(stats().dropped, 0);
+    CHECK(hasInt("after", 42));
+    CHECK(hasInt("k0", 0));
+    storage_log_close();
+
+    // Same for a record whose CRC does not match
+    std::FILE *f = std::fopen(Host::fsPath(LOG_FILE).c_str(), "r+b");
+    std::fseek(f, -6, SEEK_END);
+    std::fputc(0xFF, f);
+    std::fclose(f);
+    CHECK(storage_log_open("test"));
+    CHECK_EQ(stats().dropped, 1);
+    CHECK(!storage_log_contains("after"));
+    CHECK(hasInt("k8", 8));
+    storage_log_close();
+}
+
+static void testUnfinishedBatch() {
+    Host::fsReset();
+    CHECK(storage_log_open("test"));
+    putInt("base", 1);
+
+    int64_t one = 1, two = 2;
+    std::vector<StorageLogRecord> batch(3);
+    batch[0].key = "x";
+    batch[0].type = STORAGE_INT;
+    batch[0].value.assign((uint8_t *)&one, (uint8_t *)&one + 8);
+    batch[1].key = "y";
+    batch[1].type = STORAGE_INT;
+    batch[1].value.assign((uint8_t *)&two, (uint8_t *)&two + 8);
+    batch[2].key = "base";
+    batch[2].type = STORAGE_REMOVED;
+    CHECK(storage_log_write_batch(batch));
+    storage_log_close();
+
+    // Lose the END marker (an empty record): none of the batch applies
+    truncateLog(logSize() - StorageLogConfig::RECORD_OVERHEAD);
+    CHECK(storage_log_open("test"));
+    CHECK_EQ(stats().dropped, 3 + 1);
+    CHECK(!storage_log_contains("x"));
+    CHECK(!storage_log_contains("y"));
+    CHECK(hasInt("base", 1));
+
+    CHECK(storage_log_write_batch(batch));
+    storage_log_close();
+    CHECK(storage_log_open("test"));
+    CHECK(hasInt("x", 1));
+    CHECK(hasInt("y", 2));
+    CHECK(!storage_log_contains("base"));
+    storage_log_close();
+}
+
+static void testCompaction() {
+    Host::fsReset();
+    CHECK(storage_log_open("test"));
+
+    std::vector<uint8_t> big(100, 0x33);
+    storage_log_put("blob", STORAGE_BLOB, big.data(), big.size());
+    char key[16];
+    for (int i = 0; i < 2000; i++) {
+        snprintf(key, sizeof(key), "k%d", i % 10);
+        putInt(key, i);
+    }
+    uint32_t before = stats().file_bytes;
+    CHECK(before > 30000);
+
+    CHECK(storage_log_compact());
+    CHECK_EQ(stats().compactions, 1);
+    CHECK_EQ(stats().file_bytes, stats().live_bytes);
+    CHECK_EQ(logSize(), stats().file_bytes);
+    CHECK(!LittleFS.exists(TMP_FILE));
+    printf("compaction: %u -> %u bytes\n", (unsigned)before, (unsigned)stats().file_bytes);
+
+    // Offsets point into the new file, before and after a reopen
+    StorageValueType type;
+    std::vector<uint8_t> value;
+    CHECK(storage_log_get("blob", type, value) && value == big);
+    CHECK(hasInt("k9", 1999));
+    CHECK(putInt("k0", -1));
+    storage_log_close();
+
+    CHECK(storage_log_open("test"));
+    CHECK_EQ(stats().dropped, 0);
+    CHECK(storage_log_get("blob", type, value) && value == big);
+    CHECK(hasInt("k0", -1));
+    CHECK(hasInt("k5", 1995));
+    storage_log_close();
+}
+
+// A log with a few keys and enough garbage to compact
+static void fillForSwap() {
+    Host::fsReset();
+    CHECK(storage_log_open("test"));
+    std::vector<uint8_t> big(100, 0x44);
+    storage_log_put("blob", STORAGE_BLOB, big.data(), big.size());
+    for (int i = 0; i < 100; i++) {
+        putInt("a", i);
+        putInt("b", -i);
+    }
+}
+
+static bool swapIntact() {
+    StorageValueType type;
+    std::vector<uint8_t> value;
+    return hasInt("a", 99) && hasInt("b", -99) && storage_log_get("blob", type, value) &&
+           value == std::vector<uint8_t>(100, 0x44);
+}
+
+static void testInterruptedSwap() {
+    // Remove-then-rename (SPIFFS): the retry lands
+    fillForSwap();
+    Host::fsFailRenames = 1;
+    CHECK(storage_log_compact());
+    CHECK(swapIntact());
+    CHECK(!LittleFS.exists(TMP_FILE));
+    storage_log_close();
+
+    // Neither the rename nor the remove worked: the log was never touched
+    fillForSwap();
+    Host::fsFailRenames = 1;
+    Host::fsFailRemoves = 1;
+    CHECK(!storage_log_compact());
+    CHECK(!LittleFS.exists(TMP_FILE));
+    CHECK(putInt("a", 100));
+    storage_log_close();
+    CHECK(storage_log_open("test"));
+    CHECK(hasInt("a", 100));
+    storage_log_close();
+
+    // Log removed, rename failed: the .tmp is the only copy. The backend
+    // stops instead of starting a fresh log the next open would prefer.
+    fillForSwap();
+    Host::fsFailRenames = 2;
+    CHECK(!storage_log_compact());
+    CHECK(LittleFS.exists(TMP_FILE));
+    CHECK(!LittleFS.exists(LOG_FILE));
+    CHECK(!putInt("a", 1000));
+    CHECK(!storage_log_contains("a"));
+
+    // The next open finishes the swap, unless that rename fails as well
+    Host::fsFailRenames = 1;
+    CHECK(!storage_log_open("test"));
+    CHECK(LittleFS.exists(TMP_FILE));
+    CHECK(storage_log_open("test"));
+    CHECK(!LittleFS.exists(TMP_FILE));
+    CHECK(swapIntact());
+    storage_log_close();
+
+    // Reset mid-compaction: a .tmp next to a complete log is discarded
+    fillForSwap();
+    storage_log_close();
+    std::FILE *f = std::fopen(Host::fsPath(TMP_FILE).c_str(), "wb");
+    std::fputs("half-written", f);
+    std::fclose(f);
+    CHECK(storage_log_open("test"));
+    CHECK(!LittleFS.exists(TMP_FILE));
+    CHECK(swapIntact());
+    CHECK_EQ(stats().dropped, 0);
+    storage_log_close();
+}
+
+static void benchPuts() {
+    Host::fsReset();
+    storage_log_open("test");
+
+    const int keys = 50;
+    const int puts = 500000;
+    char names[keys][16];
+    for (int k = 0; k < keys; k++) {
+        snprintf(names[k], sizeof(names[k]), "hot.%02d", k);
+    }
+
+    double t0 = Host::seconds();
+    for (int i = 0; i < puts; i++) {
+        putInt(names[i % keys], i);
+        if ((i & 63) == 63) storage_log_service();
+    }
+    storage_log_sync();
+    double elapsed = Host::seconds() - t0;
+
+    StorageLogStats s = stats();
+    CHECK(hasInt(names[keys - 1], puts - 1));
+    CHECK(s.compactions > 0);
+    printf("put, %d hot keys: %.2f M puts/s (%u compactions, log %u bytes)\n",
+           keys, puts / elapsed / 1e6, s.compactions, s.file_bytes);
+    storage_log_close();
+}
+
+static void benchReplay() {
+    Host::fsReset();
+    storage_log_open("test");
+
+    const int keys = 1000;
+    const int records = 100000;
+    char key[16];
+    for (int i = 0; i < records; i++) {
+        snprintf(key, sizeof(key), "key.%04d", i % keys);
+        putInt(key, i);
+    }
+    size_t bytes = stats().file_bytes;
+    storage_log_close();
+
+    double t0 = Host::seconds();
+    CHECK(storage_log_open("test"));
+    double elapsed = Host::seconds() - t0;
+
+    CHECK_EQ(stats().keys, keys);
+    CHECK_EQ(stats().replayed, records);
+    printf("replay, %d records / %d keys (%u KB): %.1f ms\n",
+           records, keys, (unsigned)(bytes / 1024), elapsed * 1e3);
+    storage_log_close();
+}
+
+int main() {
+    LittleFS.begin();
+    testAppendReplay();
+    testTornTail();
+    testUnfinishedBatch();
+    testCompaction();
+    testInterruptedSwap();
+    benchPuts();
+    benchReplay();
+    return host_check_result("storage_log_test");
+}
@@ -0,0 +1,115 @@
+// ═══════════════════════════════════════════════════════
+// STORAGE TABLE BENCH (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Size and speed of the LTB binary format storage.set(key, table) writes,
+// against JSON from a plain Lua encoder (what a script without the binary
+// format would have to ship). The table is a 200-entry config: ten groups
+// of twenty integer, float, string and boolean settings. Every encode is
+// decoded back and compared field by field. Host figures, not device ones.
+//
+// Build and run:
+//   make -C tools/host bench
+
+#include "host.h"
+#include "lua.hpp"
+#include "lua_modules/lua_storage/storage_table.h"
+
+static const int ROUNDS = 20000;
+static const int JSON_ROUNDS = 2000;
+
+static const char *CONFIG =
+    "cfg = {}\n"
+    "for g = 1, 10 do\n"
+    "  local group = {}\n"
+    "  for j = 1, 20 do\n"
+    "    local i = (g - 1) * 20 + j\n"
+    "    local name = string.format('param_%03d', i)\n"
+    "    if i % 4 == 0 then group[name] = i * 37\n"
+    "    elseif i % 4 == 1 then group[name] = i * 0.125 + 0.001\n"
+    "    elseif i % 4 == 2 then group[name] = 'value_' .. i\n"
+    "    else group[name] = (i % 3 == 0) end\n"
+    "  end\n"
+    "  cfg['group_' .. g] = group\n"
+    "end\n"
+    "function same(a, b)\n"
+    "  if type(a) ~= 'table' or type(b) ~= 'table' then\n"
+    "    return a == b and math.type(a) == math.type(b)\n"
+    "  end\n"
+    "  for k, v in pairs(a) do if not same(v, b[k]) then return false end end\n"
+    "  for k in pairs(b) do if a[k] == nil then return false end end\n"
+    "  return true\n"
+    "end\n";
+
+static const char *JSON_ENCODER =
+    "local escapes = { ['\"'] = '\\\\\"', ['\\\\'] = '\\\\\\\\', ['\\n'] = '\\\\n', ['\\r'] = '\\\\r', ['\\t'] = '\\\\t' }\n"
+    "local function str(s) return '\"' .. s:gsub('[%c\"\\\\]', escapes) .. '\"' end\n"
+    "function json_encode(v)\n"
+    "  local t = type(v)\n"
+    "  if t == 'table' then\n"
+    "    local parts = {}\n"
+    "    if #v > 0 then\n"
+    "      for i = 1, #v do parts[i] = json_encode(v[i]) end\n"
+    "      return '[' .. table.concat(parts, ',') .. ']'\n"
+    "    end\n"
+    "    for k, x in pairs(v) do parts[#parts + 1] = str(tostring(k)) .. ':' .. json_encode(x) end\n"
+    "    return '{' .. table.concat(parts, ',') .. '}'\n"
+    "  elseif t == 'string' then return str(v)\n"
+    "  elseif t == 'number' then\n"
+    "    return math.type(v) == 'integer' and tostring(v) or string.format('%.14g', v)\n"
+    "  else return tostring(v) end\n"
+    "end\n";
+
+int main() {
+    lua_State *L = Host::openLua();
+    Host::runLua(L, CONFIG);
+    Host::runLua(L, JSON_ENCODER);
+
+    lua_getglobal(L, "cfg");
+    int cfg = lua_gettop(L);
+
+    std::vector<uint8_t> blob;
+    const char *error = NULL;
+    CHECK(storage_table_encode(L, cfg, blob, &error));
+    CHECK(storage_table_is_blob(blob.data(), blob.size()));
+
+    // Round trip (runLua clears the stack)
+    CHECK(storage_table_decode(L, blob.data(), blob.size()));
+    lua_setglobal(L, "decoded");
+    Host::runLua(L, "assert(same(cfg, decoded), 'decoded table differs')");
+    lua_getglobal(L, "cfg");
+    cfg = lua_gettop(L);
+
+    double t0 = Host::seconds();
+    for (int i = 0; i < ROUNDS; i++) {
+        blob.clear();
+        storage_table_encode(L, cfg, blob, &error);
+    }
+    double encode = (Host::seconds() - t0) * 1e6 / ROUNDS;
+
+    t0 = Host::seconds();
+    for (int i = 0; i < ROUNDS; i++) {
+        storage_table_decode(L, blob.data(), blob.size());
+        lua_pop(L, 1);
+    }
+    double decode = (Host::seconds() - t0) * 1e6 / ROUNDS;
+
+    char code[96];
+    snprintf(code, sizeof(code), "for i = 1, %d do json = json_encode(cfg) end", JSON_ROUNDS);
+    t0 = Host::seconds();
+    Host::runLua(L, code);
+    double json = (Host::seconds() - t0) * 1e6 / JSON_ROUNDS;
+
+    lua_getglobal(L, "json");
+    size_t jsonBytes = lua_rawlen(L, -1);
+    lua_pop(L, 1);
+
+    CHECK(blob.size() < jsonBytes);
+    printf("200-entry config table:\n");
+    printf("  LTB binary   %5u bytes  encode %6.1f us  decode %6.1f us\n",
+           (unsigned)blob.size(), encode, decode);
+    printf("  Lua JSON     %5u bytes  encode %6.1f us\n", (unsigned)jsonBytes, json);
+
+    lua_close(L);
+    return host_check_result("storage_table_bench");
+}
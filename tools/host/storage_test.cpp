@@ -0,0 +1,95 @@
+// ═══════════════════════════════════════════════════════
+// STORAGE MODULE TEST (host side)
+// ═══════════════════════════════════════════════════════
+//
+// lua_storage on the NVS emulator. Covers the move of long keys that
+// firmware before the key index stored under their first 15 characters:
+// the first read finds the old entry, the next flush moves it to the
+// hashed name, and a restart no longer needs the legacy name.
+//
+// Build and run:
+//   make -C tools/host check
+
+#include "host.h"
+#include "lua_modules/lua_storage/lua_storage.h"
+#include "lua_modules/lua_storage/storage_keymap.h"
+
+static const char *NS = "legacy_test";
+
+static bool hasKey(const char *key) {
+    std::vector<String> keys;
+    storage_keys_c(NULL, keys);
+    return std::find(keys.begin(), keys.end(), String(key)) != keys.end();
+}
+
+// Read straight from the emulator, past the storage cache
+static bool nvsHas(const String &name) {
+    Preferences prefs;
+    prefs.begin(NS, true);
+    bool found = prefs.isKey(name.c_str());
+    prefs.end();
+    return found;
+}
+
+static void testLegacyMigration() {
+    Host::nvsErase();
+
+    // As the old firmware left it: long keys cut to 15 characters
+    Preferences prefs;
+    prefs.begin(NS, false);
+    prefs.putLong64("sensor.calibrat", 42);                 // sensor.calibration.offset
+    prefs.putString("wifi.access.poi", "greenhouse");       // wifi.access.point.name
+    prefs.putLong64("boot_count", 7);
+    prefs.end();
+
+    CHECK(storage_set_namespace_c(NS));
+
+    StorageStats stats;
+    storage_get_stats_c(&stats);
+    CHECK_EQ(stats.long_keys, 0);
+
+    // Found under the legacy name and listed under the full key from then on
+    CHECK_EQ(storage_get_int_c("sensor.calibration.offset", 0), 42);
+    CHECK(hasKey("sensor.calibration.offset"));
+    CHECK(!hasKey("sensor.calibrat"));
+    CHECK(strcmp(storage_get_string_c("wifi.access.point.name", ""), "greenhouse") == 0);
+    CHECK_EQ(storage_get_int_c("boot_count", 0), 7);
+
+    // Keys that shared the legacy name shared the value; the first read took it
+    CHECK_EQ(storage_get_int_c("sensor.calibration.gain", -1), -1);
+
+    // Unknown long keys take no index slot
+    CHECK_EQ(storage_get_int_c("never.stored.anywhere", -1), -1);
+    storage_get_stats_c(&stats);
+    CHECK_EQ(stats.long_keys, 2);
+
+    // The move reaches flash in the next flush
+    String hashed = storage_keymap_resolve("sensor.calibration.offset", false);
+    CHECK(hashed.length() > 0 && hashed[0] == '#');
+    CHECK(nvsHas("sensor.calibrat"));
+    CHECK(storage_flush_c());
+    CHECK(!nvsHas("sensor.calibrat"));
+    CHECK(!nvsHas("wifi.access.poi"));
+    CHECK(nvsHas(hashed));
+
+    // After a restart the hashed name answers without a legacy read
+    storage_stop_c();
+    CHECK(storage_init_c());
+    CHECK_EQ(storage_get_int_c("sensor.calibration.offset", 0), 42);
+    CHECK(strcmp(storage_get_string_c("wifi.access.point.name", ""), "greenhouse") == 0);
+    CHECK(hasKey("wifi.access.point.name"));
+
+    // A long key written before it was ever read is not overwritten by a legacy value
+    prefs.begin(NS, false);
+    prefs.putLong64("motor.speed.lim", 100);                // motor.speed.limit.max
+    prefs.end();
+    CHECK(storage_set_int_c("motor.speed.limit.max", 250));
+    CHECK_EQ(storage_get_int_c("motor.speed.limit.max", 0), 250);
+
+    storage_stop_c();
+}
+
+int main() {
+    testLegacyMigration();
+    return host_check_result("storage_test");
+}
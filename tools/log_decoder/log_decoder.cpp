@@ -0,0 +1,226 @@
+// ═══════════════════════════════════════════════════════
+// DEFERRED LOG DECODER (host side)
+// ═══════════════════════════════════════════════════════
+//
+// Expands the binary "log" events the device streams after
+// log_config {"stream": true}. Records carry the flash addresses of their
+// format string and tag; the text is looked up in the firmware ELF.
+//
+// Build:
+//   g++ -std=c++11 -O2 -o log_decoder log_decoder.cpp
+//
+// Usage:
+//   log_decoder <firmware.elf> <capture.bin>
+//       capture.bin holds each "log" event payload as [length u16 LE][payload]
+//       (the layout delta_encoder -o writes). Prints one line per message.
+//   log_decoder <firmware.elf> --sections
+//       List the loaded sections string addresses are looked up in.
+//
+// The ELF must be the exact build running on the device
+// (.pio/build/<env>/firmware.elf).
+
+#include "../../lib/EasyLuaESP32/src/core/utils/log_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+static const char *const LEVEL_NAMES[] = { "NONE", "ERROR", "INFO", "DEBUG", "TRACE" };
+
+static bool readFile(const char *path, Bytes &out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(size > 0 ? size : 0);
+    bool ok = out.empty() || fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+// ═══════════════════════════════════════════════════════
+// ELF STRING LOOKUP
+// ═══════════════════════════════════════════════════════
+
+// Loaded sections of a 32-bit little-endian ELF (Xtensa / RISC-V ESP32 builds)
+struct ElfSection {
+    uint32_t addr;
+    uint32_t size;
+    uint32_t offset;
+};
+
+struct ElfImage {
+    Bytes file;
+    std::vector<ElfSection> sections;
+
+    uint32_t u32(size_t pos) const {
+        uint32_t v = 0;
+        if (pos + 4 <= file.size()) memcpy(&v, &file[pos], 4);
+        return v;
+    }
+
+    uint16_t u16(size_t pos) const {
+        uint16_t v = 0;
+        if (pos + 2 <= file.size()) memcpy(&v, &file[pos], 2);
+        return v;
+    }
+
+    bool load(const char *path) {
+        if (!readFile(path, file)) return false;
+        if (file.size() < 52 || memcmp(file.data(), "\x7f" "ELF", 4) != 0 || file[4] != 1 || file[5] != 1) {
+            return false;       // Not a 32-bit little-endian ELF
+        }
+
+        uint32_t shoff = u32(32);
+        uint16_t shentsize = u16(46);
+        uint16_t shnum = u16(48);
+        for (uint16_t i = 0; i < shnum; i++) {
+            size_t sh = shoff + (size_t)i * shentsize;
+            uint32_t type = u32(sh + 4);
+            uint32_t flags = u32(sh + 8);
+            const uint32_t SHT_PROGBITS = 1, SHF_ALLOC = 2;
+            if (type != SHT_PROGBITS || !(flags & SHF_ALLOC)) continue;
+
+            ElfSection s;
+            s.addr = u32(sh + 12);
+            s.offset = u32(sh + 16);
+            s.size = u32(sh + 20);
+            if ((size_t)s.offset + s.size <= file.size()) {
+                sections.push_back(s);
+            }
+        }
+        return !sections.empty();
+    }
+
+    // NUL-terminated string at a device address, or NULL
+    const char *string(uint32_t addr) const {
+        for (size_t i = 0; i < sections.size(); i++) {
+            const ElfSection &s = sections[i];
+            if (addr < s.addr || addr >= s.addr + s.size) continue;
+
+            const char *start = (const char *)&file[s.offset + (addr - s.addr)];
+            size_t room = s.addr + s.size - addr;
+            return memchr(start, '\0', room) ? start : NULL;
+        }
+        return NULL;
+    }
+};
+
+// ═══════════════════════════════════════════════════════
+// FRAME DECODING
+// ═══════════════════════════════════════════════════════
+
+struct DecodeStats {
+    size_t frames;
+    size_t records;
+    size_t unknown;         // Records whose format address is not in the ELF
+    uint32_t dropped;
+};
+
+// Print the records of one "log" payload; false if it is malformed
+static bool decodeFrame(const ElfImage &elf, const uint8_t *data, size_t len, DecodeStats &stats, bool &midLine) {
+    LogFrameHeader header;
+    if (len < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.version != LogFormat::STREAM_VERSION) {
+        fprintf(stderr, "Unsupported stream version %u\n", header.version);
+        return false;
+    }
+
+    if (header.flags & LOG_FRAME_DROPPED) {
+        printf("%s[LOG] device dropped records (%u total)\n", midLine ? "\n" : "", header.dropped);
+        midLine = false;
+    }
+    stats.dropped = header.dropped;
+    stats.frames++;
+
+    size_t pos = sizeof(header);
+    for (uint16_t i = 0; i < header.count; i++) {
+        LogRecordHeader record;
+        if (pos + sizeof(record) > len) return false;
+        memcpy(&record, data + pos, sizeof(record));
+        pos += sizeof(record);
+        if (pos + record.length > len) return false;
+        const uint8_t *args = data + pos;
+        pos += record.length;
+        stats.records++;
+
+        const char *fmt = elf.string(record.fmt);
+        const char *tag = elf.string(record.tag);
+        char text[1024];
+        if (fmt) {
+            log_format(text, sizeof(text), fmt, args, record.length);
+        } else {
+            snprintf(text, sizeof(text), "<unknown format 0x%08x, %u arg bytes>", record.fmt, record.length);
+            stats.unknown++;
+        }
+
+        if (!(record.flags & LOG_RECORD_CONTINUED)) {
+            if (midLine) printf("\n");
+            const char *level = record.level <= 4 ? LEVEL_NAMES[record.level] : "?";
+            printf("%10.3f [%s][%s] ", record.time_us / 1000.0, level, tag ? tag : "?");
+        }
+        printf("%s%s", text, (record.flags & LOG_RECORD_TRUNCATED) ? "..." : "");
+        midLine = (record.flags & LOG_RECORD_PARTIAL) != 0;
+        if (!midLine) printf("\n");
+    }
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════
+// MAIN
+// ═══════════════════════════════════════════════════════
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <firmware.elf> <capture.bin>\n"
+                        "       %s <firmware.elf> --sections\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    ElfImage elf;
+    if (!elf.load(argv[1])) {
+        fprintf(stderr, "Cannot load %s (expected a 32-bit little-endian ELF)\n", argv[1]);
+        return 1;
+    }
+
+    if (strcmp(argv[2], "--sections") == 0) {
+        for (size_t i = 0; i < elf.sections.size(); i++) {
+            const ElfSection &s = elf.sections[i];
+            printf("section 0x%08x..0x%08x\n", s.addr, s.addr + s.size);
+        }
+        return 0;
+    }
+
+    Bytes capture;
+    if (!readFile(argv[2], capture)) {
+        fprintf(stderr, "Cannot read %s\n", argv[2]);
+        return 1;
+    }
+
+    DecodeStats stats = { 0, 0, 0, 0 };
+    bool midLine = false;
+    size_t pos = 0;
+    while (pos + 2 <= capture.size()) {
+        size_t len = capture[pos] | (capture[pos + 1] << 8);
+        pos += 2;
+        if (pos + len > capture.size()) {
+            fprintf(stderr, "Capture ends inside a frame\n");
+            break;
+        }
+        if (!decodeFrame(elf, &capture[pos], len, stats, midLine)) {
+            fprintf(stderr, "Malformed frame at offset %zu\n", pos - 2);
+        }
+        pos += len;
+    }
+    if (midLine) printf("\n");
+
+    fprintf(stderr, "%zu frames, %zu records, %zu unknown formats, %u dropped on device\n",
+            stats.frames, stats.records, stats.unknown, stats.dropped);
+    return stats.unknown > 0 ? 2 : 0;
+}
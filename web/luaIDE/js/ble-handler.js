@@ -67,11 +67,14 @@ export function initializeBLE() {
 
 function setupEventHandlers() {
     // Handler for lua_code_output events (from Lua print() function)
+    // The device batches consecutive prints into one event, one per line
     BLEState.decoder.on(EVENT_LUA_OUTPUT, (data) => {
-        const message = toString(data);
-        console.log('[LUA OUTPUT]', message);
-        if (BLEState.onLuaPrint) {
-            BLEState.onLuaPrint(message);
+        const lines = toString(data).split('\n');
+        for (const message of lines) {
+            console.log('[LUA OUTPUT]', message);
+            if (BLEState.onLuaPrint) {
+                BLEState.onLuaPrint(message);
+            }
         }
     });
 